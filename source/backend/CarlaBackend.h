@@ -679,6 +679,7 @@ typedef enum {
     /*!
      * A plugin has been added.
      * @a pluginId Plugin Id
+     * @a value3   Time it took to load the plugin and restore its state, in milliseconds (only set when loading a project)
      * @a valueStr Plugin name
      */
     ENGINE_CALLBACK_PLUGIN_ADDED = 1,
@@ -1124,7 +1125,39 @@ typedef enum {
     /*!
      * Capture console output into debug callbacks.
      */
-    ENGINE_OPTION_DEBUG_CONSOLE_OUTPUT = 24
+    ENGINE_OPTION_DEBUG_CONSOLE_OUTPUT = 24,
+
+    /*!
+     * Number of extra threads used to process independent plugins in parallel.
+     * Only used in patchbay and rack modes, cannot be changed while the engine is running.
+     * Default is 0 (all processing is done in the audio thread).
+     */
+    ENGINE_OPTION_AUDIO_WORKER_THREADS = 25,
+
+    /*!
+     * Let plugin bridges process the current block while the host consumes the previous one.
+     * Removes the bridge round-trip from the audio thread, at the cost of one block of latency.
+     * Only applies to bridges started afterwards.
+     * Default is false.
+     */
+    ENGINE_OPTION_PIPELINED_PLUGIN_BRIDGES = 26,
+
+    /*!
+     * Minimum size of the sub-blocks plugins are split into for sample-accurate events, in frames.
+     * Parameter changes closer than this to the previous split or to the end of the block
+     * are applied at the previous split instead, MIDI events keep their exact time where the plugin format allows it.
+     * 0 splits at every event time.
+     * Default is 0.
+     */
+    ENGINE_OPTION_MIN_SUB_BLOCK_SIZE = 27,
+
+    /*!
+     * Time spent busy-waiting on plugin bridge semaphores before going to sleep, in microseconds.
+     * Avoids a sleep and wake-up when the other side answers quickly, at the cost of some CPU.
+     * Applies to the host and to bridges started afterwards, ignored on single-core systems.
+     * Default is 20 on Linux, 0 elsewhere.
+     */
+    ENGINE_OPTION_PLUGIN_BRIDGES_SPIN_TIME = 28
 
 } EngineOption;
 
@@ -29,6 +29,9 @@ class MemoryOutputStream;
 class XmlDocument;
 }
 
+class CarlaBackgroundWorkPool;
+class Lv2UridMap;
+
 CARLA_BACKEND_START_NAMESPACE
 
 // -----------------------------------------------------------------------
@@ -40,6 +43,8 @@ CARLA_BACKEND_START_NAMESPACE
  * @{
  */
 
+class CarlaBinaryStateFile;
+
 /*!
  * The type of an engine.
  */
@@ -225,6 +230,7 @@ struct CARLA_API EngineOptions {
 
     bool forceStereo;
     bool preferPluginBridges;
+    bool pipelinedPluginBridges;
     bool preferUiBridges;
     bool uisAlwaysOnTop;
 
@@ -233,6 +239,9 @@ struct CARLA_API EngineOptions {
     uint audioNumPeriods;
     uint audioBufferSize;
     uint audioSampleRate;
+    uint audioWorkerThreads;
+    uint minSubBlockSize;
+    uint bridgesSpinTime;
     const char* audioDevice;
 
     const char* pathLADSPA;
@@ -925,6 +934,22 @@ public:
      */
     const EngineTimeInfo& getTimeInfo() const noexcept;
 
+    /*!
+     * Get the pool of non-realtime threads used for work scheduled by plugins.
+     */
+    CarlaBackgroundWorkPool& getBackgroundWorkPool() const noexcept;
+
+    /*!
+     * Get the URID map shared by all LV2 plugins of this engine.
+     */
+    Lv2UridMap& getLv2UridMap() const noexcept;
+
+    /*!
+     * Tell the engine thread a plugin has postponed events waiting for its idle() call.
+     * Real-time safe.
+     */
+    void requestPluginIdle(const uint pluginId) const noexcept;
+
     // -------------------------------------------------------------------
     // Information (peaks)
 
@@ -1135,14 +1160,30 @@ protected:
 
     /*!
      * Common save project function for main engine and plugin.
+     * With @a binary the project is written as a binary project file instead of xml.
      */
-    void saveProjectInternal(water::MemoryOutputStream& outStrm) const;
+    void saveProjectInternal(water::MemoryOutputStream& outStrm, const bool binary = false) const;
 
     /*!
      * Common load project function for main engine and plugin.
      */
     bool loadProjectInternal(water::XmlDocument& xmlDoc);
 
+    /*!
+     * Load a project or preset from a binary file, which must stay open until this returns.
+     */
+    bool loadProjectInternal(const CarlaBinaryStateFile& binaryState);
+
+    /*!
+     * Everything read from a project or preset file.
+     */
+    struct ProjectLoadData;
+
+    /*!
+     * Load the data read by the functions above.
+     */
+    bool loadProjectInternal(ProjectLoadData& data);
+
 #ifndef BUILD_BRIDGE
     // -------------------------------------------------------------------
     // Patchbay stuff
@@ -1226,6 +1267,7 @@ public:
     void oscSend_control_note_on(const uint pluginId, const uint8_t channel, const uint8_t note, const uint8_t velo) const noexcept;
     void oscSend_control_note_off(const uint pluginId, const uint8_t channel, const uint8_t note) const noexcept;
     void oscSend_control_set_peaks(const uint pluginId) const noexcept;
+    void oscSend_control_updates() const noexcept; // changed output parameters and peaks, bundled
     void oscSend_control_exit() const noexcept;
 #endif
 
@@ -268,6 +268,50 @@ typedef struct _CarlaTransportInfo {
 
 } CarlaTransportInfo;
 
+/*!
+ * Wake-up latency statistics of a plugin bridge.
+ * Measures the time between the host waking up the bridge audio thread and that thread running.
+ * @see carla_get_plugin_bridge_wake_stats()
+ */
+typedef struct _CarlaBridgeWakeStats {
+    /*!
+     * Number of wake-ups measured.
+     */
+    uint64_t count;
+
+    /*!
+     * Highest wake-up latency, in microseconds.
+     */
+    uint32_t maxUsecs;
+
+    /*!
+     * Number of wake-ups per latency range.
+     * Index 0 counts wake-ups under 1 microsecond, index N the ones under 2^N microseconds.
+     * The last index also counts anything slower.
+     */
+    uint32_t histogram[16];
+
+} CarlaBridgeWakeStats;
+
+/*!
+ * Sub-block splitting statistics of a plugin.
+ * Plugins split their audio block at event times, so parameter changes happen on the right frame.
+ * @see carla_get_plugin_sub_block_stats()
+ * @see ENGINE_OPTION_MIN_SUB_BLOCK_SIZE
+ */
+typedef struct _CarlaSubBlockStats {
+    /*!
+     * Number of times the audio block was split at an event.
+     */
+    uint64_t splitCount;
+
+    /*!
+     * Number of splits skipped because the event was too close to the previous split or to the end of the block.
+     */
+    uint64_t skippedCount;
+
+} CarlaSubBlockStats;
+
 /*!
  * Image data for LV2 inline display API.
  * raw image pixmap format is ARGB32,
@@ -552,6 +596,20 @@ CARLA_EXPORT bool carla_export_plugin_lv2(uint pluginId, const char* lv2path);
  */
 CARLA_EXPORT const CarlaPluginInfo* carla_get_plugin_info(uint pluginId);
 
+/*!
+ * Get wake-up latency statistics from a bridged plugin.
+ * All values are zero for plugins that are not bridged, or bridges running on Windows.
+ * @param pluginId Plugin
+ */
+CARLA_EXPORT const CarlaBridgeWakeStats* carla_get_plugin_bridge_wake_stats(uint pluginId);
+
+/*!
+ * Get sub-block splitting statistics from a plugin.
+ * Bridged plugins split inside the bridge, their values are zero here.
+ * @param pluginId Plugin
+ */
+CARLA_EXPORT const CarlaSubBlockStats* carla_get_plugin_sub_block_stats(uint pluginId);
+
 /*!
  * Get audio port count information from a plugin.
  * @param pluginId Plugin
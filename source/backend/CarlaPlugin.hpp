@@ -156,6 +156,19 @@ public:
      */
     virtual uint32_t getLatencyInFrames() const noexcept;
 
+    /*!
+     * Get the wake-up latency statistics of the plugin bridge audio thread.
+     * @a histogram must have room for 16 values, see CarlaBridgeWakeStats.
+     * Returns false if the plugin is not bridged.
+     */
+    virtual bool getBridgeWakeStats(uint64_t& count, uint32_t& maxUsecs, uint32_t* histogram) const noexcept;
+
+    /*!
+     * Get how many times the audio block was split for sample-accurate events,
+     * and how many splits were skipped because of ENGINE_OPTION_MIN_SUB_BLOCK_SIZE.
+     */
+    void getSubBlockStats(uint64_t& splitCount, uint64_t& skippedCount) const noexcept;
+
     // -------------------------------------------------------------------
     // Information (count)
 
@@ -397,17 +410,20 @@ public:
     /*!
      * Get the plugin's save state.
      * The plugin will automatically call prepareForSave() if requested.
+     * With @a rawChunk the chunk is given as raw data instead of base64 text, valid until the plugin state changes.
      *
      * @see loadStateSave()
      */
-    const CarlaStateSave& getStateSave(const bool callPrepareForSave = true);
+    const CarlaStateSave& getStateSave(const bool callPrepareForSave = true, const bool rawChunk = false);
 
     /*!
      * Get the plugin's save state.
+     * Without @a sendOsc and @a sendCallback nobody is told about the changes,
+     * which allows restoring from a thread other than the main one.
      *
      * @see getStateSave()
      */
-    void loadStateSave(const CarlaStateSave& stateSave);
+    void loadStateSave(const CarlaStateSave& stateSave, const bool sendOsc = true, const bool sendCallback = true);
 
     /*!
      * Save the current plugin state to @a filename.
@@ -699,11 +715,18 @@ public:
     // Misc
 
     /*!
-     * Idle function (non-UI), called at regular intervals.
+     * Idle function (non-UI), called when the plugin has postponed events and at regular intervals.
      * @note: This function is NOT called from the main thread.
      */
     virtual void idle();
 
+    /*!
+     * Check if idle() needs to be called often, even without postponed events.
+     * This also covers uiIdle() when PLUGIN_NEEDS_UI_MAIN_THREAD is not set.
+     * Plugins that don't are only checked every now and then, for things like latency changes.
+     */
+    virtual bool needsFrequentIdle() const noexcept;
+
     /*!
      * Try to lock the plugin's master mutex.
      * @param forcedOffline When true, always locks and returns true
@@ -167,6 +167,12 @@ static void carla_engine_init_common()
     if (const char* const uiBridgesTimeout = std::getenv("ENGINE_OPTION_UI_BRIDGES_TIMEOUT"))
         gStandalone.engine->setOption(CB::ENGINE_OPTION_UI_BRIDGES_TIMEOUT, std::atoi(uiBridgesTimeout), nullptr);
 
+    if (const char* const minSubBlockSize = std::getenv("ENGINE_OPTION_MIN_SUB_BLOCK_SIZE"))
+        gStandalone.engine->setOption(CB::ENGINE_OPTION_MIN_SUB_BLOCK_SIZE, std::atoi(minSubBlockSize), nullptr);
+
+    if (const char* const bridgesSpinTime = std::getenv("ENGINE_OPTION_PLUGIN_BRIDGES_SPIN_TIME"))
+        gStandalone.engine->setOption(CB::ENGINE_OPTION_PLUGIN_BRIDGES_SPIN_TIME, std::atoi(bridgesSpinTime), nullptr);
+
     if (const char* const pathLADSPA = std::getenv("ENGINE_OPTION_PLUGIN_PATH_LADSPA"))
         gStandalone.engine->setOption(CB::ENGINE_OPTION_PLUGIN_PATH, CB::PLUGIN_LADSPA, pathLADSPA);
 
@@ -213,6 +219,10 @@ static void carla_engine_init_common()
     gStandalone.engine->setOption(CB::ENGINE_OPTION_AUDIO_NUM_PERIODS,     static_cast<int>(gStandalone.engineOptions.audioNumPeriods),  nullptr);
     gStandalone.engine->setOption(CB::ENGINE_OPTION_AUDIO_BUFFER_SIZE,     static_cast<int>(gStandalone.engineOptions.audioBufferSize),  nullptr);
     gStandalone.engine->setOption(CB::ENGINE_OPTION_AUDIO_SAMPLE_RATE,     static_cast<int>(gStandalone.engineOptions.audioSampleRate),  nullptr);
+    gStandalone.engine->setOption(CB::ENGINE_OPTION_AUDIO_WORKER_THREADS,  static_cast<int>(gStandalone.engineOptions.audioWorkerThreads), nullptr);
+    gStandalone.engine->setOption(CB::ENGINE_OPTION_PIPELINED_PLUGIN_BRIDGES, gStandalone.engineOptions.pipelinedPluginBridges ? 1 : 0, nullptr);
+    gStandalone.engine->setOption(CB::ENGINE_OPTION_MIN_SUB_BLOCK_SIZE,    static_cast<int>(gStandalone.engineOptions.minSubBlockSize),  nullptr);
+    gStandalone.engine->setOption(CB::ENGINE_OPTION_PLUGIN_BRIDGES_SPIN_TIME, static_cast<int>(gStandalone.engineOptions.bridgesSpinTime), nullptr);
 
     gStandalone.engine->setOption(CB::ENGINE_OPTION_AUDIO_SAMPLE_RATE,     static_cast<int>(gStandalone.engineOptions.audioSampleRate),  nullptr);
 
@@ -641,6 +651,26 @@ void carla_set_engine_option(EngineOption option, int value, const char* valueSt
     case CB::ENGINE_OPTION_DEBUG_CONSOLE_OUTPUT:
         gStandalone.logThreadEnabled = (value != 0);
         break;
+
+    case CB::ENGINE_OPTION_AUDIO_WORKER_THREADS:
+        CARLA_SAFE_ASSERT_RETURN(value >= 0 && value <= 32,);
+        gStandalone.engineOptions.audioWorkerThreads = static_cast<uint>(value);
+        break;
+
+    case CB::ENGINE_OPTION_PIPELINED_PLUGIN_BRIDGES:
+        CARLA_SAFE_ASSERT_RETURN(value == 0 || value == 1,);
+        gStandalone.engineOptions.pipelinedPluginBridges = (value != 0);
+        break;
+
+    case CB::ENGINE_OPTION_PLUGIN_BRIDGES_SPIN_TIME:
+        CARLA_SAFE_ASSERT_RETURN(value >= 0 && value <= 1000,);
+        gStandalone.engineOptions.bridgesSpinTime = static_cast<uint>(value);
+        break;
+
+    case CB::ENGINE_OPTION_MIN_SUB_BLOCK_SIZE:
+        CARLA_SAFE_ASSERT_RETURN(value >= 0 && value <= 1024,);
+        gStandalone.engineOptions.minSubBlockSize = static_cast<uint>(value);
+        break;
     }
 
     if (gStandalone.engine != nullptr)
@@ -1059,6 +1089,40 @@ const CarlaPluginInfo* carla_get_plugin_info(uint pluginId)
     return &retInfo;
 }
 
+const CarlaBridgeWakeStats* carla_get_plugin_bridge_wake_stats(uint pluginId)
+{
+    static CarlaBridgeWakeStats retStats;
+    carla_zeroStruct(retStats);
+
+    CARLA_SAFE_ASSERT_RETURN(gStandalone.engine != nullptr, &retStats);
+
+    CarlaPlugin* const plugin(gStandalone.engine->getPlugin(pluginId));
+    CARLA_SAFE_ASSERT_RETURN(plugin != nullptr, &retStats);
+
+    carla_debug("carla_get_plugin_bridge_wake_stats(%i)", pluginId);
+
+    if (! plugin->getBridgeWakeStats(retStats.count, retStats.maxUsecs, retStats.histogram))
+        carla_zeroStruct(retStats);
+
+    return &retStats;
+}
+
+const CarlaSubBlockStats* carla_get_plugin_sub_block_stats(uint pluginId)
+{
+    static CarlaSubBlockStats retStats;
+    carla_zeroStruct(retStats);
+
+    CARLA_SAFE_ASSERT_RETURN(gStandalone.engine != nullptr, &retStats);
+
+    CarlaPlugin* const plugin(gStandalone.engine->getPlugin(pluginId));
+    CARLA_SAFE_ASSERT_RETURN(plugin != nullptr, &retStats);
+
+    carla_debug("carla_get_plugin_sub_block_stats(%i)", pluginId);
+
+    plugin->getSubBlockStats(retStats.splitCount, retStats.skippedCount);
+    return &retStats;
+}
+
 const CarlaPortCountInfo* carla_get_audio_port_count_info(uint pluginId)
 {
     static CarlaPortCountInfo retInfo;
@@ -36,6 +36,7 @@
 #include "jackbridge/JackBridge.hpp"
 
 #include "water/files/File.h"
+#include "water/containers/OwnedArray.h"
 #include "water/streams/MemoryOutputStream.h"
 #include "water/xml/XmlDocument.h"
 #include "water/xml/XmlElement.h"
@@ -44,6 +45,7 @@ using water::Array;
 using water::CharPointer_UTF8;
 using water::File;
 using water::MemoryOutputStream;
+using water::OwnedArray;
 using water::String;
 using water::StringArray;
 using water::XmlDocument;
@@ -615,7 +617,9 @@ bool CarlaEngine::addPlugin(const BinaryType btype, const PluginType ptype,
     }
 
 # ifdef HAVE_LIBLO
-    plugin->registerToOscClient();
+    // when loading a project, this is done once the plugin state is restored
+    if (! pData->loadingProject)
+        plugin->registerToOscClient();
 # endif
 #endif
 
@@ -627,6 +631,11 @@ bool CarlaEngine::addPlugin(const BinaryType btype, const PluginType ptype,
     pluginData.outsPeak[1] = 0.0f;
 
 #ifndef BUILD_BRIDGE
+# ifdef HAVE_LIBLO
+    // a replaced plugin can be allocated at the same address as the old one
+    pData->osc.resetControlUpdates();
+# endif
+
     if (oldPlugin != nullptr)
     {
         CARLA_SAFE_ASSERT(! pData->loadingProject);
@@ -711,6 +720,9 @@ bool CarlaEngine::removePlugin(const uint id)
     */
 
 # ifdef HAVE_LIBLO
+    // plugin ids after this one change
+    pData->osc.resetControlUpdates();
+
     if (isOscControlRegistered())
         oscSend_control_remove_plugin(id);
 # endif
@@ -747,6 +759,8 @@ bool CarlaEngine::removeAllPlugins()
         pData->graph.removeAllPlugins();
 
 # ifdef HAVE_LIBLO
+    pData->osc.resetControlUpdates();
+
     if (isOscControlRegistered())
     {
         for (uint i=0; i < curPluginCount; ++i)
@@ -895,6 +909,10 @@ bool CarlaEngine::switchPlugins(const uint idA, const uint idB) noexcept
     const bool lockWait(isRunning() /*&& pData->options.processMode != ENGINE_PROCESS_MODE_MULTIPLE_CLIENTS*/);
     const ScopedActionLock sal(this, kEnginePostActionSwitchPlugins, idA, idB, lockWait);
 
+#ifdef HAVE_LIBLO
+    pData->osc.resetControlUpdates();
+#endif
+
     // TODO
     /*
     pluginA->updateOscURL();
@@ -1030,7 +1048,7 @@ bool CarlaEngine::loadFile(const char* const filename)
     // -------------------------------------------------------------------
     // NOTE: please keep in sync with carla_get_supported_file_extensions!!
 
-    if (extension == "carxp" || extension == "carxs")
+    if (extension == "carxp" || extension == "carxs" || extension == "carbp" || extension == "carbs")
         return loadProject(filename);
 
     // -------------------------------------------------------------------
@@ -1152,6 +1170,15 @@ bool CarlaEngine::loadProject(const char* const filename)
     File file(jfilename);
     CARLA_SAFE_ASSERT_RETURN_ERR(file.existsAsFile(), "Requested file does not exist or is not a readable file");
 
+    if (CarlaBinaryStateFile::isBinaryStateFile(filename))
+    {
+        CarlaBinaryStateFile binaryState;
+        CARLA_SAFE_ASSERT_RETURN_ERR(binaryState.openFile(filename), "Failed to open binary project file");
+
+        // chunks point into the mapped file, which must stay open until all plugins are loaded
+        return loadProjectInternal(binaryState);
+    }
+
     XmlDocument xml(file);
     return loadProjectInternal(xml);
 }
@@ -1161,12 +1188,12 @@ bool CarlaEngine::saveProject(const char* const filename)
     CARLA_SAFE_ASSERT_RETURN_ERR(filename != nullptr && filename[0] != '\0', "Invalid filename");
     carla_debug("CarlaEngine::saveProject(\"%s\")", filename);
 
-    MemoryOutputStream out;
-    saveProjectInternal(out);
-
     const String jfilename = String(CharPointer_UTF8(filename));
     File file(jfilename);
 
+    MemoryOutputStream out;
+    saveProjectInternal(out, file.hasFileExtension("carbp"));
+
     if (file.replaceWithData(out.getData(), out.getDataSize()))
         return true;
 
@@ -1212,6 +1239,21 @@ const EngineTimeInfo& CarlaEngine::getTimeInfo() const noexcept
     return pData->timeInfo;
 }
 
+CarlaBackgroundWorkPool& CarlaEngine::getBackgroundWorkPool() const noexcept
+{
+    return pData->backgroundWorkPool;
+}
+
+Lv2UridMap& CarlaEngine::getLv2UridMap() const noexcept
+{
+    return pData->lv2UridMap;
+}
+
+void CarlaEngine::requestPluginIdle(const uint pluginId) const noexcept
+{
+    pData->thread.requestPluginIdle(pluginId);
+}
+
 // -----------------------------------------------------------------------
 // Information (peaks)
 
@@ -1388,7 +1430,7 @@ void CarlaEngine::setOption(const EngineOption option, const int value, const ch
 {
     carla_debug("CarlaEngine::setOption(%i:%s, %i, \"%s\")", option, EngineOption2Str(option), value, valueStr);
 
-    if (isRunning() && (option == ENGINE_OPTION_PROCESS_MODE || option == ENGINE_OPTION_AUDIO_NUM_PERIODS || option == ENGINE_OPTION_AUDIO_DEVICE))
+    if (isRunning() && (option == ENGINE_OPTION_PROCESS_MODE || option == ENGINE_OPTION_AUDIO_NUM_PERIODS || option == ENGINE_OPTION_AUDIO_DEVICE || option == ENGINE_OPTION_AUDIO_WORKER_THREADS))
         return carla_stderr("CarlaEngine::setOption(%i:%s, %i, \"%s\") - Cannot set this option while engine is running!", option, EngineOption2Str(option), value, valueStr);
 
     // do not un-force stereo for rack mode
@@ -1637,6 +1679,26 @@ void CarlaEngine::setOption(const EngineOption option, const int value, const ch
 
     case ENGINE_OPTION_DEBUG_CONSOLE_OUTPUT:
         break;
+
+    case ENGINE_OPTION_AUDIO_WORKER_THREADS:
+        CARLA_SAFE_ASSERT_RETURN(value >= 0 && value <= 32,);
+        pData->options.audioWorkerThreads = static_cast<uint>(value);
+        break;
+
+    case ENGINE_OPTION_PIPELINED_PLUGIN_BRIDGES:
+        CARLA_SAFE_ASSERT_RETURN(value == 0 || value == 1,);
+        pData->options.pipelinedPluginBridges = (value != 0);
+        break;
+
+    case ENGINE_OPTION_PLUGIN_BRIDGES_SPIN_TIME:
+        CARLA_SAFE_ASSERT_RETURN(value >= 0 && value <= 1000,);
+        pData->options.bridgesSpinTime = static_cast<uint>(value);
+        break;
+
+    case ENGINE_OPTION_MIN_SUB_BLOCK_SIZE:
+        CARLA_SAFE_ASSERT_RETURN(value >= 0 && value <= 1024,);
+        pData->options.minSubBlockSize = static_cast<uint>(value);
+        break;
     }
 }
 
@@ -1759,7 +1821,33 @@ void CarlaEngine::setPluginPeaks(const uint pluginId, float const inPeaks[2], fl
     pluginData.outsPeak[1] = outPeaks[1];
 }
 
-void CarlaEngine::saveProjectInternal(water::MemoryOutputStream& outStream) const
+#ifndef BUILD_BRIDGE
+static void saveProjectConnections(MemoryOutputStream& outStream, const char* const tagName, const char* const* const patchbayConns)
+{
+    MemoryOutputStream outPatchbay(2048);
+
+    outPatchbay << "\n <" << tagName << ">\n";
+
+    for (int i=0; patchbayConns[i] != nullptr && patchbayConns[i+1] != nullptr; ++i, ++i )
+    {
+        const char* const connSource(patchbayConns[i]);
+        const char* const connTarget(patchbayConns[i+1]);
+
+        CARLA_SAFE_ASSERT_CONTINUE(connSource != nullptr && connSource[0] != '\0');
+        CARLA_SAFE_ASSERT_CONTINUE(connTarget != nullptr && connTarget[0] != '\0');
+
+        outPatchbay << "  <Connection>\n";
+        outPatchbay << "   <Source>" << xmlSafeString(connSource, true) << "</Source>\n";
+        outPatchbay << "   <Target>" << xmlSafeString(connTarget, true) << "</Target>\n";
+        outPatchbay << "  </Connection>\n";
+    }
+
+    outPatchbay << " </" << tagName << ">\n";
+    outStream << outPatchbay;
+}
+#endif
+
+void CarlaEngine::saveProjectInternal(water::MemoryOutputStream& outStream, const bool binary) const
 {
     // send initial prepareForSave first, giving time for bridges to act
     for (uint i=0; i < pData->curPluginCount; ++i)
@@ -1777,42 +1865,61 @@ void CarlaEngine::saveProjectInternal(water::MemoryOutputStream& outStream) cons
         }
     }
 
-    outStream << "<?xml version='1.0' encoding='UTF-8'?>\n";
-    outStream << "<!DOCTYPE CARLA-PROJECT>\n";
-    outStream << "<CARLA-PROJECT VERSION='2.0'>\n";
-
     const bool isPlugin(getType() == kEngineTypePlugin);
     const EngineOptions& options(pData->options);
 
-    MemoryOutputStream outSettings(1024);
+    // binary projects are written straight from the plugin states, with raw chunks
+    ScopedPointer<CarlaBinaryStateWriter> binaryWriter(binary ? new CarlaBinaryStateWriter(false) : nullptr);
+
+    if (binaryWriter == nullptr)
+    {
+        outStream << "<?xml version='1.0' encoding='UTF-8'?>\n";
+        outStream << "<!DOCTYPE CARLA-PROJECT>\n";
+        outStream << "<CARLA-PROJECT VERSION='2.0'>\n";
+    }
 
-    // save appropriate engine settings
-    outSettings << " <EngineSettings>\n";
+    // save appropriate engine settings, as names and values
+    StringArray settings;
 
     //processMode
     //transportMode
 
-    outSettings << "  <ForceStereo>"         << bool2str(options.forceStereo)         << "</ForceStereo>\n";
-    outSettings << "  <PreferPluginBridges>" << bool2str(options.preferPluginBridges) << "</PreferPluginBridges>\n";
-    outSettings << "  <PreferUiBridges>"     << bool2str(options.preferUiBridges)     << "</PreferUiBridges>\n";
-    outSettings << "  <UIsAlwaysOnTop>"      << bool2str(options.uisAlwaysOnTop)      << "</UIsAlwaysOnTop>\n";
+    settings.add("ForceStereo");         settings.add(bool2str(options.forceStereo));
+    settings.add("PreferPluginBridges"); settings.add(bool2str(options.preferPluginBridges));
+    settings.add("PreferUiBridges");     settings.add(bool2str(options.preferUiBridges));
+    settings.add("UIsAlwaysOnTop");      settings.add(bool2str(options.uisAlwaysOnTop));
 
-    outSettings << "  <MaxParameters>"       << String(options.maxParameters)    << "</MaxParameters>\n";
-    outSettings << "  <UIBridgesTimeout>"    << String(options.uiBridgesTimeout) << "</UIBridgesTimeout>\n";
+    settings.add("MaxParameters");       settings.add(String(options.maxParameters));
+    settings.add("UIBridgesTimeout");    settings.add(String(options.uiBridgesTimeout));
 
     if (isPlugin)
     {
-        outSettings << "  <LADSPA_PATH>" << xmlSafeString(options.pathLADSPA, true) << "</LADSPA_PATH>\n";
-        outSettings << "  <DSSI_PATH>"   << xmlSafeString(options.pathDSSI,   true) << "</DSSI_PATH>\n";
-        outSettings << "  <LV2_PATH>"    << xmlSafeString(options.pathLV2,    true) << "</LV2_PATH>\n";
-        outSettings << "  <VST2_PATH>"   << xmlSafeString(options.pathVST2,   true) << "</VST2_PATH>\n";
-        outSettings << "  <GIG_PATH>"    << xmlSafeString(options.pathGIG,    true) << "</GIG_PATH>\n";
-        outSettings << "  <SF2_PATH>"    << xmlSafeString(options.pathSF2,    true) << "</SF2_PATH>\n";
-        outSettings << "  <SFZ_PATH>"    << xmlSafeString(options.pathSFZ,    true) << "</SFZ_PATH>\n";
+        settings.add("LADSPA_PATH"); settings.add(String(CharPointer_UTF8(options.pathLADSPA)));
+        settings.add("DSSI_PATH");   settings.add(String(CharPointer_UTF8(options.pathDSSI)));
+        settings.add("LV2_PATH");    settings.add(String(CharPointer_UTF8(options.pathLV2)));
+        settings.add("VST2_PATH");   settings.add(String(CharPointer_UTF8(options.pathVST2)));
+        settings.add("GIG_PATH");    settings.add(String(CharPointer_UTF8(options.pathGIG)));
+        settings.add("SF2_PATH");    settings.add(String(CharPointer_UTF8(options.pathSF2)));
+        settings.add("SFZ_PATH");    settings.add(String(CharPointer_UTF8(options.pathSFZ)));
     }
 
-    outSettings << " </EngineSettings>\n";
-    outStream << outSettings;
+    if (binaryWriter != nullptr)
+    {
+        for (int i=0; i+1 < settings.size(); i += 2)
+            binaryWriter->addEngineSetting(settings[i].toRawUTF8(), settings[i+1].toRawUTF8());
+    }
+    else
+    {
+        MemoryOutputStream outSettings(1024);
+
+        outSettings << " <EngineSettings>\n";
+
+        for (int i=0; i+1 < settings.size(); i += 2)
+            outSettings << "  <" << settings[i] << ">" << xmlSafeString(settings[i+1], true) << "</" << settings[i] << ">\n";
+
+        outSettings << " </EngineSettings>\n";
+        outStream << outSettings;
+    }
 
     char strBuf[STR_MAX+1];
 
@@ -1822,6 +1929,12 @@ void CarlaEngine::saveProjectInternal(water::MemoryOutputStream& outStream) cons
 
         if (plugin != nullptr && plugin->isEnabled())
         {
+            if (binaryWriter != nullptr)
+            {
+                binaryWriter->addStateSave(plugin->getStateSave(false, true));
+                continue;
+            }
+
             MemoryOutputStream outPlugin(4096), streamPlugin;
             plugin->getStateSave(false).dumpToMemoryStream(streamPlugin);
 
@@ -1855,26 +1968,10 @@ void CarlaEngine::saveProjectInternal(water::MemoryOutputStream& outStream) cons
     {
         if (const char* const* const patchbayConns = getPatchbayConnections(false))
         {
-            MemoryOutputStream outPatchbay(2048);
-
-            outPatchbay << "\n <Patchbay>\n";
-
-            for (int i=0; patchbayConns[i] != nullptr && patchbayConns[i+1] != nullptr; ++i, ++i )
-            {
-                const char* const connSource(patchbayConns[i]);
-                const char* const connTarget(patchbayConns[i+1]);
-
-                CARLA_SAFE_ASSERT_CONTINUE(connSource != nullptr && connSource[0] != '\0');
-                CARLA_SAFE_ASSERT_CONTINUE(connTarget != nullptr && connTarget[0] != '\0');
-
-                outPatchbay << "  <Connection>\n";
-                outPatchbay << "   <Source>" << xmlSafeString(connSource, true) << "</Source>\n";
-                outPatchbay << "   <Target>" << xmlSafeString(connTarget, true) << "</Target>\n";
-                outPatchbay << "  </Connection>\n";
-            }
-
-            outPatchbay << " </Patchbay>\n";
-            outStream << outPatchbay;
+            if (binaryWriter != nullptr)
+                binaryWriter->addConnections(false, patchbayConns);
+            else
+                saveProjectConnections(outStream, "Patchbay", patchbayConns);
         }
     }
 
@@ -1898,30 +1995,20 @@ void CarlaEngine::saveProjectInternal(water::MemoryOutputStream& outStream) cons
     {
         if (const char* const* const patchbayConns = getPatchbayConnections(true))
         {
-            MemoryOutputStream outPatchbay(2048);
-
-            outPatchbay << "\n <ExternalPatchbay>\n";
-
-            for (int i=0; patchbayConns[i] != nullptr && patchbayConns[i+1] != nullptr; ++i, ++i )
-            {
-                const char* const connSource(patchbayConns[i]);
-                const char* const connTarget(patchbayConns[i+1]);
-
-                CARLA_SAFE_ASSERT_CONTINUE(connSource != nullptr && connSource[0] != '\0');
-                CARLA_SAFE_ASSERT_CONTINUE(connTarget != nullptr && connTarget[0] != '\0');
-
-                outPatchbay << "  <Connection>\n";
-                outPatchbay << "   <Source>" << xmlSafeString(connSource, true) << "</Source>\n";
-                outPatchbay << "   <Target>" << xmlSafeString(connTarget, true) << "</Target>\n";
-                outPatchbay << "  </Connection>\n";
-            }
-
-            outPatchbay << " </ExternalPatchbay>\n";
-            outStream << outPatchbay;
+            if (binaryWriter != nullptr)
+                binaryWriter->addConnections(true, patchbayConns);
+            else
+                saveProjectConnections(outStream, "ExternalPatchbay", patchbayConns);
         }
     }
 #endif
 
+    if (binaryWriter != nullptr)
+    {
+        CARLA_SAFE_ASSERT(binaryWriter->writeToStream(outStream));
+        return;
+    }
+
     outStream << "</CARLA-PROJECT>\n";
 }
 
@@ -1989,6 +2076,463 @@ static String findBinaryInCustomPath(const char* const searchPath, const char* c
     return String();
 }
 
+// -----------------------------------------------------------------------
+// Project loading helpers
+
+// number of threads used to look for plugin binaries and restore plugin states while loading a project,
+// one per CPU core but never more than there are jobs to run
+static uint getProjectLoadThreadCount(const uint maxJobs) noexcept
+{
+#ifdef CARLA_OS_WIN
+    SYSTEM_INFO systemInfo;
+    GetSystemInfo(&systemInfo);
+    const long numCores = static_cast<long>(systemInfo.dwNumberOfProcessors);
+#else
+    const long numCores = ::sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+
+    const uint numThreads = numCores > 0 ? static_cast<uint>(numCores) : 1U;
+
+    return numThreads < maxJobs ? numThreads : maxJobs;
+}
+
+// A plugin from a project file, going through the loading steps.
+struct ProjectPluginLoad {
+    CarlaStateSave stateSave;
+    PluginType     ptype;
+    const void*    extraStuff;
+
+    // where to look for the plugin binary, if the saved one does not exist on this system
+    CarlaString searchPath;
+    CarlaString envSearchPath;
+
+    CarlaPlugin* plugin;
+    uint         pluginId;
+    uint64_t     loadTimeNs;
+    bool         restoredOnLoaderThread;
+
+    ProjectPluginLoad() noexcept
+        : stateSave(),
+          ptype(PLUGIN_NONE),
+          extraStuff(nullptr),
+          searchPath(),
+          envSearchPath(),
+          plugin(nullptr),
+          pluginId(0),
+          loadTimeNs(0),
+          restoredOnLoaderThread(false) {}
+
+    void prepare(const EngineOptions& options)
+    {
+        static const char kTrue[] = "true";
+
+        ptype = getPluginTypeFromString(stateSave.type);
+
+        switch (ptype)
+        {
+        case PLUGIN_GIG:
+        case PLUGIN_SF2:
+            if (CarlaString(stateSave.label).endsWith(" (16 outs)"))
+                extraStuff = kTrue;
+            // fall through
+        case PLUGIN_LADSPA:
+        case PLUGIN_DSSI:
+        case PLUGIN_VST2:
+        case PLUGIN_SFZ:
+            if (stateSave.binary != nullptr && stateSave.binary[0] != '\0' &&
+                ! (File::isAbsolutePath(stateSave.binary) && File(stateSave.binary).exists()))
+            {
+                switch (ptype)
+                {
+                case PLUGIN_LADSPA:
+                    searchPath    = options.pathLADSPA;
+                    envSearchPath = std::getenv("LADSPA_PATH");
+                    break;
+                case PLUGIN_DSSI:
+                    searchPath    = options.pathDSSI;
+                    envSearchPath = std::getenv("DSSI_PATH");
+                    break;
+                case PLUGIN_VST2:
+                    searchPath    = options.pathVST2;
+                    envSearchPath = std::getenv("VST_PATH");
+                    break;
+                case PLUGIN_GIG:
+                    searchPath    = options.pathGIG;
+                    envSearchPath = std::getenv("GIG_PATH");
+                    break;
+                case PLUGIN_SF2:
+                    searchPath    = options.pathSF2;
+                    envSearchPath = std::getenv("SF2_PATH");
+                    break;
+                case PLUGIN_SFZ:
+                    searchPath    = options.pathSFZ;
+                    envSearchPath = std::getenv("SFZ_PATH");
+                    break;
+                default:
+                    break;
+                }
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    bool needsBinarySearch() const noexcept
+    {
+        return searchPath.isNotEmpty();
+    }
+
+    // does not touch the engine, safe to call from a loader thread
+    void findBinary()
+    {
+        const uint64_t start = carla_gettime_ns();
+
+        carla_stderr("Plugin binary '%s' doesn't exist on this filesystem, let's look for it...", stateSave.binary);
+
+        String result = findBinaryInCustomPath(searchPath, stateSave.binary);
+
+        if (result.isEmpty() && envSearchPath.isNotEmpty())
+            result = findBinaryInCustomPath(envSearchPath, stateSave.binary);
+
+        if (result.isNotEmpty())
+        {
+            delete[] stateSave.binary;
+            stateSave.binary = carla_strdup(result.toRawUTF8());
+            carla_stderr("Found it! :)");
+        }
+        else
+        {
+            carla_stderr("Damn, we failed... :(");
+        }
+
+        loadTimeNs += carla_gettime_ns() - start;
+    }
+
+    /*
+     * The OSC control client only learns about the plugin once the project is loaded, so nothing is sent there.
+     * Engine callbacks are only sent when restoring on the main thread, as CarlaEngine::callback() is not thread-safe.
+     */
+    void restoreState()
+    {
+        const uint64_t start = carla_gettime_ns();
+
+        plugin->loadStateSave(stateSave, false, ! restoredOnLoaderThread);
+
+        loadTimeNs += carla_gettime_ns() - start;
+    }
+
+    /*
+     * Restoring a state calls into the plugin from a loader thread,
+     * only do it for plugins known to cope with that.
+     */
+    bool canRestoreStateOnLoaderThread() const noexcept
+    {
+        const uint hints(plugin->getHints());
+
+        if (hints & PLUGIN_NEEDS_UI_MAIN_THREAD)
+            return false;
+        if (hints & PLUGIN_IS_BRIDGE)
+            return true;
+
+        switch (plugin->getType())
+        {
+        case PLUGIN_INTERNAL:
+            // carla-rack and carla-patchbay load a whole project of their own
+            return ! (CarlaString(stateSave.label).startsWith("carlarack") ||
+                      CarlaString(stateSave.label).startsWith("carlapatchbay"));
+        case PLUGIN_SF2:
+        case PLUGIN_SFZ:
+        case PLUGIN_GIG:
+            return true;
+        case PLUGIN_LV2:
+            // LV2 presets are loaded through the global lilv world, which is not thread-safe
+            return stateSave.currentProgramIndex < 0;
+        default:
+            return false;
+        }
+    }
+
+    CARLA_DECLARE_NON_COPY_STRUCT(ProjectPluginLoad)
+};
+
+// A few threads running project loading jobs, in the order they were added.
+class ProjectLoadThreads
+{
+public:
+    enum JobType {
+        kJobFindBinary,
+        kJobRestoreState
+    };
+
+    // threads are only started once the first job is added, 'maxJobs' is used for deciding how many
+    ProjectLoadThreads(const uint maxJobs) noexcept
+        : fMutex(),
+          fSignal(),
+          fJobs(),
+          fPending(0),
+          fClosing(false),
+          fNumThreads(getProjectLoadThreadCount(maxJobs)),
+          fThreads(nullptr) {}
+
+    ~ProjectLoadThreads() noexcept
+    {
+        if (fThreads == nullptr)
+            return;
+
+        {
+            const CarlaMutexLocker cml(fMutex);
+            fClosing = true;
+        }
+
+        fSignal.signal();
+
+        for (uint i=0; i < fNumThreads; ++i)
+        {
+            if (fThreads[i] == nullptr)
+                continue;
+
+            fThreads[i]->stopThread(-1);
+            delete fThreads[i];
+        }
+
+        delete[] fThreads;
+    }
+
+    void addJob(ProjectPluginLoad* const load, const JobType type) noexcept
+    {
+        if (fThreads == nullptr)
+        {
+            if (fNumThreads != 0)
+            {
+                try {
+                    fThreads = new LoaderThread*[fNumThreads];
+                } CARLA_SAFE_EXCEPTION("ProjectLoadThreads::addJob");
+            }
+
+            // no threads at all, do it ourselves
+            if (fThreads == nullptr)
+                return runJob(load, type);
+
+            carla_zeroPointers(fThreads, fNumThreads);
+
+            for (uint i=0; i < fNumThreads; ++i)
+            {
+                try {
+                    fThreads[i] = new LoaderThread(*this);
+                } CARLA_SAFE_EXCEPTION_BREAK("ProjectLoadThreads::addJob");
+
+                fThreads[i]->startThread();
+            }
+
+            if (fThreads[0] == nullptr)
+                return runJob(load, type);
+        }
+
+        const Job job = { load, type };
+
+        {
+            const CarlaMutexLocker cml(fMutex);
+
+            if (! fJobs.append(job))
+                return runJob(load, type);
+
+            ++fPending;
+        }
+
+        fSignal.signal();
+    }
+
+    /*
+     * Wait until all jobs are done, keeping the frontend responsive meanwhile.
+     */
+    void waitForJobs(CarlaEngine* const engine)
+    {
+        for (;;)
+        {
+            {
+                const CarlaMutexLocker cml(fMutex);
+
+                if (fPending == 0)
+                    break;
+            }
+
+            engine->callback(ENGINE_CALLBACK_IDLE, 0, 0, 0, 0.0f, nullptr);
+            carla_msleep(5);
+        }
+    }
+
+private:
+    struct Job {
+        ProjectPluginLoad* load;
+        JobType type;
+    };
+
+    class LoaderThread : public CarlaThread
+    {
+    public:
+        LoaderThread(ProjectLoadThreads& threads) noexcept
+            : CarlaThread("ProjectLoadThread"),
+              kThreads(threads) {}
+
+    protected:
+        void run() override
+        {
+            kThreads.runJobs();
+        }
+
+    private:
+        ProjectLoadThreads& kThreads;
+
+        CARLA_DECLARE_NON_COPY_CLASS(LoaderThread)
+    };
+
+    CarlaMutex  fMutex;
+    CarlaSignal fSignal;
+    LinkedList<Job> fJobs;
+    uint fPending;
+    bool fClosing;
+
+    const uint fNumThreads;
+    LoaderThread** fThreads;
+
+    static void runJob(ProjectPluginLoad* const load, const JobType type)
+    {
+        try {
+            switch (type)
+            {
+            case kJobFindBinary:
+                load->findBinary();
+                break;
+            case kJobRestoreState:
+                load->restoreState();
+                break;
+            }
+        } CARLA_SAFE_EXCEPTION("ProjectLoadThreads::runJob");
+    }
+
+    void runJobs()
+    {
+        static Job kFallback = { nullptr, kJobFindBinary };
+
+        for (;;)
+        {
+            Job job;
+            bool hasMoreJobs;
+
+            {
+                const CarlaMutexLocker cml(fMutex);
+
+                if (fJobs.isEmpty())
+                {
+                    if (fClosing)
+                        break;
+
+                    job.load = nullptr;
+                }
+                else
+                {
+                    job = fJobs.getFirst(kFallback, true);
+                }
+
+                hasMoreJobs = ! fJobs.isEmpty();
+            }
+
+            if (job.load == nullptr)
+            {
+                fSignal.wait();
+                continue;
+            }
+
+            // the signal only wakes up one thread at a time, pass it on
+            if (hasMoreJobs)
+                fSignal.signal();
+
+            runJob(job.load, job.type);
+
+            const CarlaMutexLocker cml(fMutex);
+            --fPending;
+        }
+
+        // let the other threads know we are closing
+        fSignal.signal();
+    }
+
+    CARLA_DECLARE_NON_COPY_CLASS(ProjectLoadThreads)
+};
+
+// -----------------------------------------------------------------------
+
+// Everything read from a project or preset file, in either format.
+struct CarlaEngine::ProjectLoadData {
+    bool isPreset;
+
+    // engine setting names and values
+    StringArray engineSettings;
+
+    // plugins in project order, states are already filled
+    OwnedArray<ProjectPluginLoad> loads;
+
+    // connection sources and targets, only used if the project saved them
+    bool hasPatchbay;
+    bool hasExternalPatchbay;
+    StringArray patchbay;
+    StringArray externalPatchbay;
+
+    ProjectLoadData(const bool preset)
+        : isPreset(preset),
+          engineSettings(),
+          loads(),
+          hasPatchbay(false),
+          hasExternalPatchbay(false),
+          patchbay(),
+          externalPatchbay() {}
+
+    CARLA_DECLARE_NON_COPY_STRUCT(ProjectLoadData)
+};
+
+static void getProjectConnections(const XmlElement* const xmlElement, StringArray& connections)
+{
+    CarlaString sourcePort, targetPort;
+
+    for (XmlElement* patchElem = xmlElement->getFirstChildElement(); patchElem != nullptr; patchElem = patchElem->getNextElement())
+    {
+        const String& patchTag(patchElem->getTagName());
+
+        sourcePort.clear();
+        targetPort.clear();
+
+        if (! patchTag.equalsIgnoreCase("connection"))
+            continue;
+
+        for (XmlElement* connElem = patchElem->getFirstChildElement(); connElem != nullptr; connElem = connElem->getNextElement())
+        {
+            const String& tag(connElem->getTagName());
+            const String  text(connElem->getAllSubText().trim());
+
+            /**/ if (tag.equalsIgnoreCase("source"))
+                sourcePort = xmlSafeString(text, false).toRawUTF8();
+            else if (tag.equalsIgnoreCase("target"))
+                targetPort = xmlSafeString(text, false).toRawUTF8();
+        }
+
+        if (sourcePort.isNotEmpty() && targetPort.isNotEmpty())
+        {
+            connections.add(sourcePort.buffer());
+            connections.add(targetPort.buffer());
+        }
+    }
+}
+
+static void getProjectConnections(const std::vector<const char*>& sourcesAndTargets, StringArray& connections)
+{
+    for (std::size_t i=0; i+1 < sourcesAndTargets.size(); i += 2)
+    {
+        connections.add(String(CharPointer_UTF8(sourcesAndTargets[i])));
+        connections.add(String(CharPointer_UTF8(sourcesAndTargets[i+1])));
+    }
+}
+
 bool CarlaEngine::loadProjectInternal(water::XmlDocument& xmlDoc)
 {
     ScopedPointer<XmlElement> xmlElement(xmlDoc.getDocumentElement(true));
@@ -2004,31 +2548,113 @@ bool CarlaEngine::loadProjectInternal(water::XmlDocument& xmlDoc)
         return false;
     }
 
-#ifndef BUILD_BRIDGE
-    const ScopedValueSetter<bool> _svs(pData->loadingProject, true, false);
-#endif
-
     // completely load file
     xmlElement = xmlDoc.getDocumentElement(false);
     CARLA_SAFE_ASSERT_RETURN_ERR(xmlElement != nullptr, "Failed to completely parse project file");
 
+    ProjectLoadData data(isPreset);
+
+    for (XmlElement* elem = xmlElement->getFirstChildElement(); elem != nullptr; elem = elem->getNextElement())
+    {
+        const String& tagName(elem->getTagName());
+
+        if (isPreset || tagName.equalsIgnoreCase("plugin"))
+        {
+            ScopedPointer<ProjectPluginLoad> load(new ProjectPluginLoad());
+            load->stateSave.fillFromXmlElement(isPreset ? xmlElement.get() : elem);
+            CARLA_SAFE_ASSERT_CONTINUE(load->stateSave.type != nullptr);
+
+            data.loads.add(load.release());
+
+            if (isPreset)
+                break;
+        }
+        else if (tagName.equalsIgnoreCase("enginesettings") && data.engineSettings.size() == 0)
+        {
+            for (XmlElement* settElem = elem->getFirstChildElement(); settElem != nullptr; settElem = settElem->getNextElement())
+            {
+                data.engineSettings.add(settElem->getTagName());
+                data.engineSettings.add(settElem->getAllSubText().trim());
+            }
+        }
+        else if (tagName.equalsIgnoreCase("patchbay") && ! data.hasPatchbay)
+        {
+            data.hasPatchbay = true;
+            getProjectConnections(elem, data.patchbay);
+        }
+        else if (tagName.equalsIgnoreCase("externalpatchbay") && ! data.hasExternalPatchbay)
+        {
+            data.hasExternalPatchbay = true;
+            getProjectConnections(elem, data.externalPatchbay);
+        }
+    }
+
+    return loadProjectInternal(data);
+}
+
+bool CarlaEngine::loadProjectInternal(const CarlaBinaryStateFile& binaryState)
+{
+    ProjectLoadData data(binaryState.isPreset());
+
+    const uint32_t pluginCount = binaryState.getPluginCount();
+
+    for (uint32_t i=0; i < pluginCount; ++i)
+    {
+        ScopedPointer<ProjectPluginLoad> load(new ProjectPluginLoad());
+        CARLA_SAFE_ASSERT_CONTINUE(binaryState.fillStateSave(i, load->stateSave));
+        CARLA_SAFE_ASSERT_CONTINUE(load->stateSave.type != nullptr);
+
+        data.loads.add(load.release());
+
+        if (data.isPreset)
+            break;
+    }
+
+    std::vector<const char*> strings;
+
+    if (binaryState.getEngineSettings(strings))
+    {
+        for (std::size_t i=0; i+1 < strings.size(); i += 2)
+        {
+            data.engineSettings.add(String(CharPointer_UTF8(strings[i])));
+            data.engineSettings.add(String(CharPointer_UTF8(strings[i+1])));
+        }
+    }
+
+    if (binaryState.getConnections(false, strings))
+    {
+        data.hasPatchbay = true;
+        getProjectConnections(strings, data.patchbay);
+    }
+
+    if (binaryState.getConnections(true, strings))
+    {
+        data.hasExternalPatchbay = true;
+        getProjectConnections(strings, data.externalPatchbay);
+    }
+
+    return loadProjectInternal(data);
+}
+
+bool CarlaEngine::loadProjectInternal(ProjectLoadData& data)
+{
+    const bool isPreset(data.isPreset);
+
+#ifndef BUILD_BRIDGE
+    const ScopedValueSetter<bool> _svs(pData->loadingProject, true, false);
+#endif
+
     if (pData->aboutToClose)
         return true;
 
     const bool isPlugin(getType() == kEngineTypePlugin);
 
     // engine settings
-    for (XmlElement* elem = xmlElement->getFirstChildElement(); elem != nullptr; elem = elem->getNextElement())
     {
-        const String& tagName(elem->getTagName());
-
-        if (! tagName.equalsIgnoreCase("enginesettings"))
-            continue;
-
-        for (XmlElement* settElem = elem->getFirstChildElement(); settElem != nullptr; settElem = settElem->getNextElement())
+        for (int i=0; i+1 < data.engineSettings.size(); i += 2)
         {
-            const String& tag(settElem->getTagName());
-            const String  text(settElem->getAllSubText().trim());
+            const String& tag(data.engineSettings[i]);
+            const String& text(data.engineSettings[i+1]);
 
            /** some settings might be incorrect or require extra work,
                so we call setOption rather than modifying them direly */
@@ -2117,158 +2743,184 @@ bool CarlaEngine::loadProjectInternal(water::XmlDocument& xmlDoc)
 
             setOption(static_cast<EngineOption>(option), value, valueStr);
         }
-
-        break;
     }
 
     if (pData->aboutToClose)
         return true;
 
-    // handle plugins first
-    for (XmlElement* elem = xmlElement->getFirstChildElement(); elem != nullptr; elem = elem->getNextElement())
+    // handle plugins first, their states were all parsed up front
+    OwnedArray<ProjectPluginLoad>& loads(data.loads);
+
+    for (int i=0; i < loads.size(); ++i)
+        loads.getUnchecked(i)->prepare(pData->options);
+
+    // plugin binaries that moved can take a while to find, look for all of them at once
     {
-        const String& tagName(elem->getTagName());
+        uint numSearches = 0;
 
-        if (isPreset || tagName.equalsIgnoreCase("plugin"))
+        for (int i=0; i < loads.size(); ++i)
         {
-            CarlaStateSave stateSave;
-            stateSave.fillFromXmlElement(isPreset ? xmlElement.get() : elem);
+            if (loads.getUnchecked(i)->needsBinarySearch())
+                ++numSearches;
+        }
 
-            callback(ENGINE_CALLBACK_IDLE, 0, 0, 0, 0.0f, nullptr);
+        ProjectLoadThreads loadThreads(numSearches);
 
-            if (pData->aboutToClose)
-                return true;
+        for (int i=0; i < loads.size(); ++i)
+        {
+            if (loads.getUnchecked(i)->needsBinarySearch())
+                loadThreads.addJob(loads.getUnchecked(i), ProjectLoadThreads::kJobFindBinary);
+        }
 
-            CARLA_SAFE_ASSERT_CONTINUE(stateSave.type != nullptr);
+        loadThreads.waitForJobs(this);
+    }
 
-            const void* extraStuff    = nullptr;
-            static const char kTrue[] = "true";
+    if (pData->aboutToClose)
+        return true;
 
-            const PluginType ptype(getPluginTypeFromString(stateSave.type));
+    // Add plugins in project order, the main thread creates them while loader threads restore their state.
+    // Plugins stay disabled until everything is loaded.
+    //
+    // Creating plugins is not done on the loader threads, as it goes through engine calls that are not thread-safe:
+    // unique plugin names are picked from the plugins already added, engine clients get registered,
+    // errors are reported through setLastError() and bridges run the engine idle while waiting for their process.
+    // This holds for every format, even those whose own instantiate call could run off the main thread
+    // (LV2, LADSPA, DSSI and internal plugins), so only binary searches and state restores are done concurrently.
+    {
+#ifndef BUILD_BRIDGE
+        // plugins get counted before being enabled, keep the engine thread away from them meanwhile
+        const ScopedThreadStopper sts(this);
+#endif
 
-            switch (ptype)
+        {
+            ProjectLoadThreads loadThreads(static_cast<uint>(loads.size()));
+
+            for (int i=0; i < loads.size(); ++i)
             {
-            case PLUGIN_GIG:
-            case PLUGIN_SF2:
-                if (CarlaString(stateSave.label).endsWith(" (16 outs)"))
-                    extraStuff = kTrue;
-                // fall through
-            case PLUGIN_LADSPA:
-            case PLUGIN_DSSI:
-            case PLUGIN_VST2:
-            case PLUGIN_SFZ:
-                if (stateSave.binary != nullptr && stateSave.binary[0] != '\0' &&
-                    ! (File::isAbsolutePath(stateSave.binary) && File(stateSave.binary).exists()))
+                ProjectPluginLoad* const load(loads.getUnchecked(i));
+                const CarlaStateSave& stateSave(load->stateSave);
+
+                callback(ENGINE_CALLBACK_IDLE, 0, 0, 0, 0.0f, nullptr);
+
+                if (pData->aboutToClose)
+                    break;
+
+                const uint64_t start = carla_gettime_ns();
+
+                if (! addPlugin(getBinaryTypeFromFile(stateSave.binary), load->ptype, stateSave.binary,
+                                stateSave.name, stateSave.label, stateSave.uniqueId, load->extraStuff, stateSave.options))
                 {
-                    const char* searchPath;
-
-                    switch (ptype)
-                    {
-                    case PLUGIN_LADSPA: searchPath = pData->options.pathLADSPA; break;
-                    case PLUGIN_DSSI:   searchPath = pData->options.pathDSSI;   break;
-                    case PLUGIN_VST2:   searchPath = pData->options.pathVST2;   break;
-                    case PLUGIN_GIG:    searchPath = pData->options.pathGIG;    break;
-                    case PLUGIN_SF2:    searchPath = pData->options.pathSF2;    break;
-                    case PLUGIN_SFZ:    searchPath = pData->options.pathSFZ;    break;
-                    default:            searchPath = nullptr;                   break;
-                    }
-
-                    if (searchPath != nullptr && searchPath[0] != '\0')
-                    {
-                        carla_stderr("Plugin binary '%s' doesn't exist on this filesystem, let's look for it...",
-                                     stateSave.binary);
-
-                        String result = findBinaryInCustomPath(searchPath, stateSave.binary);
-
-                        if (result.isEmpty())
-                        {
-                            switch (ptype)
-                            {
-                            case PLUGIN_LADSPA: searchPath = std::getenv("LADSPA_PATH"); break;
-                            case PLUGIN_DSSI:   searchPath = std::getenv("DSSI_PATH");   break;
-                            case PLUGIN_VST2:   searchPath = std::getenv("VST_PATH");    break;
-                            case PLUGIN_GIG:    searchPath = std::getenv("GIG_PATH");    break;
-                            case PLUGIN_SF2:    searchPath = std::getenv("SF2_PATH");    break;
-                            case PLUGIN_SFZ:    searchPath = std::getenv("SFZ_PATH");    break;
-                            default:            searchPath = nullptr;                    break;
-                            }
-
-                            if (searchPath != nullptr && searchPath[0] != '\0')
-                                result = findBinaryInCustomPath(searchPath, stateSave.binary);
-                        }
-
-                        if (result.isNotEmpty())
-                        {
-                            delete[] stateSave.binary;
-                            stateSave.binary = carla_strdup(result.toRawUTF8());
-                            carla_stderr("Found it! :)");
-                        }
-                        else
-                        {
-                            carla_stderr("Damn, we failed... :(");
-                        }
-                    }
+                    carla_stderr2("Failed to load a plugin, error was:\n%s", getLastError());
+                    continue;
                 }
-                break;
-            default:
-                break;
-            }
 
-            if (addPlugin(getBinaryTypeFromFile(stateSave.binary), ptype, stateSave.binary,
-                          stateSave.name, stateSave.label, stateSave.uniqueId, extraStuff, stateSave.options))
-            {
 #ifndef BUILD_BRIDGE
                 const uint pluginId = pData->curPluginCount;
 #else
                 const uint pluginId = 0;
 #endif
 
-                if (CarlaPlugin* const plugin = pData->plugins[pluginId].plugin)
-                {
-                    callback(ENGINE_CALLBACK_IDLE, 0, 0, 0, 0.0f, nullptr);
-
-                    if (pData->aboutToClose)
-                        return true;
+                CarlaPlugin* const plugin = pData->plugins[pluginId].plugin;
 
-                    // deactivate bridge client-side ping check, since some plugins block during load
-                    if ((plugin->getHints() & PLUGIN_IS_BRIDGE) != 0 && ! isPreset)
-                        plugin->setCustomData(CUSTOM_DATA_TYPE_STRING, "__CarlaPingOnOff__", "false", false);
+                if (plugin == nullptr)
+                {
+                    carla_stderr2("Failed to get new plugin, state will not be restored correctly\n");
+                    continue;
+                }
 
-                    plugin->loadStateSave(stateSave);
+                load->plugin   = plugin;
+                load->pluginId = pluginId;
+                load->loadTimeNs += carla_gettime_ns() - start;
 
-                    /* NOTE: The following code is the same as the end of addPlugin().
-                     *       When project is loading we do not enable the plugin right away,
-                     *        as we want to load state first.
-                     */
-#ifdef BUILD_BRIDGE
-                    plugin->setActive(true, true, false);
-#else
-                    ++pData->curPluginCount;
+#ifndef BUILD_BRIDGE
+                // take the slot now, so the next plugin gets its own id
+                ++pData->curPluginCount;
 #endif
 
-                    plugin->setEnabled(true);
-                    callback(ENGINE_CALLBACK_PLUGIN_ADDED, pluginId, 0, 0, 0.0f, plugin->getName());
+                // deactivate bridge client-side ping check, since some plugins block during load
+                if ((plugin->getHints() & PLUGIN_IS_BRIDGE) != 0 && ! isPreset)
+                    plugin->setCustomData(CUSTOM_DATA_TYPE_STRING, "__CarlaPingOnOff__", "false", false);
 
-#ifndef BUILD_BRIDGE
-                    if (pData->options.processMode == ENGINE_PROCESS_MODE_PATCHBAY)
-                        pData->graph.addPlugin(plugin);
-#endif
+                if (load->canRestoreStateOnLoaderThread())
+                {
+                    load->restoredOnLoaderThread = true;
+                    loadThreads.addJob(load, ProjectLoadThreads::kJobRestoreState);
                 }
                 else
                 {
-                    carla_stderr2("Failed to get new plugin, state will not be restored correctly\n");
+                    load->restoreState();
                 }
             }
-            else
+
+            loadThreads.waitForJobs(this);
+        }
+
+        if (pData->aboutToClose)
+        {
+#ifndef BUILD_BRIDGE
+            // these were never enabled nor announced, give their slots back
+            for (int i=loads.size(); --i >= 0;)
             {
-                carla_stderr2("Failed to load a plugin, error was:\n%s", getLastError());
+                ProjectPluginLoad* const load(loads.getUnchecked(i));
+
+                if (load->plugin == nullptr)
+                    continue;
+
+                CARLA_SAFE_ASSERT_CONTINUE(load->pluginId + 1 == pData->curPluginCount);
+
+                {
+                    const ScopedActionLock sal(this, kEnginePostActionRemovePlugin, load->pluginId, 0, isRunning());
+                }
+
+                delete load->plugin;
+                load->plugin = nullptr;
             }
+#endif
+            return true;
         }
 
-        if (isPreset)
-            return true;
+        for (int i=0; i < loads.size(); ++i)
+        {
+            const ProjectPluginLoad* const load(loads.getUnchecked(i));
+            CarlaPlugin* const plugin(load->plugin);
+
+            if (plugin == nullptr)
+                continue;
+
+            // what loadStateSave() could not send from the loader thread
+            if (load->restoredOnLoaderThread)
+                callback(ENGINE_CALLBACK_UPDATE, load->pluginId, 0, 0, 0.0f, nullptr);
+
+            /* NOTE: The following code is the same as the end of addPlugin().
+             *       When project is loading we do not enable the plugin right away,
+             *        as we want to load state first.
+             */
+#ifdef BUILD_BRIDGE
+            plugin->setActive(true, true, false);
+#endif
+
+            plugin->setEnabled(true);
+
+            const float loadTimeMs = static_cast<float>(static_cast<double>(load->loadTimeNs) / 1000000.0);
+            carla_debug("Plugin '%s' took %.1f ms to load", plugin->getName(), static_cast<double>(loadTimeMs));
+
+            callback(ENGINE_CALLBACK_PLUGIN_ADDED, load->pluginId, 0, 0, loadTimeMs, plugin->getName());
+
+#ifndef BUILD_BRIDGE
+# ifdef HAVE_LIBLO
+            // sends the restored state too
+            plugin->registerToOscClient();
+# endif
+
+            if (pData->options.processMode == ENGINE_PROCESS_MODE_PATCHBAY)
+                pData->graph.addPlugin(plugin);
+#endif
+        }
     }
 
+    if (isPreset)
+        return true;
+
 #ifndef BUILD_BRIDGE
     // tell bridges we're done loading
     for (uint i=0; i < pData->curPluginCount; ++i)
@@ -2289,42 +2941,9 @@ bool CarlaEngine::loadProjectInternal(water::XmlDocument& xmlDoc)
     {
         const bool isUsingExternal(pData->graph.isUsingExternal());
 
-        for (XmlElement* elem = xmlElement->getFirstChildElement(); elem != nullptr; elem = elem->getNextElement())
-        {
-            const String& tagName(elem->getTagName());
-
-            // only load internal patchbay connections
-            if (! tagName.equalsIgnoreCase("patchbay"))
-                continue;
-
-            CarlaString sourcePort, targetPort;
-
-            for (XmlElement* patchElem = elem->getFirstChildElement(); patchElem != nullptr; patchElem = patchElem->getNextElement())
-            {
-                const String& patchTag(patchElem->getTagName());
-
-                sourcePort.clear();
-                targetPort.clear();
-
-                if (! patchTag.equalsIgnoreCase("connection"))
-                    continue;
-
-                for (XmlElement* connElem = patchElem->getFirstChildElement(); connElem != nullptr; connElem = connElem->getNextElement())
-                {
-                    const String& tag(connElem->getTagName());
-                    const String  text(connElem->getAllSubText().trim());
-
-                    /**/ if (tag.equalsIgnoreCase("source"))
-                        sourcePort = xmlSafeString(text, false).toRawUTF8();
-                    else if (tag.equalsIgnoreCase("target"))
-                        targetPort = xmlSafeString(text, false).toRawUTF8();
-                }
-
-                if (sourcePort.isNotEmpty() && targetPort.isNotEmpty())
-                    restorePatchbayConnection(false, sourcePort, targetPort, !isUsingExternal);
-            }
-            break;
-        }
+        // only load internal patchbay connections
+        for (int i=0; i+1 < data.patchbay.size(); i += 2)
+            restorePatchbayConnection(false, data.patchbay[i].toRawUTF8(), data.patchbay[i+1].toRawUTF8(), !isUsingExternal);
 
         callback(ENGINE_CALLBACK_IDLE, 0, 0, 0, 0.0f, nullptr);
 
@@ -2354,49 +2973,19 @@ bool CarlaEngine::loadProjectInternal(water::XmlDocument& xmlDoc)
         const bool isUsingExternal(pData->options.processMode != ENGINE_PROCESS_MODE_PATCHBAY ||
                                    pData->graph.isUsingExternal());
 
-        for (XmlElement* elem = xmlElement->getFirstChildElement(); elem != nullptr; elem = elem->getNextElement())
-        {
-            const String& tagName(elem->getTagName());
-
-            // check if we want to load patchbay-mode connections into an external (multi-client) graph
-            if (tagName.equalsIgnoreCase("patchbay"))
-            {
-                if (pData->options.processMode == ENGINE_PROCESS_MODE_PATCHBAY)
-                    continue;
-            }
-            // or load external patchbay connections
-            else if (! tagName.equalsIgnoreCase("externalpatchbay"))
-            {
-                continue;
-            }
-
-            CarlaString sourcePort, targetPort;
-
-            for (XmlElement* patchElem = elem->getFirstChildElement(); patchElem != nullptr; patchElem = patchElem->getNextElement())
-            {
-                const String& patchTag(patchElem->getTagName());
-
-                sourcePort.clear();
-                targetPort.clear();
-
-                if (! patchTag.equalsIgnoreCase("connection"))
-                    continue;
-
-                for (XmlElement* connElem = patchElem->getFirstChildElement(); connElem != nullptr; connElem = connElem->getNextElement())
-                {
-                    const String& tag(connElem->getTagName());
-                    const String  text(connElem->getAllSubText().trim());
+        // check if we want to load patchbay-mode connections into an external (multi-client) graph,
+        // or load external patchbay connections
+        const StringArray* connections = nullptr;
 
-                    /**/ if (tag.equalsIgnoreCase("source"))
-                        sourcePort = xmlSafeString(text, false).toRawUTF8();
-                    else if (tag.equalsIgnoreCase("target"))
-                        targetPort = xmlSafeString(text, false).toRawUTF8();
-                }
+        if (data.hasPatchbay && pData->options.processMode != ENGINE_PROCESS_MODE_PATCHBAY)
+            connections = &data.patchbay;
+        else if (data.hasExternalPatchbay)
+            connections = &data.externalPatchbay;
 
-                if (sourcePort.isNotEmpty() && targetPort.isNotEmpty())
-                    restorePatchbayConnection(true, sourcePort, targetPort, isUsingExternal);
-            }
-            break;
+        if (connections != nullptr)
+        {
+            for (int i=0; i+1 < connections->size(); i += 2)
+                restorePatchbayConnection(true, (*connections)[i].toRawUTF8(), (*connections)[i+1].toRawUTF8(), isUsingExternal);
         }
     }
 
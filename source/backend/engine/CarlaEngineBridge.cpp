@@ -32,12 +32,16 @@
 #endif
 
 #include "water/files/File.h"
+#include "water/files/FileInputStream.h"
+#include "water/files/FileOutputStream.h"
 #include "water/misc/Time.h"
 
 // must be last
 #include "jackbridge/JackBridge.hpp"
 
 using water::File;
+using water::FileInputStream;
+using water::FileOutputStream;
 using water::MemoryBlock;
 using water::String;
 using water::Time;
@@ -795,11 +799,17 @@ public:
                 File chunkFile(chunkFilePath);
                 CARLA_SAFE_ASSERT_BREAK(chunkFile.existsAsFile());
 
-                String chunkDataBase64(chunkFile.loadFileAsString());
-                chunkFile.deleteFile();
-                CARLA_SAFE_ASSERT_BREAK(chunkDataBase64.isNotEmpty());
+                std::vector<uint8_t> chunk;
+
+                {
+                    FileInputStream stream(chunkFile);
+                    CARLA_SAFE_ASSERT_BREAK(stream.openedOk());
 
-                std::vector<uint8_t> chunk(carla_getChunkFromBase64String(chunkDataBase64.toRawUTF8()));
+                    chunk = carla_getChunkFromBase64Stream(stream, static_cast<std::size_t>(stream.getTotalLength()));
+                }
+
+                chunkFile.deleteFile();
+                CARLA_SAFE_ASSERT_BREAK(chunk.size() > 0);
 
 #ifdef CARLA_PROPER_CPP11_SUPPORT
                 plugin->setChunkData(chunk.data(), chunk.size());
@@ -895,15 +905,27 @@ public:
                     {
                         CARLA_SAFE_ASSERT_BREAK(data != nullptr);
 
-                        CarlaString dataBase64 = CarlaString::asBase64(data, dataSize);
-                        CARLA_SAFE_ASSERT_BREAK(dataBase64.length() > 0);
-
                         String filePath(File::getSpecialLocation(File::tempDirectory).getFullPathName());
 
                         filePath += CARLA_OS_SEP_STR ".CarlaChunk_";
                         filePath += fShmAudioPool.getFilenameSuffix();
 
-                        if (File(filePath).replaceWithText(dataBase64.buffer()))
+                        bool written;
+
+                        {
+                            // encode straight into the file, without a full base64 copy in memory
+                            const File chunkFile(filePath);
+                            chunkFile.deleteFile(); // streams append to existing files
+
+                            FileOutputStream stream(chunkFile);
+
+                            written = stream.openedOk() && carla_writeBase64ToStream(stream, data, dataSize);
+
+                            stream.flush();
+                            written = written && stream.getStatus().wasOk();
+                        }
+
+                        if (written)
                         {
                             const uint32_t ulength(static_cast<uint32_t>(filePath.length()));
 
@@ -1237,8 +1259,7 @@ protected:
                     carla_zeroBytes(midiData, kBridgeBaseMidiOutHeaderSize);
                     std::size_t curMidiDataPos = 0;
 
-                    if (pData->events.in[0].type != kEngineEventTypeNull)
-                        carla_zeroStructs(pData->events.in, kMaxEngineEventInternalCount);
+                    clearEngineEvents(pData->events.in);
 
                     if (pData->events.out[0].type != kEngineEventTypeNull)
                     {
@@ -1313,7 +1334,7 @@ protected:
                             curMidiDataPos + kBridgeBaseMidiOutHeaderSize < kBridgeRtClientDataMidiOutSize)
                             carla_zeroBytes(midiData, kBridgeBaseMidiOutHeaderSize);
 
-                        carla_zeroStructs(pData->events.out, kMaxEngineEventInternalCount);
+                        clearEngineEvents(pData->events.out);
                     }
 
                 }   break;
@@ -17,6 +17,7 @@
 
 #include "CarlaEngine.hpp"
 #include "CarlaMathUtils.hpp"
+#include "CarlaSemUtils.hpp"
 #include "CarlaMIDI.h"
 
 CARLA_BACKEND_START_NAMESPACE
@@ -185,6 +186,7 @@ EngineOptions::EngineOptions() noexcept
       transportExtra(nullptr),
       forceStereo(false),
       preferPluginBridges(false),
+      pipelinedPluginBridges(false),
 #if defined(CARLA_OS_MAC) || defined(CARLA_OS_WIN)
       preferUiBridges(false),
 #else
@@ -196,6 +198,9 @@ EngineOptions::EngineOptions() noexcept
       audioNumPeriods(2),
       audioBufferSize(512),
       audioSampleRate(44100),
+      audioWorkerThreads(0),
+      minSubBlockSize(0),
+      bridgesSpinTime(kCarlaSemDefaultSpinUsecs),
       audioDevice(nullptr),
       pathLADSPA(nullptr),
       pathDSSI(nullptr),
@@ -647,6 +647,86 @@ void RackGraph::Buffers::setBufferSize(const uint32_t bufferSize, const bool cre
     }
 }
 
+// -----------------------------------------------------------------------
+// RackGraph ParallelLayer
+
+RackGraph::ParallelLayer::ParallelLayer() noexcept
+    : plugins(nullptr),
+      outBufs(nullptr),
+      maxCount(0),
+      count(0),
+      nextIndex(0),
+      inBuf(nullptr),
+      frames(0) {}
+
+RackGraph::ParallelLayer::~ParallelLayer() noexcept
+{
+    setBufferSize(0, 0);
+}
+
+void RackGraph::ParallelLayer::setBufferSize(const uint32_t bufferSize, const uint maxPlugins) noexcept
+{
+    if (outBufs != nullptr)
+    {
+        for (uint i=0; i < maxCount*2; ++i)
+            delete[] outBufs[i];
+
+        delete[] outBufs;
+        outBufs = nullptr;
+    }
+
+    if (plugins != nullptr)
+    {
+        delete[] plugins;
+        plugins = nullptr;
+    }
+
+    maxCount = 0;
+
+    if (bufferSize == 0 || maxPlugins < 2)
+        return;
+
+    try {
+        plugins = new CarlaPlugin*[maxPlugins];
+        outBufs = new float*[maxPlugins*2];
+        carla_zeroPointers(outBufs, maxPlugins*2);
+
+        for (uint i=0; i < maxPlugins*2; ++i)
+            outBufs[i] = new float[bufferSize];
+    }
+    catch(...) {
+        if (outBufs != nullptr)
+        {
+            for (uint i=0; i < maxPlugins*2; ++i)
+                delete[] outBufs[i];
+
+            delete[] outBufs;
+            outBufs = nullptr;
+        }
+
+        delete[] plugins;
+        plugins = nullptr;
+        return;
+    }
+
+    maxCount = maxPlugins;
+}
+
+void RackGraph::ParallelLayer::run(const bool) noexcept
+{
+    for (int index; (index = __sync_fetch_and_add(&nextIndex, 1)) < static_cast<int>(count);)
+    {
+        CarlaPlugin* const plugin = plugins[index];
+        float* pluginOutBuf[2] = { outBufs[index*2], outBufs[index*2+1] };
+
+        carla_zeroFloats(pluginOutBuf[0], frames);
+        carla_zeroFloats(pluginOutBuf[1], frames);
+
+        plugin->initBuffers();
+        plugin->process(const_cast<const float**>(inBuf), pluginOutBuf, nullptr, nullptr, frames);
+    }
+}
+
 // -----------------------------------------------------------------------
 // RackGraph
 
@@ -656,8 +736,16 @@ RackGraph::RackGraph(CarlaEngine* const engine, const uint32_t ins, const uint32
       outputs(outs),
       isOffline(false),
       audioBuffers(),
+      parallelLayer(),
+      workerPool(),
       kEngine(engine)
 {
+    if (const uint numWorkers = engine->getOptions().audioWorkerThreads)
+    {
+        if (! workerPool.start(numWorkers))
+            carla_stderr2("RackGraph: failed to start %u audio worker threads, processing serially", numWorkers);
+    }
+
     setBufferSize(engine->getBufferSize());
 }
 
@@ -669,6 +757,9 @@ RackGraph::~RackGraph() noexcept
 void RackGraph::setBufferSize(const uint32_t bufferSize) noexcept
 {
     audioBuffers.setBufferSize(bufferSize, (inputs > 0 || outputs > 0));
+
+    if (const uint numWorkers = workerPool.getNumWorkers())
+        parallelLayer.setBufferSize(bufferSize, numWorkers+1);
 }
 
 void RackGraph::setOffline(const bool offline) noexcept
@@ -791,7 +882,7 @@ void RackGraph::process(CarlaEngine::ProtectedData* const data, const float* inB
     carla_zeroFloats(outBuf[1], frames);
 
     // initialize event outputs (zero)
-    carla_zeroStructs(data->events.out, kMaxEngineEventInternalCount);
+    clearEngineEvents(data->events.out);
 
     uint32_t oldAudioInCount  = 0;
     uint32_t oldAudioOutCount = 0;
@@ -828,13 +919,28 @@ void RackGraph::process(CarlaEngine::ProtectedData* const data, const float* inB
             else
             {
                 // initialize event inputs from previous outputs
-                carla_copyStructs(data->events.in, data->events.out, kMaxEngineEventInternalCount);
+                copyEngineEvents(data->events.in, data->events.out);
 
                 // initialize event outputs (zero)
-                carla_zeroStructs(data->events.out, kMaxEngineEventInternalCount);
+                clearEngineEvents(data->events.out);
             }
         }
 
+        // plugins with no audio inputs only add to the previous signal, so they can run concurrently.
+        // the first of them must not write events, as that would change the input of the next ones.
+        if (parallelLayer.maxCount > 1 && plugin->getAudioInCount() == 0 && plugin->getDefaultEventOutPort() == nullptr)
+        {
+            i = processParallelLayer(data, i, inBuf, outBuf, frames);
+
+            CarlaPlugin* const lastPlugin = data->plugins[i].plugin;
+            oldAudioInCount  = lastPlugin->getAudioInCount();
+            oldAudioOutCount = lastPlugin->getAudioOutCount();
+            oldMidiOutCount  = lastPlugin->getMidiOutCount();
+
+            processed = true;
+            continue;
+        }
+
         oldAudioInCount  = plugin->getAudioInCount();
         oldAudioOutCount = plugin->getAudioOutCount();
         oldMidiOutCount  = plugin->getMidiOutCount();
@@ -888,6 +994,84 @@ void RackGraph::process(CarlaEngine::ProtectedData* const data, const float* inB
     }
 }
 
+uint RackGraph::processParallelLayer(CarlaEngine::ProtectedData* const data, const uint index, const float* inBuf[2], float* outBuf[2], const uint32_t frames)
+{
+    // first plugin is already locked
+    parallelLayer.plugins[0] = data->plugins[index].plugin;
+    parallelLayer.count = 1;
+
+    uint lastIndex = index;
+
+    for (uint i=index+1; i < data->curPluginCount && parallelLayer.count < parallelLayer.maxCount; ++i)
+    {
+        CarlaPlugin* const plugin = data->plugins[i].plugin;
+
+        if (plugin == nullptr || ! plugin->isEnabled())
+            continue;
+        if (plugin->getAudioInCount() != 0)
+            break;
+        if (! plugin->tryLock(isOffline))
+            continue;
+
+        parallelLayer.plugins[parallelLayer.count++] = plugin;
+        lastIndex = i;
+
+        // events written by this plugin go to the next ones, so it must be the last of the layer
+        if (plugin->getDefaultEventOutPort() != nullptr)
+            break;
+    }
+
+    parallelLayer.inBuf = inBuf;
+    parallelLayer.frames = frames;
+    parallelLayer.nextIndex = 0;
+
+    workerPool.runJob(parallelLayer);
+
+    // mix in the same order as serial processing, so results are identical
+    const float* mixBuf[2] = { inBuf[0], inBuf[1] };
+
+    for (uint i=0, j=index; i < parallelLayer.count; ++i, ++j)
+    {
+        CarlaPlugin* const plugin = parallelLayer.plugins[i];
+        float* const pluginOutBuf[2] = { parallelLayer.outBufs[i*2], parallelLayer.outBufs[i*2+1] };
+
+        plugin->unlock();
+
+        carla_addFloats(pluginOutBuf[0], mixBuf[0], frames);
+        carla_addFloats(pluginOutBuf[1], mixBuf[1], frames);
+
+        if (plugin->getAudioOutCount() == 1)
+            carla_copyFloats(pluginOutBuf[1], pluginOutBuf[0], frames);
+
+        mixBuf[0] = pluginOutBuf[0];
+        mixBuf[1] = pluginOutBuf[1];
+
+        // set peaks
+        while (data->plugins[j].plugin != plugin)
+            ++j;
+
+        EnginePluginData& pluginData(data->plugins[j]);
+        pluginData.insPeak[0] = 0.0f;
+        pluginData.insPeak[1] = 0.0f;
+
+        if (plugin->getAudioOutCount() > 0)
+        {
+            pluginData.outsPeak[0] = carla_findMaxNormalizedFloat(pluginOutBuf[0], frames);
+            pluginData.outsPeak[1] = carla_findMaxNormalizedFloat(pluginOutBuf[1], frames);
+        }
+        else
+        {
+            pluginData.outsPeak[0] = 0.0f;
+            pluginData.outsPeak[1] = 0.0f;
+        }
+    }
+
+    carla_copyFloats(outBuf[0], mixBuf[0], frames);
+    carla_copyFloats(outBuf[1], mixBuf[1], frames);
+
+    return lastIndex;
+}
+
 void RackGraph::processHelper(CarlaEngine::ProtectedData* const data, const float* const* const inBuf, float* const* const outBuf, const uint32_t frames)
 {
     CARLA_SAFE_ASSERT_RETURN(audioBuffers.outBuf[1] != nullptr,);
@@ -1167,7 +1351,7 @@ public:
             EngineEvent* const engineEvents(port->fBuffer);
             CARLA_SAFE_ASSERT_RETURN(engineEvents != nullptr,);
 
-            carla_zeroStructs(engineEvents, kMaxEngineEventInternalCount);
+            clearEngineEvents(engineEvents);
             fillEngineEventsFromWaterMidiBuffer(engineEvents, midi);
         }
 
@@ -1215,7 +1399,7 @@ public:
             CARLA_SAFE_ASSERT_RETURN(engineEvents != nullptr,);
 
             fillWaterMidiBufferFromEngineEvents(midi, engineEvents);
-            carla_zeroStructs(engineEvents, kMaxEngineEventInternalCount);
+            clearEngineEvents(engineEvents);
         }
 
         fPlugin->unlock();
@@ -1286,9 +1470,28 @@ private:
     StringArray outputNames;
 };
 
+PatchbayGraph::GraphJobRunner::GraphJobRunner(CarlaWorkerPool& p) noexcept
+    : pool(p),
+      job(nullptr) {}
+
+void PatchbayGraph::GraphJobRunner::runJob(AudioProcessorGraph::JobRunner::Job& j) noexcept
+{
+    // published to the workers by the pool before they are woken up
+    job = &j;
+    pool.runJob(*this);
+    job = nullptr;
+}
+
+void PatchbayGraph::GraphJobRunner::run(const bool fromWorker) noexcept
+{
+    job->run(fromWorker);
+}
+
 PatchbayGraph::PatchbayGraph(CarlaEngine* const engine, const uint32_t ins, const uint32_t outs)
     : CarlaThread("PatchbayReorderThread"),
       connections(),
+      workerPool(),
+      jobRunner(workerPool),
       graph(),
       audioBuffer(),
       midiBuffer(),
@@ -1297,12 +1500,26 @@ PatchbayGraph::PatchbayGraph(CarlaEngine* const engine, const uint32_t ins, cons
       retCon(),
       usingExternal(false),
       extGraph(engine),
-      kEngine(engine)
+      kEngine(engine),
+      fWakeSem(),
+      fWakePending(0)
 {
+    carla_sem_create2(fWakeSem);
+
     const int    bufferSize(static_cast<int>(engine->getBufferSize()));
     const double sampleRate(engine->getSampleRate());
 
     graph.setPlayConfigDetails(static_cast<int>(inputs), static_cast<int>(outputs), sampleRate, bufferSize);
+    graph.setReorderCallback(_reorderCallback, this);
+
+    if (const uint numWorkers = engine->getOptions().audioWorkerThreads)
+    {
+        if (workerPool.start(numWorkers))
+            graph.setJobRunner(&jobRunner);
+        else
+            carla_stderr2("PatchbayGraph: failed to start %u audio worker threads, processing serially", numWorkers);
+    }
+
     graph.prepareToPlay(sampleRate, bufferSize);
 
     audioBuffer.setSize(static_cast<int>(jmax(inputs, outputs)), bufferSize);
@@ -1382,8 +1599,13 @@ PatchbayGraph::PatchbayGraph(CarlaEngine* const engine, const uint32_t ins, cons
 
 PatchbayGraph::~PatchbayGraph()
 {
+    signalThreadShouldExit();
+    wakeUp();
     stopThread(-1);
 
+    graph.setReorderCallback(nullptr, nullptr);
+    carla_sem_destroy2(fWakeSem);
+
     connections.clear();
     extGraph.clear();
 
@@ -1840,7 +2062,7 @@ void PatchbayGraph::process(CarlaEngine::ProtectedData* const data, const float*
 
     // put water events in carla buffer
     {
-        carla_zeroStructs(data->events.out, kMaxEngineEventInternalCount);
+        clearEngineEvents(data->events.out);
         fillEngineEventsFromWaterMidiBuffer(data->events.out, midiBuffer);
         midiBuffer.clear();
     }
@@ -1850,11 +2072,35 @@ void PatchbayGraph::run()
 {
     while (! shouldThreadExit())
     {
-        carla_msleep(100);
+        carla_sem_wait(fWakeSem);
+
+        // anything happening from now on posts again
+        __sync_lock_release(&fWakePending);
+        __sync_synchronize();
+
+        if (shouldThreadExit())
+            break;
+
         graph.reorderNowIfNeeded();
+
+        // deletes the old sequence once the audio thread has picked up the new one,
+        // which calls us back and gets us here again
+        graph.releaseOldRenderingSequence();
     }
 }
 
+void PatchbayGraph::_reorderCallback(void* const ptr)
+{
+    ((PatchbayGraph*)ptr)->wakeUp();
+}
+
+void PatchbayGraph::wakeUp() noexcept
+{
+    // only post when our thread is not already about to wake up, the semaphore does not count
+    if (__sync_bool_compare_and_swap(&fWakePending, 0, 1))
+        carla_sem_post(fWakeSem);
+}
+
 // -----------------------------------------------------------------------
 // InternalGraph
 
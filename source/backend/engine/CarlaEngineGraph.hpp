@@ -21,8 +21,10 @@
 #include "CarlaEngine.hpp"
 #include "CarlaMutex.hpp"
 #include "CarlaPatchbayUtils.hpp"
+#include "CarlaSemUtils.hpp"
 #include "CarlaStringList.hpp"
 #include "CarlaThread.hpp"
+#include "CarlaWorkerPool.hpp"
 
 #include "water/processors/AudioProcessorGraph.h"
 #include "water/text/StringArray.h"
@@ -121,6 +123,24 @@ struct RackGraph {
         CARLA_DECLARE_NON_COPY_CLASS(Buffers)
     } audioBuffers;
 
+    // plugins without audio inputs that are rendered concurrently, each into its own buffers
+    struct ParallelLayer : public CarlaWorkerPool::Job {
+        CarlaPlugin** plugins;
+        float** outBufs;
+        uint maxCount;
+        uint count;
+        int nextIndex;
+        const float* const* inBuf;
+        uint32_t frames;
+        ParallelLayer() noexcept;
+        ~ParallelLayer() noexcept override;
+        void setBufferSize(const uint32_t bufferSize, const uint maxPlugins) noexcept;
+        void run(const bool fromWorker) noexcept override;
+        CARLA_DECLARE_NON_COPY_CLASS(ParallelLayer)
+    } parallelLayer;
+
+    CarlaWorkerPool workerPool;
+
     RackGraph(CarlaEngine* const engine, const uint32_t inputs, const uint32_t outputs) noexcept;
     ~RackGraph() noexcept;
 
@@ -141,6 +161,11 @@ struct RackGraph {
     void processHelper(CarlaEngine::ProtectedData* const data, const float* const* const inBuf, float* const* const outBuf, const uint32_t frames);
 
     CarlaEngine* const kEngine;
+
+private:
+    // renders plugins starting at 'index' concurrently, returns the index of the last one handled
+    uint processParallelLayer(CarlaEngine::ProtectedData* const data, const uint index, const float* inBuf[2], float* outBuf[2], const uint32_t frames);
+
     CARLA_DECLARE_NON_COPY_CLASS(RackGraph)
 };
 
@@ -150,6 +175,19 @@ struct RackGraph {
 class PatchbayGraph : private CarlaThread {
 public:
     PatchbayConnectionList connections;
+    CarlaWorkerPool workerPool;
+
+    // lets the graph run its rendering jobs on our worker pool
+    struct GraphJobRunner : public AudioProcessorGraph::JobRunner,
+                            private CarlaWorkerPool::Job {
+        CarlaWorkerPool& pool;
+        AudioProcessorGraph::JobRunner::Job* job;
+        GraphJobRunner(CarlaWorkerPool& p) noexcept;
+        void runJob(AudioProcessorGraph::JobRunner::Job& j) noexcept override;
+        void run(const bool fromWorker) noexcept override;
+        CARLA_DECLARE_NON_COPY_STRUCT(GraphJobRunner)
+    } jobRunner;
+
     AudioProcessorGraph graph;
     AudioSampleBuffer audioBuffer;
     MidiBuffer midiBuffer;
@@ -186,7 +224,16 @@ public:
 private:
     void run() override;
 
+    // called by the graph when it needs to be reordered or has picked up a new sequence, wakes up our thread.
+    // may run on the audio thread
+    static void _reorderCallback(void* ptr);
+    void wakeUp() noexcept;
+
     CarlaEngine* const kEngine;
+
+    // posted at most once until our thread wakes up, see wakeUp()
+    carla_sem_t fWakeSem;
+    volatile int fWakePending;
     CARLA_DECLARE_NON_COPY_CLASS(PatchbayGraph)
 };
 
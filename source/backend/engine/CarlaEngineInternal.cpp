@@ -451,7 +451,9 @@ CarlaEngine::ProtectedData::ProtectedData(CarlaEngine* const engine) noexcept
       graph(engine),
 #endif
       time(timeInfo, options.transportMode),
-      nextAction()
+      nextAction(),
+      backgroundWorkPool(),
+      lv2UridMap()
 {
 #ifdef BUILD_BRIDGE
     carla_zeroStructs(plugins, 1);
@@ -488,6 +490,9 @@ bool CarlaEngine::ProtectedData::init(const char* const clientName)
     curPluginCount = 0;
     nextPluginId   = 0;
 
+    // calibrates the busy-wait here, so it never runs on the audio thread
+    jackbridge_sem_set_spin(options.bridgesSpinTime);
+
     switch (options.processMode)
     {
     case ENGINE_PROCESS_MODE_CONTINUOUS_RACK:
@@ -512,6 +517,9 @@ bool CarlaEngine::ProtectedData::init(const char* const clientName)
     case ENGINE_PROCESS_MODE_BRIDGE:
         events.in  = new EngineEvent[kMaxEngineEventInternalCount];
         events.out = new EngineEvent[kMaxEngineEventInternalCount];
+        // only the used part gets cleared during processing, start with everything zeroed
+        carla_zeroStructs(events.in,  kMaxEngineEventInternalCount);
+        carla_zeroStructs(events.out, kMaxEngineEventInternalCount);
         break;
     default:
         break;
@@ -552,7 +560,7 @@ void CarlaEngine::ProtectedData::close()
 
     aboutToClose = true;
 
-    thread.stopThread(500);
+    thread.stop();
     nextAction.clearAndReset();
 
 #ifdef HAVE_LIBLO
@@ -784,7 +792,7 @@ ScopedThreadStopper::ScopedThreadStopper(CarlaEngine* const e) noexcept
     : engine(e),
       pData(e->pData)
 {
-    pData->thread.stopThread(500);
+    pData->thread.stop();
 }
 
 ScopedThreadStopper::~ScopedThreadStopper() noexcept
@@ -21,6 +21,8 @@
 #include "CarlaEngineOsc.hpp"
 #include "CarlaEngineThread.hpp"
 #include "CarlaEngineUtils.hpp"
+#include "CarlaBackgroundWorkPool.hpp"
+#include "Lv2UridMap.hpp"
 
 #include "hylia/hylia.h"
 
@@ -257,6 +259,12 @@ struct CarlaEngine::ProtectedData {
     EngineInternalTime   time;
     EngineNextAction     nextAction;
 
+    // non-realtime work scheduled by plugins
+    CarlaBackgroundWorkPool backgroundWorkPool;
+
+    // URIDs shared by all LV2 plugins
+    Lv2UridMap lv2UridMap;
+
     // -------------------------------------------------------------------
 
     ProtectedData(CarlaEngine* const engine) noexcept;
@@ -1687,8 +1687,8 @@ protected:
             /**/  float* outBuf[2] = { audioOut1, audioOut2 };
 
             // initialize events
-            carla_zeroStructs(pData->events.in,  kMaxEngineEventInternalCount);
-            carla_zeroStructs(pData->events.out, kMaxEngineEventInternalCount);
+            clearEngineEvents(pData->events.in);
+            clearEngineEvents(pData->events.out);
 
             if (eventIn != nullptr)
             {
@@ -1704,12 +1704,15 @@ protected:
 
                     CARLA_SAFE_ASSERT_CONTINUE(jackEvent.size < 0xFF /* uint8_t max */);
 
-                    EngineEvent& engineEvent(pData->events.in[engineEventIndex++]);
+                    EngineEvent& engineEvent(pData->events.in[engineEventIndex]);
 
                     engineEvent.time = jackEvent.time;
                     engineEvent.fillFromMidiData(static_cast<uint8_t>(jackEvent.size), jackEvent.buffer, 0);
 
-                    if (engineEventIndex >= kMaxEngineEventInternalCount)
+                    if (engineEvent.type == kEngineEventTypeNull)
+                        continue;
+
+                    if (++engineEventIndex >= kMaxEngineEventInternalCount)
                         break;
                 }
             }
@@ -1512,8 +1512,8 @@ protected:
         // ---------------------------------------------------------------
         // initialize events
 
-        carla_zeroStructs(pData->events.in,  kMaxEngineEventInternalCount);
-        carla_zeroStructs(pData->events.out, kMaxEngineEventInternalCount);
+        clearEngineEvents(pData->events.in);
+        clearEngineEvents(pData->events.out);
 
         // ---------------------------------------------------------------
         // events input (before processing)
@@ -1524,12 +1524,15 @@ protected:
             for (uint32_t i=0; i < midiEventCount && engineEventIndex < kMaxEngineEventInternalCount; ++i)
             {
                 const NativeMidiEvent& midiEvent(midiEvents[i]);
-                EngineEvent&           engineEvent(pData->events.in[engineEventIndex++]);
+                EngineEvent&           engineEvent(pData->events.in[engineEventIndex]);
 
                 engineEvent.time = midiEvent.time;
                 engineEvent.fillFromMidiData(midiEvent.size, midiEvent.data, 0);
 
-                if (engineEventIndex >= kMaxEngineEventInternalCount)
+                if (engineEvent.type == kEngineEventTypeNull)
+                    continue;
+
+                if (++engineEventIndex >= kMaxEngineEventInternalCount)
                     break;
             }
         }
@@ -1558,7 +1561,7 @@ protected:
         // ---------------------------------------------------------------
         // events output (after processing)
 
-        carla_zeroStructs(pData->events.in, kMaxEngineEventInternalCount);
+        clearEngineEvents(pData->events.in);
 
         if (kHasMidiOut)
         {
@@ -21,19 +21,45 @@
 
 #include "CarlaEngine.hpp"
 #include "CarlaEngineOsc.hpp"
+#include "CarlaEngineThread.hpp"
 #include "CarlaPlugin.hpp"
 #include "CarlaMIDI.h"
 
 #include <cctype>
+#include <cmath>
 
 CARLA_BACKEND_START_NAMESPACE
 
+#ifndef BUILD_BRIDGE
+// default and allowed range of control client update intervals, in ms
+// updates are sent from the engine thread idle, so nothing faster than it makes sense
+static const uint kControlUpdateInterval    = CarlaEngineThread::kFrequentIdleInterval;
+static const uint kControlUpdateIntervalMin = CarlaEngineThread::kFrequentIdleInterval;
+static const uint kControlUpdateIntervalMax = 1000;
+
+// smallest change worth sending, relative to the parameter range
+static const float kControlUpdateEpsilon = 0.001f;
+
+// keep UDP bundles within a reasonable datagram size, TCP is a stream
+static const std::size_t kControlBundleSizeUDP = 8192;
+static const std::size_t kControlBundleSizeTCP = 65536;
+#endif
+
 // -----------------------------------------------------------------------
 
 CarlaEngineOsc::CarlaEngineOsc(CarlaEngine* const engine) noexcept
     : fEngine(engine),
 #ifndef BUILD_BRIDGE
       fControlData(),
+      fControlIsTCP(false),
+      fControlUpdateInterval(kControlUpdateInterval),
+      fControlLastUpdate(0),
+      fControlCache(nullptr),
+      fControlCacheSize(0),
+      fControlCacheNeedsReset(false),
+      fControlBundleMutex(),
+      fControlBundle(nullptr),
+      fControlBundling(false),
 #endif
       fName(),
       fServerPathTCP(),
@@ -52,6 +78,10 @@ CarlaEngineOsc::~CarlaEngineOsc() noexcept
     CARLA_SAFE_ASSERT(fServerPathUDP.isEmpty());
     CARLA_SAFE_ASSERT(fServerTCP == nullptr);
     CARLA_SAFE_ASSERT(fServerUDP == nullptr);
+#ifndef BUILD_BRIDGE
+    CARLA_SAFE_ASSERT(fControlCache == nullptr);
+    CARLA_SAFE_ASSERT(fControlBundle == nullptr);
+#endif
     carla_debug("CarlaEngineOsc::~CarlaEngineOsc()");
 }
 
@@ -168,12 +198,244 @@ void CarlaEngineOsc::close() noexcept
     fServerPathUDP.clear();
 
 #ifndef BUILD_BRIDGE
+    {
+        const CarlaMutexLocker cml(fControlBundleMutex);
+
+        if (fControlBundle != nullptr)
+        {
+            lo_bundle_free_recursive(fControlBundle);
+            fControlBundle = nullptr;
+        }
+
+        fControlBundling = false;
+    }
+
+    clearControlCache();
     fControlData.clear();
 #endif
 }
 
 // -----------------------------------------------------------------------
 
+#ifndef BUILD_BRIDGE
+void CarlaEngineOsc::sendControlMessage(const char* const path, const lo_message msg) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(msg != nullptr,);
+
+    const CarlaMutexLocker cml(fControlBundleMutex);
+
+    if (fControlBundling)
+        return addControlBundleMessage(fControlBundle, path, msg);
+
+    try {
+        lo_send_message(fControlData.target, path, msg);
+    } CARLA_SAFE_EXCEPTION("lo_send_message");
+
+    lo_message_free(msg);
+}
+
+void CarlaEngineOsc::sendControlUpdates() noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(fControlData.path != nullptr && fControlData.path[0] != '\0',);
+    CARLA_SAFE_ASSERT_RETURN(fControlData.target != nullptr,);
+
+    const uint64_t now(carla_gettime_ns());
+
+    // called once per engine thread idle, which can run a little early or late,
+    // so only skip this one if the next idle is closer to the requested interval
+    static const uint64_t kHalfIdleInterval = CarlaEngineThread::kFrequentIdleInterval * 1000000ULL / 2;
+
+    if (fControlLastUpdate != 0 && now - fControlLastUpdate + kHalfIdleInterval < static_cast<uint64_t>(fControlUpdateInterval) * 1000000ULL)
+        return;
+
+    fControlLastUpdate = now;
+
+    if (fControlCacheNeedsReset)
+    {
+        fControlCacheNeedsReset = false;
+        clearControlCache();
+    }
+
+    const uint count(fEngine->getCurrentPluginCount());
+
+    if (count == 0)
+        return;
+
+    if (fControlCache == nullptr)
+    {
+        const uint cacheSize(fEngine->getMaxPluginNumber());
+        CARLA_SAFE_ASSERT_RETURN(cacheSize >= count,);
+
+        try {
+            fControlCache = new ControlUpdateCache[cacheSize];
+        } CARLA_SAFE_EXCEPTION_RETURN("CarlaEngineOsc::sendControlUpdates",);
+
+        carla_zeroStructs(fControlCache, cacheSize);
+        fControlCacheSize = cacheSize;
+    }
+
+    CARLA_SAFE_ASSERT_RETURN(count <= fControlCacheSize,);
+
+    const std::size_t pathSize(std::strlen(fControlData.path));
+
+    char paramPath[pathSize+21];
+    std::strcpy(paramPath, fControlData.path);
+    std::strcat(paramPath, "/set_parameter_value");
+
+    char peaksPath[pathSize+11];
+    std::strcpy(peaksPath, fControlData.path);
+    std::strcat(peaksPath, "/set_peaks");
+
+    lo_bundle bundle = nullptr;
+
+    for (uint i=0; i < count; ++i)
+    {
+        CarlaPlugin* const plugin(fEngine->getPluginUnchecked(i));
+
+        if (plugin == nullptr || ! plugin->isEnabled())
+            continue;
+
+        ControlUpdateCache& cache(fControlCache[i]);
+        const uint32_t paramCount(plugin->getParameterCount());
+
+        // new plugin in this slot, everything needs to be sent
+        const bool sendAll(cache.plugin != plugin || cache.valueCount != paramCount);
+
+        if (sendAll)
+        {
+            delete[] cache.values;
+            cache.plugin = nullptr;
+            cache.values = nullptr;
+            cache.valueCount = 0;
+
+            if (paramCount > 0)
+            {
+                try {
+                    cache.values = new float[paramCount];
+                } CARLA_SAFE_EXCEPTION_CONTINUE("CarlaEngineOsc::sendControlUpdates");
+            }
+
+            cache.plugin = plugin;
+            cache.valueCount = paramCount;
+        }
+
+        // -------------------------------------------------------------------
+        // output parameters
+
+        for (uint32_t j=0; j < paramCount; ++j)
+        {
+            if (! plugin->isParameterOutput(j))
+                continue;
+
+            const float value(plugin->getParameterValue(j));
+
+            if (! sendAll)
+            {
+                const ParameterRanges& ranges(plugin->getParameterRanges(j));
+
+                if (std::abs(value - cache.values[j]) <= (ranges.max - ranges.min) * kControlUpdateEpsilon)
+                    continue;
+            }
+
+            cache.values[j] = value;
+
+            const lo_message msg(lo_message_new());
+            CARLA_SAFE_ASSERT_CONTINUE(msg != nullptr);
+
+            lo_message_add(msg, "iif", static_cast<int32_t>(i), static_cast<int32_t>(j), value);
+            addControlBundleMessage(bundle, paramPath, msg);
+        }
+
+        // -------------------------------------------------------------------
+        // peaks
+
+        const float peaks[4] = {
+            fEngine->getInputPeak(i, true),
+            fEngine->getInputPeak(i, false),
+            fEngine->getOutputPeak(i, true),
+            fEngine->getOutputPeak(i, false)
+        };
+
+        bool peaksChanged = sendAll;
+
+        for (uint j=0; j < 4 && ! peaksChanged; ++j)
+            peaksChanged = std::abs(peaks[j] - cache.peaks[j]) > kControlUpdateEpsilon;
+
+        if (! peaksChanged)
+            continue;
+
+        std::memcpy(cache.peaks, peaks, sizeof(peaks));
+
+        const lo_message msg(lo_message_new());
+        CARLA_SAFE_ASSERT_CONTINUE(msg != nullptr);
+
+        lo_message_add(msg, "iffff", static_cast<int32_t>(i), peaks[0], peaks[1], peaks[2], peaks[3]);
+        addControlBundleMessage(bundle, peaksPath, msg);
+    }
+
+    if (bundle != nullptr)
+        sendControlBundle(bundle);
+}
+
+void CarlaEngineOsc::resetControlUpdates() noexcept
+{
+    fControlCacheNeedsReset = true;
+}
+
+// -----------------------------------------------------------------------
+
+void CarlaEngineOsc::addControlBundleMessage(lo_bundle& bundle, const char* const path, const lo_message msg) noexcept
+{
+    const std::size_t maxSize(fControlIsTCP ? kControlBundleSizeTCP : kControlBundleSizeUDP);
+
+    // each bundle element is prefixed by its size
+    if (bundle != nullptr && lo_bundle_length(bundle) + lo_message_length(msg, path) + 4 > maxSize)
+        sendControlBundle(bundle);
+
+    if (bundle == nullptr)
+    {
+        bundle = lo_bundle_new(LO_TT_IMMEDIATE);
+
+        if (bundle == nullptr)
+        {
+            carla_safe_assert("bundle != nullptr", __FILE__, __LINE__);
+            lo_message_free(msg);
+            return;
+        }
+    }
+
+    // the bundle takes a reference to the message, and frees it later on
+    lo_bundle_add_message(bundle, path, msg);
+}
+
+void CarlaEngineOsc::sendControlBundle(lo_bundle& bundle) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(bundle != nullptr,);
+
+    try {
+        lo_send_bundle(fControlData.target, bundle);
+    } CARLA_SAFE_EXCEPTION("lo_send_bundle");
+
+    lo_bundle_free_recursive(bundle);
+    bundle = nullptr;
+}
+
+void CarlaEngineOsc::clearControlCache() noexcept
+{
+    if (fControlCache == nullptr)
+        return;
+
+    for (uint i=0; i < fControlCacheSize; ++i)
+        delete[] fControlCache[i].values;
+
+    delete[] fControlCache;
+    fControlCache = nullptr;
+    fControlCacheSize = 0;
+}
+#endif
+
+// -----------------------------------------------------------------------
+
 int CarlaEngineOsc::handleMessage(const bool isTCP, const char* const path, const int argc, const lo_arg* const* const argv, const char* const types, const lo_message msg)
 {
     CARLA_SAFE_ASSERT_RETURN(fName.isNotEmpty(), 1);
@@ -330,7 +592,17 @@ int CarlaEngineOsc::handleMessage(const bool isTCP, const char* const path, cons
 int CarlaEngineOsc::handleMsgRegister(const bool isTCP, const int argc, const lo_arg* const* const argv, const char* const types)
 {
     carla_debug("CarlaEngineOsc::handleMsgRegister()");
-    CARLA_ENGINE_OSC_CHECK_OSC_TYPES(1, "s");
+
+    // an optional update interval in ms can follow the url,
+    // rounded up to a multiple of the engine thread idle interval as updates are sent from there
+    if (argc == 2)
+    {
+        CARLA_ENGINE_OSC_CHECK_OSC_TYPES(2, "si");
+    }
+    else
+    {
+        CARLA_ENGINE_OSC_CHECK_OSC_TYPES(1, "s");
+    }
 
     if (fControlData.path != nullptr)
     {
@@ -352,6 +624,31 @@ int CarlaEngineOsc::handleMsgRegister(const bool isTCP, const int argc, const lo
         fControlData.target = lo_address_new_with_proto(isTCP ? LO_TCP : LO_UDP, host, port);
     }
 
+    fControlIsTCP = isTCP;
+    fControlUpdateInterval = kControlUpdateInterval;
+    fControlLastUpdate = 0;
+    fControlCacheNeedsReset = true;
+
+    if (argc == 2)
+    {
+        const int32_t interval = argv[1]->i;
+
+        if (interval <= static_cast<int32_t>(kControlUpdateIntervalMin))
+            fControlUpdateInterval = kControlUpdateIntervalMin;
+        else if (interval >= static_cast<int32_t>(kControlUpdateIntervalMax))
+            fControlUpdateInterval = kControlUpdateIntervalMax;
+        else
+            fControlUpdateInterval = static_cast<uint>(interval);
+
+        fControlUpdateInterval = (fControlUpdateInterval + kControlUpdateIntervalMin - 1) / kControlUpdateIntervalMin * kControlUpdateIntervalMin;
+    }
+
+    // send the full state as a few large bundles, instead of thousands of small messages
+    {
+        const CarlaMutexLocker cml(fControlBundleMutex);
+        fControlBundling = true;
+    }
+
     for (uint i=0, count=fEngine->getCurrentPluginCount(); i < count; ++i)
     {
         CarlaPlugin* const plugin(fEngine->getPluginUnchecked(i));
@@ -360,6 +657,14 @@ int CarlaEngineOsc::handleMsgRegister(const bool isTCP, const int argc, const lo
             plugin->registerToOscClient();
     }
 
+    {
+        const CarlaMutexLocker cml(fControlBundleMutex);
+        fControlBundling = false;
+
+        if (fControlBundle != nullptr)
+            sendControlBundle(fControlBundle);
+    }
+
     return 0;
 }
 
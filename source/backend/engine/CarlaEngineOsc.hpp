@@ -23,6 +23,7 @@
 #ifdef HAVE_LIBLO
 
 #include "CarlaBackend.h"
+#include "CarlaMutex.hpp"
 #include "CarlaOscUtils.hpp"
 #include "CarlaString.hpp"
 
@@ -89,6 +90,27 @@ public:
     {
         return &fControlData;
     }
+
+    // -------------------------------------------------------------------
+
+    /*
+     * Send a message to the control client, or add it to the current bundle.
+     * Takes ownership of 'msg'.
+     */
+    void sendControlMessage(const char* const path, const lo_message msg) noexcept;
+
+    /*
+     * Send the output parameters and peaks that changed since the last update, as bundles.
+     * Does nothing until the update interval requested by the client has passed.
+     * Called from the engine thread, so the interval is a multiple of its frequent idle interval.
+     */
+    void sendControlUpdates() noexcept;
+
+    /*
+     * Forget what sendControlUpdates() sent before.
+     * Needed when plugins are added, removed, replaced or switched, as the cache matches plugins by pointer.
+     */
+    void resetControlUpdates() noexcept;
 #endif
 
     // -------------------------------------------------------------------
@@ -98,6 +120,27 @@ private:
 
 #ifndef BUILD_BRIDGE
     CarlaOscData fControlData; // for carla-control
+
+    // last values sent to the control client, per plugin id
+    struct ControlUpdateCache {
+        const CarlaPlugin* plugin;
+        float* values;
+        uint32_t valueCount;
+        float peaks[4];
+    };
+
+    bool     fControlIsTCP;
+    uint     fControlUpdateInterval; // in ms
+    uint64_t fControlLastUpdate;
+
+    ControlUpdateCache* fControlCache;
+    uint                fControlCacheSize;
+    volatile bool       fControlCacheNeedsReset;
+
+    // used to send the initial state dump in bulk
+    CarlaMutex fControlBundleMutex;
+    lo_bundle  fControlBundle;
+    bool       fControlBundling;
 #endif
 
     CarlaString fName;
@@ -114,6 +157,10 @@ private:
 #ifndef BUILD_BRIDGE
     int handleMsgRegister(const bool isTCP, const int argc, const lo_arg* const* const argv, const char* const types);
     int handleMsgUnregister();
+
+    void addControlBundleMessage(lo_bundle& bundle, const char* const path, const lo_message msg) noexcept;
+    void sendControlBundle(lo_bundle& bundle) noexcept;
+    void clearControlCache() noexcept;
 #endif
 
     // Internal methods
@@ -28,6 +28,15 @@ CARLA_BACKEND_START_NAMESPACE
 // -----------------------------------------------------------------------
 
 #ifndef BUILD_BRIDGE
+// goes through the engine OSC so messages can be bundled
+#define try_lo_send_control(path, ...)                  \
+    try {                                               \
+        const lo_message msg(lo_message_new());         \
+        CARLA_SAFE_ASSERT_RETURN(msg != nullptr,);      \
+        lo_message_add(msg, __VA_ARGS__);               \
+        pData->osc.sendControlMessage(path, msg);       \
+    } CARLA_SAFE_EXCEPTION("lo_send");
+
 void CarlaEngine::oscSend_control_add_plugin_start(const uint pluginId, const char* const pluginName) const noexcept
 {
     CARLA_SAFE_ASSERT_RETURN(pData->oscData != nullptr,);
@@ -40,7 +49,7 @@ void CarlaEngine::oscSend_control_add_plugin_start(const uint pluginId, const ch
     char targetPath[std::strlen(pData->oscData->path)+18];
     std::strcpy(targetPath, pData->oscData->path);
     std::strcat(targetPath, "/add_plugin_start");
-    try_lo_send(pData->oscData->target, targetPath, "is", static_cast<int32_t>(pluginId), pluginName);
+    try_lo_send_control(targetPath, "is", static_cast<int32_t>(pluginId), pluginName);
 }
 
 void CarlaEngine::oscSend_control_add_plugin_end(const uint pluginId) const noexcept
@@ -54,7 +63,7 @@ void CarlaEngine::oscSend_control_add_plugin_end(const uint pluginId) const noex
     char targetPath[std::strlen(pData->oscData->path)+16];
     std::strcpy(targetPath, pData->oscData->path);
     std::strcat(targetPath, "/add_plugin_end");
-    try_lo_send(pData->oscData->target, targetPath, "i", static_cast<int32_t>(pluginId));
+    try_lo_send_control(targetPath, "i", static_cast<int32_t>(pluginId));
 }
 
 void CarlaEngine::oscSend_control_remove_plugin(const uint pluginId) const noexcept
@@ -68,7 +77,7 @@ void CarlaEngine::oscSend_control_remove_plugin(const uint pluginId) const noexc
     char targetPath[std::strlen(pData->oscData->path)+15];
     std::strcpy(targetPath, pData->oscData->path);
     std::strcat(targetPath, "/remove_plugin");
-    try_lo_send(pData->oscData->target, targetPath, "i", static_cast<int32_t>(pluginId));
+    try_lo_send_control(targetPath, "i", static_cast<int32_t>(pluginId));
 }
 
 void CarlaEngine::oscSend_control_set_plugin_info1(const uint pluginId, const PluginType type, const PluginCategory category, const uint hints, const int64_t uniqueId) const noexcept
@@ -83,7 +92,7 @@ void CarlaEngine::oscSend_control_set_plugin_info1(const uint pluginId, const Pl
     char targetPath[std::strlen(pData->oscData->path)+18];
     std::strcpy(targetPath, pData->oscData->path);
     std::strcat(targetPath, "/set_plugin_info1");
-    try_lo_send(pData->oscData->target, targetPath, "iiiih", static_cast<int32_t>(pluginId), static_cast<int32_t>(type), static_cast<int32_t>(category), static_cast<int32_t>(hints), static_cast<int64_t>(uniqueId));
+    try_lo_send_control(targetPath, "iiiih", static_cast<int32_t>(pluginId), static_cast<int32_t>(type), static_cast<int32_t>(category), static_cast<int32_t>(hints), static_cast<int64_t>(uniqueId));
 }
 
 void CarlaEngine::oscSend_control_set_plugin_info2(const uint pluginId, const char* const realName, const char* const label, const char* const maker, const char* const copyright) const noexcept
@@ -101,7 +110,7 @@ void CarlaEngine::oscSend_control_set_plugin_info2(const uint pluginId, const ch
     char targetPath[std::strlen(pData->oscData->path)+18];
     std::strcpy(targetPath, pData->oscData->path);
     std::strcat(targetPath, "/set_plugin_info2");
-    try_lo_send(pData->oscData->target, targetPath, "issss", static_cast<int32_t>(pluginId), realName, label, maker, copyright);
+    try_lo_send_control(targetPath, "issss", static_cast<int32_t>(pluginId), realName, label, maker, copyright);
 }
 
 void CarlaEngine::oscSend_control_set_audio_count(const uint pluginId, const uint32_t ins, const uint32_t outs) const noexcept
@@ -115,7 +124,7 @@ void CarlaEngine::oscSend_control_set_audio_count(const uint pluginId, const uin
     char targetPath[std::strlen(pData->oscData->path)+18];
     std::strcpy(targetPath, pData->oscData->path);
     std::strcat(targetPath, "/set_audio_count");
-    try_lo_send(pData->oscData->target, targetPath, "iii", static_cast<int32_t>(pluginId), static_cast<int32_t>(ins), static_cast<int32_t>(outs));
+    try_lo_send_control(targetPath, "iii", static_cast<int32_t>(pluginId), static_cast<int32_t>(ins), static_cast<int32_t>(outs));
 }
 
 void CarlaEngine::oscSend_control_set_midi_count(const uint pluginId, const uint32_t ins, const uint32_t outs) const noexcept
@@ -129,7 +138,7 @@ void CarlaEngine::oscSend_control_set_midi_count(const uint pluginId, const uint
     char targetPath[std::strlen(pData->oscData->path)+18];
     std::strcpy(targetPath, pData->oscData->path);
     std::strcat(targetPath, "/set_midi_count");
-    try_lo_send(pData->oscData->target, targetPath, "iii", static_cast<int32_t>(pluginId), static_cast<int32_t>(ins), static_cast<int32_t>(outs));
+    try_lo_send_control(targetPath, "iii", static_cast<int32_t>(pluginId), static_cast<int32_t>(ins), static_cast<int32_t>(outs));
 }
 
 void CarlaEngine::oscSend_control_set_parameter_count(const uint pluginId, const uint32_t ins, const uint32_t outs) const noexcept
@@ -145,7 +154,7 @@ void CarlaEngine::oscSend_control_set_parameter_count(const uint pluginId, const
     char targetPath[std::strlen(pData->oscData->path)+18];
     std::strcpy(targetPath, pData->oscData->path);
     std::strcat(targetPath, "/set_parameter_count");
-    try_lo_send(pData->oscData->target, targetPath, "iii", static_cast<int32_t>(pluginId), static_cast<int32_t>(ins), static_cast<int32_t>(outs));
+    try_lo_send_control(targetPath, "iii", static_cast<int32_t>(pluginId), static_cast<int32_t>(ins), static_cast<int32_t>(outs));
 }
 
 void CarlaEngine::oscSend_control_set_program_count(const uint pluginId, const uint32_t count) const noexcept
@@ -160,7 +169,7 @@ void CarlaEngine::oscSend_control_set_program_count(const uint pluginId, const u
     char targetPath[std::strlen(pData->oscData->path)+19];
     std::strcpy(targetPath, pData->oscData->path);
     std::strcat(targetPath, "/set_program_count");
-    try_lo_send(pData->oscData->target, targetPath, "ii", static_cast<int32_t>(pluginId), static_cast<int32_t>(count));
+    try_lo_send_control(targetPath, "ii", static_cast<int32_t>(pluginId), static_cast<int32_t>(count));
 }
 
 void CarlaEngine::oscSend_control_set_midi_program_count(const uint pluginId, const uint32_t count) const noexcept
@@ -175,7 +184,7 @@ void CarlaEngine::oscSend_control_set_midi_program_count(const uint pluginId, co
     char targetPath[std::strlen(pData->oscData->path)+24];
     std::strcpy(targetPath, pData->oscData->path);
     std::strcat(targetPath, "/set_midi_program_count");
-    try_lo_send(pData->oscData->target, targetPath, "ii", static_cast<int32_t>(pluginId), static_cast<int32_t>(count));
+    try_lo_send_control(targetPath, "ii", static_cast<int32_t>(pluginId), static_cast<int32_t>(count));
 }
 
 void CarlaEngine::oscSend_control_set_parameter_data(const uint pluginId, const uint32_t index, const ParameterType type, const uint hints, const char* const name, const char* const unit) const noexcept
@@ -192,7 +201,7 @@ void CarlaEngine::oscSend_control_set_parameter_data(const uint pluginId, const
     char targetPath[std::strlen(pData->oscData->path)+20];
     std::strcpy(targetPath, pData->oscData->path);
     std::strcat(targetPath, "/set_parameter_data");
-    try_lo_send(pData->oscData->target, targetPath, "iiiiss", static_cast<int32_t>(pluginId), static_cast<int32_t>(index), static_cast<int32_t>(type), static_cast<int32_t>(hints), name, unit);
+    try_lo_send_control(targetPath, "iiiiss", static_cast<int32_t>(pluginId), static_cast<int32_t>(index), static_cast<int32_t>(type), static_cast<int32_t>(hints), name, unit);
 }
 
 void CarlaEngine::oscSend_control_set_parameter_ranges1(const uint pluginId, const uint32_t index, const float def, const float min, const float max) const noexcept
@@ -209,7 +218,7 @@ void CarlaEngine::oscSend_control_set_parameter_ranges1(const uint pluginId, con
     char targetPath[std::strlen(pData->oscData->path)+24];
     std::strcpy(targetPath, pData->oscData->path);
     std::strcat(targetPath, "/set_parameter_ranges1");
-    try_lo_send(pData->oscData->target, targetPath, "iifff", static_cast<int32_t>(pluginId), static_cast<int32_t>(index), def, min, max);
+    try_lo_send_control(targetPath, "iifff", static_cast<int32_t>(pluginId), static_cast<int32_t>(index), def, min, max);
 }
 
 void CarlaEngine::oscSend_control_set_parameter_ranges2(const uint pluginId, const uint32_t index, const float step, const float stepSmall, const float stepLarge) const noexcept
@@ -226,7 +235,7 @@ void CarlaEngine::oscSend_control_set_parameter_ranges2(const uint pluginId, con
     char targetPath[std::strlen(pData->oscData->path)+24];
     std::strcpy(targetPath, pData->oscData->path);
     std::strcat(targetPath, "/set_parameter_ranges2");
-    try_lo_send(pData->oscData->target, targetPath, "iifff", static_cast<int32_t>(pluginId), static_cast<int32_t>(index), step, stepSmall, stepLarge);
+    try_lo_send_control(targetPath, "iifff", static_cast<int32_t>(pluginId), static_cast<int32_t>(index), step, stepSmall, stepLarge);
 }
 
 void CarlaEngine::oscSend_control_set_parameter_midi_cc(const uint pluginId, const uint32_t index, const int16_t cc) const noexcept
@@ -242,7 +251,7 @@ void CarlaEngine::oscSend_control_set_parameter_midi_cc(const uint pluginId, con
     char targetPath[std::strlen(pData->oscData->path)+23];
     std::strcpy(targetPath, pData->oscData->path);
     std::strcat(targetPath, "/set_parameter_midi_cc");
-    try_lo_send(pData->oscData->target, targetPath, "iii", static_cast<int32_t>(pluginId), static_cast<int32_t>(index), static_cast<int32_t>(cc));
+    try_lo_send_control(targetPath, "iii", static_cast<int32_t>(pluginId), static_cast<int32_t>(index), static_cast<int32_t>(cc));
 }
 
 void CarlaEngine::oscSend_control_set_parameter_midi_channel(const uint pluginId, const uint32_t index, const uint8_t channel) const noexcept
@@ -258,7 +267,7 @@ void CarlaEngine::oscSend_control_set_parameter_midi_channel(const uint pluginId
     char targetPath[std::strlen(pData->oscData->path)+28];
     std::strcpy(targetPath, pData->oscData->path);
     std::strcat(targetPath, "/set_parameter_midi_channel");
-    try_lo_send(pData->oscData->target, targetPath, "iii", static_cast<int32_t>(pluginId), static_cast<int32_t>(index), static_cast<int32_t>(channel));
+    try_lo_send_control(targetPath, "iii", static_cast<int32_t>(pluginId), static_cast<int32_t>(index), static_cast<int32_t>(channel));
 }
 
 void CarlaEngine::oscSend_control_set_parameter_value(const uint pluginId, const int32_t index, const float value) const noexcept
@@ -274,7 +283,7 @@ void CarlaEngine::oscSend_control_set_parameter_value(const uint pluginId, const
     char targetPath[std::strlen(pData->oscData->path)+21];
     std::strcpy(targetPath, pData->oscData->path);
     std::strcat(targetPath, "/set_parameter_value");
-    try_lo_send(pData->oscData->target, targetPath, "iif", static_cast<int32_t>(pluginId), index, value);
+    try_lo_send_control(targetPath, "iif", static_cast<int32_t>(pluginId), index, value);
 }
 
 void CarlaEngine::oscSend_control_set_default_value(const uint pluginId, const uint32_t index, const float value) const noexcept
@@ -289,7 +298,7 @@ void CarlaEngine::oscSend_control_set_default_value(const uint pluginId, const u
     char targetPath[std::strlen(pData->oscData->path)+19];
     std::strcpy(targetPath, pData->oscData->path);
     std::strcat(targetPath, "/set_default_value");
-    try_lo_send(pData->oscData->target, targetPath, "iif", static_cast<int32_t>(pluginId), static_cast<int32_t>(index), value);
+    try_lo_send_control(targetPath, "iif", static_cast<int32_t>(pluginId), static_cast<int32_t>(index), value);
 }
 
 void CarlaEngine::oscSend_control_set_current_program(const uint pluginId, const int32_t index) const noexcept
@@ -304,7 +313,7 @@ void CarlaEngine::oscSend_control_set_current_program(const uint pluginId, const
     char targetPath[std::strlen(pData->oscData->path)+21];
     std::strcpy(targetPath, pData->oscData->path);
     std::strcat(targetPath, "/set_current_program");
-    try_lo_send(pData->oscData->target, targetPath, "ii", static_cast<int32_t>(pluginId), index);
+    try_lo_send_control(targetPath, "ii", static_cast<int32_t>(pluginId), index);
 }
 
 void CarlaEngine::oscSend_control_set_current_midi_program(const uint pluginId, const int32_t index) const noexcept
@@ -319,7 +328,7 @@ void CarlaEngine::oscSend_control_set_current_midi_program(const uint pluginId,
     char targetPath[std::strlen(pData->oscData->path)+26];
     std::strcpy(targetPath, pData->oscData->path);
     std::strcat(targetPath, "/set_current_midi_program");
-    try_lo_send(pData->oscData->target, targetPath, "ii", static_cast<int32_t>(pluginId), index);
+    try_lo_send_control(targetPath, "ii", static_cast<int32_t>(pluginId), index);
 }
 
 void CarlaEngine::oscSend_control_set_program_name(const uint pluginId, const uint32_t index, const char* const name) const noexcept
@@ -335,7 +344,7 @@ void CarlaEngine::oscSend_control_set_program_name(const uint pluginId, const ui
     char targetPath[std::strlen(pData->oscData->path)+18];
     std::strcpy(targetPath, pData->oscData->path);
     std::strcat(targetPath, "/set_program_name");
-    try_lo_send(pData->oscData->target, targetPath, "iis", static_cast<int32_t>(pluginId), static_cast<int32_t>(index), name);
+    try_lo_send_control(targetPath, "iis", static_cast<int32_t>(pluginId), static_cast<int32_t>(index), name);
 }
 
 void CarlaEngine::oscSend_control_set_midi_program_data(const uint pluginId, const uint32_t index, const uint32_t bank, const uint32_t program, const char* const name) const noexcept
@@ -351,7 +360,7 @@ void CarlaEngine::oscSend_control_set_midi_program_data(const uint pluginId, con
     char targetPath[std::strlen(pData->oscData->path)+23];
     std::strcpy(targetPath, pData->oscData->path);
     std::strcat(targetPath, "/set_midi_program_data");
-    try_lo_send(pData->oscData->target, targetPath, "iiiis", static_cast<int32_t>(pluginId), static_cast<int32_t>(index), static_cast<int32_t>(bank), static_cast<int32_t>(program), name);
+    try_lo_send_control(targetPath, "iiiis", static_cast<int32_t>(pluginId), static_cast<int32_t>(index), static_cast<int32_t>(bank), static_cast<int32_t>(program), name);
 }
 
 void CarlaEngine::oscSend_control_note_on(const uint pluginId, const uint8_t channel, const uint8_t note, const uint8_t velo) const noexcept
@@ -368,7 +377,7 @@ void CarlaEngine::oscSend_control_note_on(const uint pluginId, const uint8_t cha
     char targetPath[std::strlen(pData->oscData->path)+9];
     std::strcpy(targetPath, pData->oscData->path);
     std::strcat(targetPath, "/note_on");
-    try_lo_send(pData->oscData->target, targetPath, "iiii", static_cast<int32_t>(pluginId), static_cast<int32_t>(channel), static_cast<int32_t>(note), static_cast<int32_t>(velo));
+    try_lo_send_control(targetPath, "iiii", static_cast<int32_t>(pluginId), static_cast<int32_t>(channel), static_cast<int32_t>(note), static_cast<int32_t>(velo));
 }
 
 void CarlaEngine::oscSend_control_note_off(const uint pluginId, const uint8_t channel, const uint8_t note) const noexcept
@@ -384,7 +393,7 @@ void CarlaEngine::oscSend_control_note_off(const uint pluginId, const uint8_t ch
     char targetPath[std::strlen(pData->oscData->path)+10];
     std::strcpy(targetPath, pData->oscData->path);
     std::strcat(targetPath, "/note_off");
-    try_lo_send(pData->oscData->target, targetPath, "iii", static_cast<int32_t>(pluginId), static_cast<int32_t>(channel), static_cast<int32_t>(note));
+    try_lo_send_control(targetPath, "iii", static_cast<int32_t>(pluginId), static_cast<int32_t>(channel), static_cast<int32_t>(note));
 }
 
 void CarlaEngine::oscSend_control_set_peaks(const uint pluginId) const noexcept
@@ -400,7 +409,15 @@ void CarlaEngine::oscSend_control_set_peaks(const uint pluginId) const noexcept
     char targetPath[std::strlen(pData->oscData->path)+11];
     std::strcpy(targetPath, pData->oscData->path);
     std::strcat(targetPath, "/set_peaks");
-    try_lo_send(pData->oscData->target, targetPath, "iffff", static_cast<int32_t>(pluginId), epData.insPeak[0], epData.insPeak[1], epData.outsPeak[0], epData.outsPeak[1]);
+    try_lo_send_control(targetPath, "iffff", static_cast<int32_t>(pluginId), epData.insPeak[0], epData.insPeak[1], epData.outsPeak[0], epData.outsPeak[1]);
+}
+
+void CarlaEngine::oscSend_control_updates() const noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(pData->oscData != nullptr,);
+    CARLA_SAFE_ASSERT_RETURN(pData->oscData->target != nullptr,);
+
+    pData->osc.sendControlUpdates();
 }
 
 void CarlaEngine::oscSend_control_exit() const noexcept
@@ -413,7 +430,7 @@ void CarlaEngine::oscSend_control_exit() const noexcept
     char targetPath[std::strlen(pData->oscData->path)+6];
     std::strcpy(targetPath, pData->oscData->path);
     std::strcat(targetPath, "/exit");
-    try_lo_send(pData->oscData->target, targetPath, "");
+    try_lo_send_control(targetPath, "");
 }
 #endif // BUILD_BRIDGE
 
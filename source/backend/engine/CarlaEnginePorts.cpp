@@ -91,7 +91,10 @@ CarlaEngineEventPort::CarlaEngineEventPort(const CarlaEngineClient& client, cons
     carla_debug("CarlaEngineEventPort::CarlaEngineEventPort(%s)", bool2str(isInputPort));
 
     if (kProcessMode == ENGINE_PROCESS_MODE_PATCHBAY)
+    {
         fBuffer = new EngineEvent[kMaxEngineEventInternalCount];
+        carla_zeroStructs(fBuffer, kMaxEngineEventInternalCount);
+    }
 }
 
 CarlaEngineEventPort::~CarlaEngineEventPort() noexcept
@@ -112,7 +115,7 @@ void CarlaEngineEventPort::initBuffer() noexcept
     if (kProcessMode == ENGINE_PROCESS_MODE_CONTINUOUS_RACK || kProcessMode == ENGINE_PROCESS_MODE_BRIDGE)
         fBuffer = kClient.getEngine().getInternalEventBuffer(kIsInput);
     else if (kProcessMode == ENGINE_PROCESS_MODE_PATCHBAY && ! kIsInput)
-        carla_zeroStructs(fBuffer, kMaxEngineEventInternalCount);
+        clearEngineEvents(fBuffer);
 }
 
 uint32_t CarlaEngineEventPort::getEventCount() const noexcept
@@ -121,15 +124,7 @@ uint32_t CarlaEngineEventPort::getEventCount() const noexcept
     CARLA_SAFE_ASSERT_RETURN(fBuffer != nullptr, 0);
     CARLA_SAFE_ASSERT_RETURN(kProcessMode != ENGINE_PROCESS_MODE_SINGLE_CLIENT && kProcessMode != ENGINE_PROCESS_MODE_MULTIPLE_CLIENTS, 0);
 
-    uint32_t i=0;
-
-    for (; i < kMaxEngineEventInternalCount; ++i)
-    {
-        if (fBuffer[i].type == kEngineEventTypeNull)
-            break;
-    }
-
-    return i;
+    return getEngineEventCount(fBuffer);
 }
 
 const EngineEvent& CarlaEngineEventPort::getEvent(const uint32_t index) const noexcept
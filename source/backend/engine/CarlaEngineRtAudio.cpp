@@ -19,9 +19,10 @@
 #include "CarlaEngineInternal.hpp"
 #include "CarlaBackendUtils.hpp"
 #include "CarlaMathUtils.hpp"
+#include "CarlaRingBuffer.hpp"
+#include "CarlaSemUtils.hpp"
 #include "CarlaStringList.hpp"
-
-#include "RtLinkedList.hpp"
+#include "CarlaThread.hpp"
 
 #include "jackbridge/JackBridge.hpp"
 
@@ -165,18 +166,21 @@ public:
           fAudioInterleaved(false),
           fAudioInCount(0),
           fAudioOutCount(0),
-          fLastEventTime(0),
           fDeviceName(),
           fAudioIntBufIn(nullptr),
           fAudioIntBufOut(nullptr),
+          fBlockClock(),
           fMidiIns(),
-          fMidiInEvents(),
+          fMidiInMutex(),
           fMidiOuts(),
           fMidiOutMutex(),
-          fMidiOutVector(EngineMidiEvent::kDataSize)
+          fMidiOutRing(),
+          fMidiOutThread(this)
     {
         carla_debug("CarlaEngineRtAudio::CarlaEngineRtAudio(%i)", api);
 
+        fMidiOutRing.createBuffer(kMidiOutRingSize);
+
         // just to make sure
         pData->options.transportMode = ENGINE_TRANSPORT_MODE_INTERNAL;
     }
@@ -185,7 +189,6 @@ public:
     {
         CARLA_SAFE_ASSERT(fAudioInCount == 0);
         CARLA_SAFE_ASSERT(fAudioOutCount == 0);
-        CARLA_SAFE_ASSERT(fLastEventTime == 0);
         carla_debug("CarlaEngineRtAudio::~CarlaEngineRtAudio()");
     }
 
@@ -195,7 +198,6 @@ public:
     {
         CARLA_SAFE_ASSERT_RETURN(fAudioInCount == 0, false);
         CARLA_SAFE_ASSERT_RETURN(fAudioOutCount == 0, false);
-        CARLA_SAFE_ASSERT_RETURN(fLastEventTime == 0, false);
         CARLA_SAFE_ASSERT_RETURN(clientName != nullptr && clientName[0] != '\0', false);
         carla_debug("CarlaEngineRtAudio::init(\"%s\")", clientName);
 
@@ -306,7 +308,10 @@ public:
 
         fAudioInCount  = iParams.nChannels;
         fAudioOutCount = oParams.nChannels;
-        fLastEventTime = 0;
+
+        fBlockClock.reset(static_cast<double>(bufferFrames) * 1000000000.0 / pData->sampleRate);
+        fMidiOutRing.clearData();
+        fMidiOutThread.startThread(true);
 
         if (fAudioInCount > 0)
             fAudioIntBufIn = new float[fAudioInCount*bufferFrames];
@@ -354,14 +359,21 @@ public:
             }
         }
 
+        // the audio thread is not queueing anything anymore, let the MIDI one finish
+        fMidiOutThread.signalThreadShouldExit();
+        fMidiOutThread.wakeUp();
+        fMidiOutThread.stopThread(-1);
+
         // clear engine data
         CarlaEngine::close();
 
         pData->graph.destroy();
 
+        fMidiInMutex.lock();
+
         for (LinkedList<MidiInPort>::Itenerator it = fMidiIns.begin2(); it.valid(); it.next())
         {
-            static MidiInPort fallback = { nullptr, { '\0' } };
+            static MidiInPort fallback = { nullptr, nullptr, { '\0' } };
 
             MidiInPort& inPort(it.getValue(fallback));
             CARLA_SAFE_ASSERT_CONTINUE(inPort.port != nullptr);
@@ -369,10 +381,11 @@ public:
             inPort.port->cancelCallback();
             inPort.port->closePort();
             delete inPort.port;
+            delete inPort.queue;
         }
 
         fMidiIns.clear();
-        fMidiInEvents.clear();
+        fMidiInMutex.unlock();
 
         fMidiOutMutex.lock();
 
@@ -392,7 +405,6 @@ public:
 
         fAudioInCount  = 0;
         fAudioOutCount = 0;
-        fLastEventTime = 0;
         fDeviceName.clear();
 
         if (fAudioIntBufIn != nullptr)
@@ -516,7 +528,7 @@ public:
 
         for (LinkedList<MidiInPort>::Itenerator it=fMidiIns.begin2(); it.valid(); it.next())
         {
-            static const MidiInPort fallback = { nullptr, { '\0' } };
+            static const MidiInPort fallback = { nullptr, nullptr, { '\0' } };
 
             const MidiInPort& inPort(it.getValue(fallback));
             CARLA_SAFE_ASSERT_CONTINUE(inPort.port != nullptr);
@@ -629,55 +641,75 @@ protected:
         }
 
         // initialize events
-        carla_zeroStructs(pData->events.in,  kMaxEngineEventInternalCount);
-        carla_zeroStructs(pData->events.out, kMaxEngineEventInternalCount);
+        clearEngineEvents(pData->events.in);
+        clearEngineEvents(pData->events.out);
+
+        // input events that arrived during the previous period get placed in this block, at the same offsets
+        const double prevBlockStart(fBlockClock.t0);
+        fBlockClock.update(carla_gettime_ns());
+        const double prevBlockLength(fBlockClock.t0 - prevBlockStart);
 
-        if (fMidiInEvents.mutex.tryLock())
+        // (dis)connecting ports takes this lock, events will come in the next block then
+        if (fMidiInMutex.tryLock())
         {
             uint32_t engineEventIndex = 0;
-            fMidiInEvents.splice();
 
-            for (LinkedList<RtMidiEvent>::Itenerator it = fMidiInEvents.data.begin2(); it.valid(); it.next())
+            while (engineEventIndex < kMaxEngineEventInternalCount)
             {
-                static const RtMidiEvent fallback = { 0, 0, { 0 } };
+                MidiInQueue* queue = nullptr;
 
-                const RtMidiEvent& midiEvent(it.getValue(fallback));
-                CARLA_SAFE_ASSERT_CONTINUE(midiEvent.size > 0);
+                // merge all inputs in time order
+                for (LinkedList<MidiInPort>::Itenerator it = fMidiIns.begin2(); it.valid(); it.next())
+                {
+                    static const MidiInPort fallback = { nullptr, nullptr, { '\0' } };
 
-                EngineEvent& engineEvent(pData->events.in[engineEventIndex++]);
+                    const MidiInPort& inPort(it.getValue(fallback));
+                    CARLA_SAFE_ASSERT_CONTINUE(inPort.queue != nullptr);
 
-                if (midiEvent.time < pData->timeInfo.frame)
-                {
-                    engineEvent.time = 0;
-                }
-                else if (midiEvent.time >= pData->timeInfo.frame + nframes)
-                {
-                    carla_stderr("MIDI Event in the future!, %i vs %i", engineEvent.time, pData->timeInfo.frame);
-                    engineEvent.time = static_cast<uint32_t>(pData->timeInfo.frame) + nframes - 1;
+                    if (! inPort.queue->fetchPending())
+                        continue;
+                    if (static_cast<double>(inPort.queue->pendingTime) >= fBlockClock.t0)
+                        continue;
+
+                    if (queue == nullptr || inPort.queue->pendingTime < queue->pendingTime)
+                        queue = inPort.queue;
                 }
+
+                if (queue == nullptr)
+                    break;
+
+                queue->hasPending = false;
+
+                EngineEvent& engineEvent(pData->events.in[engineEventIndex]);
+
+                const double offset(static_cast<double>(queue->pendingTime) - prevBlockStart);
+
+                if (offset <= 0.0 || prevBlockLength <= 0.0)
+                    engineEvent.time = 0;
                 else
-                    engineEvent.time = static_cast<uint32_t>(midiEvent.time - pData->timeInfo.frame);
+                    engineEvent.time = std::min(static_cast<uint32_t>(offset / prevBlockLength * nframes), nframes - 1);
 
-                engineEvent.fillFromMidiData(midiEvent.size, midiEvent.data, 0);
+                engineEvent.fillFromMidiData(queue->pendingSize, queue->pendingData, 0);
 
-                if (engineEventIndex >= kMaxEngineEventInternalCount)
-                    break;
+                if (engineEvent.type != kEngineEventTypeNull)
+                    ++engineEventIndex;
             }
 
-            fMidiInEvents.data.clear();
-            fMidiInEvents.mutex.unlock();
+            fMidiInMutex.unlock();
         }
 
         pData->graph.process(pData, inBuf, outBuf, nframes);
 
-        fMidiOutMutex.lock();
-
+        // unlocked read, worst case is queueing or skipping events during a port (dis)connection
         if (fMidiOuts.count() > 0)
         {
             uint8_t size     = 0;
             uint8_t mdata[3] = { 0, 0, 0 };
             uint8_t mdataTmp[EngineMidiEvent::kDataSize];
             const uint8_t* mdataPtr;
+            bool queuedAny = false;
+
+            const double nsPerFrame(fBlockClock.period / nframes);
 
             for (ushort i=0; i < kMaxEngineEventInternalCount; ++i)
             {
@@ -725,22 +757,21 @@ protected:
 
                 if (size > 0)
                 {
-                    fMidiOutVector.assign(mdataPtr, mdataPtr + size);
+                    // this block's audio is heard one period from now, so are its events
+                    fMidiOutRing.writeULong(static_cast<uint64_t>(fBlockClock.t0 + fBlockClock.period + engineEvent.time * nsPerFrame));
+                    fMidiOutRing.writeByte(size);
+                    fMidiOutRing.writeCustomData(mdataPtr, size);
 
-                    for (LinkedList<MidiOutPort>::Itenerator it=fMidiOuts.begin2(); it.valid(); it.next())
-                    {
-                        static MidiOutPort fallback = { nullptr, { '\0' } };
-
-                        MidiOutPort& outPort(it.getValue(fallback));
-                        CARLA_SAFE_ASSERT_CONTINUE(outPort.port != nullptr);
+                    if (! fMidiOutRing.commitWrite())
+                        break;
 
-                        outPort.port->sendMessage(&fMidiOutVector);
-                    }
+                    queuedAny = true;
                 }
             }
-        }
 
-        fMidiOutMutex.unlock();
+            if (queuedAny)
+                fMidiOutThread.wakeUp();
+        }
 
         if (fAudioInterleaved)
         {
@@ -753,37 +784,47 @@ protected:
         (void)streamTime; (void)status;
     }
 
-    void handleMidiCallback(double timeStamp, std::vector<uchar>* const message)
+    // Sends all outgoing MIDI events at the time they were queued for.
+    void runMidiOut(CarlaThread& thread, carla_sem_t& sem)
     {
-        const size_t messageSize(message->size());
+        std::vector<uint8_t> message;
+        message.reserve(EngineMidiEvent::kDataSize);
+
+        uint8_t data[0xff];
+
+        while (! thread.shouldThreadExit())
+        {
+            if (! fMidiOutRing.isDataAvailableForReading())
+            {
+                carla_sem_timedwait(sem, 50);
+                continue;
+            }
 
-        if (messageSize == 0 || messageSize > EngineMidiEvent::kDataSize)
-            return;
+            const uint64_t time(fMidiOutRing.readULong());
+            const uint8_t  size(fMidiOutRing.readByte());
+            CARLA_SAFE_ASSERT_CONTINUE(size > 0);
 
-        timeStamp /= 2;
+            fMidiOutRing.readCustomData(data, size);
 
-        if (timeStamp > 0.95)
-            timeStamp = 0.95;
-        else if (timeStamp < 0.0)
-            timeStamp = 0.0;
+            for (uint64_t now = carla_gettime_ns(); now < time && ! thread.shouldThreadExit(); now = carla_gettime_ns())
+                carla_usleep(static_cast<uint>(std::min<uint64_t>((time - now) / 1000 + 1, 10000)));
 
-        RtMidiEvent midiEvent;
-        midiEvent.time = pData->timeInfo.frame + uint64_t(timeStamp * (double)pData->bufferSize);
+            message.assign(data, data + size);
 
-        if (midiEvent.time < fLastEventTime)
-            midiEvent.time = fLastEventTime;
-        else
-            fLastEventTime = midiEvent.time;
+            const CarlaMutexLocker cml(fMidiOutMutex);
 
-        midiEvent.size = static_cast<uint8_t>(messageSize);
+            for (LinkedList<MidiOutPort>::Itenerator it=fMidiOuts.begin2(); it.valid(); it.next())
+            {
+                static MidiOutPort fallback = { nullptr, { '\0' } };
 
-        size_t i=0;
-        for (; i < messageSize; ++i)
-            midiEvent.data[i] = message->at(i);
-        for (; i < EngineMidiEvent::kDataSize; ++i)
-            midiEvent.data[i] = 0;
+                MidiOutPort& outPort(it.getValue(fallback));
+                CARLA_SAFE_ASSERT_CONTINUE(outPort.port != nullptr);
 
-        fMidiInEvents.append(midiEvent);
+                try {
+                    outPort.port->sendMessage(&message);
+                } CARLA_SAFE_EXCEPTION_CONTINUE("RtMidiOut::sendMessage");
+            }
+        }
     }
 
     // -------------------------------------------------------------------
@@ -813,8 +854,10 @@ protected:
                 rtMidiIn = new RtMidiIn(getMatchedAudioMidiAPI(fAudio.getCurrentApi()), newRtMidiPortName.buffer(), 512);
             } CARLA_SAFE_EXCEPTION_RETURN("new RtMidiIn", false);
 
+            MidiInQueue* const queue(new MidiInQueue());
+
             rtMidiIn->ignoreTypes();
-            rtMidiIn->setCallback(carla_rtmidi_callback, this);
+            rtMidiIn->setCallback(carla_rtmidi_callback, queue);
 
             bool found = false;
             uint rtMidiPortIndex;
@@ -832,6 +875,7 @@ protected:
             if (! found)
             {
                 delete rtMidiIn;
+                delete queue;
                 return false;
             }
 
@@ -840,15 +884,19 @@ protected:
             }
             catch(...) {
                 delete rtMidiIn;
+                delete queue;
                 return false;
             };
 
             MidiInPort midiPort;
-            midiPort.port = rtMidiIn;
+            midiPort.port  = rtMidiIn;
+            midiPort.queue = queue;
 
             std::strncpy(midiPort.name, portName, STR_MAX);
             midiPort.name[STR_MAX] = '\0';
 
+            const CarlaMutexLocker cml(fMidiInMutex);
+
             fMidiIns.append(midiPort);
             return true;
         }   break;
@@ -921,10 +969,12 @@ protected:
         case kExternalGraphConnectionAudioOut2:
             return CarlaEngine::disconnectExternalGraphPort(connectionType, portId, portName);
 
-        case kExternalGraphConnectionMidiInput:
+        case kExternalGraphConnectionMidiInput: {
+            const CarlaMutexLocker cml(fMidiInMutex);
+
             for (LinkedList<MidiInPort>::Itenerator it=fMidiIns.begin2(); it.valid(); it.next())
             {
-                static MidiInPort fallback = { nullptr, { '\0' } };
+                static MidiInPort fallback = { nullptr, nullptr, { '\0' } };
 
                 MidiInPort& inPort(it.getValue(fallback));
                 CARLA_SAFE_ASSERT_CONTINUE(inPort.port != nullptr);
@@ -935,11 +985,12 @@ protected:
                 inPort.port->cancelCallback();
                 inPort.port->closePort();
                 delete inPort.port;
+                delete inPort.queue;
 
                 fMidiIns.remove(it);
                 return true;
             }
-            break;
+        }   break;
 
         case kExternalGraphConnectionMidiOutput: {
             const CarlaMutexLocker cml(fMidiOutMutex);
@@ -975,7 +1026,6 @@ private:
     bool fAudioInterleaved;
     uint fAudioInCount;
     uint fAudioOutCount;
-    uint64_t fLastEventTime;
 
     // current device name
     CarlaString fDeviceName;
@@ -984,8 +1034,123 @@ private:
     float* fAudioIntBufIn;
     float* fAudioIntBufOut;
 
+    // Delay-locked loop mapping audio periods to the monotonic clock.
+    // Filters out callback wake-up jitter while following the drift between the audio and system clocks.
+    // See "Using a DLL to filter time" by Fons Adriaensen.
+    struct BlockClock {
+        double t0;     // start of the current block, in ns
+        double t1;     // predicted start of the next block
+        double period; // filtered period length
+        double nominalPeriod;
+        double b, c;   // loop coefficients
+
+        BlockClock() noexcept
+            : t0(0.0),
+              t1(0.0),
+              period(0.0),
+              nominalPeriod(0.0),
+              b(0.0),
+              c(0.0) {}
+
+        void reset(const double periodNs) noexcept
+        {
+            // 0.5 Hz bandwidth
+            const double omega(2.0 * M_PI * 0.5 * periodNs / 1000000000.0);
+
+            t0 = t1 = 0.0;
+            period = nominalPeriod = periodNs;
+            b = std::sqrt(2.0) * omega;
+            c = omega * omega;
+        }
+
+        void update(const uint64_t now) noexcept
+        {
+            const double error(static_cast<double>(now) - t1);
+
+            // first block, or after an xrun
+            if (t1 <= 0.0 || std::abs(error) > nominalPeriod)
+            {
+                t0 = static_cast<double>(now);
+                t1 = t0 + nominalPeriod;
+                period = nominalPeriod;
+                return;
+            }
+
+            t0 = t1;
+            t1 += b * error + period;
+            period += c * error;
+        }
+    };
+
+    // Events of one MIDI input, written by its RtMidi thread and read by the audio thread.
+    // Each event is [uint64 time in ns, uint8 size, size bytes].
+    struct MidiInQueue {
+        CarlaHeapRingBuffer ring;
+        uint64_t lastTime;
+
+        // read from the ring, but not due yet
+        bool     hasPending;
+        uint64_t pendingTime;
+        uint8_t  pendingSize;
+        uint8_t  pendingData[EngineMidiEvent::kDataSize];
+
+        MidiInQueue() noexcept
+            : ring(),
+              lastTime(0),
+              hasPending(false),
+              pendingTime(0),
+              pendingSize(0)
+        {
+            ring.createBuffer(kMidiInRingSize);
+        }
+
+        // called from the RtMidi thread
+        void handleMessage(const double timeStamp, const std::vector<uchar>* const message) noexcept
+        {
+            const size_t messageSize(message->size());
+
+            if (messageSize == 0 || messageSize > EngineMidiEvent::kDataSize)
+                return;
+
+            // RtMidi gives the time since the previous message, which keeps bursts of events properly spaced.
+            // Arrival time is used for the first event, and whenever the deltas drift away from the clock.
+            const uint64_t now(carla_gettime_ns());
+            uint64_t time(lastTime + static_cast<uint64_t>(std::max(timeStamp, 0.0) * 1000000000.0));
+
+            if (lastTime == 0 || time > now || now - time > kMidiInMaxDriftNs)
+                time = now;
+
+            lastTime = time;
+
+            ring.writeULong(time);
+            ring.writeByte(static_cast<uint8_t>(messageSize));
+            ring.writeCustomData(message->data(), static_cast<uint32_t>(messageSize));
+            ring.commitWrite();
+        }
+
+        // called from the audio thread
+        bool fetchPending() noexcept
+        {
+            if (hasPending)
+                return true;
+            if (! ring.isDataAvailableForReading())
+                return false;
+
+            pendingTime = ring.readULong();
+            pendingSize = ring.readByte();
+            CARLA_SAFE_ASSERT_RETURN(pendingSize > 0 && pendingSize <= EngineMidiEvent::kDataSize, false);
+
+            ring.readCustomData(pendingData, pendingSize);
+            hasPending = true;
+            return true;
+        }
+
+        CARLA_DECLARE_NON_COPY_STRUCT(MidiInQueue)
+    };
+
     struct MidiInPort {
         RtMidiIn* port;
+        MidiInQueue* queue;
         char name[STR_MAX+1];
     };
 
@@ -994,57 +1159,56 @@ private:
         char name[STR_MAX+1];
     };
 
-    struct RtMidiEvent {
-        uint64_t time; // needs to compare to internal time
-        uint8_t  size;
-        uint8_t  data[EngineMidiEvent::kDataSize];
-    };
+    static const uint32_t kMidiInRingSize   = 0x2000;
+    static const uint64_t kMidiInMaxDriftNs = 2000000;
 
-    struct RtMidiEvents {
-        CarlaMutex mutex;
-        RtLinkedList<RtMidiEvent>::Pool dataPool;
-        RtLinkedList<RtMidiEvent> data;
-        RtLinkedList<RtMidiEvent> dataPending;
+    BlockClock fBlockClock;
 
-        RtMidiEvents()
-            : mutex(),
-              dataPool(512, 512),
-              data(dataPool),
-              dataPending(dataPool) {}
+    LinkedList<MidiInPort> fMidiIns;
+    CarlaMutex             fMidiInMutex;
 
-        ~RtMidiEvents()
+    // High priority thread that takes MIDI output away from the audio thread.
+    class MidiOutThread : public CarlaThread
+    {
+    public:
+        MidiOutThread(CarlaEngineRtAudio* const engine) noexcept
+            : CarlaThread("CarlaEngineRtAudioMidiOut"),
+              kEngine(engine),
+              fSem()
         {
-            clear();
+            carla_sem_create2(fSem);
         }
 
-        void append(const RtMidiEvent& event)
+        ~MidiOutThread() noexcept override
         {
-            mutex.lock();
-            dataPending.append(event);
-            mutex.unlock();
+            carla_sem_destroy2(fSem);
         }
 
-        void clear()
+        void wakeUp() noexcept
         {
-            mutex.lock();
-            data.clear();
-            dataPending.clear();
-            mutex.unlock();
+            carla_sem_post(fSem);
         }
 
-        void splice()
+    protected:
+        void run() override
         {
-            if (dataPending.count() > 0)
-                dataPending.moveTo(data, true /* append */);
+            kEngine->runMidiOut(*this, fSem);
         }
+
+    private:
+        CarlaEngineRtAudio* const kEngine;
+        carla_sem_t fSem;
+
+        CARLA_DECLARE_NON_COPY_CLASS(MidiOutThread)
     };
 
-    LinkedList<MidiInPort> fMidiIns;
-    RtMidiEvents           fMidiInEvents;
+    // holds [uint64 time in ns, uint8 size, size bytes] per event
+    static const uint32_t kMidiOutRingSize = 0x10000;
 
     LinkedList<MidiOutPort> fMidiOuts;
     CarlaMutex              fMidiOutMutex;
-    std::vector<uint8_t>    fMidiOutVector;
+    CarlaHeapRingBuffer     fMidiOutRing;
+    MidiOutThread           fMidiOutThread;
 
     #define handlePtr ((CarlaEngineRtAudio*)userData)
 
@@ -1056,7 +1220,7 @@ private:
 
     static void carla_rtmidi_callback(double timeStamp, std::vector<uchar>* message, void* userData)
     {
-        handlePtr->handleMidiCallback(timeStamp, message);
+        ((MidiInQueue*)userData)->handleMessage(timeStamp, message);
     }
 
     #undef handlePtr
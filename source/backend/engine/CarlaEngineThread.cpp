@@ -23,17 +23,56 @@ CARLA_BACKEND_START_NAMESPACE
 
 // -----------------------------------------------------------------------
 
+// interval for everything else, in ms
+static const uint kSlowIdleInterval = 250;
+
+// -----------------------------------------------------------------------
+
 CarlaEngineThread::CarlaEngineThread(CarlaEngine* const engine) noexcept
     : CarlaThread("CarlaEngineThread"),
-      kEngine(engine)
+      kEngine(engine),
+      fWakePending(0)
 {
     CARLA_SAFE_ASSERT(engine != nullptr);
     carla_debug("CarlaEngineThread::CarlaEngineThread(%p)", engine);
+
+    carla_zeroStruct(fSem);
+    carla_sem_create2(fSem);
+
+    for (uint i=0; i < kDirtyWordCount; ++i)
+        fDirtyPlugins[i] = 0;
 }
 
 CarlaEngineThread::~CarlaEngineThread() noexcept
 {
     carla_debug("CarlaEngineThread::~CarlaEngineThread()");
+
+    carla_sem_destroy2(fSem);
+}
+
+// -----------------------------------------------------------------------
+
+void CarlaEngineThread::requestPluginIdle(const uint pluginId) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(pluginId < kDirtyWordCount * 32,);
+
+    __sync_fetch_and_or(&fDirtyPlugins[pluginId / 32], 1U << (pluginId % 32));
+
+    wakeUp();
+}
+
+void CarlaEngineThread::stop() noexcept
+{
+    signalThreadShouldExit();
+    wakeUp();
+    stopThread(500);
+}
+
+// only post when nobody has yet, futex based semaphores can't count past 1
+void CarlaEngineThread::wakeUp() noexcept
+{
+    if (__sync_bool_compare_and_swap(&fWakePending, 0, 1))
+        carla_sem_post(fSem);
 }
 
 // -----------------------------------------------------------------------
@@ -49,7 +88,10 @@ void CarlaEngineThread::run() noexcept
 #ifdef HAVE_LIBLO
     const bool isPlugin(kEngine->getType() == kEngineTypePlugin);
 #endif
-    float value;
+
+    // plugin ids might have changed while stopped, so the first run goes through everyone
+    uint64_t nextFrequentIdle = 0;
+    uint64_t nextSlowIdle     = 0;
 
 #ifdef BUILD_BRIDGE
     for (; ! shouldThreadExit();)
@@ -57,17 +99,28 @@ void CarlaEngineThread::run() noexcept
     for (; kEngine->isRunning() && ! shouldThreadExit();)
 #endif
     {
-#if defined(HAVE_LIBLO) && ! defined(BUILD_BRIDGE)
-        const bool oscRegisted = kEngine->isOscControlRegistered();
-#else
-        const bool oscRegisted = false;
-#endif
-
 #ifdef HAVE_LIBLO
         if (isPlugin)
             kEngine->idleOsc();
 #endif
 
+        uint64_t now = carla_gettime_ns();
+
+        const bool frequentIdle(now >= nextFrequentIdle);
+        const bool slowIdle(now >= nextSlowIdle);
+
+        if (frequentIdle)
+            nextFrequentIdle = now + kFrequentIdleInterval * 1000000ULL;
+        if (slowIdle)
+            nextSlowIdle = now + kSlowIdleInterval * 1000000ULL;
+
+        uint32_t dirtyPlugins[kDirtyWordCount];
+
+        for (uint i=0; i < kDirtyWordCount; ++i)
+            dirtyPlugins[i] = __sync_fetch_and_and(&fDirtyPlugins[i], 0U);
+
+        bool anyNeedsFrequentIdle = false;
+
         for (uint i=0, count = kEngine->getCurrentPluginCount(); i < count; ++i)
         {
             CarlaPlugin* const plugin(kEngine->getPluginUnchecked(i));
@@ -75,6 +128,15 @@ void CarlaEngineThread::run() noexcept
             CARLA_SAFE_ASSERT_CONTINUE(plugin != nullptr && plugin->isEnabled());
             CARLA_SAFE_ASSERT_UINT2(i == plugin->getId(), i, plugin->getId());
 
+            const bool needsFrequentIdle(plugin->needsFrequentIdle());
+            const bool isDirty(i < kDirtyWordCount * 32 && (dirtyPlugins[i / 32] & (1U << (i % 32))) != 0);
+
+            if (needsFrequentIdle)
+                anyNeedsFrequentIdle = true;
+
+            if (! (isDirty || slowIdle || (frequentIdle && needsFrequentIdle)))
+                continue;
+
             const uint hints(plugin->getHints());
             const bool updateUI((hints & PLUGIN_HAS_CUSTOM_UI) != 0 && (hints & PLUGIN_NEEDS_UI_MAIN_THREAD) == 0);
 
@@ -88,46 +150,57 @@ void CarlaEngineThread::run() noexcept
             // -----------------------------------------------------------
             // Post-poned events
 
-            if (oscRegisted || updateUI)
+            if (updateUI)
             {
                 // -------------------------------------------------------
                 // Update parameter outputs
 
                 for (uint32_t j=0, pcount=plugin->getParameterCount(); j < pcount; ++j)
                 {
-                    if (! plugin->isParameterOutput(j))
-                        continue;
-
-                    value = plugin->getParameterValue(j);
-
-#if defined(HAVE_LIBLO) && ! defined(BUILD_BRIDGE)
-                    // Update OSC engine client
-                    if (oscRegisted)
-                        kEngine->oscSend_control_set_parameter_value(i, static_cast<int32_t>(j), value);
-#endif
-                    // Update UI
-                    if (updateUI)
-                        plugin->uiParameterChange(j, value);
+                    if (plugin->isParameterOutput(j))
+                        plugin->uiParameterChange(j, plugin->getParameterValue(j));
                 }
 
-                if (updateUI)
-                {
-                    try {
-                        plugin->uiIdle();
-                    } CARLA_SAFE_EXCEPTION("uiIdle()")
-                }
+                try {
+                    plugin->uiIdle();
+                } CARLA_SAFE_EXCEPTION("uiIdle()")
             }
+        }
+
+        bool needsFrequentWakeUp = anyNeedsFrequentIdle;
 
 #if defined(HAVE_LIBLO) && ! defined(BUILD_BRIDGE)
-            // -----------------------------------------------------------
-            // Update OSC control client peaks
+        // ---------------------------------------------------------------
+        // Update OSC control client, only what changed and at its own rate
 
-            if (oscRegisted)
-                kEngine->oscSend_control_set_peaks(i);
-#endif
+        if (kEngine->isOscControlRegistered())
+        {
+            needsFrequentWakeUp = true;
+
+            if (frequentIdle)
+                kEngine->oscSend_control_updates();
         }
+#endif
+#ifdef HAVE_LIBLO
+        if (isPlugin)
+            needsFrequentWakeUp = true;
+#endif
 
-        carla_msleep(25);
+        // ---------------------------------------------------------------
+        // Sleep until the next regular idle, or until a plugin asks for one
+
+        const uint64_t nextIdle(needsFrequentWakeUp ? std::min(nextFrequentIdle, nextSlowIdle) : nextSlowIdle);
+
+        now = carla_gettime_ns();
+
+        if (nextIdle > now && ! shouldThreadExit())
+        {
+            if (carla_sem_timedwait(fSem, static_cast<uint>((nextIdle - now + 999999ULL) / 1000000ULL)))
+            {
+                fWakePending = 0;
+                __sync_synchronize();
+            }
+        }
     }
 
     carla_debug("CarlaEngineThread closed");
@@ -19,12 +19,16 @@
 #define CARLA_ENGINE_THREAD_HPP_INCLUDED
 
 #include "CarlaBackend.h"
+#include "CarlaSemUtils.hpp"
 #include "CarlaThread.hpp"
 
 CARLA_BACKEND_START_NAMESPACE
 
 // -----------------------------------------------------------------------
 // CarlaEngineThread
+//
+// Sleeps until a plugin has postponed events to deliver, or until it is time for the regular idle calls.
+// Plugins that do not need frequent idle calls are only visited every now and then.
 
 class CarlaEngineThread : public CarlaThread
 {
@@ -32,12 +36,36 @@ public:
     CarlaEngineThread(CarlaEngine* const engine) noexcept;
     ~CarlaEngineThread() noexcept override;
 
+    /*
+     * Mark a plugin as needing an idle call, and wake up the thread.
+     * Real-time safe.
+     */
+    void requestPluginIdle(const uint pluginId) noexcept;
+
+    /*
+     * Stop the thread without waiting for its current sleep to time out.
+     */
+    void stop() noexcept;
+
+    /*
+     * Interval for plugins that need frequent idle calls, and for the OSC control client, in ms.
+     */
+    static const uint kFrequentIdleInterval = 25;
+
 protected:
     void run() noexcept override;
 
 private:
     CarlaEngine* const kEngine;
 
+    static const uint kDirtyWordCount = (MAX_PATCHBAY_PLUGINS + 31) / 32;
+
+    carla_sem_t       fSem;
+    volatile int      fWakePending;
+    volatile uint32_t fDirtyPlugins[kDirtyWordCount];
+
+    void wakeUp() noexcept;
+
     CARLA_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CarlaEngineThread)
 };
 
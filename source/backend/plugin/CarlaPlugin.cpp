@@ -168,6 +168,17 @@ uint32_t CarlaPlugin::getLatencyInFrames() const noexcept
     return 0;
 }
 
+bool CarlaPlugin::getBridgeWakeStats(uint64_t&, uint32_t&, uint32_t*) const noexcept
+{
+    return false;
+}
+
+void CarlaPlugin::getSubBlockStats(uint64_t& splitCount, uint64_t& skippedCount) const noexcept
+{
+    splitCount   = pData->subBlocks.splitCount;
+    skippedCount = pData->subBlocks.skippedCount;
+}
+
 // -------------------------------------------------------------------
 // Information (count)
 
@@ -482,7 +493,7 @@ void CarlaPlugin::randomizeParameters() noexcept
     }
 }
 
-const CarlaStateSave& CarlaPlugin::getStateSave(const bool callPrepareForSave)
+const CarlaStateSave& CarlaPlugin::getStateSave(const bool callPrepareForSave, const bool rawChunk)
 {
     if (callPrepareForSave)
         prepareForSave();
@@ -534,7 +545,15 @@ const CarlaStateSave& CarlaPlugin::getStateSave(const bool callPrepareForSave)
 
         if (data != nullptr && dataSize > 0)
         {
-            pData->stateSave.chunk = CarlaString::asBase64(data, dataSize).dup();
+            if (rawChunk)
+            {
+                pData->stateSave.rawChunk     = data;
+                pData->stateSave.rawChunkSize = dataSize;
+            }
+            else
+            {
+                pData->stateSave.chunk = CarlaString::asBase64(data, dataSize).dup();
+            }
 
             if (pluginType != PLUGIN_INTERNAL)
                 usingChunk = true;
@@ -626,7 +645,7 @@ const CarlaStateSave& CarlaPlugin::getStateSave(const bool callPrepareForSave)
     return pData->stateSave;
 }
 
-void CarlaPlugin::loadStateSave(const CarlaStateSave& stateSave)
+void CarlaPlugin::loadStateSave(const CarlaStateSave& stateSave, const bool sendOsc, const bool sendCallback)
 {
     char strBuf[STR_MAX+1];
     const bool usesMultiProgs(pData->hints & PLUGIN_USES_MULTI_PROGS);
@@ -686,14 +705,14 @@ void CarlaPlugin::loadStateSave(const CarlaStateSave& stateSave)
 
         // set program now, if valid
         if (programId >= 0)
-            setProgram(programId, true, true, true);
+            setProgram(programId, true, sendOsc, sendCallback);
     }
 
     // ---------------------------------------------------------------
     // Part 3 - set midi program
 
     if (stateSave.currentMidiBank >= 0 && stateSave.currentMidiProgram >= 0 && ! usesMultiProgs)
-        setMidiProgramById(static_cast<uint32_t>(stateSave.currentMidiBank), static_cast<uint32_t>(stateSave.currentMidiProgram), true, true, true);
+        setMidiProgramById(static_cast<uint32_t>(stateSave.currentMidiBank), static_cast<uint32_t>(stateSave.currentMidiProgram), true, sendOsc, sendCallback);
 
     // ---------------------------------------------------------------
     // Part 4a - get plugin parameter symbols
@@ -789,12 +808,12 @@ void CarlaPlugin::loadStateSave(const CarlaStateSave& stateSave)
                 if (pData->param.data[index].hints & PARAMETER_USES_SAMPLERATE)
                     stateParameter->value *= sampleRate;
 
-                setParameterValue(static_cast<uint32_t>(index), stateParameter->value, true, true, true);
+                setParameterValue(static_cast<uint32_t>(index), stateParameter->value, true, sendOsc, sendCallback);
             }
 
 #ifndef BUILD_BRIDGE
-            setParameterMidiCC(static_cast<uint32_t>(index), stateParameter->midiCC, true, true);
-            setParameterMidiChannel(static_cast<uint32_t>(index), stateParameter->midiChannel, true, true);
+            setParameterMidiCC(static_cast<uint32_t>(index), stateParameter->midiCC, sendOsc, sendCallback);
+            setParameterMidiChannel(static_cast<uint32_t>(index), stateParameter->midiChannel, sendOsc, sendCallback);
 #endif
         }
         else
@@ -842,7 +861,11 @@ void CarlaPlugin::loadStateSave(const CarlaStateSave& stateSave)
     // ---------------------------------------------------------------
     // Part 6 - set chunk
 
-    if (stateSave.chunk != nullptr && (pData->options & PLUGIN_OPTION_USE_CHUNKS) != 0)
+    if (stateSave.rawChunk != nullptr && (pData->options & PLUGIN_OPTION_USE_CHUNKS) != 0)
+    {
+        setChunkData(stateSave.rawChunk, stateSave.rawChunkSize);
+    }
+    else if (stateSave.chunk != nullptr && (pData->options & PLUGIN_OPTION_USE_CHUNKS) != 0)
     {
         std::vector<uint8_t> chunk(carla_getChunkFromBase64String(stateSave.chunk));
 #ifdef CARLA_PROPER_CPP11_SUPPORT
@@ -863,19 +886,20 @@ void CarlaPlugin::loadStateSave(const CarlaStateSave& stateSave)
         const uint option(1u << i);
 
         if (availOptions & option)
-            setOption(option, (stateSave.options & option) != 0, true);
+            setOption(option, (stateSave.options & option) != 0, sendCallback);
     }
 
-    setDryWet(stateSave.dryWet, true, true);
-    setVolume(stateSave.volume, true, true);
-    setBalanceLeft(stateSave.balanceLeft, true, true);
-    setBalanceRight(stateSave.balanceRight, true, true);
-    setPanning(stateSave.panning, true, true);
-    setCtrlChannel(stateSave.ctrlChannel, true, true);
-    setActive(stateSave.active, true, true);
+    setDryWet(stateSave.dryWet, sendOsc, sendCallback);
+    setVolume(stateSave.volume, sendOsc, sendCallback);
+    setBalanceLeft(stateSave.balanceLeft, sendOsc, sendCallback);
+    setBalanceRight(stateSave.balanceRight, sendOsc, sendCallback);
+    setPanning(stateSave.panning, sendOsc, sendCallback);
+    setCtrlChannel(stateSave.ctrlChannel, sendOsc, sendCallback);
+    setActive(stateSave.active, sendOsc, sendCallback);
 #endif
 
-    pData->engine->callback(ENGINE_CALLBACK_UPDATE, pData->id, 0, 0, 0.0f, nullptr);
+    if (sendCallback)
+        pData->engine->callback(ENGINE_CALLBACK_UPDATE, pData->id, 0, 0, 0.0f, nullptr);
 }
 
 bool CarlaPlugin::saveStateToFile(const char* const filename)
@@ -883,18 +907,34 @@ bool CarlaPlugin::saveStateToFile(const char* const filename)
     CARLA_SAFE_ASSERT_RETURN(filename != nullptr && filename[0] != '\0', false);
     carla_debug("CarlaPlugin::saveStateToFile(\"%s\")", filename);
 
-    MemoryOutputStream out, streamState;
-    getStateSave().dumpToMemoryStream(streamState);
-
-    out << "<?xml version='1.0' encoding='UTF-8'?>\n";
-    out << "<!DOCTYPE CARLA-PRESET>\n";
-    out << "<CARLA-PRESET VERSION='2.0'>\n";
-    out << streamState;
-    out << "</CARLA-PRESET>\n";
-
     const String jfilename = String(CharPointer_UTF8(filename));
     File file(jfilename);
 
+    MemoryOutputStream out;
+
+    if (file.hasFileExtension("carbs"))
+    {
+        CarlaBinaryStateWriter writer(true);
+        writer.addStateSave(getStateSave(true, true));
+
+        // the chunk points into the plugin, don't keep it around
+        pData->stateSave.rawChunk     = nullptr;
+        pData->stateSave.rawChunkSize = 0;
+
+        CARLA_SAFE_ASSERT_RETURN(writer.writeToStream(out), false);
+    }
+    else
+    {
+        MemoryOutputStream streamState;
+        getStateSave().dumpToMemoryStream(streamState);
+
+        out << "<?xml version='1.0' encoding='UTF-8'?>\n";
+        out << "<!DOCTYPE CARLA-PRESET>\n";
+        out << "<CARLA-PRESET VERSION='2.0'>\n";
+        out << streamState;
+        out << "</CARLA-PRESET>\n";
+    }
+
     if (file.replaceWithData(out.getData(), out.getDataSize()))
         return true;
 
@@ -913,6 +953,23 @@ bool CarlaPlugin::loadStateFromFile(const char* const filename)
     File file(jfilename);
     CARLA_SAFE_ASSERT_RETURN(file.existsAsFile(), false);
 
+    if (CarlaBinaryStateFile::isBinaryStateFile(filename))
+    {
+        CarlaBinaryStateFile binaryState;
+        CARLA_SAFE_ASSERT_RETURN(binaryState.openFile(filename), false);
+        CARLA_SAFE_ASSERT_RETURN(binaryState.isPreset(), false);
+
+        if (! binaryState.fillStateSave(0, pData->stateSave))
+            return false;
+
+        loadStateSave(pData->stateSave);
+
+        // the chunk points into the file we are about to close
+        pData->stateSave.rawChunk     = nullptr;
+        pData->stateSave.rawChunkSize = 0;
+        return true;
+    }
+
     XmlDocument xml(file);
     ScopedPointer<XmlElement> xmlElement(xml.getDocumentElement(true));
     CARLA_SAFE_ASSERT_RETURN(xmlElement != nullptr, false);
@@ -1274,10 +1331,6 @@ void CarlaPlugin::setEnabled(const bool yesNo) noexcept
 
 void CarlaPlugin::setActive(const bool active, const bool sendOsc, const bool sendCallback) noexcept
 {
-#ifndef BUILD_BRIDGE
-    CARLA_SAFE_ASSERT_RETURN(sendOsc || sendCallback,); // never call this from RT
-#endif
-
     if (pData->active == active)
         return;
 
@@ -1491,9 +1544,6 @@ void CarlaPlugin::setPanningRT(const float value) noexcept
 
 void CarlaPlugin::setCtrlChannel(const int8_t channel, const bool sendOsc, const bool sendCallback) noexcept
 {
-#ifndef BUILD_BRIDGE
-    CARLA_SAFE_ASSERT_RETURN(sendOsc || sendCallback,); // never call this from RT
-#endif
     CARLA_SAFE_ASSERT_RETURN(channel >= -1 && channel < MAX_MIDI_CHANNELS,);
 
     if (pData->ctrlChannel == channel)
@@ -1582,9 +1632,6 @@ void CarlaPlugin::setParameterValueByRealIndex(const int32_t rindex, const float
 
 void CarlaPlugin::setParameterMidiChannel(const uint32_t parameterId, const uint8_t channel, const bool sendOsc, const bool sendCallback) noexcept
 {
-#ifndef BUILD_BRIDGE
-    CARLA_SAFE_ASSERT_RETURN(sendOsc || sendCallback,); // never call this from RT
-#endif
     CARLA_SAFE_ASSERT_RETURN(parameterId < pData->param.count,);
     CARLA_SAFE_ASSERT_RETURN(channel < MAX_MIDI_CHANNELS,);
 
@@ -1606,9 +1653,6 @@ void CarlaPlugin::setParameterMidiChannel(const uint32_t parameterId, const uint
 
 void CarlaPlugin::setParameterMidiCC(const uint32_t parameterId, const int16_t cc, const bool sendOsc, const bool sendCallback) noexcept
 {
-#ifndef BUILD_BRIDGE
-    CARLA_SAFE_ASSERT_RETURN(sendOsc || sendCallback,); // never call this from RT
-#endif
     CARLA_SAFE_ASSERT_RETURN(parameterId < pData->param.count,);
     CARLA_SAFE_ASSERT_RETURN(cc >= -1 && cc < MAX_MIDI_CONTROL,);
 
@@ -1870,11 +1914,10 @@ void CarlaPlugin::idle()
 #endif
     }
 
-    const CarlaMutexLocker sl(pData->postRtEvents.getDataMutex());
+    PluginPostRtEvent event;
 
-    for (RtLinkedList<PluginPostRtEvent>::Itenerator it = pData->postRtEvents.getDataIterator(); it.valid(); it.next())
+    while (pData->postRtEvents.get(event))
     {
-        const PluginPostRtEvent& event(it.getValue(kPluginPostRtEventFallback));
         CARLA_SAFE_ASSERT_CONTINUE(event.type != kPluginPostRtEventNull);
 
         switch (event.type)
@@ -2038,7 +2081,14 @@ void CarlaPlugin::idle()
         }
     }
 
-    pData->postRtEvents.clearData();
+    if (const uint32_t lostEvents = pData->postRtEvents.takeOverflowCount())
+        carla_stderr2("Plugin '%s' lost %u events from the audio thread, the queue was full", pData->name, lostEvents);
+}
+
+bool CarlaPlugin::needsFrequentIdle() const noexcept
+{
+    // custom UIs not tied to the main thread get idle and output parameter updates from the engine thread
+    return (pData->hints & PLUGIN_HAS_CUSTOM_UI) != 0 && (pData->hints & PLUGIN_NEEDS_UI_MAIN_THREAD) == 0;
 }
 
 bool CarlaPlugin::tryLock(const bool forcedOffline) noexcept
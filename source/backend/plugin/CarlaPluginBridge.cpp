@@ -31,6 +31,8 @@
 #include <ctime>
 
 #include "water/files/File.h"
+#include "water/files/FileInputStream.h"
+#include "water/files/FileOutputStream.h"
 #include "water/misc/Time.h"
 #include "water/threads/ChildProcess.h"
 
@@ -38,17 +40,14 @@
 
 using water::ChildProcess;
 using water::File;
+using water::FileInputStream;
+using water::FileOutputStream;
 using water::String;
 using water::StringArray;
 using water::Time;
 
 CARLA_BACKEND_START_NAMESPACE
 
-// ---------------------------------------------------------------------------------------------------------------------
-// Fallback data
-
-static const ExternalMidiNote kExternalMidiNoteFallback = { -1, 0, 0 };
-
 // ---------------------------------------------------------------------------------------------------------------------
 
 static String findWinePrefix(const String filename, const int recursionLimit = 10)
@@ -204,6 +203,12 @@ protected:
             std::snprintf(strBuf, STR_MAX, "%u", options.uiBridgesTimeout);
             carla_setenv("ENGINE_OPTION_UI_BRIDGES_TIMEOUT",strBuf);
 
+            std::snprintf(strBuf, STR_MAX, "%u", options.minSubBlockSize);
+            carla_setenv("ENGINE_OPTION_MIN_SUB_BLOCK_SIZE", strBuf);
+
+            std::snprintf(strBuf, STR_MAX, "%u", options.bridgesSpinTime);
+            carla_setenv("ENGINE_OPTION_PLUGIN_BRIDGES_SPIN_TIME", strBuf);
+
             if (options.pathLADSPA != nullptr)
                 carla_setenv("ENGINE_OPTION_PLUGIN_PATH_LADSPA", options.pathLADSPA);
             else
@@ -366,6 +371,9 @@ public:
           fTimedOut(false),
           fTimedError(false),
           fProcWaitTime(0),
+          fPipelined(engine->getOptions().pipelinedPluginBridges),
+          fProcessPending(0),
+          fPoolBufferSize(0),
           fLastPongTime(-1),
           fBridgeBinary(),
           fBridgeThread(engine, this),
@@ -385,6 +393,8 @@ public:
         carla_debug("CarlaPluginBridge::CarlaPluginBridge(%p, %i, %s, %s)", engine, id, BinaryType2Str(btype), PluginType2Str(ptype));
 
         pData->hints |= PLUGIN_IS_BRIDGE;
+
+        carla_zeroBytes(fMidiOut, kBridgeRtClientDataMidiOutSize);
     }
 
     ~CarlaPluginBridge() override
@@ -411,6 +421,8 @@ public:
 
         if (fBridgeThread.isThreadRunning())
         {
+            waitForPendingProcess();
+
             fShmNonRtClientControl.writeOpcode(kPluginBridgeNonRtClientQuit);
             fShmNonRtClientControl.commitWrite();
 
@@ -458,7 +470,15 @@ public:
 
     uint32_t getLatencyInFrames() const noexcept override
     {
-        return fLatency;
+        // output is one block late when pipelined
+        return fPipelined ? fLatency + pData->engine->getBufferSize() : fLatency;
+    }
+
+    bool getBridgeWakeStats(uint64_t& count, uint32_t& maxUsecs, uint32_t* histogram) const noexcept override
+    {
+        CARLA_SAFE_ASSERT_RETURN(histogram != nullptr, false);
+
+        return fShmRtClientControl.getWakeStats(count, maxUsecs, histogram);
     }
 
     // -------------------------------------------------------------------
@@ -835,15 +855,27 @@ public:
         CARLA_SAFE_ASSERT_RETURN(data != nullptr,);
         CARLA_SAFE_ASSERT_RETURN(dataSize > 0,);
 
-        CarlaString dataBase64(CarlaString::asBase64(data, dataSize));
-        CARLA_SAFE_ASSERT_RETURN(dataBase64.length() > 0,);
-
         String filePath(File::getSpecialLocation(File::tempDirectory).getFullPathName());
 
         filePath += CARLA_OS_SEP_STR ".CarlaChunk_";
         filePath += fShmAudioPool.getFilenameSuffix();
 
-        if (File(filePath).replaceWithText(dataBase64.buffer()))
+        bool written;
+
+        {
+            // encode straight into the file, without a full base64 copy in memory
+            const File chunkFile(filePath);
+            chunkFile.deleteFile(); // streams append to existing files
+
+            FileOutputStream stream(chunkFile);
+
+            written = stream.openedOk() && carla_writeBase64ToStream(stream, data, dataSize);
+
+            stream.flush();
+            written = written && stream.getStatus().wasOk();
+        }
+
+        if (written)
         {
             const uint32_t ulength(static_cast<uint32_t>(filePath.length()));
 
@@ -918,6 +950,12 @@ public:
         CarlaPlugin::idle();
     }
 
+    bool needsFrequentIdle() const noexcept override
+    {
+        // the bridge needs to be pinged and its non-rt data read
+        return true;
+    }
+
     // -------------------------------------------------------------------
     // Plugin state
 
@@ -1077,6 +1115,7 @@ public:
         if (fInfo.aIns <= 2 && fInfo.aOuts <= 2 && (fInfo.aIns == fInfo.aOuts || fInfo.aIns == 0 || fInfo.aOuts == 0))
             pData->extraHints |= PLUGIN_EXTRA_HINT_CAN_RUN_RACK;
 
+        // also updates latency, as the audio channel count might have changed
         bufferSizeChanged(pData->engine->getBufferSize());
         reloadPrograms(true);
 
@@ -1090,6 +1129,8 @@ public:
     {
         CARLA_SAFE_ASSERT_RETURN(! fTimedError,);
 
+        waitForPendingProcess();
+
         {
             const CarlaMutexLocker _cml(fShmNonRtClientControl.mutex);
 
@@ -1108,6 +1149,8 @@ public:
     {
         CARLA_SAFE_ASSERT_RETURN(! fTimedError,);
 
+        waitForPendingProcess();
+
         {
             const CarlaMutexLocker _cml(fShmNonRtClientControl.mutex);
 
@@ -1147,6 +1190,21 @@ public:
             pData->needsReset = false;
         }
 
+        // --------------------------------------------------------------------------------------------------------
+        // Pipelined mode, wait for the block started during the previous cycle.
+        // Must happen before writing any events, the bridge would apply them to that block otherwise
+
+        bool hasPipelinedOutput = false;
+
+        if (fPipelined && ! joinPendingProcess(hasPipelinedOutput))
+        {
+            for (uint32_t i=0; i < pData->audioOut.count; ++i)
+                carla_zeroFloats(audioOut[i], frames);
+            for (uint32_t i=0; i < pData->cvOut.count; ++i)
+                carla_zeroFloats(cvOut[i], frames);
+            return;
+        }
+
         // --------------------------------------------------------------------------------------------------------
         // Event Input
 
@@ -1155,11 +1213,11 @@ public:
             // ----------------------------------------------------------------------------------------------------
             // MIDI Input (External)
 
-            if (pData->extNotes.mutex.tryLock())
             {
-                for (RtLinkedList<ExternalMidiNote>::Itenerator it = pData->extNotes.data.begin2(); it.valid(); it.next())
+                ExternalMidiNote note;
+
+                while (pData->extNotes.data.get(note))
                 {
-                    const ExternalMidiNote& note(it.getValue(kExternalMidiNoteFallback));
                     CARLA_SAFE_ASSERT_CONTINUE(note.channel >= 0 && note.channel < MAX_MIDI_CHANNELS);
 
                     uint8_t data1, data2, data3;
@@ -1177,9 +1235,6 @@ public:
                     fShmRtClientControl.commitWrite();
                 }
 
-                pData->extNotes.data.clear();
-                pData->extNotes.mutex.unlock();
-
             } // End of MIDI Input (External)
 
             // ----------------------------------------------------------------------------------------------------
@@ -1356,11 +1411,11 @@ public:
                 }
             }
 
-            pData->postRtEvents.trySplice();
+            pData->postRtEvents.notifyRT();
 
         } // End of Event Input
 
-        if (! processSingle(audioIn, audioOut, cvIn, cvOut, frames))
+        if (! processSingle(audioIn, audioOut, cvIn, cvOut, frames, hasPipelinedOutput))
             return;
 
         // --------------------------------------------------------------------------------------------------------
@@ -1384,7 +1439,8 @@ public:
 
             uint32_t time;
             uint8_t port, size;
-            const uint8_t* midiData(fShmRtClientControl.data->midiOut);
+            // the pipelined bridge is already writing the next block, use the copy taken before starting it
+            const uint8_t* midiData(fPipelined ? fMidiOut : fShmRtClientControl.data->midiOut);
 
             for (std::size_t read=0; read<kBridgeRtClientDataMidiOutSize-kBridgeBaseMidiOutHeaderSize;)
             {
@@ -1417,10 +1473,12 @@ public:
     }
 
     bool processSingle(const float** const audioIn, float** const audioOut,
-                       const float** const cvIn, float** const cvOut, const uint32_t frames)
+                       const float** const cvIn, float** const cvOut, const uint32_t frames,
+                       const bool hasPipelinedOutput)
     {
         CARLA_SAFE_ASSERT_RETURN(! fTimedError, false);
         CARLA_SAFE_ASSERT_RETURN(frames > 0, false);
+        CARLA_SAFE_ASSERT_RETURN(frames <= fPoolBufferSize, false);
 
         if (pData->audioIn.count > 0)
         {
@@ -1462,7 +1520,27 @@ public:
         // Reset audio buffers
 
         for (uint32_t i=0; i < fInfo.aIns; ++i)
-            carla_copyFloats(fShmAudioPool.data + (i * frames), audioIn[i], frames);
+            carla_copyFloats(fShmAudioPool.data + (i * fPoolBufferSize), audioIn[i], frames);
+
+        if (fPipelined)
+        {
+            // take the previous block output before the bridge starts writing the next one
+            if (hasPipelinedOutput)
+            {
+                for (uint32_t i=0; i < fInfo.aOuts; ++i)
+                    carla_copyFloats(audioOut[i], fShmAudioPool.data + ((i + fInfo.aIns) * fPoolBufferSize), frames);
+
+                if (pData->event.portOut != nullptr)
+                    std::memcpy(fMidiOut, fShmRtClientControl.data->midiOut, kBridgeRtClientDataMidiOutSize);
+            }
+            else
+            {
+                for (uint32_t i=0; i < fInfo.aOuts; ++i)
+                    carla_zeroFloats(audioOut[i], frames);
+
+                carla_zeroBytes(fMidiOut, kBridgeBaseMidiOutHeaderSize);
+            }
+        }
 
         // --------------------------------------------------------------------------------------------------------
         // TimeInfo
@@ -1497,106 +1575,50 @@ public:
             fShmRtClientControl.commitWrite();
         }
 
-        waitForClient("process", fProcWaitTime);
-
-        if (fTimedOut)
+        if (fPipelined)
         {
-            pData->singleMutex.unlock();
-            return false;
+            // do not wait, the result is collected on the next cycle
+            fShmRtClientControl.postToClient();
+            __sync_lock_test_and_set(&fProcessPending, 1);
         }
-
-        for (uint32_t i=0; i < fInfo.aOuts; ++i)
-            carla_copyFloats(audioOut[i], fShmAudioPool.data + ((i + fInfo.aIns) * frames), frames);
-
-#ifndef BUILD_BRIDGE
-        // --------------------------------------------------------------------------------------------------------
-        // Post-processing (dry/wet, volume and balance)
-
+        else
         {
-            const bool doVolume  = (pData->hints & PLUGIN_CAN_VOLUME) != 0 && carla_isNotEqual(pData->postProc.volume, 1.0f);
-            const bool doDryWet  = (pData->hints & PLUGIN_CAN_DRYWET) != 0 && carla_isNotEqual(pData->postProc.dryWet, 1.0f);
-            const bool doBalance = (pData->hints & PLUGIN_CAN_BALANCE) != 0 && ! (carla_isEqual(pData->postProc.balanceLeft, -1.0f) && carla_isEqual(pData->postProc.balanceRight, 1.0f));
-            const bool isMono    = (pData->audioIn.count == 1);
+            waitForClient("process", fProcWaitTime);
 
-            bool isPair;
-            float bufValue, oldBufLeft[doBalance ? frames : 1];
-
-            for (uint32_t i=0; i < pData->audioOut.count; ++i)
+            if (fTimedOut)
             {
-                // Dry/Wet
-                if (doDryWet)
-                {
-                    const uint32_t c = isMono ? 0 : i;
-
-                    for (uint32_t k=0; k < frames; ++k)
-                    {
-                        if (k < pData->latency.frames)
-                            bufValue = pData->latency.buffers[c][k];
-                        else if (pData->latency.frames < frames)
-                            bufValue = audioIn[c][k-pData->latency.frames];
-                        else
-                            bufValue = audioIn[c][k];
-
-                        audioOut[i][k] = (audioOut[i][k] * pData->postProc.dryWet) + (bufValue * (1.0f - pData->postProc.dryWet));
-                    }
-                }
-
-                // Balance
-                if (doBalance)
-                {
-                    isPair = (i % 2 == 0);
-
-                    if (isPair)
-                    {
-                        CARLA_ASSERT(i+1 < pData->audioOut.count);
-                        carla_copyFloats(oldBufLeft, audioOut[i], frames);
-                    }
-
-                    float balRangeL = (pData->postProc.balanceLeft  + 1.0f)/2.0f;
-                    float balRangeR = (pData->postProc.balanceRight + 1.0f)/2.0f;
+                pData->singleMutex.unlock();
+                return false;
+            }
 
-                    for (uint32_t k=0; k < frames; ++k)
-                    {
-                        if (isPair)
-                        {
-                            // left
-                            audioOut[i][k]  = oldBufLeft[k]     * (1.0f - balRangeL);
-                            audioOut[i][k] += audioOut[i+1][k] * (1.0f - balRangeR);
-                        }
-                        else
-                        {
-                            // right
-                            audioOut[i][k]  = audioOut[i][k] * balRangeR;
-                            audioOut[i][k] += oldBufLeft[k]   * balRangeL;
-                        }
-                    }
-                }
+            for (uint32_t i=0; i < fInfo.aOuts; ++i)
+                carla_copyFloats(audioOut[i], fShmAudioPool.data + ((i + fInfo.aIns) * fPoolBufferSize), frames);
+        }
 
-                // Volume (and buffer copy)
-                if (doVolume)
-                {
-                    for (uint32_t k=0; k < frames; ++k)
-                        audioOut[i][k] *= pData->postProc.volume;
-                }
-            }
+#ifndef BUILD_BRIDGE
+        // --------------------------------------------------------------------------------------------------------
+        // Post-processing (dry/wet, volume and balance)
 
-        } // End of Post-processing
+        pData->postProcessAudio(audioOut, audioIn, 0, true, nullptr, 0, frames);
 
         // --------------------------------------------------------------------------------------------------------
         // Save latency values for next callback
 
-        if (const uint32_t latframes = pData->latency.frames)
+        // the latency can be known before the buffers are, when there are no audio channels yet
+        if (const uint32_t latframes = pData->latency.channels > 0 ? pData->latency.frames : 0)
         {
+            const uint32_t latchannels = std::min(pData->audioIn.count, pData->latency.channels);
+
             if (latframes <= frames)
             {
-                for (uint32_t i=0; i < pData->audioIn.count; ++i)
+                for (uint32_t i=0; i < latchannels; ++i)
                     carla_copyFloats(pData->latency.buffers[i], audioIn[i]+(frames-latframes), latframes);
             }
             else
             {
                 const uint32_t diff = pData->latency.frames-frames;
 
-                for (uint32_t i=0, k; i<pData->audioIn.count; ++i)
+                for (uint32_t i=0, k; i<latchannels; ++i)
                 {
                     // push back buffer by 'frames'
                     for (k=0; k < diff; ++k)
@@ -1619,6 +1641,8 @@ public:
 
     void bufferSizeChanged(const uint32_t newBufferSize) override
     {
+        waitForPendingProcess();
+
         resizeAudioPool(newBufferSize);
 
         {
@@ -1631,10 +1655,15 @@ public:
         fProcWaitTime = 1000;
 
         waitForClient("buffersize", 1000);
+
+        // the pipelined block delay depends on buffer size
+        updateLatency();
     }
 
     void sampleRateChanged(const double newSampleRate) override
     {
+        waitForPendingProcess();
+
         {
             fShmRtClientControl.writeOpcode(kPluginBridgeRtClientSetSampleRate);
             fShmRtClientControl.writeDouble(newSampleRate);
@@ -1649,6 +1678,8 @@ public:
 
     void offlineModeChanged(const bool isOffline) override
     {
+        waitForPendingProcess();
+
         {
             fShmRtClientControl.writeOpcode(kPluginBridgeRtClientSetOnline);
             fShmRtClientControl.writeBool(isOffline);
@@ -2158,24 +2189,23 @@ public:
                 File chunkFile(realChunkFilePath);
                 CARLA_SAFE_ASSERT_BREAK(chunkFile.existsAsFile());
 
-                fInfo.chunk = carla_getChunkFromBase64String(chunkFile.loadFileAsString().toRawUTF8());
+                {
+                    FileInputStream stream(chunkFile);
+                    CARLA_SAFE_ASSERT_BREAK(stream.openedOk());
+
+                    fInfo.chunk = carla_getChunkFromBase64Stream(stream, static_cast<std::size_t>(stream.getTotalLength()));
+                }
+
                 chunkFile.deleteFile();
             }   break;
 
             case kPluginBridgeNonRtServerSetLatency:
-                if (true)
-                {
-                    // FIXME - latency adjust code on this file is broken
-                    fShmNonRtServerControl.readUInt();
-                    break;
-                }
-
                 // uint
                 fLatency = fShmNonRtServerControl.readUInt();
-#ifndef BUILD_BRIDGE
-                if (! fInitiated)
-                    pData->latency.recreateBuffers(std::max(fInfo.aIns, fInfo.aOuts), fLatency);
-#endif
+
+                // before init, reload() takes care of it
+                if (fInitiated)
+                    updateLatency();
                 break;
 
             case kPluginBridgeNonRtServerSetParameterText: {
@@ -2460,6 +2490,14 @@ private:
     bool fTimedError;
     uint fProcWaitTime;
 
+    // pipelined mode, the bridge processes a block while the host consumes the previous one
+    const bool fPipelined;
+    volatile int fProcessPending; // set by process(), taken back atomically by whoever waits for the reply
+    uint8_t fMidiOut[kBridgeRtClientDataMidiOutSize];
+
+    // buffer size the audio pool was allocated for, used as stride between ports
+    uint32_t fPoolBufferSize;
+
     int64_t fLastPongTime;
 
     CarlaString             fBridgeBinary;
@@ -2575,6 +2613,7 @@ private:
     void resizeAudioPool(const uint32_t bufferSize)
     {
         fShmAudioPool.resize(bufferSize, fInfo.aIns+fInfo.aOuts, fInfo.cvIns+fInfo.cvOuts);
+        fPoolBufferSize = bufferSize;
 
         fShmRtClientControl.writeOpcode(kPluginBridgeRtClientSetAudioPool);
         fShmRtClientControl.writeULong(static_cast<uint64_t>(fShmAudioPool.dataSize));
@@ -2583,6 +2622,32 @@ private:
         waitForClient("resize-pool", 5000);
     }
 
+    // apply the current latency (which includes the extra block when pipelined) to the engine client and dry/wet buffers
+    void updateLatency()
+    {
+        CARLA_SAFE_ASSERT_RETURN(pData->client != nullptr,);
+
+        const uint32_t latency = getLatencyInFrames();
+#ifndef BUILD_BRIDGE
+        const uint32_t latencyChannels = latency != 0 ? std::max(fInfo.aIns, fInfo.aOuts) : 0;
+
+        if (pData->latency.channels == latencyChannels && pData->latency.frames == latency)
+            return;
+#else
+        if (pData->latency.frames == latency)
+            return;
+#endif
+
+        const ScopedSingleProcessLocker sspl(this, true);
+
+        pData->client->setLatency(latency);
+#ifndef BUILD_BRIDGE
+        pData->latency.recreateBuffers(latencyChannels, latency);
+#else
+        pData->latency.frames = latency;
+#endif
+    }
+
     void waitForClient(const char* const action, const uint msecs)
     {
         CARLA_SAFE_ASSERT_RETURN(! fTimedOut,);
@@ -2595,6 +2660,55 @@ private:
         carla_stderr2("waitForClient(%s) timed out", action);
     }
 
+    void waitForClientReply(const char* const action, const uint msecs)
+    {
+        CARLA_SAFE_ASSERT_RETURN(! fTimedOut,);
+        CARLA_SAFE_ASSERT_RETURN(! fTimedError,);
+
+        if (fShmRtClientControl.waitForClientReply(msecs))
+            return;
+
+        fTimedOut = true;
+        carla_stderr2("waitForClientReply(%s) timed out", action);
+    }
+
+    // join the block still running in pipelined mode, needed before any other request that waits for the client.
+    // must not be called while process() can run, callers may already hold the single process lock.
+    void waitForPendingProcess()
+    {
+        if (! __sync_bool_compare_and_swap(&fProcessPending, 1, 0))
+            return;
+
+        if (fTimedOut || fTimedError)
+            return;
+
+        waitForClientReply("process", fProcWaitTime);
+    }
+
+    // the same from the audio thread, under the single process lock like processSingle() so that it
+    // stays out of the way of setActive() and others. returns false if it could not lock or timed out.
+    bool joinPendingProcess(bool& hasOutput)
+    {
+#ifndef STOAT_TEST_BUILD
+        if (pData->engine->isOffline())
+        {
+            pData->singleMutex.lock();
+        }
+        else
+#endif
+        if (! pData->singleMutex.tryLock())
+            return false;
+
+        if (__sync_bool_compare_and_swap(&fProcessPending, 1, 0))
+        {
+            waitForClientReply("process", fProcWaitTime);
+            hasOutput = ! fTimedOut;
+        }
+
+        pData->singleMutex.unlock();
+        return ! fTimedOut;
+    }
+
     CARLA_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CarlaPluginBridge)
 };
 
@@ -1375,13 +1375,11 @@ public:
             // ----------------------------------------------------------------------------------------------------
             // MIDI Input (External)
 
-            if (pData->extNotes.mutex.tryLock())
             {
-                ExternalMidiNote note = { 0, 0, 0 };
+                ExternalMidiNote note;
 
-                for (; midiEventCount < kPluginMaxMidiEvents && ! pData->extNotes.data.isEmpty();)
+                for (; midiEventCount < kPluginMaxMidiEvents && pData->extNotes.data.get(note);)
                 {
-                    note = pData->extNotes.data.getFirst(note, true);
                     CARLA_SAFE_ASSERT_CONTINUE(note.channel >= 0 && note.channel < MAX_MIDI_CHANNELS);
 
                     snd_seq_event_t& seqEvent(fMidiEvents[midiEventCount++]);
@@ -1392,8 +1390,6 @@ public:
                     seqEvent.data.note.velocity = note.velo;
                 }
 
-                pData->extNotes.mutex.unlock();
-
             } // End of MIDI Input (External)
 
             // ----------------------------------------------------------------------------------------------------
@@ -1424,8 +1420,13 @@ public:
 
                 if (isSampleAccurate && event.time > timeOffset)
                 {
-                    if (processSingle(audioIn, audioOut, event.time - timeOffset, timeOffset, midiEventCount))
+                    if (! pData->shouldSplitBlock(event.time, timeOffset, frames))
+                    {
+                        startTime = event.time - timeOffset;
+                    }
+                    else if (processSingle(audioIn, audioOut, event.time - timeOffset, timeOffset, midiEventCount))
                     {
+                        pData->countBlockSplit();
                         startTime  = 0;
                         timeOffset = event.time;
                         midiEventCount = 0;
@@ -1713,7 +1714,7 @@ public:
                 } // switch (event.type)
             }
 
-            pData->postRtEvents.trySplice();
+            pData->postRtEvents.notifyRT();
 
             if (frames > timeOffset)
                 processSingle(audioIn, audioOut, frames - timeOffset, timeOffset, midiEventCount);
@@ -1856,73 +1857,7 @@ public:
         // --------------------------------------------------------------------------------------------------------
         // Post-processing (dry/wet, volume and balance)
 
-        {
-            const bool doDryWet  = (pData->hints & PLUGIN_CAN_DRYWET) != 0 && carla_isNotEqual(pData->postProc.dryWet, 1.0f);
-            const bool doBalance = (pData->hints & PLUGIN_CAN_BALANCE) != 0 && ! (carla_isEqual(pData->postProc.balanceLeft, -1.0f) && carla_isEqual(pData->postProc.balanceRight, 1.0f));
-            const bool isMono    = (pData->audioIn.count == 1);
-
-            bool isPair;
-            float bufValue, oldBufLeft[doBalance ? frames : 1];
-
-            for (uint32_t i=0; i < pData->audioOut.count; ++i)
-            {
-                // Dry/Wet
-                if (doDryWet)
-                {
-                    const uint32_t c = isMono ? 0 : i;
-
-                    for (uint32_t k=0; k < frames; ++k)
-                    {
-                        if (k < pData->latency.frames)
-                            bufValue = pData->latency.buffers[c][k];
-                        else if (pData->latency.frames < frames)
-                            bufValue = fAudioInBuffers[c][k-pData->latency.frames];
-                        else
-                            bufValue = fAudioInBuffers[c][k];
-
-                        fAudioOutBuffers[i][k] = (fAudioOutBuffers[i][k] * pData->postProc.dryWet) + (bufValue * (1.0f - pData->postProc.dryWet));
-                    }
-                }
-
-                // Balance
-                if (doBalance)
-                {
-                    isPair = (i % 2 == 0);
-
-                    if (isPair)
-                    {
-                        CARLA_ASSERT(i+1 < pData->audioOut.count);
-                        carla_copyFloats(oldBufLeft, fAudioOutBuffers[i], frames);
-                    }
-
-                    float balRangeL = (pData->postProc.balanceLeft  + 1.0f)/2.0f;
-                    float balRangeR = (pData->postProc.balanceRight + 1.0f)/2.0f;
-
-                    for (uint32_t k=0; k < frames; ++k)
-                    {
-                        if (isPair)
-                        {
-                            // left
-                            fAudioOutBuffers[i][k]  = oldBufLeft[k]            * (1.0f - balRangeL);
-                            fAudioOutBuffers[i][k] += fAudioOutBuffers[i+1][k] * (1.0f - balRangeR);
-                        }
-                        else
-                        {
-                            // right
-                            fAudioOutBuffers[i][k]  = fAudioOutBuffers[i][k] * balRangeR;
-                            fAudioOutBuffers[i][k] += oldBufLeft[k]          * balRangeL;
-                        }
-                    }
-                }
-
-                // Volume (and buffer copy)
-                {
-                    for (uint32_t k=0; k < frames; ++k)
-                        audioOut[i][k+timeOffset] = fAudioOutBuffers[i][k] * pData->postProc.volume;
-                }
-            }
-
-        } // End of Post-processing
+        pData->postProcessAudio(fAudioOutBuffers, fAudioInBuffers, 0, true, audioOut, timeOffset, frames);
 
         // --------------------------------------------------------------------------------------------------------
         // Save latency values for next callback
@@ -20,12 +20,11 @@
 
 #ifdef HAVE_FLUIDSYNTH
 
+#include "CarlaFluidSynthUtils.hpp"
 #include "CarlaMathUtils.hpp"
 
 #include "water/text/StringArray.h"
 
-#include <fluidsynth.h>
-
 #if (FLUIDSYNTH_VERSION_MAJOR >= 1 && FLUIDSYNTH_VERSION_MINOR >= 1 && FLUIDSYNTH_VERSION_MICRO >= 4)
 # define FLUIDSYNTH_VERSION_NEW_API
 #endif
@@ -38,9 +37,9 @@ using water::StringArray;
 CARLA_BACKEND_START_NAMESPACE
 
 // -------------------------------------------------------------------------------------------------------------------
-// Fallback data
+// SoundFonts loaded by any FluidSynth plugin instance
 
-static const ExternalMidiNote kExternalMidiNoteFallback = { -1, 0, 0 };
+static FluidSoundFontCache sSoundFontCache;
 
 // -------------------------------------------------------------------------------------------------------------------
 
@@ -77,6 +76,9 @@ public:
         fSynth = new_fluid_synth(fSettings);
         CARLA_SAFE_ASSERT_RETURN(fSynth != nullptr,);
 
+        // load SoundFonts through the shared cache
+        sSoundFontCache.addLoaderToSynth(fSynth);
+
 #ifdef FLUIDSYNTH_VERSION_NEW_API
         fluid_synth_set_sample_rate(fSynth, (float)pData->engine->getSampleRate());
 #endif
@@ -1097,11 +1099,11 @@ public:
             // ----------------------------------------------------------------------------------------------------
             // MIDI Input (External)
 
-            if (pData->extNotes.mutex.tryLock())
             {
-                for (RtLinkedList<ExternalMidiNote>::Itenerator it = pData->extNotes.data.begin2(); it.valid(); it.next())
+                ExternalMidiNote note;
+
+                while (pData->extNotes.data.get(note))
                 {
-                    const ExternalMidiNote& note(it.getValue(kExternalMidiNoteFallback));
                     CARLA_SAFE_ASSERT_CONTINUE(note.channel >= 0 && note.channel < MAX_MIDI_CHANNELS);
 
                     if (note.velo > 0)
@@ -1110,9 +1112,6 @@ public:
                         fluid_synth_noteoff(fSynth,note.channel, note.note);
                 }
 
-                pData->extNotes.data.clear();
-                pData->extNotes.mutex.unlock();
-
             } // End of MIDI Input (External)
 
             // ----------------------------------------------------------------------------------------------------
@@ -1137,10 +1136,12 @@ public:
 
                 CARLA_ASSERT_INT2(event.time >= timeOffset, event.time, timeOffset);
 
-                if (event.time > timeOffset)
+                // fluidsynth has no timed events, skipped splits make them happen a few frames early
+                if (event.time > timeOffset && pData->shouldSplitBlock(event.time, timeOffset, frames))
                 {
                     if (processSingle(audioOut, event.time - timeOffset, timeOffset))
                     {
+                        pData->countBlockSplit();
                         timeOffset = event.time;
 
                         if (pData->midiprog.current >= 0 && pData->midiprog.count > 0 && pData->ctrlChannel >= 0 && pData->ctrlChannel < MAX_MIDI_CHANNELS)
@@ -1391,7 +1392,7 @@ public:
                 } // switch (event.type)
             }
 
-            pData->postRtEvents.trySplice();
+            pData->postRtEvents.notifyRT();
 
             if (frames > timeOffset)
                 processSingle(audioOut, frames - timeOffset, timeOffset);
@@ -1467,55 +1468,11 @@ public:
         // --------------------------------------------------------------------------------------------------------
         // Post-processing (volume and balance)
 
-        {
-            // note - balance not possible with kUse16Outs, so we can safely skip fAudioOutBuffers
-            const bool doVolume  = (pData->hints & PLUGIN_CAN_VOLUME) != 0 && carla_isNotEqual(pData->postProc.volume, 1.0f);
-            const bool doBalance = (pData->hints & PLUGIN_CAN_BALANCE) != 0 && ! (carla_isEqual(pData->postProc.balanceLeft, -1.0f) && carla_isEqual(pData->postProc.balanceRight, 1.0f));
-
-            float oldBufLeft[doBalance ? frames : 1];
-
-            for (uint32_t i=0; i < pData->audioOut.count; ++i)
-            {
-                // Balance
-                if (doBalance)
-                {
-                    if (i % 2 == 0)
-                        carla_copyFloats(oldBufLeft, outBuffer[i]+timeOffset, frames);
-
-                    float balRangeL = (pData->postProc.balanceLeft  + 1.0f)/2.0f;
-                    float balRangeR = (pData->postProc.balanceRight + 1.0f)/2.0f;
-
-                    for (uint32_t k=0; k < frames; ++k)
-                    {
-                        if (i % 2 == 0)
-                        {
-                            // left
-                            outBuffer[i][k+timeOffset]  = oldBufLeft[k]                * (1.0f - balRangeL);
-                            outBuffer[i][k+timeOffset] += outBuffer[i+1][k+timeOffset] * (1.0f - balRangeR);
-                        }
-                        else
-                        {
-                            // right
-                            outBuffer[i][k+timeOffset]  = outBuffer[i][k+timeOffset] * balRangeR;
-                            outBuffer[i][k+timeOffset] += oldBufLeft[k]              * balRangeL;
-                        }
-                    }
-                }
-
-                // Volume
-                if (kUse16Outs)
-                {
-                    for (uint32_t k=0; k < frames; ++k)
-                        outBuffer[i][k+timeOffset] = fAudio16Buffers[i][k] * pData->postProc.volume;
-                }
-                else if (doVolume)
-                {
-                    for (uint32_t k=0; k < frames; ++k)
-                        outBuffer[i][k+timeOffset] *= pData->postProc.volume;
-                }
-            }
-
-        } // End of Post-processing
+        // note - balance not possible with kUse16Outs
+        if (kUse16Outs)
+            pData->postProcessAudio(fAudio16Buffers, nullptr, 0, false, outBuffer, timeOffset, frames);
+        else
+            pData->postProcessAudio(outBuffer, nullptr, timeOffset, false, nullptr, 0, frames);
 #else
         if (kUse16Outs)
         {
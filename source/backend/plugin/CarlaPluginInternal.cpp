@@ -20,6 +20,7 @@
 
 #include "CarlaLibCounter.hpp"
 #include "CarlaMathUtils.hpp"
+#include "CarlaPostProcUtils.hpp"
 
 CARLA_BACKEND_START_NAMESPACE
 
@@ -376,27 +377,12 @@ const MidiProgramData& PluginMidiProgramData::getCurrent() const noexcept
 // ProtectedData::ExternalNotes
 
 CarlaPlugin::ProtectedData::ExternalNotes::ExternalNotes() noexcept
-    : mutex(),
-      dataPool(32, 152),
-      data(dataPool) {}
-
-CarlaPlugin::ProtectedData::ExternalNotes::~ExternalNotes() noexcept
-{
-    clear();
-}
+    : data() {}
 
 void CarlaPlugin::ProtectedData::ExternalNotes::appendNonRT(const ExternalMidiNote& note) noexcept
 {
-    mutex.lock();
-    data.append_sleepy(note);
-    mutex.unlock();
-}
-
-void CarlaPlugin::ProtectedData::ExternalNotes::clear() noexcept
-{
-    mutex.lock();
-    data.clear();
-    mutex.unlock();
+    if (! data.put(note))
+        carla_stderr2("External note dropped, the plugin is not processing them fast enough");
 }
 
 // -----------------------------------------------------------------------
@@ -500,50 +486,21 @@ void CarlaPlugin::ProtectedData::Latency::recreateBuffers(const uint32_t newChan
 // -----------------------------------------------------------------------
 // ProtectedData::PostRtEvents
 
-CarlaPlugin::ProtectedData::PostRtEvents::PostRtEvents() noexcept
-    : dataPool(128, 128),
-      dataPendingRT(dataPool),
-      data(dataPool),
-      dataMutex(),
-      dataPendingMutex() {}
-
-CarlaPlugin::ProtectedData::PostRtEvents::~PostRtEvents() noexcept
-{
-    dataMutex.lock();
-    data.clear();
-    dataMutex.unlock();
-
-    dataPendingMutex.lock();
-    dataPendingRT.clear();
-    dataPendingMutex.unlock();
-}
+CarlaPlugin::ProtectedData::PostRtEvents::PostRtEvents(ProtectedData* const owner) noexcept
+    : kOwner(owner),
+      data() {}
 
 void CarlaPlugin::ProtectedData::PostRtEvents::appendRT(const PluginPostRtEvent& e) noexcept
 {
-    CARLA_SAFE_ASSERT_RETURN(dataPendingMutex.tryLock(),);
-
-    dataPendingRT.append(e);
-    dataPendingMutex.unlock();
+    // a full queue is counted, and reported later from idle()
+    data.put(e);
 }
 
-void CarlaPlugin::ProtectedData::PostRtEvents::trySplice() noexcept
+void CarlaPlugin::ProtectedData::PostRtEvents::notifyRT() noexcept
 {
-    if (dataMutex.tryLock())
-    {
-        if (dataPendingRT.count() > 0)
-            dataPendingRT.moveTo(data, true);
-        dataMutex.unlock();
-    }
-}
-
-void CarlaPlugin::ProtectedData::PostRtEvents::clearData() noexcept
-{
-    const bool tryLockOk(dataMutex.tryLock());
-    CARLA_SAFE_ASSERT(! tryLockOk);
-    data.clear();
-
-    if (tryLockOk)
-        dataMutex.unlock();
+    // let the engine thread know this plugin needs an idle call
+    if (! data.isEmpty())
+        kOwner->engine->requestPluginIdle(kOwner->id);
 }
 
 // -----------------------------------------------------------------------
@@ -572,6 +529,13 @@ void CarlaPlugin::ProtectedData::PostUiEvents::clear() noexcept
     mutex.unlock();
 }
 
+// -----------------------------------------------------------------------
+// ProtectedData::SubBlocks
+
+CarlaPlugin::ProtectedData::SubBlocks::SubBlocks() noexcept
+    : splitCount(0),
+      skippedCount(0) {}
+
 #ifndef BUILD_BRIDGE
 // -----------------------------------------------------------------------
 // ProtectedData::PostProc
@@ -581,7 +545,11 @@ CarlaPlugin::ProtectedData::PostProc::PostProc() noexcept
       volume(1.0f),
       balanceLeft(-1.0f),
       balanceRight(1.0f),
-      panning(0.0f) {}
+      panning(0.0f),
+      lastDryWet(1.0f),
+      lastVolume(1.0f),
+      lastBalanceLeft(-1.0f),
+      lastBalanceRight(1.0f) {}
 #endif
 
 // -----------------------------------------------------------------------
@@ -621,8 +589,9 @@ CarlaPlugin::ProtectedData::ProtectedData(CarlaEngine* const eng, const uint idx
       stateSave(),
       extNotes(),
       latency(),
-      postRtEvents(),
-      postUiEvents()
+      postRtEvents(this),
+      postUiEvents(),
+      subBlocks()
 #ifndef BUILD_BRIDGE
     , postProc()
 #endif
@@ -736,6 +705,60 @@ void CarlaPlugin::ProtectedData::clearBuffers() noexcept
 #endif
 }
 
+#ifndef BUILD_BRIDGE
+// -----------------------------------------------------------------------
+// Post-processing
+
+void CarlaPlugin::ProtectedData::postProcessAudio(float* const* const buffers, const float* const* const dryBuffers, const uint32_t offset,
+                                                  const bool dryUsesLatency, float* const* const outBuffers, const uint32_t outOffset,
+                                                  const uint32_t frames) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(buffers != nullptr,);
+    CARLA_SAFE_ASSERT_RETURN(frames > 0,);
+
+    // values to reach at the end of this block
+    const float dryWet       = (hints & PLUGIN_CAN_DRYWET)  != 0 ? postProc.dryWet       :  1.0f;
+    const float volume       = (hints & PLUGIN_CAN_VOLUME)  != 0 ? postProc.volume       :  1.0f;
+    const float balanceLeft  = (hints & PLUGIN_CAN_BALANCE) != 0 ? postProc.balanceLeft  : -1.0f;
+    const float balanceRight = (hints & PLUGIN_CAN_BALANCE) != 0 ? postProc.balanceRight :  1.0f;
+
+    const CarlaPostProcValues from = { postProc.lastDryWet, postProc.lastVolume, postProc.lastBalanceLeft, postProc.lastBalanceRight };
+    const CarlaPostProcValues to   = { dryWet, volume, balanceLeft, balanceRight };
+
+    carla_postProcessAudio(buffers, offset, audioOut.count, dryBuffers, audioIn.count,
+                           dryUsesLatency ? latency.buffers : nullptr, latency.frames,
+                           outBuffers, outOffset, frames, from, to);
+
+    postProc.lastDryWet       = dryWet;
+    postProc.lastVolume       = volume;
+    postProc.lastBalanceLeft  = balanceLeft;
+    postProc.lastBalanceRight = balanceRight;
+}
+#endif
+
+// -----------------------------------------------------------------------
+// Sub-block splitting
+
+bool CarlaPlugin::ProtectedData::shouldSplitBlock(const uint32_t eventTime, const uint32_t timeOffset, const uint32_t frames) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(eventTime >= timeOffset && eventTime <= frames, false);
+
+    const uint minSubBlockSize(engine->getOptions().minSubBlockSize);
+
+    if (eventTime - timeOffset < minSubBlockSize || frames - eventTime < minSubBlockSize)
+    {
+        ++subBlocks.skippedCount;
+        return false;
+    }
+
+    return true;
+}
+
+void CarlaPlugin::ProtectedData::countBlockSplit() noexcept
+{
+    ++subBlocks.splitCount;
+}
+
 // -----------------------------------------------------------------------
 // Post-poned events
 
@@ -23,10 +23,11 @@
 #include "CarlaLibUtils.hpp"
 #include "CarlaStateUtils.hpp"
 
+#include "CarlaLockFreeQueue.hpp"
 #include "CarlaMIDI.h"
 #include "CarlaMutex.hpp"
 #include "CarlaString.hpp"
-#include "RtLinkedList.hpp"
+#include "LinkedList.hpp"
 
 CARLA_BACKEND_START_NAMESPACE
 
@@ -253,15 +254,12 @@ struct CarlaPlugin::ProtectedData {
 
     CarlaStateSave stateSave;
 
+    // notes sent from the host, the audio thread takes them with data.get()
     struct ExternalNotes {
-        CarlaMutex mutex;
-        RtLinkedList<ExternalMidiNote>::Pool dataPool;
-        RtLinkedList<ExternalMidiNote> data;
+        CarlaMpscQueue<ExternalMidiNote, 256> data;
 
         ExternalNotes() noexcept;
-        ~ExternalNotes() noexcept;
         void appendNonRT(const ExternalMidiNote& note) noexcept;
-        void clear() noexcept;
 
         CARLA_DECLARE_NON_COPY_STRUCT(ExternalNotes)
 
@@ -285,32 +283,27 @@ struct CarlaPlugin::ProtectedData {
 
     } latency;
 
+    // events from the audio thread, handled later in idle()
     class PostRtEvents {
     public:
-        PostRtEvents() noexcept;
-        ~PostRtEvents() noexcept;
+        PostRtEvents(ProtectedData* const owner) noexcept;
         void appendRT(const PluginPostRtEvent& event) noexcept;
-        void trySplice() noexcept;
-        void clearData() noexcept;
+        void notifyRT() noexcept;
 
-        inline CarlaMutex& getDataMutex() noexcept
+        inline bool get(PluginPostRtEvent& event) noexcept
         {
-            return dataMutex;
+            return data.get(event);
         }
 
-        inline RtLinkedList<PluginPostRtEvent>::Itenerator getDataIterator() const noexcept
+        inline uint32_t takeOverflowCount() noexcept
         {
-            return data.begin2();
+            return data.takeOverflowCount();
         }
 
     private:
-        RtLinkedList<PluginPostRtEvent>::Pool dataPool;
-        RtLinkedList<PluginPostRtEvent> dataPendingRT;
-        RtLinkedList<PluginPostRtEvent> data;
-        CarlaMutex dataMutex;
+        ProtectedData* const kOwner;
 
-        // TESTING for thread-safety, remove later
-        CarlaMutex dataPendingMutex;
+        CarlaMpscQueue<PluginPostRtEvent, 512> data;
 
         CARLA_DECLARE_NON_COPY_CLASS(PostRtEvents)
 
@@ -329,6 +322,17 @@ struct CarlaPlugin::ProtectedData {
 
     } postUiEvents;
 
+    // sub-block splitting stats, only written by the audio thread
+    struct SubBlocks {
+        uint64_t splitCount;
+        uint64_t skippedCount;
+
+        SubBlocks() noexcept;
+
+        CARLA_DECLARE_NON_COPY_STRUCT(SubBlocks)
+
+    } subBlocks;
+
 #ifndef BUILD_BRIDGE
     struct PostProc {
         float dryWet;
@@ -337,6 +341,12 @@ struct CarlaPlugin::ProtectedData {
         float balanceRight;
         float panning;
 
+        // values used at the end of the last processed block, changes are ramped from these
+        float lastDryWet;
+        float lastVolume;
+        float lastBalanceLeft;
+        float lastBalanceRight;
+
         PostProc() noexcept;
 
         CARLA_DECLARE_NON_COPY_STRUCT(PostProc)
@@ -352,6 +362,33 @@ struct CarlaPlugin::ProtectedData {
 
     void clearBuffers() noexcept;
 
+#ifndef BUILD_BRIDGE
+    // -------------------------------------------------------------------
+    // Post-processing
+
+    // Applies dry/wet, balance and volume to the audio outputs, one output at a time (see carla_postProcessAudio).
+    // 'buffers' hold the processed audio starting at 'offset', they are modified in place.
+    // 'dryBuffers' hold the plugin input at the same offset, only needed if the plugin can do dry/wet.
+    // With 'dryUsesLatency' the dry signal is delayed using the latency buffers, which the plugin must keep updated.
+    // If 'outBuffers' is not null, the final result is written there starting at 'outOffset' instead.
+    void postProcessAudio(float* const* const buffers, const float* const* const dryBuffers, const uint32_t offset,
+                          const bool dryUsesLatency, float* const* const outBuffers, const uint32_t outOffset,
+                          const uint32_t frames) noexcept;
+#endif
+
+    // -------------------------------------------------------------------
+    // Sub-block splitting
+
+    // Checks if process() should split the block at an event, to apply it on the right frame.
+    // A split is not worth it if either side would be less than ENGINE_OPTION_MIN_SUB_BLOCK_SIZE frames,
+    // that is the sub-block before the event (from 'timeOffset') or the remaining one (up to 'frames').
+    // The caller then applies the event at 'timeOffset' instead.
+    // When a split is skipped this way, MIDI keeps its frame within the current sub-block.
+    bool shouldSplitBlock(const uint32_t eventTime, const uint32_t timeOffset, const uint32_t frames) noexcept;
+
+    // Counts a split, call it once the sub-block before the event has been processed.
+    void countBlockSplit() noexcept;
+
     // -------------------------------------------------------------------
     // Post-poned events
 
@@ -47,11 +47,6 @@ using water::Time;
 
 CARLA_BACKEND_START_NAMESPACE
 
-// -------------------------------------------------------------------------------------------------------------------
-// Fallback data
-
-static const ExternalMidiNote kExternalMidiNoteFallback = { -1, 0, 0 };
-
 // -------------------------------------------------------------------------------------------------------------------
 
 class CarlaPluginJackThread : public CarlaThread
@@ -440,6 +435,12 @@ public:
         CarlaPlugin::idle();
     }
 
+    bool needsFrequentIdle() const noexcept override
+    {
+        // the bridge needs to be pinged and its non-rt data read
+        return true;
+    }
+
     // -------------------------------------------------------------------
     // Plugin state
 
@@ -663,11 +664,11 @@ public:
             // ----------------------------------------------------------------------------------------------------
             // MIDI Input (External)
 
-            if (pData->extNotes.mutex.tryLock())
             {
-                for (RtLinkedList<ExternalMidiNote>::Itenerator it = pData->extNotes.data.begin2(); it.valid(); it.next())
+                ExternalMidiNote note;
+
+                while (pData->extNotes.data.get(note))
                 {
-                    const ExternalMidiNote& note(it.getValue(kExternalMidiNoteFallback));
                     CARLA_SAFE_ASSERT_CONTINUE(note.channel >= 0 && note.channel < MAX_MIDI_CHANNELS);
 
                     uint8_t data1, data2, data3;
@@ -685,9 +686,6 @@ public:
                     fShmRtClientControl.commitWrite();
                 }
 
-                pData->extNotes.data.clear();
-                pData->extNotes.mutex.unlock();
-
             } // End of MIDI Input (External)
 
             // ----------------------------------------------------------------------------------------------------
@@ -857,7 +855,7 @@ public:
                 }
             }
 
-            pData->postRtEvents.trySplice();
+            pData->postRtEvents.notifyRT();
 
         } // End of Event Input
 
@@ -994,69 +992,7 @@ public:
         // --------------------------------------------------------------------------------------------------------
         // Post-processing (dry/wet, volume and balance)
 
-        {
-            const bool doVolume  = (pData->hints & PLUGIN_CAN_VOLUME) != 0 && carla_isNotEqual(pData->postProc.volume, 1.0f);
-            const bool doDryWet  = (pData->hints & PLUGIN_CAN_DRYWET) != 0 && carla_isNotEqual(pData->postProc.dryWet, 1.0f);
-            const bool doBalance = (pData->hints & PLUGIN_CAN_BALANCE) != 0 && ! (carla_isEqual(pData->postProc.balanceLeft, -1.0f) && carla_isEqual(pData->postProc.balanceRight, 1.0f));
-            const bool isMono    = (pData->audioIn.count == 1);
-
-            bool isPair;
-            float bufValue, oldBufLeft[doBalance ? frames : 1];
-
-            for (uint32_t i=0; i < pData->audioOut.count; ++i)
-            {
-                // Dry/Wet
-                if (doDryWet)
-                {
-                    const uint32_t c = isMono ? 0 : i;
-
-                    for (uint32_t k=0; k < frames; ++k)
-                    {
-                        bufValue = audioIn[c][k];
-                        audioOut[i][k] = (audioOut[i][k] * pData->postProc.dryWet) + (bufValue * (1.0f - pData->postProc.dryWet));
-                    }
-                }
-
-                // Balance
-                if (doBalance)
-                {
-                    isPair = (i % 2 == 0);
-
-                    if (isPair)
-                    {
-                        CARLA_ASSERT(i+1 < pData->audioOut.count);
-                        carla_copyFloats(oldBufLeft, audioOut[i], frames);
-                    }
-
-                    float balRangeL = (pData->postProc.balanceLeft  + 1.0f)/2.0f;
-                    float balRangeR = (pData->postProc.balanceRight + 1.0f)/2.0f;
-
-                    for (uint32_t k=0; k < frames; ++k)
-                    {
-                        if (isPair)
-                        {
-                            // left
-                            audioOut[i][k]  = oldBufLeft[k]     * (1.0f - balRangeL);
-                            audioOut[i][k] += audioOut[i+1][k] * (1.0f - balRangeR);
-                        }
-                        else
-                        {
-                            // right
-                            audioOut[i][k]  = audioOut[i][k] * balRangeR;
-                            audioOut[i][k] += oldBufLeft[k]   * balRangeL;
-                        }
-                    }
-                }
-
-                // Volume (and buffer copy)
-                if (doVolume)
-                {
-                    for (uint32_t k=0; k < frames; ++k)
-                        audioOut[i][k] *= pData->postProc.volume;
-                }
-            }
-
-        } // End of Post-processing
+        pData->postProcessAudio(audioOut, audioIn, 0, false, nullptr, 0, frames);
 #endif
         // --------------------------------------------------------------------------------------------------------
 
@@ -947,10 +947,13 @@ public:
 
                 CARLA_ASSERT_INT2(event.time >= timeOffset, event.time, timeOffset);
 
-                if (isSampleAccurate && event.time > timeOffset)
+                if (isSampleAccurate && event.time > timeOffset && pData->shouldSplitBlock(event.time, timeOffset, frames))
                 {
                     if (processSingle(audioIn, audioOut, event.time - timeOffset, timeOffset))
+                    {
+                        pData->countBlockSplit();
                         timeOffset = event.time;
+                    }
                 }
 
                 switch (event.type)
@@ -1060,7 +1063,7 @@ public:
                 } // switch (event.type)
             }
 
-            pData->postRtEvents.trySplice();
+            pData->postRtEvents.notifyRT();
 
             if (frames > timeOffset)
                 processSingle(audioIn, audioOut, frames - timeOffset, timeOffset);
@@ -1194,73 +1197,7 @@ public:
         // --------------------------------------------------------------------------------------------------------
         // Post-processing (dry/wet, volume and balance)
 
-        {
-            const bool doDryWet  = (pData->hints & PLUGIN_CAN_DRYWET) != 0 && carla_isNotEqual(pData->postProc.dryWet, 1.0f);
-            const bool doBalance = (pData->hints & PLUGIN_CAN_BALANCE) != 0 && ! (carla_isEqual(pData->postProc.balanceLeft, -1.0f) && carla_isEqual(pData->postProc.balanceRight, 1.0f));
-            const bool isMono    = (pData->audioIn.count == 1);
-
-            bool isPair;
-            float bufValue, oldBufLeft[doBalance ? frames : 1];
-
-            for (uint32_t i=0; i < pData->audioOut.count; ++i)
-            {
-                // Dry/Wet
-                if (doDryWet)
-                {
-                    const uint32_t c = isMono ? 0 : i;
-
-                    for (uint32_t k=0; k < frames; ++k)
-                    {
-                        if (k < pData->latency.frames)
-                            bufValue = pData->latency.buffers[c][k];
-                        else if (pData->latency.frames < frames)
-                            bufValue = fAudioInBuffers[c][k-pData->latency.frames];
-                        else
-                            bufValue = fAudioInBuffers[c][k];
-
-                        fAudioOutBuffers[i][k] = (fAudioOutBuffers[i][k] * pData->postProc.dryWet) + (bufValue * (1.0f - pData->postProc.dryWet));
-                    }
-                }
-
-                // Balance
-                if (doBalance)
-                {
-                    isPair = (i % 2 == 0);
-
-                    if (isPair)
-                    {
-                        CARLA_ASSERT(i+1 < pData->audioOut.count);
-                        carla_copyFloats(oldBufLeft, fAudioOutBuffers[i], frames);
-                    }
-
-                    float balRangeL = (pData->postProc.balanceLeft  + 1.0f)/2.0f;
-                    float balRangeR = (pData->postProc.balanceRight + 1.0f)/2.0f;
-
-                    for (uint32_t k=0; k < frames; ++k)
-                    {
-                        if (isPair)
-                        {
-                            // left
-                            fAudioOutBuffers[i][k]  = oldBufLeft[k]            * (1.0f - balRangeL);
-                            fAudioOutBuffers[i][k] += fAudioOutBuffers[i+1][k] * (1.0f - balRangeR);
-                        }
-                        else
-                        {
-                            // right
-                            fAudioOutBuffers[i][k]  = fAudioOutBuffers[i][k] * balRangeR;
-                            fAudioOutBuffers[i][k] += oldBufLeft[k]          * balRangeL;
-                        }
-                    }
-                }
-
-                // Volume (and buffer copy)
-                {
-                    for (uint32_t k=0; k < frames; ++k)
-                        audioOut[i][k+timeOffset] = fAudioOutBuffers[i][k] * pData->postProc.volume;
-                }
-            }
-
-        } // End of Post-processing
+        pData->postProcessAudio(fAudioOutBuffers, fAudioInBuffers, 0, true, audioOut, timeOffset, frames);
 
         // --------------------------------------------------------------------------------------------------------
         // Save latency values for next callback
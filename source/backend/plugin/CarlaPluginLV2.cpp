@@ -28,7 +28,10 @@
 #include "CarlaEngineUtils.hpp"
 #include "CarlaPipeUtils.hpp"
 #include "CarlaPluginUI.hpp"
+#include "CarlaBackgroundWorkPool.hpp"
 #include "Lv2AtomRingBuffer.hpp"
+#include "Lv2FixedUrids.hpp"
+#include "Lv2UridMap.hpp"
 
 #include "../engine/CarlaEngineOsc.hpp"
 #include "../modules/lilv/config/lilv_config.h"
@@ -39,21 +42,17 @@ extern "C" {
 
 #include "water/files/File.h"
 
-#include <string>
 #include <vector>
 
 using water::File;
 
-#define URI_CARLA_ATOM_WORKER "http://kxstudio.sf.net/ns/carla/atomWorker"
-
 CARLA_BACKEND_START_NAMESPACE
 
 // -------------------------------------------------------------------------------------------------------------------
 // Fallback data
 
-static const CustomData       kCustomDataFallback       = { nullptr, nullptr, nullptr };
-static /* */ CustomData       kCustomDataFallbackNC     = { nullptr, nullptr, nullptr };
-static const ExternalMidiNote kExternalMidiNoteFallback = { -1, 0, 0 };
+static const CustomData kCustomDataFallback   = { nullptr, nullptr, nullptr };
+static /* */ CustomData kCustomDataFallbackNC = { nullptr, nullptr, nullptr };
 
 // -------------------------------------------------------------------------------------------------------------------
 
@@ -79,61 +78,6 @@ const uint CARLA_EVENT_TYPE_MESSAGE = 0x10; // unused
 const uint CARLA_EVENT_TYPE_MIDI    = 0x20;
 const uint CARLA_EVENT_TYPE_TIME    = 0x40;
 
-// LV2 URI Map Ids
-enum CarlaLv2URIDs {
-    kUridNull = 0,
-    kUridAtomBlank,
-    kUridAtomBool,
-    kUridAtomChunk,
-    kUridAtomDouble,
-    kUridAtomEvent,
-    kUridAtomFloat,
-    kUridAtomInt,
-    kUridAtomLiteral,
-    kUridAtomLong,
-    kUridAtomNumber,
-    kUridAtomObject,
-    kUridAtomPath,
-    kUridAtomProperty,
-    kUridAtomResource,
-    kUridAtomSequence,
-    kUridAtomSound,
-    kUridAtomString,
-    kUridAtomTuple,
-    kUridAtomURI,
-    kUridAtomURID,
-    kUridAtomVector,
-    kUridAtomTransferAtom,
-    kUridAtomTransferEvent,
-    kUridBufMaxLength,
-    kUridBufMinLength,
-    kUridBufNominalLength,
-    kUridBufSequenceSize,
-    kUridLogError,
-    kUridLogNote,
-    kUridLogTrace,
-    kUridLogWarning,
-    // time base type
-    kUridTimePosition,
-     // time values
-    kUridTimeBar,
-    kUridTimeBarBeat,
-    kUridTimeBeat,
-    kUridTimeBeatUnit,
-    kUridTimeBeatsPerBar,
-    kUridTimeBeatsPerMinute,
-    kUridTimeFrame,
-    kUridTimeFramesPerSecond,
-    kUridTimeSpeed,
-    kUridTimeTicksPerBeat,
-    kUridMidiEvent,
-    kUridParamSampleRate,
-    kUridWindowTitle,
-    kUridCarlaAtomWorker,
-    kUridCarlaTransientWindowId,
-    kUridCount
-};
-
 // LV2 Feature Ids
 enum CarlaLv2Features {
     // DSP features
@@ -504,7 +448,8 @@ private:
 // -------------------------------------------------------------------------------------------------------------------
 
 class CarlaPluginLV2 : public CarlaPlugin,
-                       private CarlaPluginUI::Callback
+                       private CarlaPluginUI::Callback,
+                       private CarlaBackgroundWorkPool::Client
 {
 public:
     CarlaPluginLV2(CarlaEngine* const engine, const uint id)
@@ -527,11 +472,15 @@ public:
           fAtomBufferOut(),
           fAtomForge(),
           fTmpAtomBuffer(nullptr),
+          fWorkerRequests(),
+          fWorkerResponses(),
+          fWorkerRegistered(false),
           fEventsIn(),
           fEventsOut(),
           fLv2Options(),
           fPipeServer(engine, this),
-          fCustomURIDs(kUridCount, std::string("urn:null")),
+          fUridMap(engine->getLv2UridMap()),
+          fUridsSentToUI(0),
           fFirstActive(true),
           fLastStateChunk(nullptr),
           fLastTimeInfo(),
@@ -539,7 +488,7 @@ public:
           fUI()
     {
         carla_debug("CarlaPluginLV2::CarlaPluginLV2(%p, %i)", engine, id);
-        CARLA_SAFE_ASSERT(fCustomURIDs.size() == kUridCount);
+        fUridMap.addFixedURIs(kCarlaLv2URIs, kUridCount);
 
         carla_zeroPointers(fFeatures, kFeatureCountAll+1);
 
@@ -629,6 +578,13 @@ public:
             pData->active = false;
         }
 
+        // waits for any work in progress
+        if (fWorkerRegistered)
+        {
+            pData->engine->getBackgroundWorkPool().removeClient(this);
+            fWorkerRegistered = false;
+        }
+
         if (fDescriptor != nullptr)
         {
             if (fDescriptor->cleanup != nullptr)
@@ -1351,24 +1307,31 @@ public:
                     const CarlaMutexLocker cml(fPipeServer.getPipeLock());
                     const ScopedLocale csl;
 
-                    // write URI mappings
-                    uint32_t u = 0;
-                    for (std::vector<std::string>::iterator it=fCustomURIDs.begin(), end=fCustomURIDs.end(); it != end; ++it, ++u)
-                    {
-                        if (u < kUridCount)
-                            continue;
-                        const std::string& uri(*it);
+                    // write URI mappings, as a single snapshot
+                    const uint32_t uridCount = fUridMap.getCount();
 
-                        std::snprintf(tmpBuf, 0xff, "%u\n", u);
-                        if (! fPipeServer.writeMessage("urid\n", 5))
+                    if (uridCount > kUridCount)
+                    {
+                        if (! fPipeServer.writeMessage("urids\n", 6))
                             return;
 
+                        std::snprintf(tmpBuf, 0xff, "%u\n", static_cast<uint>(kUridCount));
                         if (! fPipeServer.writeMessage(tmpBuf))
                             return;
-                        if (! fPipeServer.writeAndFixMessage(uri.c_str()))
+
+                        std::snprintf(tmpBuf, 0xff, "%u\n", uridCount - kUridCount);
+                        if (! fPipeServer.writeMessage(tmpBuf))
                             return;
+
+                        for (uint32_t u=kUridCount; u < uridCount; ++u)
+                        {
+                            if (! fPipeServer.writeAndFixMessage(getURIDString(u)))
+                                return;
+                        }
                     }
 
+                    fUridsSentToUI = uridCount;
+
                     // write UI options
                     if (! fPipeServer.writeMessage("uiOptions\n", 10))
                         return;
@@ -1572,6 +1535,9 @@ public:
 
     void uiIdle() override
     {
+        // send URIDs mapped since the last time, before any atom that might use them
+        sendNewURIDsToUI();
+
         if (fAtomBufferOut.isDataAvailableForReading())
         {
             Lv2AtomRingBuffer tmpRingBuffer(fAtomBufferOut, fTmpAtomBuffer);
@@ -1584,12 +1550,7 @@ public:
 
             for (; tmpRingBuffer.get(atom, portIndex);)
             {
-                if (atom->type == kUridCarlaAtomWorker)
-                {
-                    CARLA_SAFE_ASSERT_CONTINUE(fExt.worker != nullptr && fExt.worker->work != nullptr);
-                    fExt.worker->work(fHandle, carla_lv2_worker_respond, this, atom->size, LV2_ATOM_BODY_CONST(atom));
-                }
-                else if (fUI.type == UI::TYPE_BRIDGE)
+                if (fUI.type == UI::TYPE_BRIDGE)
                 {
                     if (fPipeServer.isPipeRunning())
                         fPipeServer.writeLv2AtomMessage(portIndex, atom);
@@ -2418,6 +2379,18 @@ public:
             fTmpAtomBuffer = new uint8_t[fAtomBufferOut.getSize()];
         }
 
+        if (fExt.worker != nullptr && fWorkerRequests.getSize() == 0)
+        {
+            fWorkerRequests.createBuffer(std::min(eventBufferSize*32, 1638400U));
+            fWorkerResponses.createBuffer(std::min(eventBufferSize*32, 1638400U));
+        }
+
+        if (fExt.worker != nullptr && ! fWorkerRegistered)
+        {
+            pData->engine->getBackgroundWorkPool().addClient(this);
+            fWorkerRegistered = true;
+        }
+
         if (fEventsIn.ctrl != nullptr && fEventsIn.ctrl->port == nullptr)
             fEventsIn.ctrl->port = pData->event.portIn;
 
@@ -2999,7 +2972,7 @@ public:
                 //lv2_atom_buffer_write(&evInAtomIters[i], 0, 0, atom->type, atom->size, LV2_ATOM_BODY_CONST(atom));
             }
 
-            pData->postRtEvents.trySplice();
+            pData->postRtEvents.notifyRT();
 
             carla_copyStruct(fLastTimeInfo, timeInfo);
         }
@@ -3009,6 +2982,22 @@ public:
 
         if (fEventsIn.ctrl != nullptr)
         {
+            // ----------------------------------------------------------------------------------------------------
+            // Worker responses
+
+            if (fWorkerResponses.isDataAvailableForReading())
+            {
+                const LV2_Atom* atom;
+                uint32_t portIndex;
+
+                for (; fWorkerResponses.get(atom, portIndex);)
+                {
+                    CARLA_SAFE_ASSERT_CONTINUE(atom->type == kUridCarlaAtomWorker);
+                    CARLA_SAFE_ASSERT_CONTINUE(fExt.worker != nullptr && fExt.worker->work_response != nullptr);
+                    fExt.worker->work_response(fHandle, atom->size, LV2_ATOM_BODY_CONST(atom));
+                }
+            }
+
             // ----------------------------------------------------------------------------------------------------
             // Message Input
 
@@ -3023,12 +3012,7 @@ public:
                     {
                         j = (portIndex < fEventsIn.count) ? portIndex : fEventsIn.ctrlIndex;
 
-                        if (atom->type == kUridCarlaAtomWorker)
-                        {
-                            CARLA_SAFE_ASSERT_CONTINUE(fExt.worker != nullptr && fExt.worker->work_response != nullptr);
-                            fExt.worker->work_response(fHandle, atom->size, LV2_ATOM_BODY_CONST(atom));
-                        }
-                        else if (! lv2_atom_buffer_write(&evInAtomIters[j], 0, 0, atom->type, atom->size, LV2_ATOM_BODY_CONST(atom)))
+                        if (! lv2_atom_buffer_write(&evInAtomIters[j], 0, 0, atom->type, atom->size, LV2_ATOM_BODY_CONST(atom)))
                         {
                             carla_stderr2("Event input buffer full, at least 1 message lost");
                             continue;
@@ -3042,20 +3026,20 @@ public:
             // ----------------------------------------------------------------------------------------------------
             // MIDI Input (External)
 
-            if (pData->extNotes.mutex.tryLock())
             {
+                ExternalMidiNote note;
+
                 if ((fEventsIn.ctrl->type & CARLA_EVENT_TYPE_MIDI) == 0)
                 {
                     // does not handle MIDI
-                    pData->extNotes.data.clear();
+                    while (pData->extNotes.data.get(note)) {}
                 }
                 else
                 {
                     const uint32_t j = fEventsIn.ctrlIndex;
 
-                    for (RtLinkedList<ExternalMidiNote>::Itenerator it = pData->extNotes.data.begin2(); it.valid(); it.next())
+                    while (pData->extNotes.data.get(note))
                     {
-                        const ExternalMidiNote& note(it.getValue(kExternalMidiNoteFallback));
                         CARLA_SAFE_ASSERT_CONTINUE(note.channel >= 0 && note.channel < MAX_MIDI_CHANNELS);
 
                         uint8_t midiEvent[3];
@@ -3072,12 +3056,8 @@ public:
                         else if (fEventsIn.ctrl->type & CARLA_EVENT_DATA_MIDI_LL)
                             lv2midi_put_event(&evInMidiStates[j], 0.0, 3, midiEvent);
                     }
-
-                    pData->extNotes.data.clear();
                 }
 
-                pData->extNotes.mutex.unlock();
-
             } // End of MIDI Input (External)
 
             // ----------------------------------------------------------------------------------------------------
@@ -3110,8 +3090,13 @@ public:
 
                 if (isSampleAccurate && event.time > timeOffset)
                 {
-                    if (processSingle(audioIn, audioOut, cvIn, cvOut, event.time - timeOffset, timeOffset))
+                    if (! pData->shouldSplitBlock(event.time, timeOffset, frames))
+                    {
+                        startTime = event.time - timeOffset;
+                    }
+                    else if (processSingle(audioIn, audioOut, cvIn, cvOut, event.time - timeOffset, timeOffset))
                     {
+                        pData->countBlockSplit();
                         startTime  = 0;
                         timeOffset = event.time;
 
@@ -3435,7 +3420,7 @@ public:
                 } // switch (event.type)
             }
 
-            pData->postRtEvents.trySplice();
+            pData->postRtEvents.notifyRT();
 
             if (frames > timeOffset)
                 processSingle(audioIn, audioOut, cvIn, cvOut, frames - timeOffset, timeOffset);
@@ -3493,7 +3478,7 @@ public:
                     }
                     else //if (ev->body.type == kUridAtomBLANK)
                     {
-                        //carla_stdout("Got out event, %s", carla_lv2_urid_unmap(this, ev->body.type));
+                        //carla_stdout("Got out event, %s", getURIDString(ev->body.type));
                         fAtomBufferOut.put(&ev->body, evData.rindex);
                     }
 
@@ -3695,78 +3680,13 @@ public:
             }
         }
 
-        pData->postRtEvents.trySplice();
+        pData->postRtEvents.notifyRT();
 
 #ifndef BUILD_BRIDGE
         // --------------------------------------------------------------------------------------------------------
         // Post-processing (dry/wet, volume and balance)
 
-        {
-            const bool doDryWet  = (pData->hints & PLUGIN_CAN_DRYWET) != 0 && carla_isNotEqual(pData->postProc.dryWet, 1.0f);
-            const bool doBalance = (pData->hints & PLUGIN_CAN_BALANCE) != 0 && ! (carla_isEqual(pData->postProc.balanceLeft, -1.0f) && carla_isEqual(pData->postProc.balanceRight, 1.0f));
-            const bool isMono    = (pData->audioIn.count == 1);
-
-            bool isPair;
-            float bufValue, oldBufLeft[doBalance ? frames : 1];
-
-            for (uint32_t i=0; i < pData->audioOut.count; ++i)
-            {
-                // Dry/Wet
-                if (doDryWet)
-                {
-                    const uint32_t c = isMono ? 0 : i;
-
-                    for (uint32_t k=0; k < frames; ++k)
-                    {
-                        if (k < pData->latency.frames)
-                            bufValue = pData->latency.buffers[c][k];
-                        else if (pData->latency.frames < frames)
-                            bufValue = fAudioInBuffers[c][k-pData->latency.frames];
-                        else
-                            bufValue = fAudioInBuffers[c][k];
-
-                        fAudioOutBuffers[i][k] = (fAudioOutBuffers[i][k] * pData->postProc.dryWet) + (bufValue * (1.0f - pData->postProc.dryWet));
-                    }
-                }
-
-                // Balance
-                if (doBalance)
-                {
-                    isPair = (i % 2 == 0);
-
-                    if (isPair)
-                    {
-                        CARLA_ASSERT(i+1 < pData->audioOut.count);
-                        carla_copyFloats(oldBufLeft, fAudioOutBuffers[i], frames);
-                    }
-
-                    float balRangeL = (pData->postProc.balanceLeft  + 1.0f)/2.0f;
-                    float balRangeR = (pData->postProc.balanceRight + 1.0f)/2.0f;
-
-                    for (uint32_t k=0; k < frames; ++k)
-                    {
-                        if (isPair)
-                        {
-                            // left
-                            fAudioOutBuffers[i][k]  = oldBufLeft[k]            * (1.0f - balRangeL);
-                            fAudioOutBuffers[i][k] += fAudioOutBuffers[i+1][k] * (1.0f - balRangeR);
-                        }
-                        else
-                        {
-                            // right
-                            fAudioOutBuffers[i][k]  = fAudioOutBuffers[i][k] * balRangeR;
-                            fAudioOutBuffers[i][k] += oldBufLeft[k]          * balRangeL;
-                        }
-                    }
-                }
-
-                // Volume (and buffer copy)
-                {
-                    for (uint32_t k=0; k < frames; ++k)
-                        audioOut[i][k+timeOffset] = fAudioOutBuffers[i][k] * pData->postProc.volume;
-                }
-            }
-        } // End of Post-processing
+        pData->postProcessAudio(fAudioOutBuffers, fAudioInBuffers, 0, true, audioOut, timeOffset, frames);
 
         // --------------------------------------------------------------------------------------------------------
         // Save latency values for next callback
@@ -4399,41 +4319,15 @@ public:
 
     // -------------------------------------------------------------------
 
-    LV2_URID getCustomURID(const char* const uri)
-    {
-        CARLA_SAFE_ASSERT_RETURN(uri != nullptr && uri[0] != '\0', kUridNull);
-        carla_debug("CarlaPluginLV2::getCustomURID(\"%s\")", uri);
-
-        const std::string    s_uri(uri);
-        const std::ptrdiff_t s_pos(std::find(fCustomURIDs.begin(), fCustomURIDs.end(), s_uri) - fCustomURIDs.begin());
-
-        if (s_pos <= 0 || s_pos >= INT32_MAX)
-            return kUridNull;
-
-        const LV2_URID urid     = static_cast<LV2_URID>(s_pos);
-        const LV2_URID uriCount = static_cast<LV2_URID>(fCustomURIDs.size());
-
-        if (urid < uriCount)
-            return urid;
-
-        CARLA_SAFE_ASSERT(urid == uriCount);
-
-        fCustomURIDs.push_back(uri);
-
-        if (fUI.type == UI::TYPE_BRIDGE && fPipeServer.isPipeRunning())
-            fPipeServer.writeLv2UridMessage(urid, uri);
-
-        return urid;
-    }
-
-    const char* getCustomURIDString(const LV2_URID urid) const noexcept
+    const char* getURIDString(const LV2_URID urid) const noexcept
     {
         static const char* const sFallback = "urn:null";
         CARLA_SAFE_ASSERT_RETURN(urid != kUridNull, sFallback);
-        CARLA_SAFE_ASSERT_RETURN(urid < fCustomURIDs.size(), sFallback);
-        carla_debug("CarlaPluginLV2::getCustomURIString(%i)", urid);
 
-        return fCustomURIDs[urid].c_str();
+        const char* const uri(fUridMap.unmap(urid));
+        CARLA_SAFE_ASSERT_RETURN(uri != nullptr, sFallback);
+
+        return uri;
     }
 
     // -------------------------------------------------------------------
@@ -4489,10 +4383,10 @@ public:
         CARLA_SAFE_ASSERT_RETURN(size > 0, LV2_STATE_ERR_NO_PROPERTY);
         CARLA_SAFE_ASSERT_RETURN(type != kUridNull, LV2_STATE_ERR_BAD_TYPE);
         CARLA_SAFE_ASSERT_RETURN(flags & LV2_STATE_IS_POD, LV2_STATE_ERR_BAD_FLAGS);
-        carla_debug("CarlaPluginLV2::handleStateStore(%i:\"%s\", %p, " P_SIZE ", %i:\"%s\", %i)", key, carla_lv2_urid_unmap(this, key), value, size, type, carla_lv2_urid_unmap(this, type), flags);
+        carla_debug("CarlaPluginLV2::handleStateStore(%i:\"%s\", %p, " P_SIZE ", %i:\"%s\", %i)", key, getURIDString(key), value, size, type, getURIDString(type), flags);
 
-        const char* const skey(carla_lv2_urid_unmap(this, key));
-        const char* const stype(carla_lv2_urid_unmap(this, type));
+        const char* const skey(getURIDString(key));
+        const char* const stype(getURIDString(type));
 
         CARLA_SAFE_ASSERT_RETURN(skey != nullptr, LV2_STATE_ERR_BAD_TYPE);
         CARLA_SAFE_ASSERT_RETURN(stype != nullptr, LV2_STATE_ERR_BAD_TYPE);
@@ -4540,7 +4434,7 @@ public:
         CARLA_SAFE_ASSERT_RETURN(flags != nullptr, nullptr);
         carla_debug("CarlaPluginLV2::handleStateRetrieve(%i, %p, %p, %p)", key, size, type, flags);
 
-        const char* const skey(carla_lv2_urid_unmap(this, key));
+        const char* const skey(getURIDString(key));
 
         CARLA_SAFE_ASSERT_RETURN(skey != nullptr, nullptr);
 
@@ -4563,7 +4457,7 @@ public:
         CARLA_SAFE_ASSERT_RETURN(stype != nullptr, nullptr);
         CARLA_SAFE_ASSERT_RETURN(stringData != nullptr, nullptr);
 
-        *type  = carla_lv2_urid_map(this, stype);
+        *type  = fUridMap.map(stype);
         *flags = LV2_STATE_IS_POD;
 
         if (*type == kUridAtomString || *type == kUridAtomPath)
@@ -4604,17 +4498,21 @@ public:
         CARLA_SAFE_ASSERT_RETURN(fEventsIn.ctrl != nullptr, LV2_WORKER_ERR_UNKNOWN);
         carla_debug("CarlaPluginLV2::handleWorkerSchedule(%i, %p)", size, data);
 
-        if (pData->engine->isOffline())
-        {
-            fExt.worker->work(fHandle, carla_lv2_worker_respond, this, size, data);
-            return LV2_WORKER_SUCCESS;
-        }
-
         LV2_Atom atom;
         atom.size = size;
         atom.type = kUridCarlaAtomWorker;
 
-        return fAtomBufferOut.putChunk(&atom, data, fEventsOut.ctrlIndex) ? LV2_WORKER_SUCCESS : LV2_WORKER_ERR_NO_SPACE;
+        // only written from run(), or from restore while run() is blocked
+        if (! fWorkerRequests.putChunkUnlocked(&atom, data, 0))
+            return LV2_WORKER_ERR_NO_SPACE;
+
+        CarlaBackgroundWorkPool& workPool(pData->engine->getBackgroundWorkPool());
+
+        // when rendering offline we can block, do the work right away
+        if (! (pData->engine->isOffline() && workPool.tryRunNow(this)))
+            workPool.schedule(this);
+
+        return LV2_WORKER_SUCCESS;
     }
 
     LV2_Worker_Status handleWorkerRespond(const uint32_t size, const void* const data)
@@ -4625,7 +4523,23 @@ public:
         atom.size = size;
         atom.type = kUridCarlaAtomWorker;
 
-        return fAtomBufferIn.putChunk(&atom, data, fEventsIn.ctrlIndex) ? LV2_WORKER_SUCCESS : LV2_WORKER_ERR_NO_SPACE;
+        // only written from runWork(), which the pool never runs concurrently
+        return fWorkerResponses.putChunkUnlocked(&atom, data, 0) ? LV2_WORKER_SUCCESS : LV2_WORKER_ERR_NO_SPACE;
+    }
+
+    // -------------------------------------------------------------------
+    // CarlaBackgroundWorkPool::Client
+
+    void runWork() override
+    {
+        const LV2_Atom* atom;
+        uint32_t portIndex;
+
+        for (; fWorkerRequests.get(atom, portIndex);)
+        {
+            CARLA_SAFE_ASSERT_CONTINUE(atom->type == kUridCarlaAtomWorker);
+            fExt.worker->work(fHandle, carla_lv2_worker_respond, this, atom->size, LV2_ATOM_BODY_CONST(atom));
+        }
     }
 
     // -------------------------------------------------------------------
@@ -4758,7 +4672,7 @@ public:
         } break;
 
         default:
-            carla_stdout("CarlaPluginLV2::handleUIWrite(%i, %i, %i:\"%s\", %p) - unknown format", rindex, bufferSize, format, carla_lv2_urid_unmap(this, format), buffer);
+            carla_stdout("CarlaPluginLV2::handleUIWrite(%i, %i, %i:\"%s\", %p) - unknown format", rindex, bufferSize, format, getURIDString(format), buffer);
             break;
         }
     }
@@ -4811,7 +4725,7 @@ public:
             paramValue = static_cast<float>((*(const int64_t*)value));
             break;
         default:
-            carla_stdout("CarlaPluginLV2::handleLilvSetPortValue(\"%s\", %p, %i, %i:\"%s\") - unknown type", portSymbol, value, size, type, carla_lv2_urid_unmap(this, type));
+            carla_stdout("CarlaPluginLV2::handleLilvSetPortValue(\"%s\", %p, %i, %i:\"%s\") - unknown type", portSymbol, value, size, type, getURIDString(type));
             return;
         }
 
@@ -5096,15 +5010,15 @@ public:
         lv2_rtmempool_init_deprecated(rtMemPoolOldFt);
 
         LV2_URI_Map_Feature* const uriMapFt = new LV2_URI_Map_Feature;
-        uriMapFt->callback_data             = this;
+        uriMapFt->callback_data             = &fUridMap;
         uriMapFt->uri_to_id                 = carla_lv2_uri_to_id;
 
         LV2_URID_Map* const uridMapFt = new LV2_URID_Map;
-        uridMapFt->handle             = this;
+        uridMapFt->handle             = &fUridMap;
         uridMapFt->map                = carla_lv2_urid_map;
 
         LV2_URID_Unmap* const uridUnmapFt = new LV2_URID_Unmap;
-        uridUnmapFt->handle               = this;
+        uridUnmapFt->handle               = &fUridMap;
         uridUnmapFt->unmap                = carla_lv2_urid_unmap;
 
         LV2_Worker_Schedule* const workerFt = new LV2_Worker_Schedule;
@@ -5673,29 +5587,27 @@ public:
         fAtomBufferIn.put(atom, portIndex);
     }
 
-    void handleUridMap(const LV2_URID urid, const char* const uri)
+    // the bridged UI never maps URIs on its own, it asks us and waits for the reply
+    void handleUriMap(const char* const uri)
     {
-        CARLA_SAFE_ASSERT_RETURN(urid != kUridNull,);
         CARLA_SAFE_ASSERT_RETURN(uri != nullptr && uri[0] != '\0',);
-        carla_debug("CarlaPluginLV2::handleUridMap(%i v " P_SIZE ", \"%s\")", urid, fCustomURIDs.size()-1, uri);
+        carla_debug("CarlaPluginLV2::handleUriMap(\"%s\")", uri);
 
-        const std::size_t uriCount(fCustomURIDs.size());
+        CARLA_SAFE_ASSERT_RETURN(fUridMap.map(uri) != kUridNull,);
 
-        if (urid < uriCount)
-        {
-            const char* const ourURI(carla_lv2_urid_unmap(this, urid));
-            CARLA_SAFE_ASSERT_RETURN(ourURI != nullptr,);
+        sendNewURIDsToUI();
+    }
 
-            if (std::strcmp(ourURI, uri) != 0)
-            {
-                carla_stderr2("PLUGIN :: wrong URI '%s' vs '%s'", ourURI,  uri);
-            }
-        }
-        else
-        {
-            CARLA_SAFE_ASSERT_RETURN(urid == uriCount,);
-            fCustomURIDs.push_back(uri);
-        }
+    // URIDs are sent in order, so the UI bridge map is always a copy of the first part of ours
+    void sendNewURIDsToUI()
+    {
+        if (fUI.type != UI::TYPE_BRIDGE || ! fPipeServer.isPipeRunning())
+            return;
+
+        const uint32_t uridCount = fUridMap.getCount();
+
+        for (; fUridsSentToUI < uridCount; ++fUridsSentToUI)
+            fPipeServer.writeLv2UridMessage(fUridsSentToUI, getURIDString(fUridsSentToUI));
     }
 
     // -------------------------------------------------------------------
@@ -5724,12 +5636,18 @@ private:
     LV2_Atom_Forge    fAtomForge;
     uint8_t*          fTmpAtomBuffer;
 
+    // worker requests from run(), and responses back to it
+    Lv2AtomRingBuffer fWorkerRequests;
+    Lv2AtomRingBuffer fWorkerResponses;
+    bool              fWorkerRegistered;
+
     CarlaPluginLV2EventData fEventsIn;
     CarlaPluginLV2EventData fEventsOut;
     CarlaPluginLV2Options   fLv2Options;
     CarlaPipeServerLV2      fPipeServer;
 
-    std::vector<std::string> fCustomURIDs;
+    Lv2UridMap& fUridMap;
+    uint32_t    fUridsSentToUI; // how many URIDs the bridged UI knows about
 
     bool fFirstActive; // first process() call after activate()
     void* fLastStateChunk;
@@ -5985,114 +5903,7 @@ private:
         CARLA_SAFE_ASSERT_RETURN(uri != nullptr && uri[0] != '\0', kUridNull);
         carla_debug("carla_lv2_urid_map(%p, \"%s\")", handle, uri);
 
-        // Atom types
-        if (std::strcmp(uri, LV2_ATOM__Blank) == 0)
-            return kUridAtomBlank;
-        if (std::strcmp(uri, LV2_ATOM__Bool) == 0)
-            return kUridAtomBool;
-        if (std::strcmp(uri, LV2_ATOM__Chunk) == 0)
-            return kUridAtomChunk;
-        if (std::strcmp(uri, LV2_ATOM__Double) == 0)
-            return kUridAtomDouble;
-        if (std::strcmp(uri, LV2_ATOM__Event) == 0)
-            return kUridAtomEvent;
-        if (std::strcmp(uri, LV2_ATOM__Float) == 0)
-            return kUridAtomFloat;
-        if (std::strcmp(uri, LV2_ATOM__Int) == 0)
-            return kUridAtomInt;
-        if (std::strcmp(uri, LV2_ATOM__Literal) == 0)
-            return kUridAtomLiteral;
-        if (std::strcmp(uri, LV2_ATOM__Long) == 0)
-            return kUridAtomLong;
-        if (std::strcmp(uri, LV2_ATOM__Number) == 0)
-            return kUridAtomNumber;
-        if (std::strcmp(uri, LV2_ATOM__Object) == 0)
-            return kUridAtomObject;
-        if (std::strcmp(uri, LV2_ATOM__Path) == 0)
-            return kUridAtomPath;
-        if (std::strcmp(uri, LV2_ATOM__Property) == 0)
-            return kUridAtomProperty;
-        if (std::strcmp(uri, LV2_ATOM__Resource) == 0)
-            return kUridAtomResource;
-        if (std::strcmp(uri, LV2_ATOM__Sequence) == 0)
-            return kUridAtomSequence;
-        if (std::strcmp(uri, LV2_ATOM__Sound) == 0)
-            return kUridAtomSound;
-        if (std::strcmp(uri, LV2_ATOM__String) == 0)
-            return kUridAtomString;
-        if (std::strcmp(uri, LV2_ATOM__Tuple) == 0)
-            return kUridAtomTuple;
-        if (std::strcmp(uri, LV2_ATOM__URI) == 0)
-            return kUridAtomURI;
-        if (std::strcmp(uri, LV2_ATOM__URID) == 0)
-            return kUridAtomURID;
-        if (std::strcmp(uri, LV2_ATOM__Vector) == 0)
-            return kUridAtomVector;
-        if (std::strcmp(uri, LV2_ATOM__atomTransfer) == 0)
-            return kUridAtomTransferAtom;
-        if (std::strcmp(uri, LV2_ATOM__eventTransfer) == 0)
-            return kUridAtomTransferEvent;
-
-        // BufSize types
-        if (std::strcmp(uri, LV2_BUF_SIZE__maxBlockLength) == 0)
-            return kUridBufMaxLength;
-        if (std::strcmp(uri, LV2_BUF_SIZE__minBlockLength) == 0)
-            return kUridBufMinLength;
-        if (std::strcmp(uri, LV2_BUF_SIZE__nominalBlockLength) == 0)
-            return kUridBufNominalLength;
-        if (std::strcmp(uri, LV2_BUF_SIZE__sequenceSize) == 0)
-            return kUridBufSequenceSize;
-
-        // Log types
-        if (std::strcmp(uri, LV2_LOG__Error) == 0)
-            return kUridLogError;
-        if (std::strcmp(uri, LV2_LOG__Note) == 0)
-            return kUridLogNote;
-        if (std::strcmp(uri, LV2_LOG__Trace) == 0)
-            return kUridLogTrace;
-        if (std::strcmp(uri, LV2_LOG__Warning) == 0)
-            return kUridLogWarning;
-
-        // Time types
-        if (std::strcmp(uri, LV2_TIME__Position) == 0)
-            return kUridTimePosition;
-        if (std::strcmp(uri, LV2_TIME__bar) == 0)
-            return kUridTimeBar;
-        if (std::strcmp(uri, LV2_TIME__barBeat) == 0)
-            return kUridTimeBarBeat;
-        if (std::strcmp(uri, LV2_TIME__beat) == 0)
-            return kUridTimeBeat;
-        if (std::strcmp(uri, LV2_TIME__beatUnit) == 0)
-            return kUridTimeBeatUnit;
-        if (std::strcmp(uri, LV2_TIME__beatsPerBar) == 0)
-            return kUridTimeBeatsPerBar;
-        if (std::strcmp(uri, LV2_TIME__beatsPerMinute) == 0)
-            return kUridTimeBeatsPerMinute;
-        if (std::strcmp(uri, LV2_TIME__frame) == 0)
-            return kUridTimeFrame;
-        if (std::strcmp(uri, LV2_TIME__framesPerSecond) == 0)
-            return kUridTimeFramesPerSecond;
-        if (std::strcmp(uri, LV2_TIME__speed) == 0)
-            return kUridTimeSpeed;
-        if (std::strcmp(uri, LV2_KXSTUDIO_PROPERTIES__TimePositionTicksPerBeat) == 0)
-            return kUridTimeTicksPerBeat;
-
-        // Others
-        if (std::strcmp(uri, LV2_MIDI__MidiEvent) == 0)
-            return kUridMidiEvent;
-        if (std::strcmp(uri, LV2_PARAMETERS__sampleRate) == 0)
-            return kUridParamSampleRate;
-        if (std::strcmp(uri, LV2_UI__windowTitle) == 0)
-            return kUridWindowTitle;
-
-        // Custom Carla types
-        if (std::strcmp(uri, URI_CARLA_ATOM_WORKER) == 0)
-            return kUridCarlaAtomWorker;
-        if (std::strcmp(uri, LV2_KXSTUDIO_PROPERTIES__TransientWindowId) == 0)
-            return kUridCarlaTransientWindowId;
-
-        // Custom plugin types
-        return ((CarlaPluginLV2*)handle)->getCustomURID(uri);
+        return ((Lv2UridMap*)handle)->map(uri);
     }
 
     static const char* carla_lv2_urid_unmap(LV2_URID_Map_Handle handle, LV2_URID urid)
@@ -6101,117 +5912,7 @@ private:
         CARLA_SAFE_ASSERT_RETURN(urid != kUridNull, nullptr);
         carla_debug("carla_lv2_urid_unmap(%p, %i)", handle, urid);
 
-        switch (urid)
-        {
-        // Atom types
-        case kUridAtomBlank:
-            return LV2_ATOM__Blank;
-        case kUridAtomBool:
-            return LV2_ATOM__Bool;
-        case kUridAtomChunk:
-            return LV2_ATOM__Chunk;
-        case kUridAtomDouble:
-            return LV2_ATOM__Double;
-        case kUridAtomEvent:
-            return LV2_ATOM__Event;
-        case kUridAtomFloat:
-            return LV2_ATOM__Float;
-        case kUridAtomInt:
-            return LV2_ATOM__Int;
-        case kUridAtomLiteral:
-            return LV2_ATOM__Literal;
-        case kUridAtomLong:
-            return LV2_ATOM__Long;
-        case kUridAtomNumber:
-            return LV2_ATOM__Number;
-        case kUridAtomObject:
-            return LV2_ATOM__Object;
-        case kUridAtomPath:
-            return LV2_ATOM__Path;
-        case kUridAtomProperty:
-            return LV2_ATOM__Property;
-        case kUridAtomResource:
-            return LV2_ATOM__Resource;
-        case kUridAtomSequence:
-            return LV2_ATOM__Sequence;
-        case kUridAtomSound:
-            return LV2_ATOM__Sound;
-        case kUridAtomString:
-            return LV2_ATOM__String;
-        case kUridAtomTuple:
-            return LV2_ATOM__Tuple;
-        case kUridAtomURI:
-            return LV2_ATOM__URI;
-        case kUridAtomURID:
-            return LV2_ATOM__URID;
-        case kUridAtomVector:
-            return LV2_ATOM__Vector;
-        case kUridAtomTransferAtom:
-            return LV2_ATOM__atomTransfer;
-        case kUridAtomTransferEvent:
-            return LV2_ATOM__eventTransfer;
-
-        // BufSize types
-        case kUridBufMaxLength:
-            return LV2_BUF_SIZE__maxBlockLength;
-        case kUridBufMinLength:
-            return LV2_BUF_SIZE__minBlockLength;
-        case kUridBufNominalLength:
-            return LV2_BUF_SIZE__nominalBlockLength;
-        case kUridBufSequenceSize:
-            return LV2_BUF_SIZE__sequenceSize;
-
-        // Log types
-        case kUridLogError:
-            return LV2_LOG__Error;
-        case kUridLogNote:
-            return LV2_LOG__Note;
-        case kUridLogTrace:
-            return LV2_LOG__Trace;
-        case kUridLogWarning:
-            return LV2_LOG__Warning;
-
-        // Time types
-        case kUridTimePosition:
-            return LV2_TIME__Position;
-        case kUridTimeBar:
-            return LV2_TIME__bar;
-        case kUridTimeBarBeat:
-            return LV2_TIME__barBeat;
-        case kUridTimeBeat:
-            return LV2_TIME__beat;
-        case kUridTimeBeatUnit:
-            return LV2_TIME__beatUnit;
-        case kUridTimeBeatsPerBar:
-            return LV2_TIME__beatsPerBar;
-        case kUridTimeBeatsPerMinute:
-            return LV2_TIME__beatsPerMinute;
-        case kUridTimeFrame:
-            return LV2_TIME__frame;
-        case kUridTimeFramesPerSecond:
-            return LV2_TIME__framesPerSecond;
-        case kUridTimeSpeed:
-            return LV2_TIME__speed;
-        case kUridTimeTicksPerBeat:
-            return LV2_KXSTUDIO_PROPERTIES__TimePositionTicksPerBeat;
-
-        // Others
-        case kUridMidiEvent:
-            return LV2_MIDI__MidiEvent;
-        case kUridParamSampleRate:
-            return LV2_PARAMETERS__sampleRate;
-        case kUridWindowTitle:
-            return LV2_UI__windowTitle;
-
-        // Custom Carla types
-        case kUridCarlaAtomWorker:
-            return URI_CARLA_ATOM_WORKER;
-        case kUridCarlaTransientWindowId:
-            return LV2_KXSTUDIO_PROPERTIES__TransientWindowId;
-        }
-
-        // Custom plugin types
-        return ((CarlaPluginLV2*)handle)->getCustomURIDString(urid);
+        return ((Lv2UridMap*)handle)->unmap(urid);
     }
 
     // -------------------------------------------------------------------
@@ -6370,20 +6071,15 @@ bool CarlaPipeServerLV2::msgReceived(const char* const msg) noexcept
         return true;
     }
 
-    if (std::strcmp(msg, "urid") == 0)
+    if (std::strcmp(msg, "urimap") == 0)
     {
-        uint32_t urid;
         const char* uri;
 
-        CARLA_SAFE_ASSERT_RETURN(readNextLineAsUInt(urid), true);
         CARLA_SAFE_ASSERT_RETURN(readNextLineAsString(uri), true);
 
-        if (urid != 0)
-        {
-            try {
-                kPlugin->handleUridMap(urid, uri);
-            } CARLA_SAFE_EXCEPTION("msgReceived urid");
-        }
+        try {
+            kPlugin->handleUriMap(uri);
+        } CARLA_SAFE_EXCEPTION("msgReceived urimap");
 
         delete[] uri;
         return true;
@@ -204,11 +204,6 @@ using water::StringArray;
 
 CARLA_BACKEND_START_NAMESPACE
 
-// -------------------------------------------------------------------------------------------------------------------
-// Fallback data
-
-static const ExternalMidiNote kExternalMidiNoteFallback = { -1, 0, 0 };
-
 // -------------------------------------------------------------------------------------------------------------------
 
 class CarlaPluginLinuxSampler : public CarlaPlugin
@@ -875,11 +870,11 @@ public:
             // ----------------------------------------------------------------------------------------------------
             // MIDI Input (External)
 
-            if (pData->extNotes.mutex.tryLock())
             {
-                for (RtLinkedList<ExternalMidiNote>::Itenerator it = pData->extNotes.data.begin2(); it.valid(); it.next())
+                ExternalMidiNote note;
+
+                while (pData->extNotes.data.get(note))
                 {
-                    const ExternalMidiNote& note(it.getValue(kExternalMidiNoteFallback));
                     CARLA_SAFE_ASSERT_CONTINUE(note.channel >= 0 && note.channel < MAX_MIDI_CHANNELS);
 
                     if (note.velo > 0)
@@ -888,9 +883,6 @@ public:
                         fMidiInputPort->DispatchNoteOff(note.note, note.velo, static_cast<uint>(note.channel));
                 }
 
-                pData->extNotes.data.clear();
-                pData->extNotes.mutex.unlock();
-
             } // End of MIDI Input (External)
 
             // ----------------------------------------------------------------------------------------------------
@@ -911,8 +903,13 @@ public:
 
                 if (event.time > timeOffset)
                 {
-                    if (processSingle(audioOut, event.time - timeOffset, timeOffset))
+                    if (! pData->shouldSplitBlock(event.time, timeOffset, frames))
+                    {
+                        startTime = event.time - timeOffset;
+                    }
+                    else if (processSingle(audioOut, event.time - timeOffset, timeOffset))
                     {
+                        pData->countBlockSplit();
                         startTime  = 0;
                         timeOffset = event.time;
                     }
@@ -1086,7 +1083,7 @@ public:
                 }
             }
 
-            pData->postRtEvents.trySplice();
+            pData->postRtEvents.notifyRT();
 
             if (frames > timeOffset)
                 processSingle(audioOut, frames - timeOffset, timeOffset);
@@ -1150,51 +1147,9 @@ public:
 
 #ifndef BUILD_BRIDGE
         // --------------------------------------------------------------------------------------------------------
-        // Post-processing (dry/wet, volume and balance)
-
-        {
-            const bool doVolume  = (pData->hints & PLUGIN_CAN_VOLUME) != 0 && carla_isNotEqual(pData->postProc.volume, 1.0f);
-            const bool doBalance = (pData->hints & PLUGIN_CAN_BALANCE) != 0 && ! (carla_isEqual(pData->postProc.balanceLeft, -1.0f) && carla_isEqual(pData->postProc.balanceRight, 1.0f));
-
-            float oldBufLeft[doBalance ? frames : 1];
-
-            for (uint32_t i=0; i < pData->audioOut.count; ++i)
-            {
-                // Balance
-                if (doBalance)
-                {
-                    if (i % 2 == 0)
-                        carla_copyFloats(oldBufLeft, outBuffer[i], frames);
-
-                    float balRangeL = (pData->postProc.balanceLeft  + 1.0f)/2.0f;
-                    float balRangeR = (pData->postProc.balanceRight + 1.0f)/2.0f;
-
-                    for (uint32_t k=0; k < frames; ++k)
-                    {
-                        if (i % 2 == 0)
-                        {
-                            // left
-                            outBuffer[i][k]  = oldBufLeft[k]     * (1.0f - balRangeL);
-                            outBuffer[i][k] += outBuffer[i+1][k] * (1.0f - balRangeR);
-                        }
-                        else
-                        {
-                            // right
-                            outBuffer[i][k]  = outBuffer[i][k] * balRangeR;
-                            outBuffer[i][k] += oldBufLeft[k]   * balRangeL;
-                        }
-                    }
-                }
-
-                // Volume
-                if (doVolume)
-                {
-                    for (uint32_t k=0; k < frames; ++k)
-                        outBuffer[i][k+timeOffset] *= pData->postProc.volume;
-                }
-            }
+        // Post-processing (volume and balance)
 
-        } // End of Post-processing
+        pData->postProcessAudio(outBuffer, nullptr, timeOffset, false, nullptr, 0, frames);
 #endif
 
         // --------------------------------------------------------------------------------------------------------
@@ -546,6 +546,11 @@ public:
         CarlaPlugin::idle();
     }
 
+    bool needsFrequentIdle() const noexcept override
+    {
+        return fNeedIdle || CarlaPlugin::needsFrequentIdle();
+    }
+
     void uiIdle() override
     {
         if (fUI.window != nullptr)
@@ -1183,14 +1188,11 @@ public:
             // ----------------------------------------------------------------------------------------------------
             // MIDI Input (External)
 
-            if (pData->extNotes.mutex.tryLock())
             {
-                ExternalMidiNote note = { 0, 0, 0 };
+                ExternalMidiNote note;
 
-                for (; fMidiEventCount < kPluginMaxMidiEvents*2 && ! pData->extNotes.data.isEmpty();)
+                for (; fMidiEventCount < kPluginMaxMidiEvents*2 && pData->extNotes.data.get(note);)
                 {
-                    note = pData->extNotes.data.getFirst(note, true);
-
                     CARLA_SAFE_ASSERT_CONTINUE(note.channel >= 0 && note.channel < MAX_MIDI_CHANNELS);
 
                     VstMidiEvent& vstMidiEvent(fMidiEvents[fMidiEventCount++]);
@@ -1202,8 +1204,6 @@ public:
                     vstMidiEvent.midiData[2] = char(note.velo);
                 }
 
-                pData->extNotes.mutex.unlock();
-
             } // End of MIDI Input (External)
 
             // ----------------------------------------------------------------------------------------------------
@@ -1228,8 +1228,13 @@ public:
 
                 if (isSampleAccurate && event.time > timeOffset)
                 {
-                    if (processSingle(audioIn, audioOut, event.time - timeOffset, timeOffset))
+                    if (! pData->shouldSplitBlock(event.time, timeOffset, frames))
                     {
+                        startTime = event.time - timeOffset;
+                    }
+                    else if (processSingle(audioIn, audioOut, event.time - timeOffset, timeOffset))
+                    {
+                        pData->countBlockSplit();
                         startTime  = 0;
                         timeOffset = event.time;
 
@@ -1486,7 +1491,7 @@ public:
                 } // switch (event.type)
             }
 
-            pData->postRtEvents.trySplice();
+            pData->postRtEvents.notifyRT();
 
             if (frames > timeOffset)
                 processSingle(audioIn, audioOut, frames - timeOffset, timeOffset);
@@ -1612,66 +1617,7 @@ public:
         // --------------------------------------------------------------------------------------------------------
         // Post-processing (dry/wet, volume and balance)
 
-        {
-            const bool doVolume  = (pData->hints & PLUGIN_CAN_VOLUME) != 0 && carla_isNotEqual(pData->postProc.volume, 1.0f);
-            const bool doDryWet  = (pData->hints & PLUGIN_CAN_DRYWET) != 0 && carla_isNotEqual(pData->postProc.dryWet, 1.0f);
-            const bool doBalance = (pData->hints & PLUGIN_CAN_BALANCE) != 0 && ! (carla_isEqual(pData->postProc.balanceLeft, -1.0f) && carla_isEqual(pData->postProc.balanceRight, 1.0f));
-
-            bool isPair;
-            float bufValue, oldBufLeft[doBalance ? frames : 1];
-
-            for (uint32_t i=0; i < pData->audioOut.count; ++i)
-            {
-                // Dry/Wet
-                if (doDryWet)
-                {
-                    for (uint32_t k=0; k < frames; ++k)
-                    {
-                        bufValue = inBuffer[(pData->audioIn.count == 1) ? 0 : i][k+timeOffset];
-                        outBuffer[i][k+timeOffset] = (outBuffer[i][k+timeOffset] * pData->postProc.dryWet) + (bufValue * (1.0f - pData->postProc.dryWet));
-                    }
-                }
-
-                // Balance
-                if (doBalance)
-                {
-                    isPair = (i % 2 == 0);
-
-                    if (isPair)
-                    {
-                        CARLA_ASSERT(i+1 < pData->audioOut.count);
-                        carla_copyFloats(oldBufLeft, outBuffer[i]+timeOffset, frames);
-                    }
-
-                    float balRangeL = (pData->postProc.balanceLeft  + 1.0f)/2.0f;
-                    float balRangeR = (pData->postProc.balanceRight + 1.0f)/2.0f;
-
-                    for (uint32_t k=0; k < frames; ++k)
-                    {
-                        if (isPair)
-                        {
-                            // left
-                            outBuffer[i][k+timeOffset]  = oldBufLeft[k]                * (1.0f - balRangeL);
-                            outBuffer[i][k+timeOffset] += outBuffer[i+1][k+timeOffset] * (1.0f - balRangeR);
-                        }
-                        else
-                        {
-                            // right
-                            outBuffer[i][k+timeOffset]  = outBuffer[i][k+timeOffset] * balRangeR;
-                            outBuffer[i][k+timeOffset] += oldBufLeft[k]              * balRangeL;
-                        }
-                    }
-                }
-
-                // Volume
-                if (doVolume)
-                {
-                    for (uint32_t k=0; k < frames; ++k)
-                        outBuffer[i][k+timeOffset] *= pData->postProc.volume;
-                }
-            }
-
-        } // End of Post-processing
+        pData->postProcessAudio(outBuffer, inBuffer, timeOffset, false, nullptr, 0, frames);
 #endif
 
         // --------------------------------------------------------------------------------------------------------
@@ -156,7 +156,7 @@ public:
         if (fPorts.numMidiIns > 0)
         {
             uint32_t engineEventIndex = 0;
-            carla_zeroStructs(pData->events.in, kMaxEngineEventInternalCount);
+            clearEngineEvents(pData->events.in);
 
             for (uint32_t i=0; i < fPorts.numMidiIns; ++i)
             {
@@ -173,12 +173,15 @@ public:
 
                     const uint8_t* const data((const uint8_t*)(event + 1));
 
-                    EngineEvent& engineEvent(pData->events.in[engineEventIndex++]);
+                    EngineEvent& engineEvent(pData->events.in[engineEventIndex]);
 
                     engineEvent.time = (uint32_t)event->time.frames;
                     engineEvent.fillFromMidiData((uint8_t)event->body.size, data, (uint8_t)i);
 
-                    if (engineEventIndex >= kMaxEngineEventInternalCount)
+                    if (engineEvent.type == kEngineEventTypeNull)
+                        continue;
+
+                    if (++engineEventIndex >= kMaxEngineEventInternalCount)
                         break;
                 }
             }
@@ -186,7 +189,7 @@ public:
 
         if (fPorts.numMidiOuts > 0)
         {
-            carla_zeroStructs(pData->events.out, kMaxEngineEventInternalCount);
+            clearEngineEvents(pData->events.out);
         }
 
         if (fPlugin->tryLock(fIsOffline))
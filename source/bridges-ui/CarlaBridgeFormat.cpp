@@ -115,7 +115,7 @@ bool CarlaBridgeFormat::msgReceived(const char* const msg) noexcept
 {
     carla_debug("CarlaBridgeFormat::msgReceived(\"%s\")", msg);
 
-    if (! fGotOptions && std::strcmp(msg, "urid") != 0 && std::strcmp(msg, "uiOptions") != 0)
+    if (! fGotOptions && std::strcmp(msg, "urid") != 0 && std::strcmp(msg, "urids") != 0 && std::strcmp(msg, "uiOptions") != 0)
     {
         carla_stderr2("CarlaBridgeFormat::msgReceived(\"%s\") - invalid message while waiting for options", msg);
         return true;
@@ -228,6 +228,26 @@ bool CarlaBridgeFormat::msgReceived(const char* const msg) noexcept
         return true;
     }
 
+    if (std::strcmp(msg, "urids") == 0)
+    {
+        uint32_t first, count;
+        const char* uri;
+
+        CARLA_SAFE_ASSERT_RETURN(readNextLineAsUInt(first), true);
+        CARLA_SAFE_ASSERT_RETURN(readNextLineAsUInt(count), true);
+        CARLA_SAFE_ASSERT_RETURN(first != 0, true);
+
+        for (uint32_t i=0; i < count; ++i)
+        {
+            CARLA_SAFE_ASSERT_RETURN(readNextLineAsString(uri), true);
+
+            dspURIDReceived(first + i, uri);
+            delete[] uri;
+        }
+
+        return true;
+    }
+
     if (std::strcmp(msg, "uiOptions") == 0)
     {
         double sampleRate;
@@ -22,14 +22,11 @@
 #include "CarlaLv2Utils.hpp"
 #include "CarlaMIDI.h"
 #include "LinkedList.hpp"
+#include "Lv2FixedUrids.hpp"
+#include "Lv2UridMap.hpp"
 
 #include "water/files/File.h"
 
-#include <string>
-#include <vector>
-
-#define URI_CARLA_ATOM_WORKER "http://kxstudio.sf.net/ns/carla/atomWorker"
-
 using water::File;
 
 CARLA_BRIDGE_UI_START_NAMESPACE
@@ -38,60 +35,8 @@ CARLA_BRIDGE_UI_START_NAMESPACE
 
 static double gInitialSampleRate = 44100.0;
 
-// LV2 URI Map Ids
-enum CarlaLv2URIDs {
-    kUridNull = 0,
-    kUridAtomBlank,
-    kUridAtomBool,
-    kUridAtomChunk,
-    kUridAtomDouble,
-    kUridAtomEvent,
-    kUridAtomFloat,
-    kUridAtomInt,
-    kUridAtomLiteral,
-    kUridAtomLong,
-    kUridAtomNumber,
-    kUridAtomObject,
-    kUridAtomPath,
-    kUridAtomProperty,
-    kUridAtomResource,
-    kUridAtomSequence,
-    kUridAtomSound,
-    kUridAtomString,
-    kUridAtomTuple,
-    kUridAtomURI,
-    kUridAtomURID,
-    kUridAtomVector,
-    kUridAtomTransferAtom,
-    kUridAtomTransferEvent,
-    kUridBufMaxLength,
-    kUridBufMinLength,
-    kUridBufNominalLength,
-    kUridBufSequenceSize,
-    kUridLogError,
-    kUridLogNote,
-    kUridLogTrace,
-    kUridLogWarning,
-    // time base type
-    kUridTimePosition,
-     // time values
-    kUridTimeBar,
-    kUridTimeBarBeat,
-    kUridTimeBeat,
-    kUridTimeBeatUnit,
-    kUridTimeBeatsPerBar,
-    kUridTimeBeatsPerMinute,
-    kUridTimeFrame,
-    kUridTimeFramesPerSecond,
-    kUridTimeSpeed,
-    kUridTimeTicksPerBeat,
-    kUridMidiEvent,
-    kUridParamSampleRate,
-    kUridWindowTitle,
-    kUridCarlaAtomWorker,
-    kUridCarlaTransientWindowId,
-    kUridCount
-};
+// how long to wait for the host to map an URI for us, in milliseconds
+static const uint kUridReplyTimeout = 2000;
 
 // LV2 Feature Ids
 enum CarlaLv2Features {
@@ -187,10 +132,10 @@ public:
           fControlDesignatedPort(0),
           fLv2Options(),
           fUiOptions(),
-          fCustomURIDs(kUridCount, std::string("urn:null")),
+          fUridMap(),
           fExt()
     {
-        CARLA_SAFE_ASSERT(fCustomURIDs.size() == kUridCount);
+        fUridMap.addFixedURIs(kCarlaLv2URIs, kUridCount);
 
         carla_zeroPointers(fFeatures, kFeatureCount+1);
 
@@ -564,10 +509,11 @@ public:
 
     void dspURIDReceived(const LV2_URID urid, const char* const uri) override
     {
-        CARLA_SAFE_ASSERT_RETURN(urid == fCustomURIDs.size(),);
+        CARLA_SAFE_ASSERT_RETURN(urid != kUridNull,);
         CARLA_SAFE_ASSERT_RETURN(uri != nullptr && uri[0] != '\0',);
 
-        fCustomURIDs.push_back(uri);
+        if (! fUridMap.mapWithURID(urid, uri))
+            carla_stderr2("UI :: wrong URI '%s' vs '%s'", getCustomURIDString(urid), uri);
     }
 
     void uiOptionsChanged(const double sampleRate, const bool useTheme, const bool useThemeColors, const char* const windowTitle, uintptr_t transientWindowId) override
@@ -620,36 +566,41 @@ public:
         CARLA_SAFE_ASSERT_RETURN(uri != nullptr && uri[0] != '\0', kUridNull);
         carla_debug("CarlaLv2Client::getCustomURID(\"%s\")", uri);
 
-        const std::string    s_uri(uri);
-        const std::ptrdiff_t s_pos(std::find(fCustomURIDs.begin(), fCustomURIDs.end(), s_uri) - fCustomURIDs.begin());
-
-        if (s_pos <= 0 || s_pos >= INT32_MAX)
-            return kUridNull;
+        if (const LV2_URID urid = fUridMap.find(uri))
+            return urid;
 
-        const LV2_URID urid     = static_cast<LV2_URID>(s_pos);
-        const LV2_URID uriCount = static_cast<LV2_URID>(fCustomURIDs.size());
+        // without a host there is nobody to disagree with
+        if (! isPipeRunning())
+            return fUridMap.map(uri);
 
-        if (urid < uriCount)
-            return urid;
+        // the host owns the URID values, ask for it and wait for the reply.
+        // other messages arriving meanwhile are handled as usual
+        writeLv2UriMapMessage(uri);
 
-        CARLA_SAFE_ASSERT(urid == uriCount);
+        for (uint i=0; i < kUridReplyTimeout && isPipeRunning(); ++i)
+        {
+            idlePipe();
 
-        fCustomURIDs.push_back(uri);
+            if (const LV2_URID urid = fUridMap.find(uri))
+                return urid;
 
-        if (isPipeRunning())
-            writeLv2UridMessage(urid, uri);
+            carla_msleep(1);
+        }
 
-        return urid;
+        carla_stderr2("UI :: timed out waiting for the host to map URI '%s'", uri);
+        return kUridNull;
     }
 
     const char* getCustomURIDString(const LV2_URID urid) const noexcept
     {
         static const char* const sFallback = "urn:null";
         CARLA_SAFE_ASSERT_RETURN(urid != kUridNull, sFallback);
-        CARLA_SAFE_ASSERT_RETURN(urid < fCustomURIDs.size(), sFallback);
         carla_debug("CarlaLv2Client::getCustomURIDString(%i)", urid);
 
-        return fCustomURIDs[urid].c_str();
+        const char* const uri(fUridMap.unmap(urid));
+        CARLA_SAFE_ASSERT_RETURN(uri != nullptr, sFallback);
+
+        return uri;
     }
 
     // ----------------------------------------------------------------------------------------------------------------
@@ -720,7 +671,7 @@ public:
 
         default:
             carla_stderr("CarlaLv2Client::handleUiWrite(%i, %i, %i:\"%s\", %p) - unknown format",
-                         rindex, bufferSize, format, carla_lv2_urid_unmap(this, format), buffer);
+                         rindex, bufferSize, format, getCustomURIDString(format), buffer);
             break;
         }
     }
@@ -739,7 +690,7 @@ private:
     Lv2PluginOptions          fLv2Options;
 
     Options fUiOptions;
-    std::vector<std::string> fCustomURIDs;
+    Lv2UridMap fUridMap;
 
     struct Extensions {
         const LV2_Options_Interface* options;
@@ -895,113 +846,6 @@ private:
         CARLA_SAFE_ASSERT_RETURN(uri != nullptr && uri[0] != '\0', kUridNull);
         carla_debug("carla_lv2_urid_map(%p, \"%s\")", handle, uri);
 
-        // Atom types
-        if (std::strcmp(uri, LV2_ATOM__Blank) == 0)
-            return kUridAtomBlank;
-        if (std::strcmp(uri, LV2_ATOM__Bool) == 0)
-            return kUridAtomBool;
-        if (std::strcmp(uri, LV2_ATOM__Chunk) == 0)
-            return kUridAtomChunk;
-        if (std::strcmp(uri, LV2_ATOM__Double) == 0)
-            return kUridAtomDouble;
-        if (std::strcmp(uri, LV2_ATOM__Event) == 0)
-            return kUridAtomEvent;
-        if (std::strcmp(uri, LV2_ATOM__Float) == 0)
-            return kUridAtomFloat;
-        if (std::strcmp(uri, LV2_ATOM__Int) == 0)
-            return kUridAtomInt;
-        if (std::strcmp(uri, LV2_ATOM__Literal) == 0)
-            return kUridAtomLiteral;
-        if (std::strcmp(uri, LV2_ATOM__Long) == 0)
-            return kUridAtomLong;
-        if (std::strcmp(uri, LV2_ATOM__Number) == 0)
-            return kUridAtomNumber;
-        if (std::strcmp(uri, LV2_ATOM__Object) == 0)
-            return kUridAtomObject;
-        if (std::strcmp(uri, LV2_ATOM__Path) == 0)
-            return kUridAtomPath;
-        if (std::strcmp(uri, LV2_ATOM__Property) == 0)
-            return kUridAtomProperty;
-        if (std::strcmp(uri, LV2_ATOM__Resource) == 0)
-            return kUridAtomResource;
-        if (std::strcmp(uri, LV2_ATOM__Sequence) == 0)
-            return kUridAtomSequence;
-        if (std::strcmp(uri, LV2_ATOM__Sound) == 0)
-            return kUridAtomSound;
-        if (std::strcmp(uri, LV2_ATOM__String) == 0)
-            return kUridAtomString;
-        if (std::strcmp(uri, LV2_ATOM__Tuple) == 0)
-            return kUridAtomTuple;
-        if (std::strcmp(uri, LV2_ATOM__URI) == 0)
-            return kUridAtomURI;
-        if (std::strcmp(uri, LV2_ATOM__URID) == 0)
-            return kUridAtomURID;
-        if (std::strcmp(uri, LV2_ATOM__Vector) == 0)
-            return kUridAtomVector;
-        if (std::strcmp(uri, LV2_ATOM__atomTransfer) == 0)
-            return kUridAtomTransferAtom;
-        if (std::strcmp(uri, LV2_ATOM__eventTransfer) == 0)
-            return kUridAtomTransferEvent;
-
-        // BufSize types
-        if (std::strcmp(uri, LV2_BUF_SIZE__maxBlockLength) == 0)
-            return kUridBufMaxLength;
-        if (std::strcmp(uri, LV2_BUF_SIZE__minBlockLength) == 0)
-            return kUridBufMinLength;
-        if (std::strcmp(uri, LV2_BUF_SIZE__nominalBlockLength) == 0)
-            return kUridBufNominalLength;
-        if (std::strcmp(uri, LV2_BUF_SIZE__sequenceSize) == 0)
-            return kUridBufSequenceSize;
-
-        // Log types
-        if (std::strcmp(uri, LV2_LOG__Error) == 0)
-            return kUridLogError;
-        if (std::strcmp(uri, LV2_LOG__Note) == 0)
-            return kUridLogNote;
-        if (std::strcmp(uri, LV2_LOG__Trace) == 0)
-            return kUridLogTrace;
-        if (std::strcmp(uri, LV2_LOG__Warning) == 0)
-            return kUridLogWarning;
-
-        // Time types
-        if (std::strcmp(uri, LV2_TIME__Position) == 0)
-            return kUridTimePosition;
-        if (std::strcmp(uri, LV2_TIME__bar) == 0)
-            return kUridTimeBar;
-        if (std::strcmp(uri, LV2_TIME__barBeat) == 0)
-            return kUridTimeBarBeat;
-        if (std::strcmp(uri, LV2_TIME__beat) == 0)
-            return kUridTimeBeat;
-        if (std::strcmp(uri, LV2_TIME__beatUnit) == 0)
-            return kUridTimeBeatUnit;
-        if (std::strcmp(uri, LV2_TIME__beatsPerBar) == 0)
-            return kUridTimeBeatsPerBar;
-        if (std::strcmp(uri, LV2_TIME__beatsPerMinute) == 0)
-            return kUridTimeBeatsPerMinute;
-        if (std::strcmp(uri, LV2_TIME__frame) == 0)
-            return kUridTimeFrame;
-        if (std::strcmp(uri, LV2_TIME__framesPerSecond) == 0)
-            return kUridTimeFramesPerSecond;
-        if (std::strcmp(uri, LV2_TIME__speed) == 0)
-            return kUridTimeSpeed;
-        if (std::strcmp(uri, LV2_KXSTUDIO_PROPERTIES__TimePositionTicksPerBeat) == 0)
-            return kUridTimeTicksPerBeat;
-
-        // Others
-        if (std::strcmp(uri, LV2_MIDI__MidiEvent) == 0)
-            return kUridMidiEvent;
-        if (std::strcmp(uri, LV2_PARAMETERS__sampleRate) == 0)
-            return kUridParamSampleRate;
-        if (std::strcmp(uri, LV2_UI__windowTitle) == 0)
-            return kUridWindowTitle;
-
-        // Custom Carla types
-        if (std::strcmp(uri, URI_CARLA_ATOM_WORKER) == 0)
-            return kUridCarlaAtomWorker;
-        if (std::strcmp(uri, LV2_KXSTUDIO_PROPERTIES__TransientWindowId) == 0)
-            return kUridCarlaTransientWindowId;
-
-        // Custom plugin types
         return ((CarlaLv2Client*)handle)->getCustomURID(uri);
     }
 
@@ -1011,116 +855,6 @@ private:
         CARLA_SAFE_ASSERT_RETURN(urid != kUridNull, nullptr);
         carla_debug("carla_lv2_urid_unmap(%p, %i)", handle, urid);
 
-        switch (urid)
-        {
-        // Atom types
-        case kUridAtomBlank:
-            return LV2_ATOM__Blank;
-        case kUridAtomBool:
-            return LV2_ATOM__Bool;
-        case kUridAtomChunk:
-            return LV2_ATOM__Chunk;
-        case kUridAtomDouble:
-            return LV2_ATOM__Double;
-        case kUridAtomEvent:
-            return LV2_ATOM__Event;
-        case kUridAtomFloat:
-            return LV2_ATOM__Float;
-        case kUridAtomInt:
-            return LV2_ATOM__Int;
-        case kUridAtomLiteral:
-            return LV2_ATOM__Literal;
-        case kUridAtomLong:
-            return LV2_ATOM__Long;
-        case kUridAtomNumber:
-            return LV2_ATOM__Number;
-        case kUridAtomObject:
-            return LV2_ATOM__Object;
-        case kUridAtomPath:
-            return LV2_ATOM__Path;
-        case kUridAtomProperty:
-            return LV2_ATOM__Property;
-        case kUridAtomResource:
-            return LV2_ATOM__Resource;
-        case kUridAtomSequence:
-            return LV2_ATOM__Sequence;
-        case kUridAtomSound:
-            return LV2_ATOM__Sound;
-        case kUridAtomString:
-            return LV2_ATOM__String;
-        case kUridAtomTuple:
-            return LV2_ATOM__Tuple;
-        case kUridAtomURI:
-            return LV2_ATOM__URI;
-        case kUridAtomURID:
-            return LV2_ATOM__URID;
-        case kUridAtomVector:
-            return LV2_ATOM__Vector;
-        case kUridAtomTransferAtom:
-            return LV2_ATOM__atomTransfer;
-        case kUridAtomTransferEvent:
-            return LV2_ATOM__eventTransfer;
-
-        // BufSize types
-        case kUridBufMaxLength:
-            return LV2_BUF_SIZE__maxBlockLength;
-        case kUridBufMinLength:
-            return LV2_BUF_SIZE__minBlockLength;
-        case kUridBufNominalLength:
-            return LV2_BUF_SIZE__nominalBlockLength;
-        case kUridBufSequenceSize:
-            return LV2_BUF_SIZE__sequenceSize;
-
-        // Log types
-        case kUridLogError:
-            return LV2_LOG__Error;
-        case kUridLogNote:
-            return LV2_LOG__Note;
-        case kUridLogTrace:
-            return LV2_LOG__Trace;
-        case kUridLogWarning:
-            return LV2_LOG__Warning;
-
-        // Time types
-        case kUridTimePosition:
-            return LV2_TIME__Position;
-        case kUridTimeBar:
-            return LV2_TIME__bar;
-        case kUridTimeBarBeat:
-            return LV2_TIME__barBeat;
-        case kUridTimeBeat:
-            return LV2_TIME__beat;
-        case kUridTimeBeatUnit:
-            return LV2_TIME__beatUnit;
-        case kUridTimeBeatsPerBar:
-            return LV2_TIME__beatsPerBar;
-        case kUridTimeBeatsPerMinute:
-            return LV2_TIME__beatsPerMinute;
-        case kUridTimeFrame:
-            return LV2_TIME__frame;
-        case kUridTimeFramesPerSecond:
-            return LV2_TIME__framesPerSecond;
-        case kUridTimeSpeed:
-            return LV2_TIME__speed;
-        case kUridTimeTicksPerBeat:
-            return LV2_KXSTUDIO_PROPERTIES__TimePositionTicksPerBeat;
-
-        // Others
-        case kUridMidiEvent:
-            return LV2_MIDI__MidiEvent;
-        case kUridParamSampleRate:
-            return LV2_PARAMETERS__sampleRate;
-        case kUridWindowTitle:
-            return LV2_UI__windowTitle;
-
-        // Custom Carla types
-        case kUridCarlaAtomWorker:
-            return URI_CARLA_ATOM_WORKER;
-        case kUridCarlaTransientWindowId:
-            return LV2_KXSTUDIO_PROPERTIES__TransientWindowId;
-        }
-
-        // Custom types
         return ((CarlaLv2Client*)handle)->getCustomURIDString(urid);
     }
 
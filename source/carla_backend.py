@@ -129,6 +129,8 @@ def toPythonType(value, attr):
         return numPtrToList(value)
     if isinstance(value, POINTER(c_char_p)):
         return charPtrPtrToStringList(value)
+    if isinstance(value, Array):
+        return list(value)
     print("..............", attr, ".....................", value, ":", type(value))
     return value
 
@@ -504,6 +506,7 @@ ENGINE_CALLBACK_DEBUG = 0
 
 # A plugin has been added.
 # @a pluginId Plugin Id
+# @a value3   Time it took to load the plugin and restore its state, in milliseconds (only set when loading a project)
 # @a valueStr Plugin name
 ENGINE_CALLBACK_PLUGIN_ADDED = 1
 
@@ -811,6 +814,30 @@ ENGINE_OPTION_WINE_SERVER_RT_PRIO = 23
 # Capture console output into debug callbacks
 ENGINE_OPTION_DEBUG_CONSOLE_OUTPUT = 24
 
+# Number of extra threads used to process independent plugins in parallel.
+# Only used in patchbay and rack modes, cannot be changed while the engine is running.
+# Default is 0 (all processing is done in the audio thread).
+ENGINE_OPTION_AUDIO_WORKER_THREADS = 25
+
+# Let plugin bridges process the current block while the host consumes the previous one.
+# Removes the bridge round-trip from the audio thread, at the cost of one block of latency.
+# Only applies to bridges started afterwards.
+# Default is false.
+ENGINE_OPTION_PIPELINED_PLUGIN_BRIDGES = 26
+
+# Minimum size of the sub-blocks plugins are split into for sample-accurate events, in frames.
+# Parameter changes closer than this to the previous split or to the end of the block
+# are applied at the previous split instead, MIDI events keep their exact time where the plugin format allows it.
+# 0 splits at every event time.
+# Default is 0.
+ENGINE_OPTION_MIN_SUB_BLOCK_SIZE = 27
+
+# Time spent busy-waiting on plugin bridge semaphores before going to sleep, in microseconds.
+# Avoids a sleep and wake-up when the other side answers quickly, at the cost of some CPU.
+# Applies to the host and to bridges started afterwards, ignored on single-core systems.
+# Default is 20 on Linux, 0 elsewhere.
+ENGINE_OPTION_PLUGIN_BRIDGES_SPIN_TIME = 28
+
 # ------------------------------------------------------------------------------------------------------------
 # Engine Process Mode
 # Engine process mode.
@@ -1165,6 +1192,36 @@ class CarlaTransportInfo(Structure):
         ("bpm", c_double)
     ]
 
+# Wake-up latency statistics of a plugin bridge.
+# Measures the time between the host waking up the bridge audio thread and that thread running.
+# @see carla_get_plugin_bridge_wake_stats()
+class CarlaBridgeWakeStats(Structure):
+    _fields_ = [
+        # Number of wake-ups measured.
+        ("count", c_uint64),
+
+        # Highest wake-up latency, in microseconds.
+        ("maxUsecs", c_uint32),
+
+        # Number of wake-ups per latency range.
+        # Index 0 counts wake-ups under 1 microsecond, index N the ones under 2^N microseconds.
+        # The last index also counts anything slower.
+        ("histogram", c_uint32*16)
+    ]
+
+# Sub-block splitting statistics of a plugin.
+# Plugins split their audio block at event times, so parameter changes happen on the right frame.
+# @see carla_get_plugin_sub_block_stats()
+# @see ENGINE_OPTION_MIN_SUB_BLOCK_SIZE
+class CarlaSubBlockStats(Structure):
+    _fields_ = [
+        # Number of times the audio block was split at an event.
+        ("splitCount", c_uint64),
+
+        # Number of splits skipped because the event was too close to the previous split or to the end of the block.
+        ("skippedCount", c_uint64)
+    ]
+
 # Image data for LV2 inline display API.
 # raw image pixmap format is ARGB32,
 class CarlaInlineDisplayImageSurface(Structure):
@@ -1224,6 +1281,19 @@ PyCarlaTransportInfo = {
     "bpm": 0.0
 }
 
+# @see CarlaBridgeWakeStats
+PyCarlaBridgeWakeStats = {
+    'count': 0,
+    'maxUsecs': 0,
+    'histogram': [0]*16
+}
+
+# @see CarlaSubBlockStats
+PyCarlaSubBlockStats = {
+    'splitCount': 0,
+    'skippedCount': 0
+}
+
 # ------------------------------------------------------------------------------------------------------------
 # Set BINARY_NATIVE
 
@@ -1515,6 +1585,20 @@ class CarlaHostMeta(object):
     def get_plugin_info(self, pluginId):
         raise NotImplementedError
 
+    # Get wake-up latency statistics from a bridged plugin.
+    # All values are zero for plugins that are not bridged, or bridges running on Windows.
+    # @param pluginId Plugin
+    @abstractmethod
+    def get_plugin_bridge_wake_stats(self, pluginId):
+        raise NotImplementedError
+
+    # Get sub-block splitting statistics from a plugin.
+    # Bridged plugins split inside the bridge, their values are zero here.
+    # @param pluginId Plugin
+    @abstractmethod
+    def get_plugin_sub_block_stats(self, pluginId):
+        raise NotImplementedError
+
     # Get audio port count information from a plugin.
     # @param pluginId Plugin
     @abstractmethod
@@ -2003,6 +2087,12 @@ class CarlaHostNull(CarlaHostMeta):
     def get_plugin_info(self, pluginId):
         return PyCarlaPluginInfo
 
+    def get_plugin_bridge_wake_stats(self, pluginId):
+        return PyCarlaBridgeWakeStats
+
+    def get_plugin_sub_block_stats(self, pluginId):
+        return PyCarlaSubBlockStats
+
     def get_audio_port_count_info(self, pluginId):
         return PyCarlaPortCountInfo
 
@@ -2285,6 +2375,12 @@ class CarlaHostDLL(CarlaHostMeta):
         self.lib.carla_get_plugin_info.argtypes = [c_uint]
         self.lib.carla_get_plugin_info.restype = POINTER(CarlaPluginInfo)
 
+        self.lib.carla_get_plugin_bridge_wake_stats.argtypes = [c_uint]
+        self.lib.carla_get_plugin_bridge_wake_stats.restype = POINTER(CarlaBridgeWakeStats)
+
+        self.lib.carla_get_plugin_sub_block_stats.argtypes = [c_uint]
+        self.lib.carla_get_plugin_sub_block_stats.restype = POINTER(CarlaSubBlockStats)
+
         self.lib.carla_get_audio_port_count_info.argtypes = [c_uint]
         self.lib.carla_get_audio_port_count_info.restype = POINTER(CarlaPortCountInfo)
 
@@ -2562,6 +2658,12 @@ class CarlaHostDLL(CarlaHostMeta):
     def get_plugin_info(self, pluginId):
         return structToDict(self.lib.carla_get_plugin_info(pluginId).contents)
 
+    def get_plugin_bridge_wake_stats(self, pluginId):
+        return structToDict(self.lib.carla_get_plugin_bridge_wake_stats(pluginId).contents)
+
+    def get_plugin_sub_block_stats(self, pluginId):
+        return structToDict(self.lib.carla_get_plugin_sub_block_stats(pluginId).contents)
+
     def get_audio_port_count_info(self, pluginId):
         return structToDict(self.lib.carla_get_audio_port_count_info(pluginId).contents)
 
@@ -2902,6 +3004,12 @@ class CarlaHostPlugin(CarlaHostMeta):
     def get_plugin_info(self, pluginId):
         return self.fPluginsInfo[pluginId].pluginInfo
 
+    def get_plugin_bridge_wake_stats(self, pluginId):
+        return PyCarlaBridgeWakeStats
+
+    def get_plugin_sub_block_stats(self, pluginId):
+        return PyCarlaSubBlockStats
+
     def get_audio_port_count_info(self, pluginId):
         return self.fPluginsInfo[pluginId].audioCountInfo
 
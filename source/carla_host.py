@@ -647,7 +647,7 @@ class HostWindow(QMainWindow):
 
     @pyqtSlot()
     def slot_fileOpen(self):
-        fileFilter = self.tr("Carla Project File (*.carxp);;Carla Preset File (*.carxs)")
+        fileFilter = self.tr("Carla Project File (*.carxp);;Carla Preset File (*.carxs);;Carla Binary Project File (*.carbp);;Carla Binary Preset File (*.carbs)")
         filename   = QFileDialog.getOpenFileName(self, self.tr("Open Carla Project File"), self.fSavedSettings[CARLA_KEY_MAIN_PROJECT_FOLDER], filter=fileFilter)
 
         if config_UseQt5:
@@ -678,7 +678,7 @@ class HostWindow(QMainWindow):
         if self.fProjectFilename and not saveAs:
             return self.saveProjectNow()
 
-        fileFilter = self.tr("Carla Project File (*.carxp)")
+        fileFilter = self.tr("Carla Project File (*.carxp);;Carla Binary Project File (*.carbp)")
         filename   = QFileDialog.getSaveFileName(self, self.tr("Save Carla Project File"), self.fSavedSettings[CARLA_KEY_MAIN_PROJECT_FOLDER], filter=fileFilter)
 
         if config_UseQt5:
@@ -686,7 +686,7 @@ class HostWindow(QMainWindow):
         if not filename:
             return
 
-        if not filename.lower().endswith(".carxp"):
+        if not filename.lower().endswith((".carxp", ".carbp")):
             filename += ".carxp"
 
         if self.fProjectFilename != filename:
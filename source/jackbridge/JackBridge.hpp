@@ -399,6 +399,7 @@ JACKBRIDGE_API void jackbridge_sem_destroy(void* sem) noexcept;
 JACKBRIDGE_API bool jackbridge_sem_connect(void* sem) noexcept;
 JACKBRIDGE_API void jackbridge_sem_post(void* sem, bool server) noexcept;
 JACKBRIDGE_API bool jackbridge_sem_timedwait(void* sem, uint msecs, bool server) noexcept;
+JACKBRIDGE_API void jackbridge_sem_set_spin(uint usecs) noexcept;
 
 JACKBRIDGE_API bool  jackbridge_shm_is_valid(const void* shm) noexcept;
 JACKBRIDGE_API void  jackbridge_shm_init(void* shm) noexcept;
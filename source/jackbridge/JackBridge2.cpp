@@ -25,6 +25,13 @@
 
 // -----------------------------------------------------------------------------
 
+#ifndef JACKBRIDGE_DUMMY
+// busy-wait attempts before sleeping on a semaphore, set by jackbridge_sem_set_spin()
+static uint gSpinIterations = 0;
+#endif
+
+// -----------------------------------------------------------------------------
+
 bool jackbridge_sem_init(void* sem) noexcept
 {
     CARLA_SAFE_ASSERT_RETURN(sem != nullptr, false);
@@ -70,8 +77,22 @@ bool jackbridge_sem_timedwait(void* sem, uint msecs, bool server) noexcept
 #ifdef JACKBRIDGE_DUMMY
     return false;
 #else
-    return carla_sem_timedwait(*(carla_sem_t*)sem, msecs, server);
+    return carla_sem_timedwait(*(carla_sem_t*)sem, msecs, server, gSpinIterations);
+#endif
+}
+
+void jackbridge_sem_set_spin(uint usecs) noexcept
+{
+#ifndef JACKBRIDGE_DUMMY
+# ifdef CARLA_SEM_CAN_SPIN
+    if (usecs > 1000)
+        usecs = 1000;
+
+    gSpinIterations = usecs != 0 ? usecs * carla_sem_calibrate_spin() : 0;
+# endif
 #endif
+    // may be unused
+    (void)usecs;
 }
 
 // -----------------------------------------------------------------------------
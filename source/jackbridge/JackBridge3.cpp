@@ -131,6 +131,7 @@ const JackBridgeExportedFunctions* JACKBRIDGE_API jackbridge_get_exported_functi
     funcs.sem_connect_ptr                      = jackbridge_sem_connect;
     funcs.sem_post_ptr                         = jackbridge_sem_post;
     funcs.sem_timedwait_ptr                    = jackbridge_sem_timedwait;
+    funcs.sem_set_spin_ptr                     = jackbridge_sem_set_spin;
     funcs.shm_is_valid_ptr                     = jackbridge_shm_is_valid;
     funcs.shm_init_ptr                         = jackbridge_shm_init;
     funcs.shm_attach_ptr                       = jackbridge_shm_attach;
@@ -558,6 +558,11 @@ bool jackbridge_sem_timedwait(void* sem, uint msecs, bool server) noexcept
     return getBridgeInstance().sem_timedwait_ptr(sem, msecs, server);
 }
 
+void jackbridge_sem_set_spin(uint usecs) noexcept
+{
+    getBridgeInstance().sem_set_spin_ptr(usecs);
+}
+
 bool jackbridge_shm_is_valid(const void* shm) noexcept
 {
     return getBridgeInstance().shm_is_valid_ptr(shm);
@@ -114,6 +114,7 @@ typedef void (JACKBRIDGE_API *jackbridgesym_sem_destroy)(void*);
 typedef bool (JACKBRIDGE_API *jackbridgesym_sem_connect)(void*);
 typedef void (JACKBRIDGE_API *jackbridgesym_sem_post)(void*, bool);
 typedef bool (JACKBRIDGE_API *jackbridgesym_sem_timedwait)(void*, uint, bool);
+typedef void (JACKBRIDGE_API *jackbridgesym_sem_set_spin)(uint);
 typedef bool (JACKBRIDGE_API *jackbridgesym_shm_is_valid)(const void*);
 typedef void (JACKBRIDGE_API *jackbridgesym_shm_init)(void*);
 typedef void (JACKBRIDGE_API *jackbridgesym_shm_attach)(void*, const char*);
@@ -220,6 +221,7 @@ struct _JackBridgeExportedFunctions {
     jackbridgesym_sem_connect sem_connect_ptr;
     jackbridgesym_sem_post sem_post_ptr;
     jackbridgesym_sem_timedwait sem_timedwait_ptr;
+    jackbridgesym_sem_set_spin sem_set_spin_ptr;
     jackbridgesym_shm_is_valid shm_is_valid_ptr;
     jackbridgesym_shm_init shm_init_ptr;
     jackbridgesym_shm_attach shm_attach_ptr;
@@ -16,31 +16,38 @@
  * For a full copy of the GNU General Public License see the GPL.txt file
  */
 
-#include "list.h"
 #include "rtmempool.h"
 #include "rtmempool-lv2.h"
 
 #include <assert.h>
-#include <pthread.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-#define RTMEMPOOL_THREAD_SAFETY 0
+// ------------------------------------------------------------------------------------------------
+// Nodes are never freed before the pool is destroyed, and every one of them gets a fixed index.
+// The free list is a lock-free stack of those indexes, its head carries a tag that changes on
+// every update, so a thread that got delayed in the middle of a pop can't be fooled by a head
+// that was popped and pushed back meanwhile (ABA).
+// Both index and tag fit in 64 bits, which every supported CPU can compare-and-swap natively.
 
-#if RTMEMPOOL_THREAD_SAFETY
-#define rtmempool_mutex_lock(m) pthread_mutex_lock(m)
-#define rtmempool_mutex_unlock(m) pthread_mutex_unlock(m)
-#else
-#define rtmempool_mutex_lock(...)
-#define rtmempool_mutex_unlock(...)
-#endif
+// upper limit for maxPreallocated, the node table is allocated upfront
+#define RTMEMPOOL_MAX_NODES (1U << 20)
 
 // ------------------------------------------------------------------------------------------------
 
-typedef struct list_head k_list_head;
+typedef union _RtMemPoolNode
+{
+    struct {
+        uint32_t index;
+        uint32_t next; // index + 1 of the next free node, 0 for none
+    } s;
 
-// ------------------------------------------------------------------------------------------------
+    // user data comes right after the node, keep it aligned to 2 pointers
+    void* align[2];
+
+} RtMemPoolNode;
 
 typedef struct _RtMemPool
 {
@@ -50,63 +57,106 @@ typedef struct _RtMemPool
     size_t minPreallocated;
     size_t maxPreallocated;
 
-    k_list_head used;
-    unsigned int usedCount;
-
-    k_list_head unused;
-    unsigned int unusedCount;
+    // all nodes ever created, slots below nodeCount are reserved
+    RtMemPoolNode** nodes;
+    uint32_t nodeCount;
 
-    pthread_mutex_t mutex;
+    // tag << 32 | (index + 1) of the first free node
+    uint64_t freeHead;
+    uint32_t unusedCount;
 
 } RtMemPool;
 
 // ------------------------------------------------------------------------------------------------
-// adjust unused list size
+// lock-free free list
 
-static void rtsafe_memory_pool_sleepy(RtMemPool* poolPtr, bool* overMaxOrMallocFailed)
+static void rtmempool_push(RtMemPool* poolPtr, RtMemPoolNode* nodePtr)
 {
-    k_list_head* nodePtr;
-    k_list_head unused;
-    unsigned int unusedCount;
+    uint64_t oldHead, newHead;
 
-    INIT_LIST_HEAD(&unused);
-    unusedCount = 0;
+    oldHead = __atomic_load_n(&poolPtr->freeHead, __ATOMIC_RELAXED);
 
-    while (poolPtr->unusedCount + unusedCount < poolPtr->minPreallocated)
-    {
-        if (poolPtr->usedCount + poolPtr->unusedCount + unusedCount >= poolPtr->maxPreallocated)
-        {
-            *overMaxOrMallocFailed = true;
-            break;
-        }
+    do {
+        __atomic_store_n(&nodePtr->s.next, (uint32_t)oldHead, __ATOMIC_RELAXED);
+        newHead = (((oldHead >> 32) + 1) << 32) | (uint64_t)(nodePtr->s.index + 1);
+    }
+    while (! __atomic_compare_exchange_n(&poolPtr->freeHead, &oldHead, newHead, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
 
-        nodePtr = malloc(sizeof(k_list_head) + poolPtr->dataSize);
+    __atomic_add_fetch(&poolPtr->unusedCount, 1, __ATOMIC_RELAXED);
+}
 
-        if (nodePtr == NULL)
-        {
-            *overMaxOrMallocFailed = true;
-            break;
-        }
+static RtMemPoolNode* rtmempool_pop(RtMemPool* poolPtr)
+{
+    RtMemPoolNode* nodePtr;
+    uint64_t oldHead, newHead;
+    uint32_t next;
 
-        list_add_tail(nodePtr, &unused);
-        ++unusedCount;
+    oldHead = __atomic_load_n(&poolPtr->freeHead, __ATOMIC_ACQUIRE);
+
+    do {
+        if ((uint32_t)oldHead == 0)
+            return NULL;
+
+        // even if someone else takes this node meanwhile, its memory stays valid,
+        // and the tag makes our swap fail
+        nodePtr = poolPtr->nodes[(uint32_t)oldHead - 1];
+        next = __atomic_load_n(&nodePtr->s.next, __ATOMIC_RELAXED);
+        newHead = (((oldHead >> 32) + 1) << 32) | (uint64_t)next;
     }
+    while (! __atomic_compare_exchange_n(&poolPtr->freeHead, &oldHead, newHead, true, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE));
 
-    rtmempool_mutex_lock(&poolPtr->mutex);
+    __atomic_sub_fetch(&poolPtr->unusedCount, 1, __ATOMIC_RELAXED);
+    return nodePtr;
+}
 
-    poolPtr->unusedCount += unusedCount;
+// ------------------------------------------------------------------------------------------------
+// create a new node and add it to the free list, returns false if over max or malloc failed
 
-    while (unusedCount != 0)
-    {
-        assert(! list_empty(&unused));
+static bool rtmempool_add_node(RtMemPool* poolPtr)
+{
+    RtMemPoolNode* nodePtr;
+    uint32_t index;
+
+    // reserve a slot, several threads might be doing this at once
+    index = __atomic_load_n(&poolPtr->nodeCount, __ATOMIC_RELAXED);
 
-        nodePtr = unused.next;
-        list_del(nodePtr);
-        list_add_tail(nodePtr, &poolPtr->unused);
-        --unusedCount;
+    do {
+        if (index >= poolPtr->maxPreallocated)
+            return false;
     }
+    while (! __atomic_compare_exchange_n(&poolPtr->nodeCount, &index, index + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+    nodePtr = malloc(sizeof(RtMemPoolNode) + poolPtr->dataSize);
+
+    // slot stays empty and reserved, destroy skips it
+    if (nodePtr == NULL)
+        return false;
+
+    nodePtr->s.index = index;
+    nodePtr->s.next = 0;
+    poolPtr->nodes[index] = nodePtr;
 
-    rtmempool_mutex_unlock(&poolPtr->mutex);
+    // the release in push makes the table entry visible to whoever pops this node
+    rtmempool_push(poolPtr, nodePtr);
+    return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+// adjust unused list size
+
+static void rtsafe_memory_pool_sleepy(RtMemPool* poolPtr, bool* overMaxOrMallocFailed)
+{
+    // always keep at least 1 free node around, otherwise allocate_sleepy would never succeed
+    const size_t minUnused = poolPtr->minPreallocated != 0 ? poolPtr->minPreallocated : 1;
+
+    while (__atomic_load_n(&poolPtr->unusedCount, __ATOMIC_RELAXED) < minUnused)
+    {
+        if (! rtmempool_add_node(poolPtr))
+        {
+            *overMaxOrMallocFailed = true;
+            break;
+        }
+    }
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -120,9 +170,17 @@ static bool rtsafe_memory_pool_create2(RtMemPool_Handle* handlePtr,
     assert(minPreallocated <= maxPreallocated);
     assert(poolName == NULL || strlen(poolName) < RTSAFE_MEMORY_POOL_NAME_MAX);
 
-    k_list_head* nodePtr;
     RtMemPool* poolPtr;
 
+    if (maxPreallocated > RTMEMPOOL_MAX_NODES)
+    {
+        fprintf(stderr, "warning: rtsafe_memory_pool_create called with too many nodes, limiting to %u\n", RTMEMPOOL_MAX_NODES);
+        maxPreallocated = RTMEMPOOL_MAX_NODES;
+    }
+
+    if (minPreallocated > maxPreallocated)
+        minPreallocated = maxPreallocated;
+
     poolPtr = malloc(sizeof(RtMemPool));
 
     if (poolPtr == NULL)
@@ -130,6 +188,14 @@ static bool rtsafe_memory_pool_create2(RtMemPool_Handle* handlePtr,
         return false;
     }
 
+    poolPtr->nodes = calloc(maxPreallocated != 0 ? maxPreallocated : 1, sizeof(RtMemPoolNode*));
+
+    if (poolPtr->nodes == NULL)
+    {
+        free(poolPtr);
+        return false;
+    }
+
     if (poolName != NULL)
     {
         strcpy(poolPtr->name, poolName);
@@ -143,31 +209,16 @@ static bool rtsafe_memory_pool_create2(RtMemPool_Handle* handlePtr,
     poolPtr->minPreallocated = minPreallocated;
     poolPtr->maxPreallocated = maxPreallocated;
 
-    INIT_LIST_HEAD(&poolPtr->used);
-    poolPtr->usedCount = 0;
-
-    INIT_LIST_HEAD(&poolPtr->unused);
+    poolPtr->nodeCount = 0;
+    poolPtr->freeHead = 0;
     poolPtr->unusedCount = 0;
 
-    pthread_mutexattr_t atts;
-    pthread_mutexattr_init(&atts);
-#ifdef __ARM_ARCH_7A__
-    pthread_mutexattr_setprotocol(&atts, PTHREAD_PRIO_INHERIT);
-#endif
-    pthread_mutex_init(&poolPtr->mutex, &atts);
-    pthread_mutexattr_destroy(&atts);
-
     while (poolPtr->unusedCount < poolPtr->minPreallocated)
     {
-        nodePtr = malloc(sizeof(k_list_head) + poolPtr->dataSize);
-
-        if (nodePtr == NULL)
+        if (! rtmempool_add_node(poolPtr))
         {
             break;
         }
-
-        list_add_tail(nodePtr, &poolPtr->unused);
-        poolPtr->unusedCount++;
     }
 
     *handlePtr = (RtMemPool_Handle)poolPtr;
@@ -203,62 +254,57 @@ void rtsafe_memory_pool_destroy(RtMemPool_Handle handle)
 {
     assert(handle);
 
-    k_list_head* nodePtr;
+    uint32_t i, nodeCount, usedCount;
     RtMemPool* poolPtr = (RtMemPool*)handle;
 
-    // caller should deallocate all chunks prior releasing pool itself
-    if (poolPtr->usedCount != 0)
-    {
-        fprintf(stderr, "warning: rtsafe_memory_pool_destroy called with nodes still active\n");
-    }
+    nodeCount = __atomic_load_n(&poolPtr->nodeCount, __ATOMIC_ACQUIRE);
+    usedCount = 0;
 
-    while (poolPtr->unusedCount != 0)
+    // reserved slots whose malloc failed count as used, ignore them
+    for (i = 0; i < nodeCount; ++i)
     {
-        assert(! list_empty(&poolPtr->unused));
+        if (poolPtr->nodes[i] != NULL)
+            ++usedCount;
+    }
 
-        nodePtr = poolPtr->unused.next;
+    usedCount -= __atomic_load_n(&poolPtr->unusedCount, __ATOMIC_ACQUIRE);
 
-        list_del(nodePtr);
-        poolPtr->unusedCount--;
+    // caller should deallocate all chunks prior releasing pool itself
+    if (usedCount != 0)
+    {
+        fprintf(stderr, "warning: rtsafe_memory_pool_destroy called with nodes still active\n");
 
-        free(nodePtr);
+        // only free what's unused, someone might still be using the rest
+        for (RtMemPoolNode* nodePtr; (nodePtr = rtmempool_pop(poolPtr)) != NULL;)
+            free(nodePtr);
+    }
+    else
+    {
+        for (i = 0; i < nodeCount; ++i)
+            free(poolPtr->nodes[i]);
     }
 
-    assert(list_empty(&poolPtr->unused));
-
-    pthread_mutex_destroy(&poolPtr->mutex);
-
+    free(poolPtr->nodes);
     free(poolPtr);
 }
 
 // ------------------------------------------------------------------------------------------------
-// find entry in unused list, fail if it is empty
+// take a node from the free list, fail if it is empty
 
 void* rtsafe_memory_pool_allocate_atomic(RtMemPool_Handle handle)
 {
     assert(handle);
 
-    k_list_head* nodePtr;
+    RtMemPoolNode* nodePtr;
     RtMemPool* poolPtr = (RtMemPool*)handle;
 
-    rtmempool_mutex_lock(&poolPtr->mutex);
+    nodePtr = rtmempool_pop(poolPtr);
 
-    if (list_empty(&poolPtr->unused))
+    if (nodePtr == NULL)
     {
-        rtmempool_mutex_unlock(&poolPtr->mutex);
         return NULL;
     }
 
-    nodePtr = poolPtr->unused.next;
-    list_del(nodePtr);
-
-    poolPtr->unusedCount--;
-    poolPtr->usedCount++;
-
-    list_add_tail(nodePtr, &poolPtr->used);
-
-    rtmempool_mutex_unlock(&poolPtr->mutex);
-
     return (nodePtr + 1);
 }
 
@@ -282,7 +328,7 @@ void* rtsafe_memory_pool_allocate_sleepy(RtMemPool_Handle handle)
 }
 
 // ------------------------------------------------------------------------------------------------
-// move from used to unused list
+// give a node back to the free list
 
 void rtsafe_memory_pool_deallocate(RtMemPool_Handle handle, void* memoryPtr)
 {
@@ -290,14 +336,7 @@ void rtsafe_memory_pool_deallocate(RtMemPool_Handle handle, void* memoryPtr)
 
     RtMemPool* poolPtr = (RtMemPool*)handle;
 
-    rtmempool_mutex_lock(&poolPtr->mutex);
-
-    list_del((k_list_head*)memoryPtr - 1);
-    list_add_tail((k_list_head*)memoryPtr - 1, &poolPtr->unused);
-    poolPtr->usedCount--;
-    poolPtr->unusedCount++;
-
-    rtmempool_mutex_unlock(&poolPtr->mutex);
+    rtmempool_push(poolPtr, (RtMemPoolNode*)memoryPtr - 1);
 }
 
 // ------------------------------------------------------------------------------------------------
@@ -29,6 +29,51 @@ const int AudioProcessorGraph::midiChannelIndex = 0x1000;
 namespace GraphRenderingOps
 {
 
+//==============================================================================
+/** The set of shared buffers read and written by some rendering ops.
+    Used to find out which ops can be run concurrently.
+*/
+struct BufferUsage
+{
+    BufferUsage() noexcept {}
+
+    void readAudio (const int bufferNum)    { reads.add (bufferNum * 2); }
+    void writeAudio (const int bufferNum)   { writes.add (bufferNum * 2); }
+    void readMidi (const int bufferNum)     { reads.add (bufferNum * 2 + 1); }
+    void writeMidi (const int bufferNum)    { writes.add (bufferNum * 2 + 1); }
+    void writeGraphOutput()                 { writes.add (-1); }
+
+    bool usesAudio (const int bufferNum) const noexcept { return uses (bufferNum * 2); }
+    bool usesMidi (const int bufferNum) const noexcept  { return uses (bufferNum * 2 + 1); }
+
+    bool conflictsWith (const BufferUsage& other) const noexcept
+    {
+        return intersects (writes, other.writes)
+            || intersects (writes, other.reads)
+            || intersects (reads, other.writes);
+    }
+
+private:
+    SortedSet<int> reads, writes;
+
+    bool uses (const int index) const noexcept
+    {
+        return reads.contains (index) || writes.contains (index);
+    }
+
+    static bool intersects (const SortedSet<int>& a, const SortedSet<int>& b) noexcept
+    {
+        for (int i = a.size(); --i >= 0;)
+            if (b.contains (a.getUnchecked (i)))
+                return true;
+
+        return false;
+    }
+
+    CARLA_DECLARE_NON_COPY_CLASS (BufferUsage)
+};
+
+//==============================================================================
 struct AudioGraphRenderingOpBase
 {
     AudioGraphRenderingOpBase() noexcept {}
@@ -37,6 +82,11 @@ struct AudioGraphRenderingOpBase
     virtual void perform (AudioSampleBuffer& sharedBufferChans,
                           const OwnedArray<MidiBuffer>& sharedMidiBuffers,
                           const int numSamples) = 0;
+
+    virtual void addBufferUsage (BufferUsage& usage) const = 0;
+
+    /** True for the op that processes a node, which is the last one of the ops for that node. */
+    virtual bool processesNode() const noexcept { return false; }
 };
 
 // use CRTP
@@ -61,6 +111,11 @@ struct ClearChannelOp  : public AudioGraphRenderingOp<ClearChannelOp>
         sharedBufferChans.clear (channelNum, 0, numSamples);
     }
 
+    void addBufferUsage (BufferUsage& usage) const override
+    {
+        usage.writeAudio (channelNum);
+    }
+
     const int channelNum;
 
     CARLA_DECLARE_NON_COPY_CLASS (ClearChannelOp)
@@ -78,6 +133,12 @@ struct CopyChannelOp  : public AudioGraphRenderingOp<CopyChannelOp>
         sharedBufferChans.copyFrom (dstChannelNum, 0, sharedBufferChans, srcChannelNum, 0, numSamples);
     }
 
+    void addBufferUsage (BufferUsage& usage) const override
+    {
+        usage.readAudio (srcChannelNum);
+        usage.writeAudio (dstChannelNum);
+    }
+
     const int srcChannelNum, dstChannelNum;
 
     CARLA_DECLARE_NON_COPY_CLASS (CopyChannelOp)
@@ -95,6 +156,12 @@ struct AddChannelOp  : public AudioGraphRenderingOp<AddChannelOp>
         sharedBufferChans.addFrom (dstChannelNum, 0, sharedBufferChans, srcChannelNum, 0, numSamples);
     }
 
+    void addBufferUsage (BufferUsage& usage) const override
+    {
+        usage.readAudio (srcChannelNum);
+        usage.writeAudio (dstChannelNum);
+    }
+
     const int srcChannelNum, dstChannelNum;
 
     CARLA_DECLARE_NON_COPY_CLASS (AddChannelOp)
@@ -110,6 +177,11 @@ struct ClearMidiBufferOp  : public AudioGraphRenderingOp<ClearMidiBufferOp>
         sharedMidiBuffers.getUnchecked (bufferNum)->clear();
     }
 
+    void addBufferUsage (BufferUsage& usage) const override
+    {
+        usage.writeMidi (bufferNum);
+    }
+
     const int bufferNum;
 
     CARLA_DECLARE_NON_COPY_CLASS (ClearMidiBufferOp)
@@ -127,6 +199,12 @@ struct CopyMidiBufferOp  : public AudioGraphRenderingOp<CopyMidiBufferOp>
         *sharedMidiBuffers.getUnchecked (dstBufferNum) = *sharedMidiBuffers.getUnchecked (srcBufferNum);
     }
 
+    void addBufferUsage (BufferUsage& usage) const override
+    {
+        usage.readMidi (srcBufferNum);
+        usage.writeMidi (dstBufferNum);
+    }
+
     const int srcBufferNum, dstBufferNum;
 
     CARLA_DECLARE_NON_COPY_CLASS (CopyMidiBufferOp)
@@ -145,6 +223,12 @@ struct AddMidiBufferOp  : public AudioGraphRenderingOp<AddMidiBufferOp>
             ->addEvents (*sharedMidiBuffers.getUnchecked (srcBufferNum), 0, numSamples, 0);
     }
 
+    void addBufferUsage (BufferUsage& usage) const override
+    {
+        usage.readMidi (srcBufferNum);
+        usage.writeMidi (dstBufferNum);
+    }
+
     const int srcBufferNum, dstBufferNum;
 
     CARLA_DECLARE_NON_COPY_CLASS (AddMidiBufferOp)
@@ -176,6 +260,11 @@ struct DelayChannelOp  : public AudioGraphRenderingOp<DelayChannelOp>
         }
     }
 
+    void addBufferUsage (BufferUsage& usage) const override
+    {
+        usage.writeAudio (channel);
+    }
+
 private:
     HeapBlock<float> buffer;
     const int channel, bufferSize;
@@ -229,6 +318,33 @@ struct ProcessBufferOp   : public AudioGraphRenderingOp<ProcessBufferOp>
         processor->processBlock (buffer, midiMessages);
     }
 
+    bool processesNode() const noexcept override
+    {
+        return true;
+    }
+
+    void addBufferUsage (BufferUsage& usage) const override
+    {
+        const int numIns  = processor->getTotalNumInputChannels();
+        const int numOuts = processor->getTotalNumOutputChannels();
+
+        // input-only channels are left untouched, everything else is processed in-place
+        for (int i = 0; i < totalChans; ++i)
+        {
+            if (i < numIns && i >= numOuts)
+                usage.readAudio (audioChannelsToUse.getUnchecked (i));
+            else
+                usage.writeAudio (audioChannelsToUse.getUnchecked (i));
+        }
+
+        usage.writeMidi (midiBufferToUse);
+
+        // graph outputs are mixed into the same buffers
+        if (node->isIOProcessor()
+             && static_cast<const AudioProcessorGraph::AudioGraphIOProcessor*> (processor)->isOutput())
+            usage.writeGraphOutput();
+    }
+
     const AudioProcessorGraph::Node::Ptr node;
     AudioProcessor* const processor;
 
@@ -242,6 +358,117 @@ private:
     CARLA_DECLARE_NON_COPY_CLASS (ProcessBufferOp)
 };
 
+//==============================================================================
+// Holds a fast lookup table for checking which nodes are inputs to others.
+class ConnectionLookupTable
+{
+public:
+    explicit ConnectionLookupTable (const OwnedArray<AudioProcessorGraph::Connection>& connections)
+    {
+        for (int i = 0; i < connections.size(); ++i)
+        {
+            const AudioProcessorGraph::Connection* const c = connections.getUnchecked(i);
+
+            int index;
+            Entry* entry = findEntry (c->destNodeId, index);
+
+            if (entry == nullptr)
+            {
+                entry = new Entry (c->destNodeId);
+                entries.insert (index, entry);
+            }
+
+            entry->srcNodes.add (c->sourceNodeId);
+        }
+    }
+
+    bool isAnInputTo (const uint32 possibleInputId,
+                      const uint32 possibleDestinationId) const noexcept
+    {
+        return isAnInputToRecursive (possibleInputId, possibleDestinationId, entries.size());
+    }
+
+private:
+    //==============================================================================
+    struct Entry
+    {
+        explicit Entry (const uint32 destNodeId_) noexcept : destNodeId (destNodeId_) {}
+
+        const uint32 destNodeId;
+        SortedSet<uint32> srcNodes;
+
+        CARLA_DECLARE_NON_COPY_CLASS (Entry)
+    };
+
+    OwnedArray<Entry> entries;
+
+    bool isAnInputToRecursive (const uint32 possibleInputId,
+                               const uint32 possibleDestinationId,
+                               int recursionCheck) const noexcept
+    {
+        int index;
+
+        if (const Entry* const entry = findEntry (possibleDestinationId, index))
+        {
+            const SortedSet<uint32>& srcNodes = entry->srcNodes;
+
+            if (srcNodes.contains (possibleInputId))
+                return true;
+
+            if (--recursionCheck >= 0)
+            {
+                for (int i = 0; i < srcNodes.size(); ++i)
+                    if (isAnInputToRecursive (possibleInputId, srcNodes.getUnchecked(i), recursionCheck))
+                        return true;
+            }
+        }
+
+        return false;
+    }
+
+    Entry* findEntry (const uint32 destNodeId, int& insertIndex) const noexcept
+    {
+        Entry* result = nullptr;
+
+        int start = 0;
+        int end = entries.size();
+
+        for (;;)
+        {
+            if (start >= end)
+            {
+                break;
+            }
+            else if (destNodeId == entries.getUnchecked (start)->destNodeId)
+            {
+                result = entries.getUnchecked (start);
+                break;
+            }
+            else
+            {
+                const int halfway = (start + end) / 2;
+
+                if (halfway == start)
+                {
+                    if (destNodeId >= entries.getUnchecked (halfway)->destNodeId)
+                        ++start;
+
+                    break;
+                }
+                else if (destNodeId >= entries.getUnchecked (halfway)->destNodeId)
+                    start = halfway;
+                else
+                    end = halfway;
+            }
+        }
+
+        insertIndex = start;
+        return result;
+    }
+
+    CARLA_DECLARE_NON_COPY_CLASS (ConnectionLookupTable)
+};
+
 //==============================================================================
 /** Used to calculate the correct sequence of rendering ops needed, based on
     the best re-use of shared buffers at each stage.
@@ -250,9 +477,11 @@ struct RenderingOpSequenceCalculator
 {
     RenderingOpSequenceCalculator (AudioProcessorGraph& g,
                                    const Array<AudioProcessorGraph::Node*>& nodes,
-                                   Array<void*>& renderingOps)
+                                   Array<void*>& renderingOps,
+                                   const ConnectionLookupTable* const parallelTable)
         : graph (g),
           orderedNodes (nodes),
+          parallelLookupTable (parallelTable),
           totalLatency (0)
     {
         nodeIds.add ((uint32) zeroNodeID); // first buffer is read-only zeros
@@ -262,7 +491,20 @@ struct RenderingOpSequenceCalculator
 
         for (int i = 0; i < orderedNodes.size(); ++i)
         {
+            const int firstOp = renderingOps.size();
+
             createRenderingOpsForNode (*orderedNodes.getUnchecked(i), renderingOps, i);
+
+            if (parallelLookupTable != nullptr)
+            {
+                BufferUsage* const usage = new BufferUsage();
+
+                for (int j = firstOp; j < renderingOps.size(); ++j)
+                    ((AudioGraphRenderingOpBase*) renderingOps.getUnchecked(j))->addBufferUsage (*usage);
+
+                nodeUsages.add (usage);
+            }
+
             markAnyUnusedBuffersAsFree (i);
         }
 
@@ -276,6 +518,8 @@ private:
     //==============================================================================
     AudioProcessorGraph& graph;
     const Array<AudioProcessorGraph::Node*>& orderedNodes;
+    const ConnectionLookupTable* const parallelLookupTable;
+    OwnedArray<BufferUsage> nodeUsages;
     Array<int> channels;
     Array<uint32> nodeIds, midiNodeIds;
 
@@ -621,7 +865,7 @@ private:
         if (forMidi)
         {
             for (int i = 1; i < midiNodeIds.size(); ++i)
-                if (midiNodeIds.getUnchecked(i) == freeNodeID)
+                if (midiNodeIds.getUnchecked(i) == freeNodeID && canReuseBuffer (i, true))
                     return i;
 
             midiNodeIds.add ((uint32) freeNodeID);
@@ -630,7 +874,7 @@ private:
         else
         {
             for (int i = 1; i < nodeIds.size(); ++i)
-                if (nodeIds.getUnchecked(i) == freeNodeID)
+                if (nodeIds.getUnchecked(i) == freeNodeID && canReuseBuffer (i, false))
                     return i;
 
             nodeIds.add ((uint32) freeNodeID);
@@ -639,6 +883,28 @@ private:
         }
     }
 
+    // when rendering in parallel a buffer is only reused by a node that depends on every node
+    // that used it before, otherwise nodes which could run concurrently would end up waiting on each other
+    bool canReuseBuffer (const int bufferNum, const bool forMidi) const noexcept
+    {
+        if (parallelLookupTable == nullptr)
+            return true;
+
+        // the node being rendered is the one after those already done
+        const uint32 nodeId = orderedNodes.getUnchecked (nodeUsages.size())->nodeId;
+
+        for (int i = 0; i < nodeUsages.size(); ++i)
+        {
+            const BufferUsage& usage = *nodeUsages.getUnchecked(i);
+
+            if ((forMidi ? usage.usesMidi (bufferNum) : usage.usesAudio (bufferNum))
+                 && ! parallelLookupTable->isAnInputTo (orderedNodes.getUnchecked(i)->nodeId, nodeId))
+                return false;
+        }
+
+        return true;
+    }
+
     int getReadOnlyEmptyBuffer() const noexcept
     {
         return 0;
@@ -741,214 +1007,294 @@ private:
 };
 
 //==============================================================================
-// Holds a fast lookup table for checking which nodes are inputs to others.
-class ConnectionLookupTable
+struct ConnectionSorter
 {
-public:
-    explicit ConnectionLookupTable (const OwnedArray<AudioProcessorGraph::Connection>& connections)
+    static int compareElements (const AudioProcessorGraph::Connection* const first,
+                                const AudioProcessorGraph::Connection* const second) noexcept
     {
-        for (int i = 0; i < connections.size(); ++i)
-        {
-            const AudioProcessorGraph::Connection* const c = connections.getUnchecked(i);
+        if (first->sourceNodeId < second->sourceNodeId)                return -1;
+        if (first->sourceNodeId > second->sourceNodeId)                return 1;
+        if (first->destNodeId < second->destNodeId)                    return -1;
+        if (first->destNodeId > second->destNodeId)                    return 1;
+        if (first->sourceChannelIndex < second->sourceChannelIndex)    return -1;
+        if (first->sourceChannelIndex > second->sourceChannelIndex)    return 1;
+        if (first->destChannelIndex < second->destChannelIndex)        return -1;
+        if (first->destChannelIndex > second->destChannelIndex)        return 1;
 
-            int index;
-            Entry* entry = findEntry (c->destNodeId, index);
+        return 0;
+    }
+};
 
-            if (entry == nullptr)
-            {
-                entry = new Entry (c->destNodeId);
-                entries.insert (index, entry);
-            }
+}
 
-            entry->srcNodes.add (c->sourceNodeId);
-        }
-    }
+//==============================================================================
+AudioProcessorGraph::Connection::Connection (const uint32 sourceID, const int sourceChannel,
+                                             const uint32 destID, const int destChannel) noexcept
+    : sourceNodeId (sourceID), sourceChannelIndex (sourceChannel),
+      destNodeId (destID), destChannelIndex (destChannel)
+{
+}
 
-    bool isAnInputTo (const uint32 possibleInputId,
-                      const uint32 possibleDestinationId) const noexcept
+//==============================================================================
+AudioProcessorGraph::Node::Node (const uint32 nodeID, AudioProcessor* const p) noexcept
+    : nodeId (nodeID), processor (p),
+      isIO (dynamic_cast<AudioProcessorGraph::AudioGraphIOProcessor*> (p) != nullptr),
+      isPrepared (false)
+{
+    jassert (processor != nullptr);
+}
+
+void AudioProcessorGraph::Node::prepare (const double newSampleRate, const int newBlockSize,
+                                         AudioProcessorGraph* const graph)
+{
+    if (! isPrepared)
     {
-        return isAnInputToRecursive (possibleInputId, possibleDestinationId, entries.size());
+        isPrepared = true;
+        setParentGraph (graph);
+
+        processor->setRateAndBufferSizeDetails (newSampleRate, newBlockSize);
+        processor->prepareToPlay (newSampleRate, newBlockSize);
     }
+}
 
-private:
-    //==============================================================================
-    struct Entry
+void AudioProcessorGraph::Node::unprepare()
+{
+    if (isPrepared)
     {
-        explicit Entry (const uint32 destNodeId_) noexcept : destNodeId (destNodeId_) {}
+        isPrepared = false;
+        processor->releaseResources();
+    }
+}
 
-        const uint32 destNodeId;
-        SortedSet<uint32> srcNodes;
+void AudioProcessorGraph::Node::setParentGraph (AudioProcessorGraph* const graph) const
+{
+    if (isIO)
+        static_cast<AudioProcessorGraph::AudioGraphIOProcessor*> (processor.get())->setParentGraph (graph);
+}
 
-        CARLA_DECLARE_NON_COPY_CLASS (Entry)
-    };
+//==============================================================================
+struct AudioProcessorGraph::AudioProcessorGraphBufferHelpers
+{
+    AudioProcessorGraphBufferHelpers() noexcept
+        : currentAudioInputBuffer (nullptr) {}
 
-    OwnedArray<Entry> entries;
+    void release() noexcept
+    {
+        currentAudioInputBuffer = nullptr;
+        currentAudioOutputBuffer.setSize (1, 1);
+    }
 
-    bool isAnInputToRecursive (const uint32 possibleInputId,
-                               const uint32 possibleDestinationId,
-                               int recursionCheck) const noexcept
+    void prepareInOutBuffers(int newNumChannels, int newNumSamples) noexcept
     {
-        int index;
+        currentAudioInputBuffer = nullptr;
+        currentAudioOutputBuffer.setSize (newNumChannels, newNumSamples);
+    }
 
-        if (const Entry* const entry = findEntry (possibleDestinationId, index))
+    AudioSampleBuffer* currentAudioInputBuffer;
+    AudioSampleBuffer  currentAudioOutputBuffer;
+};
+
+//==============================================================================
+/** Splits a rendering sequence into one task per node, and runs them concurrently
+    on a job runner while respecting the order in which they touch shared buffers.
+*/
+struct AudioProcessorGraph::RenderingTaskGraph  : public AudioProcessorGraph::JobRunner::Job
+{
+    RenderingTaskGraph (const Array<void*>& ops)
+        : renderingOps (ops),
+          sharedBufferChans (nullptr),
+          sharedMidiBuffers (nullptr),
+          numSamples (0),
+          readIndex (0),
+          writeIndex (0),
+          numTasksDone (0)
+    {
+        OwnedArray<GraphRenderingOps::BufferUsage> usages;
+
+        for (int i = 0; i < renderingOps.size();)
         {
-            const SortedSet<uint32>& srcNodes = entry->srcNodes;
+            Task* const task = new Task (i);
+            GraphRenderingOps::BufferUsage* const usage = new GraphRenderingOps::BufferUsage();
 
-            if (srcNodes.contains (possibleInputId))
-                return true;
+            // each node's ops end with the one processing it
+            for (; i < renderingOps.size(); ++i)
+            {
+                GraphRenderingOps::AudioGraphRenderingOpBase* const op
+                    = (GraphRenderingOps::AudioGraphRenderingOpBase*) renderingOps.getUnchecked(i);
 
-            if (--recursionCheck >= 0)
+                op->addBufferUsage (*usage);
+                ++task->numOps;
+
+                if (op->processesNode())
+                {
+                    ++i;
+                    break;
+                }
+            }
+
+            const int taskIndex = tasks.size();
+
+            for (int j = 0; j < taskIndex; ++j)
             {
-                for (int i = 0; i < srcNodes.size(); ++i)
-                    if (isAnInputToRecursive (possibleInputId, srcNodes.getUnchecked(i), recursionCheck))
-                        return true;
+                if (usage->conflictsWith (*usages.getUnchecked (j)))
+                {
+                    tasks.getUnchecked (j)->dependents.add (taskIndex);
+                    ++task->numDependencies;
+                }
             }
+
+            tasks.add (task);
+            usages.add (usage);
         }
 
-        return false;
+        readyTasks.malloc ((size_t) jmax (1, tasks.size()));
     }
 
-    Entry* findEntry (const uint32 destNodeId, int& insertIndex) const noexcept
+    /** Resets the task states before rendering a new block. */
+    void prepare (AudioSampleBuffer& buffers, const OwnedArray<MidiBuffer>& midiBuffers, const int samples) noexcept
     {
-        Entry* result = nullptr;
+        sharedBufferChans = &buffers;
+        sharedMidiBuffers = &midiBuffers;
+        numSamples = samples;
 
-        int start = 0;
-        int end = entries.size();
+        readIndex = writeIndex = numTasksDone = 0;
 
-        for (;;)
+        for (int i = tasks.size(); --i >= 0;)
+            readyTasks[i] = -1;
+
+        for (int i = 0; i < tasks.size(); ++i)
         {
-            if (start >= end)
-            {
-                break;
-            }
-            else if (destNodeId == entries.getUnchecked (start)->destNodeId)
-            {
-                result = entries.getUnchecked (start);
-                break;
-            }
-            else
+            Task* const task = tasks.getUnchecked (i);
+            task->pendingDependencies = task->numDependencies;
+
+            if (task->numDependencies == 0)
+                pushReadyTask (i);
+        }
+    }
+
+    void run (const bool fromWorker) noexcept override
+    {
+        const int numTasks = tasks.size();
+
+        for (uint idleCount = 0; __sync_fetch_and_add (&numTasksDone, 0) < numTasks;)
+        {
+            const int index = __sync_fetch_and_add (&readIndex, 0);
+
+            if (index < __sync_fetch_and_add (&writeIndex, 0))
             {
-                const int halfway = (start + end) / 2;
+                const int taskIndex = __sync_fetch_and_add (&readyTasks[index], 0);
 
-                if (halfway == start)
+                if (taskIndex >= 0 && __sync_bool_compare_and_swap (&readIndex, index, index + 1))
                 {
-                    if (destNodeId >= entries.getUnchecked (halfway)->destNodeId)
-                        ++start;
-
-                    break;
+                    performTask (taskIndex);
+                    idleCount = 0;
+                    continue;
                 }
-                else if (destNodeId >= entries.getUnchecked (halfway)->destNodeId)
-                    start = halfway;
-                else
-                    end = halfway;
             }
-        }
 
-        insertIndex = start;
-        return result;
+            // don't keep a worker busy while the remaining tasks are waiting on others
+            if (fromWorker && ++idleCount == kMaxWorkerIdleCount)
+                return;
+
+            carla_cpu_relax();
+        }
     }
 
-    CARLA_DECLARE_NON_COPY_CLASS (ConnectionLookupTable)
-};
+private:
+    static const uint kMaxWorkerIdleCount = 2000;
 
-//==============================================================================
-struct ConnectionSorter
-{
-    static int compareElements (const AudioProcessorGraph::Connection* const first,
-                                const AudioProcessorGraph::Connection* const second) noexcept
+    struct Task
     {
-        if (first->sourceNodeId < second->sourceNodeId)                return -1;
-        if (first->sourceNodeId > second->sourceNodeId)                return 1;
-        if (first->destNodeId < second->destNodeId)                    return -1;
-        if (first->destNodeId > second->destNodeId)                    return 1;
-        if (first->sourceChannelIndex < second->sourceChannelIndex)    return -1;
-        if (first->sourceChannelIndex > second->sourceChannelIndex)    return 1;
-        if (first->destChannelIndex < second->destChannelIndex)        return -1;
-        if (first->destChannelIndex > second->destChannelIndex)        return 1;
+        Task (const int first) noexcept
+            : firstOp (first), numOps (0), numDependencies (0), pendingDependencies (0) {}
 
-        return 0;
-    }
-};
+        const int firstOp;
+        int numOps;
+        Array<int> dependents;
+        int numDependencies;
+        int pendingDependencies;
 
-}
+        CARLA_DECLARE_NON_COPY_CLASS (Task)
+    };
 
-//==============================================================================
-AudioProcessorGraph::Connection::Connection (const uint32 sourceID, const int sourceChannel,
-                                             const uint32 destID, const int destChannel) noexcept
-    : sourceNodeId (sourceID), sourceChannelIndex (sourceChannel),
-      destNodeId (destID), destChannelIndex (destChannel)
-{
-}
+    const Array<void*> renderingOps;
+    OwnedArray<Task> tasks;
+    HeapBlock<int> readyTasks;
 
-//==============================================================================
-AudioProcessorGraph::Node::Node (const uint32 nodeID, AudioProcessor* const p) noexcept
-    : nodeId (nodeID), processor (p), isPrepared (false)
-{
-    jassert (processor != nullptr);
-}
+    AudioSampleBuffer* sharedBufferChans;
+    const OwnedArray<MidiBuffer>* sharedMidiBuffers;
+    int numSamples;
 
-void AudioProcessorGraph::Node::prepare (const double newSampleRate, const int newBlockSize,
-                                         AudioProcessorGraph* const graph)
-{
-    if (! isPrepared)
-    {
-        isPrepared = true;
-        setParentGraph (graph);
+    int readIndex, writeIndex, numTasksDone;
 
-        processor->setRateAndBufferSizeDetails (newSampleRate, newBlockSize);
-        processor->prepareToPlay (newSampleRate, newBlockSize);
+    void pushReadyTask (const int taskIndex) noexcept
+    {
+        const int index = __sync_fetch_and_add (&writeIndex, 1);
+        __sync_bool_compare_and_swap (&readyTasks[index], -1, taskIndex);
     }
-}
 
-void AudioProcessorGraph::Node::unprepare()
-{
-    if (isPrepared)
+    void performTask (const int taskIndex) noexcept
     {
-        isPrepared = false;
-        processor->releaseResources();
+        const Task* const task = tasks.getUnchecked (taskIndex);
+
+        for (int i = task->firstOp, end = task->firstOp + task->numOps; i < end; ++i)
+        {
+            GraphRenderingOps::AudioGraphRenderingOpBase* const op
+                = (GraphRenderingOps::AudioGraphRenderingOpBase*) renderingOps.getUnchecked(i);
+
+            op->perform (*sharedBufferChans, *sharedMidiBuffers, numSamples);
+        }
+
+        for (int i = 0; i < task->dependents.size(); ++i)
+        {
+            const int dependent = task->dependents.getUnchecked (i);
+
+            if (__sync_sub_and_fetch (&tasks.getUnchecked (dependent)->pendingDependencies, 1) == 0)
+                pushReadyTask (dependent);
+        }
+
+        __sync_add_and_fetch (&numTasksDone, 1);
     }
-}
 
-void AudioProcessorGraph::Node::setParentGraph (AudioProcessorGraph* const graph) const
-{
-    if (AudioProcessorGraph::AudioGraphIOProcessor* const ioProc
-            = dynamic_cast<AudioProcessorGraph::AudioGraphIOProcessor*> (processor.get()))
-        ioProc->setParentGraph (graph);
-}
+    CARLA_DECLARE_NON_COPY_CLASS (RenderingTaskGraph)
+};
 
 //==============================================================================
-struct AudioProcessorGraph::AudioProcessorGraphBufferHelpers
+static void deleteRenderOpArray (Array<void*>& ops)
 {
-    AudioProcessorGraphBufferHelpers() noexcept
-        : currentAudioInputBuffer (nullptr) {}
+    for (int i = ops.size(); --i >= 0;)
+        delete static_cast<GraphRenderingOps::AudioGraphRenderingOpBase*> (ops.getUnchecked(i));
+}
 
-    void setRenderingBufferSize (int newNumChannels, int newNumSamples) noexcept
-    {
-        renderingBuffers.setSize (newNumChannels, newNumSamples);
-        renderingBuffers.clear();
-    }
+/** A complete rendering sequence along with the buffers it renders into.
+    These are built outside of the audio thread and handed over to it as a whole.
+*/
+struct AudioProcessorGraph::RenderingSequence
+{
+    RenderingSequence() noexcept {}
 
-    void release() noexcept
+    ~RenderingSequence()
     {
-        renderingBuffers.setSize (1, 1);
-        currentAudioInputBuffer = nullptr;
-        currentAudioOutputBuffer.setSize (1, 1);
+        tasks = nullptr;
+        deleteRenderOpArray (ops);
     }
 
-    void prepareInOutBuffers(int newNumChannels, int newNumSamples) noexcept
-    {
-        currentAudioInputBuffer = nullptr;
-        currentAudioOutputBuffer.setSize (newNumChannels, newNumSamples);
-    }
+    Array<void*> ops;
+    ScopedPointer<RenderingTaskGraph> tasks;
+    AudioSampleBuffer renderingBuffers;
+    OwnedArray<MidiBuffer> midiBuffers;
 
-    AudioSampleBuffer  renderingBuffers;
-    AudioSampleBuffer* currentAudioInputBuffer;
-    AudioSampleBuffer  currentAudioOutputBuffer;
+    CARLA_DECLARE_NON_COPY_CLASS (RenderingSequence)
 };
 
+// size reserved for each midi buffer, so the audio thread doesn't need to allocate after a rebuild
+static const size_t kMidiBufferReservedSize = 4096;
+
 //==============================================================================
 AudioProcessorGraph::AudioProcessorGraph()
     : lastNodeId (0), audioBuffers (new AudioProcessorGraphBufferHelpers),
+      currentSequence (nullptr), pendingSequence (nullptr), retiredSequence (nullptr),
+      jobRunner (nullptr), reorderCallback (nullptr), reorderCallbackPtr (nullptr),
       currentMidiInputBuffer (nullptr), isPrepared (false), needsReorder (false)
 {
 }
@@ -967,9 +1313,12 @@ const String AudioProcessorGraph::getName() const
 //==============================================================================
 void AudioProcessorGraph::clear()
 {
+    const CarlaRecursiveMutexLocker cml (reorderMutex);
+
     nodes.clear();
     connections.clear();
     needsReorder = true;
+    triggerReorder();
 }
 
 AudioProcessorGraph::Node* AudioProcessorGraph::getNodeForId (const uint32 nodeId) const
@@ -985,6 +1334,8 @@ AudioProcessorGraph::Node* AudioProcessorGraph::addNode (AudioProcessor* const n
 {
     CARLA_SAFE_ASSERT_RETURN (newProcessor != nullptr && newProcessor != this, nullptr);
 
+    const CarlaRecursiveMutexLocker cml (reorderMutex);
+
     for (int i = nodes.size(); --i >= 0;)
     {
         CARLA_SAFE_ASSERT_RETURN(nodes.getUnchecked(i)->getProcessor() != newProcessor, nullptr);
@@ -1007,15 +1358,16 @@ AudioProcessorGraph::Node* AudioProcessorGraph::addNode (AudioProcessor* const n
     Node* const n = new Node (nodeId, newProcessor);
     nodes.add (n);
 
-    if (isPrepared)
-        needsReorder = true;
-
     n->setParentGraph (this);
+    triggerReorder();
+
     return n;
 }
 
 bool AudioProcessorGraph::removeNode (const uint32 nodeId)
 {
+    const CarlaRecursiveMutexLocker cml (reorderMutex);
+
     disconnectNode (nodeId);
 
     for (int i = nodes.size(); --i >= 0;)
@@ -1023,10 +1375,7 @@ bool AudioProcessorGraph::removeNode (const uint32 nodeId)
         if (nodes.getUnchecked(i)->nodeId == nodeId)
         {
             nodes.remove (i);
-
-            if (isPrepared)
-                needsReorder = true;
-
+            triggerReorder();
             return true;
         }
     }
@@ -1103,6 +1452,8 @@ bool AudioProcessorGraph::addConnection (const uint32 sourceNodeId,
                                          const uint32 destNodeId,
                                          const int destChannelIndex)
 {
+    const CarlaRecursiveMutexLocker cml (reorderMutex);
+
     if (! canConnect (sourceNodeId, sourceChannelIndex, destNodeId, destChannelIndex))
         return false;
 
@@ -1110,23 +1461,23 @@ bool AudioProcessorGraph::addConnection (const uint32 sourceNodeId,
     connections.addSorted (sorter, new Connection (sourceNodeId, sourceChannelIndex,
                                                    destNodeId, destChannelIndex));
 
-    if (isPrepared)
-        needsReorder = true;
-
+    triggerReorder();
     return true;
 }
 
 void AudioProcessorGraph::removeConnection (const int index)
 {
-    connections.remove (index);
+    const CarlaRecursiveMutexLocker cml (reorderMutex);
 
-    if (isPrepared)
-        needsReorder = true;
+    connections.remove (index);
+    triggerReorder();
 }
 
 bool AudioProcessorGraph::removeConnection (const uint32 sourceNodeId, const int sourceChannelIndex,
                                             const uint32 destNodeId, const int destChannelIndex)
 {
+    const CarlaRecursiveMutexLocker cml (reorderMutex);
+
     bool doneAnything = false;
 
     for (int i = connections.size(); --i >= 0;)
@@ -1148,6 +1499,8 @@ bool AudioProcessorGraph::removeConnection (const uint32 sourceNodeId, const int
 
 bool AudioProcessorGraph::disconnectNode (const uint32 nodeId)
 {
+    const CarlaRecursiveMutexLocker cml (reorderMutex);
+
     bool doneAnything = false;
 
     for (int i = connections.size(); --i >= 0;)
@@ -1181,6 +1534,8 @@ bool AudioProcessorGraph::isConnectionLegal (const Connection* const c) const
 
 bool AudioProcessorGraph::removeIllegalConnections()
 {
+    const CarlaRecursiveMutexLocker cml (reorderMutex);
+
     bool doneAnything = false;
 
     for (int i = connections.size(); --i >= 0;)
@@ -1196,22 +1551,26 @@ bool AudioProcessorGraph::removeIllegalConnections()
 }
 
 //==============================================================================
-static void deleteRenderOpArray (Array<void*>& ops)
-{
-    for (int i = ops.size(); --i >= 0;)
-        delete static_cast<GraphRenderingOps::AudioGraphRenderingOpBase*> (ops.getUnchecked(i));
-}
-
 void AudioProcessorGraph::clearRenderingSequence()
 {
-    Array<void*> oldOps;
+    RenderingSequence* oldSequence;
 
     {
         const CarlaRecursiveMutexLocker cml (getCallbackLock());
-        renderingOps.swapWith (oldOps);
+        oldSequence = currentSequence;
+        currentSequence = nullptr;
     }
 
-    deleteRenderOpArray (oldOps);
+    delete oldSequence;
+    delete __sync_lock_test_and_set (&pendingSequence, (RenderingSequence*) nullptr);
+    delete __sync_lock_test_and_set (&retiredSequence, (RenderingSequence*) nullptr);
+}
+
+bool AudioProcessorGraph::releaseOldRenderingSequence()
+{
+    delete __sync_lock_test_and_set (&retiredSequence, (RenderingSequence*) nullptr);
+
+    return __sync_fetch_and_add (&pendingSequence, 0) == nullptr;
 }
 
 bool AudioProcessorGraph::isAnInputTo (const uint32 possibleInputId,
@@ -1234,58 +1593,294 @@ bool AudioProcessorGraph::isAnInputTo (const uint32 possibleInputId,
     return false;
 }
 
-void AudioProcessorGraph::buildRenderingSequence()
+//==============================================================================
+// Keeps the processing order of the nodes across rebuilds, so that a change only moves the nodes it affects.
+// The previous order is kept as-is and new nodes go at the end. Connections that go forwards in it need nothing,
+// for each one going backwards only the nodes between its two ends which depend on either of them are moved
+// (the Pearce-Kelly dynamic topological sort). Connections that close a feedback loop can't be sorted, so those
+// are left alone.
+class NodeOrderUpdater
 {
-    Array<void*> newRenderingOps;
-    int numRenderingBuffersNeeded = 2;
-    int numMidiBuffersNeeded = 1;
+public:
+    NodeOrderUpdater (const ReferenceCountedArray<AudioProcessorGraph::Node>& nodes,
+                      const OwnedArray<AudioProcessorGraph::Connection>& connections,
+                      const Array<uint32>& previousOrder)
+    {
+        const int numNodes = nodes.size();
+
+        // entries are indexed by the position of their node id in a sorted list, found by binary search
+        ids.ensureStorageAllocated (numNodes);
+
+        for (int i = 0; i < numNodes; ++i)
+            ids.add (nodes.getUnchecked(i)->nodeId);
+
+        ids.sort();
+
+        entryNodes.insertMultiple (0, nullptr, numNodes);
+        positions.insertMultiple (0, -1, numNodes);
+        visited.insertMultiple (0, false, numNodes);
+        order.ensureStorageAllocated (numNodes);
+
+        for (int i = 0; i < numNodes; ++i)
+        {
+            AudioProcessorGraph::Node* const node = nodes.getUnchecked(i);
+            entryNodes.set (indexOfNode (node->nodeId), node);
+            links.add (new Links());
+        }
+
+        for (int i = 0; i < previousOrder.size(); ++i)
+        {
+            const int entry = indexOfNode (previousOrder.getUnchecked(i));
 
+            if (entry >= 0 && positions.getUnchecked (entry) < 0)
+                append (entry);
+        }
+
+        for (int i = 0; i < numNodes; ++i)
+        {
+            const int entry = indexOfNode (nodes.getUnchecked(i)->nodeId);
+
+            if (positions.getUnchecked (entry) < 0)
+                append (entry);
+        }
+
+        // the order is valid for all forward connections, so those are added first
+        Array<int> backwardSources, backwardDests;
+
+        for (int i = 0; i < connections.size(); ++i)
+        {
+            const AudioProcessorGraph::Connection* const c = connections.getUnchecked(i);
+
+            const int source = indexOfNode (c->sourceNodeId);
+            const int dest   = indexOfNode (c->destNodeId);
+
+            if (source < 0 || dest < 0 || source == dest)
+                continue;
+
+            if (positions.getUnchecked (source) < positions.getUnchecked (dest))
+            {
+                addLink (source, dest);
+            }
+            else
+            {
+                backwardSources.add (source);
+                backwardDests.add (dest);
+            }
+        }
+
+        for (int i = 0; i < backwardSources.size(); ++i)
+        {
+            const int source = backwardSources.getUnchecked(i);
+            const int dest   = backwardDests.getUnchecked(i);
+
+            if (moveSourceBeforeDest (source, dest))
+                addLink (source, dest);
+        }
+    }
+
+    void getOrderedNodes (Array<AudioProcessorGraph::Node*>& orderedNodes) const
     {
-        const CarlaRecursiveMutexLocker cml (reorderMutex);
+        orderedNodes.ensureStorageAllocated (order.size());
 
-        Array<Node*> orderedNodes;
+        for (int i = 0; i < order.size(); ++i)
+            orderedNodes.add (entryNodes.getUnchecked (order.getUnchecked(i)));
+    }
+
+private:
+    struct Links
+    {
+        Array<int> inputs, outputs;
+    };
+
+    struct PositionComparator
+    {
+        explicit PositionComparator (const Array<int>& p) noexcept : positions (p) {}
+
+        int compareElements (const int first, const int second) const noexcept
+        {
+            return positions.getUnchecked (first) - positions.getUnchecked (second);
+        }
+
+        const Array<int>& positions;
+
+        CARLA_DECLARE_NON_COPY_CLASS (PositionComparator)
+    };
+
+    Array<uint32> ids;
+    Array<AudioProcessorGraph::Node*> entryNodes;
+    Array<int> positions; // entry -> position in order
+    Array<int> order;     // position -> entry
+    Array<bool> visited;
+    OwnedArray<Links> links;
+
+    int indexOfNode (const uint32 nodeId) const
+    {
+        DefaultElementComparator<uint32> comparator;
+        return ids.indexOfSorted (comparator, nodeId);
+    }
+
+    void append (const int entry)
+    {
+        positions.set (entry, order.size());
+        order.add (entry);
+    }
+
+    void addLink (const int source, const int dest)
+    {
+        // several channels can connect the same two nodes
+        if (links.getUnchecked (source)->outputs.addIfNotAlreadyThere (dest))
+            links.getUnchecked (dest)->inputs.add (source);
+    }
+
+    // returns false if 'dest' already feeds 'source', which makes a feedback loop
+    bool moveSourceBeforeDest (const int source, const int dest)
+    {
+        const int lowerBound = positions.getUnchecked (dest);
+        const int upperBound = positions.getUnchecked (source);
+
+        // an earlier move may have fixed this one already
+        if (upperBound < lowerBound)
+            return true;
+
+        // nodes fed by 'dest' and feeding 'source', only those placed between the two need to move
+        Array<int> fedByDest, feedingSource;
+
+        const bool isLoop = ! collect (dest, upperBound, true, source, fedByDest);
+
+        if (! isLoop)
+            collect (source, lowerBound, false, -1, feedingSource);
+
+        for (int i = 0; i < fedByDest.size(); ++i)
+            visited.set (fedByDest.getUnchecked(i), false);
+        for (int i = 0; i < feedingSource.size(); ++i)
+            visited.set (feedingSource.getUnchecked(i), false);
+
+        if (isLoop)
+            return false;
+
+        PositionComparator comparator (positions);
+        fedByDest.sort (comparator);
+        feedingSource.sort (comparator);
+
+        // the moved nodes take the same positions as before, those feeding 'source' first
+        Array<int> freePositions;
+        freePositions.ensureStorageAllocated (fedByDest.size() + feedingSource.size());
+
+        for (int i = 0; i < feedingSource.size(); ++i)
+            freePositions.add (positions.getUnchecked (feedingSource.getUnchecked(i)));
+        for (int i = 0; i < fedByDest.size(); ++i)
+            freePositions.add (positions.getUnchecked (fedByDest.getUnchecked(i)));
+
+        freePositions.sort();
+
+        int next = 0;
+
+        for (int i = 0; i < feedingSource.size(); ++i)
+            place (feedingSource.getUnchecked(i), freePositions.getUnchecked (next++));
+        for (int i = 0; i < fedByDest.size(); ++i)
+            place (fedByDest.getUnchecked(i), freePositions.getUnchecked (next++));
 
+        return true;
+    }
+
+    // gathers the nodes reachable from 'start' which are placed before 'bound' (or after it, when going backwards).
+    // returns false if 'target' is reached.
+    bool collect (const int start, const int bound, const bool forwards, const int target, Array<int>& found)
+    {
+        Array<int> pending;
+        pending.add (start);
+        found.add (start);
+        visited.set (start, true);
+
+        while (pending.size() > 0)
         {
-            const GraphRenderingOps::ConnectionLookupTable table (connections);
+            const Links& entryLinks (*links.getUnchecked (pending.removeAndReturn (pending.size() - 1)));
+            const Array<int>& nextEntries (forwards ? entryLinks.outputs : entryLinks.inputs);
 
-            for (int i = 0; i < nodes.size(); ++i)
+            for (int i = 0; i < nextEntries.size(); ++i)
             {
-                Node* const node = nodes.getUnchecked(i);
+                const int entry = nextEntries.getUnchecked(i);
+
+                if (entry == target)
+                    return false;
+
+                if (visited.getUnchecked (entry))
+                    continue;
 
-                node->prepare (getSampleRate(), getBlockSize(), this);
+                const int position = positions.getUnchecked (entry);
 
-                int j = 0;
-                for (; j < orderedNodes.size(); ++j)
-                    if (table.isAnInputTo (node->nodeId, ((Node*) orderedNodes.getUnchecked(j))->nodeId))
-                      break;
+                if (forwards ? position > bound : position < bound)
+                    continue;
 
-                orderedNodes.insert (j, node);
+                visited.set (entry, true);
+                found.add (entry);
+                pending.add (entry);
             }
         }
 
-        GraphRenderingOps::RenderingOpSequenceCalculator calculator (*this, orderedNodes, newRenderingOps);
+        return true;
+    }
 
-        numRenderingBuffersNeeded = calculator.getNumBuffersNeeded();
-        numMidiBuffersNeeded = calculator.getNumMidiBuffersNeeded();
+    void place (const int entry, const int position)
+    {
+        positions.set (entry, position);
+        order.set (position, entry);
     }
 
+    CARLA_DECLARE_NON_COPY_CLASS (NodeOrderUpdater)
+};
+
+void AudioProcessorGraph::updateNodeOrder (Array<Node*>& orderedNodes)
+{
+    const NodeOrderUpdater updater (nodes, connections, orderedNodeIds);
+    updater.getOrderedNodes (orderedNodes);
+
+    orderedNodeIds.clearQuick();
+    orderedNodeIds.ensureStorageAllocated (orderedNodes.size());
+
+    for (int i = 0; i < orderedNodes.size(); ++i)
+        orderedNodeIds.add (orderedNodes.getUnchecked (i)->nodeId);
+}
+
+void AudioProcessorGraph::buildRenderingSequence()
+{
+    ScopedPointer<RenderingSequence> newSequence (new RenderingSequence());
+
     {
-        // swap over to the new rendering sequence..
-        const CarlaRecursiveMutexLocker cml (getCallbackLock());
+        const CarlaRecursiveMutexLocker cml (reorderMutex);
 
-        audioBuffers->setRenderingBufferSize (numRenderingBuffersNeeded, getBlockSize());
+        Array<Node*> orderedNodes;
+        updateNodeOrder (orderedNodes);
 
-        for (int i = midiBuffers.size(); --i >= 0;)
-            midiBuffers.getUnchecked(i)->clear();
+        for (int i = 0; i < orderedNodes.size(); ++i)
+            orderedNodes.getUnchecked (i)->prepare (getSampleRate(), getBlockSize(), this);
 
-        while (midiBuffers.size() < numMidiBuffersNeeded)
-            midiBuffers.add (new MidiBuffer());
+        // only the node order is updated incrementally, the ops are still rebuilt for the whole graph.
+        // buffers are assigned across the whole sequence, so a change anywhere can move buffers everywhere
+        const GraphRenderingOps::ConnectionLookupTable table (connections);
 
-        renderingOps.swapWith (newRenderingOps);
+        GraphRenderingOps::RenderingOpSequenceCalculator calculator (*this, orderedNodes, newSequence->ops,
+                                                                     jobRunner != nullptr ? &table : nullptr);
+
+        newSequence->renderingBuffers.setSize (calculator.getNumBuffersNeeded(), getBlockSize());
+        newSequence->renderingBuffers.clear();
+
+        for (int i = calculator.getNumMidiBuffersNeeded(); --i >= 0;)
+        {
+            MidiBuffer* const midiBuffer = new MidiBuffer();
+            midiBuffer->ensureSize (kMidiBufferReservedSize);
+            newSequence->midiBuffers.add (midiBuffer);
+        }
+
+        if (jobRunner != nullptr)
+            newSequence->tasks = new RenderingTaskGraph (newSequence->ops);
+
+        // hand it over to the audio thread, replacing any sequence it did not pick up yet.
+        // this is done while still locked, so a sequence built from older settings can't replace a newer one
+        delete __sync_lock_test_and_set (&pendingSequence, newSequence.release());
     }
 
-    // delete the old ones..
-    deleteRenderOpArray (newRenderingOps);
+    releaseOldRenderingSequence();
 }
 
 //==============================================================================
@@ -1310,7 +1905,7 @@ void AudioProcessorGraph::releaseResources()
         nodes.getUnchecked(i)->unprepare();
 
     audioBuffers->release();
-    midiBuffers.clear();
+    clearRenderingSequence();
 
     currentMidiInputBuffer = nullptr;
     currentMidiOutputBuffer.clear();
@@ -1336,7 +1931,6 @@ void AudioProcessorGraph::setNonRealtime (bool isProcessingNonRealtime) noexcept
 
 void AudioProcessorGraph::processAudio (AudioSampleBuffer& buffer, MidiBuffer& midiMessages)
 {
-    AudioSampleBuffer&  renderingBuffers         = audioBuffers->renderingBuffers;
     AudioSampleBuffer*& currentAudioInputBuffer  = audioBuffers->currentAudioInputBuffer;
     AudioSampleBuffer&  currentAudioOutputBuffer = audioBuffers->currentAudioOutputBuffer;
 
@@ -1348,12 +1942,42 @@ void AudioProcessorGraph::processAudio (AudioSampleBuffer& buffer, MidiBuffer& m
     currentMidiInputBuffer = &midiMessages;
     currentMidiOutputBuffer.clear();
 
-    for (int i = 0; i < renderingOps.size(); ++i)
+    // pick up a newly built sequence, unless the previous one has not been released yet
+    if (pendingSequence != nullptr && retiredSequence == nullptr)
+    {
+        if (RenderingSequence* const newSequence = __sync_lock_test_and_set (&pendingSequence, (RenderingSequence*) nullptr))
+        {
+            CARLA_SAFE_ASSERT (__sync_bool_compare_and_swap (&retiredSequence, (RenderingSequence*) nullptr, currentSequence));
+            currentSequence = newSequence;
+
+            if (reorderCallback != nullptr)
+                reorderCallback (reorderCallbackPtr);
+        }
+    }
+
+    if (RenderingSequence* const sequence = currentSequence)
     {
-        GraphRenderingOps::AudioGraphRenderingOpBase* const op
-            = (GraphRenderingOps::AudioGraphRenderingOpBase*) renderingOps.getUnchecked(i);
+        AudioSampleBuffer& renderingBuffers = sequence->renderingBuffers;
+
+        if (sequence->tasks != nullptr)
+        {
+            // mark the buffers as used now, tasks must not race to change that flag later
+            renderingBuffers.getArrayOfWritePointers();
+            currentAudioOutputBuffer.getArrayOfWritePointers();
 
-        op->perform (renderingBuffers, midiBuffers, numSamples);
+            sequence->tasks->prepare (renderingBuffers, sequence->midiBuffers, numSamples);
+            jobRunner->runJob (*sequence->tasks);
+        }
+        else
+        {
+            for (int i = 0; i < sequence->ops.size(); ++i)
+            {
+                GraphRenderingOps::AudioGraphRenderingOpBase* const op
+                    = (GraphRenderingOps::AudioGraphRenderingOpBase*) sequence->ops.getUnchecked(i);
+
+                op->perform (renderingBuffers, sequence->midiBuffers, numSamples);
+            }
+        }
     }
 
     for (int i = 0; i < buffer.getNumChannels(); ++i)
@@ -1373,11 +1997,45 @@ void AudioProcessorGraph::processBlock (AudioSampleBuffer& buffer, MidiBuffer& m
 
 void AudioProcessorGraph::reorderNowIfNeeded()
 {
-    if (needsReorder)
+    releaseOldRenderingSequence();
+
     {
+        const CarlaRecursiveMutexLocker cml (reorderMutex);
+
+        if (! needsReorder)
+            return;
+
         needsReorder = false;
-        buildRenderingSequence();
     }
+
+    buildRenderingSequence();
+}
+
+void AudioProcessorGraph::setReorderCallback (ReorderCallback callback, void* const ptr)
+{
+    const CarlaRecursiveMutexLocker cml (reorderMutex);
+
+    reorderCallback    = callback;
+    reorderCallbackPtr = ptr;
+}
+
+void AudioProcessorGraph::triggerReorder()
+{
+    if (! isPrepared)
+        return;
+
+    needsReorder = true;
+
+    if (reorderCallback != nullptr)
+        reorderCallback (reorderCallbackPtr);
+}
+
+void AudioProcessorGraph::setJobRunner (JobRunner* const runner)
+{
+    // the audio thread reads it without locking
+    CARLA_SAFE_ASSERT_RETURN (! isPrepared,);
+
+    jobRunner = runner;
 }
 
 //==============================================================================
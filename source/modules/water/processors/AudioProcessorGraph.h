@@ -72,6 +72,9 @@ public:
         /** The actual processor object that this node represents. */
         AudioProcessor* getProcessor() const noexcept           { return processor; }
 
+        /** True if the processor is an AudioGraphIOProcessor, which can then be safely static_cast to. */
+        bool isIOProcessor() const noexcept                     { return isIO; }
+
         /** A set of user-definable properties that are associated with this node.
 
             This can be used to attach values to the node for whatever purpose seems
@@ -89,6 +92,7 @@ public:
         friend class AudioProcessorGraph;
 
         const ScopedPointer<AudioProcessor> processor;
+        const bool isIO;
         bool isPrepared;
 
         Node (uint32 nodeId, AudioProcessor*) noexcept;
@@ -344,8 +348,59 @@ public:
     bool acceptsMidi() const override;
     bool producesMidi() const override;
 
+    /** Rebuilds the rendering sequence if the graph has changed since the last time.
+
+        The new sequence is handed over to the audio thread without locking,
+        it will start using it on its next block.
+    */
     void reorderNowIfNeeded();
 
+    /** Deletes the rendering sequence that the audio thread has stopped using, if any.
+        Returns false while a newly built sequence is still waiting to be picked up.
+    */
+    bool releaseOldRenderingSequence();
+
+    /** A function called whenever the graph changes in a way that needs a new rendering sequence.
+        It is called from the thread making the change, which can then trigger reorderNowIfNeeded()
+        without having to poll for it.
+
+        It is also called from the audio thread right after it picks up a new rendering sequence,
+        so that releaseOldRenderingSequence() can run without polling either. It must be realtime safe.
+    */
+    typedef void (*ReorderCallback) (void* ptr);
+
+    /** Sets the function to call when the rendering sequence needs to be rebuilt. */
+    void setReorderCallback (ReorderCallback callback, void* ptr);
+
+    /** Something that can run a job on the calling thread and on other threads at the same time,
+        typically a pool of worker threads.
+    */
+    class JobRunner
+    {
+    public:
+        /** A job to be run, it must split the work between its concurrent callers by itself. */
+        struct Job
+        {
+            virtual ~Job() {}
+            virtual void run (bool fromWorker) noexcept = 0;
+        };
+
+        virtual ~JobRunner() {}
+
+        /** Runs the job on the calling thread and on any helper threads.
+            Must only return once the job is fully processed, and be realtime safe.
+        */
+        virtual void runJob (Job& job) noexcept = 0;
+    };
+
+    /** Lets the graph render independent nodes concurrently using a job runner.
+
+        The rendering sequence is split into tasks, one per node, which can run as soon as the
+        tasks they depend on are finished. Passing nullptr means serial rendering.
+        This must be set before prepareToPlay(), and the runner must outlive the graph.
+    */
+    void setJobRunner (JobRunner* runner);
+
 private:
     //==============================================================================
     void processAudio (AudioSampleBuffer& buffer, MidiBuffer& midiMessages);
@@ -354,13 +409,22 @@ private:
     ReferenceCountedArray<Node> nodes;
     OwnedArray<Connection> connections;
     uint32 lastNodeId;
-    OwnedArray<MidiBuffer> midiBuffers;
-    Array<void*> renderingOps;
 
     friend class AudioGraphIOProcessor;
     struct AudioProcessorGraphBufferHelpers;
     ScopedPointer<AudioProcessorGraphBufferHelpers> audioBuffers;
 
+    struct RenderingTaskGraph;
+    struct RenderingSequence;
+    RenderingSequence* currentSequence; // only used by the audio thread
+    RenderingSequence* pendingSequence; // built, waiting for the audio thread to pick it up
+    RenderingSequence* retiredSequence; // replaced by the audio thread, waiting to be deleted
+    Array<uint32> orderedNodeIds;
+    JobRunner* jobRunner;
+
+    ReorderCallback reorderCallback;
+    void* reorderCallbackPtr;
+
     MidiBuffer* currentMidiInputBuffer;
     MidiBuffer currentMidiOutputBuffer;
 
@@ -369,6 +433,8 @@ private:
 
     void clearRenderingSequence();
     void buildRenderingSequence();
+    void updateNodeOrder (Array<Node*>& orderedNodes);
+    void triggerReorder();
     bool isAnInputTo (uint32 possibleInputId, uint32 possibleDestinationId, int recursionCheck) const;
 
     CARLA_DECLARE_NON_COPY_CLASS (AudioProcessorGraph)
@@ -202,7 +202,7 @@ static const NativePluginDescriptor sNativePluginDescriptors[] = {
     /* audioOuts */ 0,
     /* midiIns   */ 0,
     /* midiOuts  */ 1,
-    /* paramIns  */ 0,
+    /* paramIns  */ 1,
     /* paramOuts */ 0,
     /* name      */ "MIDI File",
     /* label     */ "midifile",
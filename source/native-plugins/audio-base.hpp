@@ -20,6 +20,15 @@
 
 #include "CarlaThread.hpp"
 #include "CarlaMathUtils.hpp"
+#include "CarlaString.hpp"
+#include "LinkedList.hpp"
+
+#ifndef CARLA_OS_WIN
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
 
 extern "C" {
 #include "audio_decoder/ad.h"
@@ -27,30 +36,33 @@ extern "C" {
 
 typedef struct adinfo ADInfo;
 
-struct AudioFilePool {
+// -----------------------------------------------------------------------
+// Single-producer/single-consumer ring of deinterleaved stereo audio.
+// Slots are addressed by file frame, so frame N lives at (N & mask).
+
+struct AudioFileRing {
     float*   buffer[2];
-    uint32_t startFrame;
     uint32_t size;
+    uint32_t mask;
 
 #ifdef CARLA_PROPER_CPP11_SUPPORT
-    AudioFilePool()
+    AudioFileRing()
         : buffer{nullptr},
-          startFrame(0),
-          size(0) {}
+          size(0),
+          mask(0) {}
 #else
-    AudioFilePool()
-        : startFrame(0),
-          size(0)
+    AudioFileRing()
+        : size(0),
+          mask(0)
     {
         buffer[0] = buffer[1] = nullptr;
     }
 #endif
 
-    ~AudioFilePool()
+    ~AudioFileRing()
     {
         CARLA_ASSERT(buffer[0] == nullptr);
         CARLA_ASSERT(buffer[1] == nullptr);
-        CARLA_ASSERT(startFrame == 0);
         CARLA_ASSERT(size == 0);
     }
 
@@ -58,10 +70,12 @@ struct AudioFilePool {
     {
         CARLA_ASSERT(buffer[0] == nullptr);
         CARLA_ASSERT(buffer[1] == nullptr);
-        CARLA_ASSERT(startFrame == 0);
         CARLA_ASSERT(size == 0);
 
-        size = sampleRate * 2;
+        // at least 2 seconds, rounded up to a power of 2
+        for (size = 1; size < sampleRate * 2; size <<= 1) {}
+
+        mask = size - 1;
 
         buffer[0] = new float[size];
         buffer[1] = new float[size];
@@ -87,13 +101,12 @@ struct AudioFilePool {
             buffer[1] = nullptr;
         }
 
-        startFrame = 0;
         size = 0;
+        mask = 0;
     }
 
     void reset()
     {
-        startFrame = 0;
         CARLA_SAFE_ASSERT_RETURN(size != 0,);
 
         carla_zeroFloats(buffer[0], size);
@@ -101,25 +114,32 @@ struct AudioFilePool {
     }
 };
 
-class AbstractAudioPlayer
-{
-public:
-    virtual ~AbstractAudioPlayer() {}
-    virtual uint32_t getLastFrame() const = 0;
-};
+// -----------------------------------------------------------------------
+// Disk thread, decodes ahead of the playhead into the ring.
+//
+// The audio thread is the only consumer: it copies out the frames it needs and
+// then publishes how far it has read, which frees ring space for the disk thread.
+// A playhead jump outside of the buffered range is sent as a seek request
+// (frame + epoch counter); the ring contents are ignored until the disk thread
+// acknowledges that epoch, so neither side ever needs a lock.
+
+static const uint32_t kAudioFileReadChunkFrames = 4096;
 
 class AudioFileThread : public CarlaThread
 {
 public:
-    AudioFileThread(AbstractAudioPlayer* const player, const double sampleRate)
+    AudioFileThread(const double sampleRate)
         : CarlaThread("AudioFileThread"),
-          kPlayer(player),
-          fNeedsRead(false),
           fQuitNow(true),
-          fFilePtr(nullptr)
+          fFilePtr(nullptr),
+          fTmpData(nullptr),
+          fRequestEpoch(0),
+          fRequestFrame(0),
+          fReadFrame(0),
+          fFillEpoch(0),
+          fFillEnd(0),
+          fWriteFrame(0)
     {
-        CARLA_ASSERT(kPlayer != nullptr);
-
         static bool adInitiated = false;
 
         if (! adInitiated)
@@ -130,7 +150,8 @@ public:
 
         ad_clear_nfo(&fFileNfo);
 
-        fPool.create(sampleRate);
+        fRing.create(static_cast<uint32_t>(sampleRate));
+        fTmpData = new float[kAudioFileReadChunkFrames*2];
     }
 
     ~AudioFileThread() override
@@ -141,35 +162,26 @@ public:
         if (fFilePtr != nullptr)
             ad_close(fFilePtr);
 
-        fPool.destroy();
+        fRing.destroy();
+        delete[] fTmpData;
     }
 
     void startNow()
     {
-        fNeedsRead = true;
         fQuitNow = false;
         startThread();
     }
 
     void stopNow()
     {
-        fNeedsRead = false;
         fQuitNow = true;
 
         stopThread(1000);
-
-        const CarlaMutexLocker cml(fMutex);
-        fPool.reset();
     }
 
     uint32_t getMaxFrame() const
     {
-        return fFileNfo.frames > 0 ? fFileNfo.frames : 0;
-    }
-
-    void setNeedsRead()
-    {
-        fNeedsRead = true;
+        return fFileNfo.frames > 0 ? static_cast<uint32_t>(fFileNfo.frames) : 0;
     }
 
     bool loadFilename(const char* const filename)
@@ -177,8 +189,6 @@ public:
         CARLA_ASSERT(! isThreadRunning());
         CARLA_ASSERT(filename != nullptr);
 
-        fPool.startFrame = 0;
-
         // clear old data
         if (fFilePtr != nullptr)
         {
@@ -187,6 +197,7 @@ public:
         }
 
         ad_clear_nfo(&fFileNfo);
+        resetPositions();
 
         // open new
         fFilePtr = ad_open(filename, &fFileNfo);
@@ -201,8 +212,8 @@ public:
 
         if ((fFileNfo.channels == 1 || fFileNfo.channels == 2) && fFileNfo.frames > 0)
         {
-            // valid
-            readPoll();
+            // valid, fill the ring from the start of the file
+            while (fillRing()) {}
             return true;
         }
         else
@@ -215,174 +226,650 @@ public:
         }
     }
 
-    void tryPutData(AudioFilePool& pool)
+    // -------------------------------------------------------------------
+    // audio thread side
+
+    /*
+     * Copy @a frames starting at file position @a frame into the output buffers.
+     * Frames that are not decoded yet are zeroed. Returns the number of frames copied.
+     */
+    uint32_t tryGetData(float* const out1, float* const out2, const uint32_t frame, const uint32_t frames) noexcept
     {
-        CARLA_ASSERT(pool.size == fPool.size);
+        uint32_t avail = 0;
 
-        if (pool.size != fPool.size)
-            return;
-        if (! fMutex.tryLock())
-            return;
+        if (! isFrameReachable(frame))
+        {
+            requestSeek(frame);
+        }
+        else if (fFillEpoch == fRequestEpoch)
+        {
+            __sync_synchronize();
+            const uint32_t end = fFillEnd;
+            __sync_synchronize();
+
+            if (frame < end)
+            {
+                avail = std::min(end - frame, frames);
+
+                const uint32_t pos   = frame & fRing.mask;
+                const uint32_t first = std::min(avail, fRing.size - pos);
+
+                carla_copyFloats(out1, fRing.buffer[0] + pos, first);
+                carla_copyFloats(out2, fRing.buffer[1] + pos, first);
 
-        //if (pool.startFrame != fPool.startFrame || pool.buffer[0] != fPool.buffer[0] || pool.buffer[1] != fPool.buffer[1])
+                if (avail > first)
+                {
+                    carla_copyFloats(out1 + first, fRing.buffer[0], avail - first);
+                    carla_copyFloats(out2 + first, fRing.buffer[1], avail - first);
+                }
+            }
+
+            // release what we have consumed
+            __sync_synchronize();
+            fReadFrame = frame + avail < end ? frame + avail : end;
+        }
+
+        if (avail < frames)
         {
-            pool.startFrame = fPool.startFrame;
-            carla_copyFloats(pool.buffer[0], fPool.buffer[0], fPool.size);
-            carla_copyFloats(pool.buffer[1], fPool.buffer[1], fPool.size);
+            carla_zeroFloats(out1 + avail, frames - avail);
+            carla_zeroFloats(out2 + avail, frames - avail);
         }
 
-        fMutex.unlock();
+        return avail;
+    }
+
+    /*
+     * Make sure the disk thread is buffering around @a frame, used while the transport is stopped.
+     */
+    void prefetch(const uint32_t frame) noexcept
+    {
+        if (! isFrameReachable(frame))
+            requestSeek(frame);
     }
 
-    void readPoll()
+protected:
+    void run() override
     {
-        if (fFileNfo.frames <= 0 || fFilePtr == nullptr)
+        while (! fQuitNow)
         {
-            carla_stderr("R: no song loaded");
-            fNeedsRead = false;
-            return;
+            if (! fillRing())
+                carla_msleep(10);
         }
+    }
+
+private:
+    volatile bool fQuitNow;
+
+    void*  fFilePtr;
+    ADInfo fFileNfo;
+
+    AudioFileRing fRing;
+    float*        fTmpData;
+
+    // written by the audio thread
+    volatile uint32_t fRequestEpoch;
+    volatile uint32_t fRequestFrame;
+    volatile uint32_t fReadFrame;
+
+    // written by the disk thread
+    volatile uint32_t fFillEpoch;
+    volatile uint32_t fFillEnd;
+    uint32_t          fWriteFrame;
+
+    void resetPositions() noexcept
+    {
+        fRequestEpoch = fFillEpoch = 0;
+        fRequestFrame = fReadFrame = 0;
+        fFillEnd = fWriteFrame = 0;
+        fRing.reset();
+    }
+
+    bool isFrameReachable(const uint32_t frame) const noexcept
+    {
+        // allow the playhead to run ahead of the decoded data by half the ring before giving up on it
+        return frame >= fReadFrame && frame - fReadFrame < fRing.size/2;
+    }
+
+    void requestSeek(const uint32_t frame) noexcept
+    {
+        fRequestFrame = frame;
+        fReadFrame = frame;
+        __sync_synchronize();
+        fRequestEpoch = fRequestEpoch + 1;
+    }
+
+    // decode one chunk ahead of the playhead, returns false if there was nothing to do
+    bool fillRing()
+    {
+        CARLA_SAFE_ASSERT_RETURN(fFilePtr != nullptr, false);
 
-        int64_t lastFrame = kPlayer->getLastFrame();
-        int64_t readFrame = lastFrame;
-        int64_t maxFrame  = fFileNfo.frames;
+        const uint32_t requestEpoch = fRequestEpoch;
 
-        if (lastFrame >= maxFrame)
+        if (requestEpoch != fFillEpoch)
         {
-#if 0
-            if (false)
-            //if (handlePtr->loopMode)
+            __sync_synchronize();
+            fWriteFrame = fRequestFrame;
+
+            carla_debug("R: seek to frame %u", fWriteFrame);
+            ad_seek(fFilePtr, fWriteFrame);
+
+            fFillEnd = fWriteFrame;
+            __sync_synchronize();
+            fFillEpoch = requestEpoch;
+        }
+
+        const uint32_t maxFrame = getMaxFrame();
+
+        if (fWriteFrame >= maxFrame)
+            return false;
+
+        const uint32_t readFrame = fReadFrame;
+        __sync_synchronize();
+
+        // a seek request is in flight, wait for its epoch
+        if (readFrame > fWriteFrame || fWriteFrame - readFrame >= fRing.size)
+            return false;
+
+        const uint32_t space  = fRing.size - (fWriteFrame - readFrame);
+        const uint32_t frames = std::min(std::min(space, kAudioFileReadChunkFrames), maxFrame - fWriteFrame);
+
+        // only read partial chunks at the end of the file
+        if (frames < kAudioFileReadChunkFrames && frames != maxFrame - fWriteFrame)
+            return false;
+
+        const uint channels = fFileNfo.channels;
+        const ssize_t rv = ad_read(fFilePtr, fTmpData, frames*channels);
+        const uint32_t framesRead = rv > 0 ? static_cast<uint32_t>(rv)/channels : 0;
+
+        float* const buf0 = fRing.buffer[0];
+        float* const buf1 = fRing.buffer[1];
+
+        for (uint32_t i=0, pos=fWriteFrame & fRing.mask; i < frames; ++i, pos = (pos+1) & fRing.mask)
+        {
+            if (i >= framesRead)
+            {
+                buf0[pos] = buf1[pos] = 0.0f;
+            }
+            else if (channels == 1)
+            {
+                buf0[pos] = buf1[pos] = fTmpData[i];
+            }
+            else
             {
-                carla_stderr("R: DEBUG read loop, lastFrame:%i, maxFrame:%i", lastFrame, maxFrame);
+                buf0[pos] = fTmpData[i*2];
+                buf1[pos] = fTmpData[i*2+1];
+            }
+        }
 
-                if (maxFrame >= static_cast<int64_t>(fPool.size))
-                {
-                    readFrame %= maxFrame;
-                }
-                else
+        fWriteFrame += frames;
+
+        __sync_synchronize();
+        fFillEnd = fWriteFrame;
+        return true;
+    }
+};
+
+// -----------------------------------------------------------------------
+// Fully loaded audio file, shared between all instances that use the same file.
+// Uncompressed WAV files are mapped into memory, anything else is decoded once.
+// Small WAV files are copied out of the mapping right away. Bigger ones stay mapped, so truncating such a file
+// on disk while it plays raises SIGBUS on the audio thread; files in use must not be modified.
+
+// default limit for keeping a file in memory instead of streaming it, in bytes
+static const uint64_t kAudioFileDefaultCacheLimit = 32*1024*1024;
+
+// WAV files up to this size are copied instead of staying mapped
+static const std::size_t kAudioFileCopyLimit = 8*1024*1024;
+
+struct AudioFileCacheEntry {
+    enum Format {
+        kFormatFloat32,
+        kFormatInt16,
+        kFormatInt24,
+        kFormatInt32
+    };
+
+    CarlaString filename;
+    uint32_t    frames;
+    uint        channels;
+    int         refCount;
+
+    // decoded data, buffer[1] is buffer[0] for mono files
+    float* buffer[2];
+
+    // mapped or copied data, interleaved
+    void*          mapData;
+    std::size_t    mapSize;
+    uint8_t*       copyData;
+    const uint8_t* samples;
+    Format         format;
+
+    AudioFileCacheEntry(const char* const fname) noexcept
+        : filename(fname),
+          frames(0),
+          channels(0),
+          refCount(0),
+          mapData(nullptr),
+          mapSize(0),
+          copyData(nullptr),
+          samples(nullptr),
+          format(kFormatFloat32)
+    {
+        buffer[0] = buffer[1] = nullptr;
+    }
+
+    ~AudioFileCacheEntry() noexcept
+    {
+        CARLA_SAFE_ASSERT(refCount == 0);
+
+        if (buffer[1] != nullptr && buffer[1] != buffer[0])
+            delete[] buffer[1];
+        if (buffer[0] != nullptr)
+            delete[] buffer[0];
+
+        if (copyData != nullptr)
+            delete[] copyData;
+
+#ifndef CARLA_OS_WIN
+        if (mapData != nullptr)
+            ::munmap(mapData, mapSize);
+#endif
+    }
+
+    /*
+     * Copy @a count frames starting at @a frame into the output buffers, zeroing anything past the end of the file.
+     * Real-time safe.
+     */
+    void read(float* const out1, float* const out2, const uint32_t frame, const uint32_t count) const noexcept
+    {
+        const uint32_t avail = frame < frames ? std::min(frames - frame, count) : 0;
+
+        if (avail != 0)
+        {
+            if (samples == nullptr)
+            {
+                carla_copyFloats(out1, buffer[0] + frame, avail);
+                carla_copyFloats(out2, buffer[1] + frame, avail);
+            }
+            else
+            {
+                switch (format)
                 {
-                    readFrame  = 0;
-                    lastFrame -= lastFrame % maxFrame;
+                case kFormatFloat32:
+                    readMapped<kFormatFloat32>(out1, out2, frame, avail);
+                    break;
+                case kFormatInt16:
+                    readMapped<kFormatInt16>(out1, out2, frame, avail);
+                    break;
+                case kFormatInt24:
+                    readMapped<kFormatInt24>(out1, out2, frame, avail);
+                    break;
+                case kFormatInt32:
+                    readMapped<kFormatInt32>(out1, out2, frame, avail);
+                    break;
                 }
             }
-            else
-#endif
+        }
+
+        if (avail < count)
+        {
+            carla_zeroFloats(out1 + avail, count - avail);
+            carla_zeroFloats(out2 + avail, count - avail);
+        }
+    }
+
+private:
+    template<Format F>
+    static float sampleAt(const uint8_t* const ptr) noexcept
+    {
+        switch (F)
+        {
+        case kFormatFloat32: {
+            float value;
+            std::memcpy(&value, ptr, sizeof(float));
+            return value;
+        }
+        case kFormatInt16: {
+            int16_t value;
+            std::memcpy(&value, ptr, sizeof(int16_t));
+            return static_cast<float>(value) / 32768.0f;
+        }
+        case kFormatInt24: {
+            const int32_t value = static_cast<int32_t>(static_cast<uint32_t>(ptr[0]) << 8
+                                                     | static_cast<uint32_t>(ptr[1]) << 16
+                                                     | static_cast<uint32_t>(ptr[2]) << 24) >> 8;
+            return static_cast<float>(value) / 8388608.0f;
+        }
+        case kFormatInt32: {
+            int32_t value;
+            std::memcpy(&value, ptr, sizeof(int32_t));
+            return static_cast<float>(value) / 2147483648.0f;
+        }
+        }
+
+        return 0.0f;
+    }
+
+    template<Format F>
+    void readMapped(float* const out1, float* const out2, const uint32_t frame, const uint32_t count) const noexcept
+    {
+        const std::size_t sampleSize = F == kFormatInt16 ? 2 : F == kFormatInt24 ? 3 : 4;
+        const std::size_t frameSize  = sampleSize * channels;
+        const uint8_t* ptr = samples + frameSize * frame;
+
+        if (channels == 1)
+        {
+            for (uint32_t i=0; i < count; ++i, ptr += frameSize)
+                out1[i] = out2[i] = sampleAt<F>(ptr);
+        }
+        else
+        {
+            for (uint32_t i=0; i < count; ++i, ptr += frameSize)
+            {
+                out1[i] = sampleAt<F>(ptr);
+                out2[i] = sampleAt<F>(ptr + sampleSize);
+            }
+        }
+    }
+
+    CARLA_DECLARE_NON_COPY_STRUCT(AudioFileCacheEntry)
+};
+
+class AudioFileCache
+{
+public:
+    static AudioFileCache& getInstance()
+    {
+        static AudioFileCache sCache;
+        return sCache;
+    }
+
+    /*
+     * Get the in-memory version of @a filename, loading it if needed.
+     * Returns null if the file takes more than @a maxBytes or cannot be loaded, in which case it should be streamed.
+     * Files already in the cache are always shared, regardless of @a maxBytes.
+     */
+    AudioFileCacheEntry* acquire(const char* const filename, const uint64_t maxBytes)
+    {
+        CARLA_SAFE_ASSERT_RETURN(filename != nullptr && filename[0] != '\0', nullptr);
+
+        const CarlaMutexLocker cml(fMutex);
+
+        for (LinkedList<AudioFileCacheEntry*>::Itenerator it = fEntries.begin2(); it.valid(); it.next())
+        {
+            AudioFileCacheEntry* const entry(it.getValue(nullptr));
+            CARLA_SAFE_ASSERT_CONTINUE(entry != nullptr);
+
+            if (entry->filename == filename)
             {
-                carla_stderr("R: transport out of bounds");
-                fNeedsRead = false;
-                return;
+                ++entry->refCount;
+                return entry;
             }
         }
 
-        // temp data buffer
-        const size_t tmpSize = fPool.size * fFileNfo.channels;
+        if (maxBytes == 0)
+            return nullptr;
+
+        AudioFileCacheEntry* entry;
 
-        float tmpData[tmpSize];
-        carla_zeroFloats(tmpData, tmpSize);
+        try {
+            entry = new AudioFileCacheEntry(filename);
+        } CARLA_SAFE_EXCEPTION_RETURN("AudioFileCache::acquire", nullptr);
 
+        if (! mapWaveFile(entry, filename, maxBytes) && ! decodeFile(entry, filename, maxBytes))
         {
-            carla_stderr("R: poll data - reading at %li:%02li", readFrame/44100/60, (readFrame/44100) % 60);
+            delete entry;
+            return nullptr;
+        }
+
+        entry->refCount = 1;
+        fEntries.append(entry);
+        return entry;
+    }
+
+    void release(AudioFileCacheEntry* const entry)
+    {
+        CARLA_SAFE_ASSERT_RETURN(entry != nullptr,);
+
+        const CarlaMutexLocker cml(fMutex);
 
-            ad_seek(fFilePtr, readFrame);
-            size_t i = 0;
-            ssize_t j = 0;
-            ssize_t rv = ad_read(fFilePtr, tmpData, tmpSize);
+        CARLA_SAFE_ASSERT_RETURN(entry->refCount > 0,);
 
-            // lock, and put data asap
-            const CarlaMutexLocker cml(fMutex);
+        if (--entry->refCount != 0)
+            return;
 
-            for (; i < fPool.size && j < rv; ++j)
+        fEntries.removeOne(entry);
+        delete entry;
+    }
+
+private:
+    CarlaMutex fMutex;
+    LinkedList<AudioFileCacheEntry*> fEntries;
+
+    AudioFileCache()
+        : fMutex(),
+          fEntries() {}
+
+    static uint16_t readLE16(const uint8_t* const ptr) noexcept
+    {
+        return static_cast<uint16_t>(ptr[0] | ptr[1] << 8);
+    }
+
+    static uint32_t readLE32(const uint8_t* const ptr) noexcept
+    {
+        return static_cast<uint32_t>(ptr[0]) | static_cast<uint32_t>(ptr[1]) << 8
+             | static_cast<uint32_t>(ptr[2]) << 16 | static_cast<uint32_t>(ptr[3]) << 24;
+    }
+
+    // map an uncompressed WAV file, so it plays with no decoding and no copies
+    static bool mapWaveFile(AudioFileCacheEntry* const entry, const char* const filename, const uint64_t maxBytes)
+    {
+#if defined(CARLA_OS_WIN) || (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+        // unused
+        (void)entry;
+        (void)filename;
+        (void)maxBytes;
+
+        return false;
+#else
+        const int fd = ::open(filename, O_RDONLY);
+
+        if (fd < 0)
+            return false;
+
+        struct stat st;
+
+        if (::fstat(fd, &st) != 0 || st.st_size < 44 || static_cast<uint64_t>(st.st_size) > maxBytes)
+        {
+            ::close(fd);
+            return false;
+        }
+
+        const std::size_t size = static_cast<std::size_t>(st.st_size);
+
+        int flags = MAP_PRIVATE;
+# ifdef MAP_POPULATE
+        // fault everything in now, playback must not touch the disk
+        flags |= MAP_POPULATE;
+# endif
+
+        void* const data = ::mmap(nullptr, size, PROT_READ, flags, fd, 0);
+        ::close(fd);
+
+        if (data == MAP_FAILED)
+            return false;
+
+        const uint8_t* const ptr = static_cast<const uint8_t*>(data);
+
+        uint audioFormat = 0, channels = 0, bits = 0;
+        std::size_t dataOffset = 0, dataSize = 0;
+
+        if (std::memcmp(ptr, "RIFF", 4) == 0 && std::memcmp(ptr + 8, "WAVE", 4) == 0)
+        {
+            for (std::size_t offset = 12; offset + 8 <= size;)
             {
-                if (fFileNfo.channels == 1)
+                const std::size_t chunkSize = readLE32(ptr + offset + 4);
+                const std::size_t body      = offset + 8;
+
+                if (std::memcmp(ptr + offset, "fmt ", 4) == 0 && chunkSize >= 16 && body + chunkSize <= size)
                 {
-                    fPool.buffer[0][i] = tmpData[j];
-                    fPool.buffer[1][i] = tmpData[j];
-                    i++;
+                    audioFormat = readLE16(ptr + body);
+                    channels    = readLE16(ptr + body + 2);
+                    bits        = readLE16(ptr + body + 14);
+
+                    // WAVE_FORMAT_EXTENSIBLE, real format is in the sub-format GUID
+                    if (audioFormat == 0xFFFE && chunkSize >= 40)
+                        audioFormat = readLE16(ptr + body + 24);
                 }
-                else
+                else if (std::memcmp(ptr + offset, "data", 4) == 0)
                 {
-                    if (j % 2 == 0)
-                    {
-                        fPool.buffer[0][i] = tmpData[j];
-                    }
-                    else
-                    {
-                        fPool.buffer[1][i] = tmpData[j];
-                        i++;
-                    }
+                    dataOffset = body;
+                    dataSize   = std::min(chunkSize, size - body);
+                    break;
                 }
-            }
 
-#if 0
-            if (false)
-            //if (handlePtr->loopMode && i < fPool.size)
-            {
-                while (i < fPool.size)
-                {
-                    for (j=0; i < fPool.size && j < rv; ++j)
-                    {
-                        if (fFileNfo.channels == 1)
-                        {
-                            fPool.buffer[0][i] = tmpData[j];
-                            fPool.buffer[1][i] = tmpData[j];
-                            i++;
-                        }
-                        else
-                        {
-                            if (j % 2 == 0)
-                            {
-                                fPool.buffer[0][i] = tmpData[j];
-                            }
-                            else
-                            {
-                                fPool.buffer[1][i] = tmpData[j];
-                                i++;
-                            }
-                        }
-                    }
-                }
+                offset = body + chunkSize + (chunkSize & 1);
             }
+        }
+
+        bool valid = dataOffset != 0 && (channels == 1 || channels == 2);
+
+        if (valid)
+        {
+            /**/ if (audioFormat == 3 && bits == 32)
+                entry->format = AudioFileCacheEntry::kFormatFloat32;
+            else if (audioFormat == 1 && bits == 16)
+                entry->format = AudioFileCacheEntry::kFormatInt16;
+            else if (audioFormat == 1 && bits == 24)
+                entry->format = AudioFileCacheEntry::kFormatInt24;
+            else if (audioFormat == 1 && bits == 32)
+                entry->format = AudioFileCacheEntry::kFormatInt32;
             else
-#endif
+                valid = false;
+        }
+
+        if (valid)
+            valid = dataSize / (bits/8 * channels) != 0;
+
+        if (! valid)
+        {
+            ::munmap(data, size);
+            return false;
+        }
+
+        entry->channels = channels;
+        entry->frames   = static_cast<uint32_t>(dataSize / (bits/8 * channels));
+
+        // small files are cheap to copy, which makes them safe against the file changing on disk
+        if (dataSize <= kAudioFileCopyLimit)
+        {
+            try {
+                entry->copyData = new uint8_t[dataSize];
+            } CARLA_SAFE_EXCEPTION("AudioFileCache::mapWaveFile");
+
+            if (entry->copyData != nullptr)
             {
-                for (; i < fPool.size; ++i)
-                {
-                    fPool.buffer[0][i] = 0.0f;
-                    fPool.buffer[1][i] = 0.0f;
-                }
-            }
+                std::memcpy(entry->copyData, ptr + dataOffset, dataSize);
+                ::munmap(data, size);
+
+                entry->samples = entry->copyData;
 
-            fPool.startFrame = lastFrame;
+                carla_debug("AudioFileCache: copied \"%s\", %u frames", filename, entry->frames);
+                return true;
+            }
         }
 
-        fNeedsRead = false;
+        ::madvise(data, size, MADV_WILLNEED);
+
+        entry->mapData  = data;
+        entry->mapSize  = size;
+        entry->samples  = ptr + dataOffset;
+
+        carla_debug("AudioFileCache: mapped \"%s\", %u frames", filename, entry->frames);
+        return true;
+#endif
     }
 
-protected:
-    void run() override
+    // decode a whole file into memory
+    static bool decodeFile(AudioFileCacheEntry* const entry, const char* const filename, const uint64_t maxBytes)
     {
-        while (! fQuitNow)
+        ADInfo nfo;
+        ad_clear_nfo(&nfo);
+
+        void* const filePtr = ad_open(filename, &nfo);
+
+        if (filePtr == nullptr)
+            return false;
+
+        const uint channels = nfo.channels;
+
+        if ((channels != 1 && channels != 2) || nfo.frames <= 0 || nfo.frames > 0xffffffff
+            || static_cast<uint64_t>(nfo.frames) * channels * sizeof(float) > maxBytes)
+        {
+            ad_close(filePtr);
+            return false;
+        }
+
+        const uint32_t frames = static_cast<uint32_t>(nfo.frames);
+        float* tmpData = nullptr;
+
+        try {
+            entry->buffer[0] = new float[frames];
+            entry->buffer[1] = channels == 2 ? new float[frames] : entry->buffer[0];
+            tmpData = new float[kAudioFileReadChunkFrames*channels];
+        }
+        catch (...) {
+            carla_safe_exception("AudioFileCache::decodeFile", __FILE__, __LINE__);
+            ad_close(filePtr);
+            return false;
+        }
+
+        uint32_t frame = 0;
+
+        while (frame < frames)
         {
-            const uint32_t lastFrame(kPlayer->getLastFrame());
+            const uint32_t toRead = std::min(frames - frame, kAudioFileReadChunkFrames);
+            const ssize_t  rv     = ad_read(filePtr, tmpData, toRead*channels);
+
+            if (rv <= 0)
+                break;
+
+            const uint32_t framesRead = static_cast<uint32_t>(rv)/channels;
 
-            if (fNeedsRead || lastFrame < fPool.startFrame || (lastFrame - fPool.startFrame >= fPool.size*3/4 && lastFrame < fFileNfo.frames))
-                readPoll();
+            if (channels == 1)
+            {
+                carla_copyFloats(entry->buffer[0] + frame, tmpData, framesRead);
+            }
             else
-                carla_msleep(50);
+            {
+                for (uint32_t i=0; i < framesRead; ++i)
+                {
+                    entry->buffer[0][frame+i] = tmpData[i*2];
+                    entry->buffer[1][frame+i] = tmpData[i*2+1];
+                }
+            }
+
+            frame += framesRead;
         }
-    }
 
-private:
-    AbstractAudioPlayer* const kPlayer;
+        // decoder gave up early, keep the expected length
+        if (frame < frames)
+        {
+            carla_zeroFloats(entry->buffer[0] + frame, frames - frame);
+            carla_zeroFloats(entry->buffer[1] + frame, frames - frame);
+        }
 
-    bool fNeedsRead;
-    bool fQuitNow;
+        delete[] tmpData;
+        ad_close(filePtr);
 
-    void*  fFilePtr;
-    ADInfo fFileNfo;
+        entry->channels = channels;
+        entry->frames   = frames;
+
+        carla_debug("AudioFileCache: decoded \"%s\", %u frames", filename, frames);
+        return true;
+    }
 
-    AudioFilePool fPool;
-    CarlaMutex    fMutex;
+    CARLA_DECLARE_NON_COPY_CLASS(AudioFileCache)
 };
 
 #endif // AUDIO_BASE_HPP_INCLUDED
@@ -22,31 +22,26 @@
 
 #define PROGRAM_COUNT 16
 
-class AudioFilePlugin : public NativePluginClass,
-                        public AbstractAudioPlayer
+class AudioFilePlugin : public NativePluginClass
 {
 public:
     AudioFilePlugin(const NativeHostDescriptor* const host)
         : NativePluginClass(host),
-          AbstractAudioPlayer(),
           fLoopMode(false),
           fDoProcess(false),
-          fLastFrame(0),
           fMaxFrame(0),
-          fThread(this, getSampleRate())
-    {
-        fPool.create(getSampleRate());
-    }
+          fCacheLimit(kAudioFileDefaultCacheLimit),
+          fCacheEntry(nullptr),
+          fProcessCounter(0),
+          fFilename(),
+          fThread(getSampleRate()) {}
 
     ~AudioFilePlugin() override
     {
-        fPool.destroy();
         fThread.stopNow();
-    }
 
-    uint32_t getLastFrame() const override
-    {
-        return fLastFrame;
+        if (fCacheEntry != nullptr)
+            AudioFileCache::getInstance().release(fCacheEntry);
     }
 
 protected:
@@ -102,21 +97,74 @@ protected:
             return;
 
         fLoopMode = b;
-        fThread.setNeedsRead();
     }
 
     void setCustomData(const char* const key, const char* const value) override
     {
-        if (std::strcmp(key, "file") != 0)
-            return;
+        if (std::strcmp(key, "file") == 0)
+        {
+            loadFilename(value);
+        }
+        else if (std::strcmp(key, "cache-limit") == 0)
+        {
+            // maximum size in MiB for keeping a whole file in memory, 0 to always stream from disk
+            const long long limit = std::atoll(value);
+            const uint64_t cacheLimit = limit > 0 ? static_cast<uint64_t>(limit)*1024*1024 : 0;
+
+            if (cacheLimit == fCacheLimit)
+                return;
 
-        loadFilename(value);
+            fCacheLimit = cacheLimit;
+
+            if (fFilename.isNotEmpty())
+            {
+                const CarlaString filename(fFilename);
+                loadFilename(filename);
+            }
+        }
     }
 
     // -------------------------------------------------------------------
     // Plugin process calls
 
     void process(float**, float** const outBuffer, const uint32_t frames, const NativeMidiEvent*, uint32_t) override
+    {
+        // odd while processing, lets loadFilename() know when the old file is no longer in use
+        __sync_add_and_fetch(&fProcessCounter, 1);
+
+        processFile(outBuffer, frames);
+
+        __sync_add_and_fetch(&fProcessCounter, 1);
+    }
+
+    // -------------------------------------------------------------------
+    // Plugin UI calls
+
+    void uiShow(const bool show) override
+    {
+        if (! show)
+            return;
+
+        if (const char* const filename = uiOpenFile(false, "Open Audio File", ""))
+            uiCustomDataChanged("file", filename);
+
+        uiClosed();
+    }
+
+private:
+    bool fLoopMode;
+    bool volatile fDoProcess;
+
+    uint32_t fMaxFrame;
+
+    uint64_t                      fCacheLimit;
+    AudioFileCacheEntry* volatile fCacheEntry;
+    volatile uint32_t             fProcessCounter;
+    CarlaString                   fFilename;
+
+    AudioFileThread fThread;
+
+    void processFile(float** const outBuffer, const uint32_t frames)
     {
         const NativeTimeInfo* const timePos(getTimeInfo());
 
@@ -126,97 +174,70 @@ protected:
         if (! fDoProcess)
         {
             //carla_stderr("P: no process");
-            fLastFrame = timePos->frame;
             carla_zeroFloats(out1, frames);
             carla_zeroFloats(out2, frames);
             return;
         }
 
-        // not playing
+        // not playing, keep the disk thread buffering around the playhead
         if (! timePos->playing)
         {
             //carla_stderr("P: not playing");
-            fLastFrame = timePos->frame;
-
-            if (timePos->frame == 0 && fLastFrame > 0)
-                fThread.setNeedsRead();
+            if (fCacheEntry == nullptr && timePos->frame < fMaxFrame)
+                fThread.prefetch(static_cast<uint32_t>(timePos->frame));
 
             carla_zeroFloats(out1, frames);
             carla_zeroFloats(out2, frames);
             return;
         }
 
-        fThread.tryPutData(fPool);
-
         // out of reach
-        if (timePos->frame + frames < fPool.startFrame || timePos->frame >= fMaxFrame) /*&& ! loopMode)*/
+        if (timePos->frame >= fMaxFrame) /*&& ! loopMode)*/
         {
             //carla_stderr("P: out of reach");
-            fLastFrame = timePos->frame;
-
-            if (timePos->frame + frames < fPool.startFrame)
-                fThread.setNeedsRead();
-
             carla_zeroFloats(out1, frames);
             carla_zeroFloats(out2, frames);
             return;
         }
 
-        int64_t poolFrame = (int64_t)timePos->frame - fPool.startFrame;
-        int64_t poolSize  = fPool.size;
-
-        for (uint32_t i=0; i < frames; ++i, ++poolFrame)
-        {
-            if (poolFrame >= 0 && poolFrame < poolSize)
-            {
-                out1[i] = fPool.buffer[0][poolFrame];
-                out2[i] = fPool.buffer[1][poolFrame];
-
-                // reset
-                fPool.buffer[0][poolFrame] = 0.0f;
-                fPool.buffer[1][poolFrame] = 0.0f;
-            }
-            else
-            {
-                out1[i] = 0.0f;
-                out2[i] = 0.0f;
-            }
-        }
-
-        fLastFrame = timePos->frame;
+        if (AudioFileCacheEntry* const cacheEntry = fCacheEntry)
+            cacheEntry->read(out1, out2, static_cast<uint32_t>(timePos->frame), frames);
+        else
+            fThread.tryGetData(out1, out2, static_cast<uint32_t>(timePos->frame), frames);
     }
 
-    // -------------------------------------------------------------------
-    // Plugin UI calls
-
-    void uiShow(const bool show) override
+    // wait for process() to finish if it might still be using the previous file
+    void waitForProcess() const noexcept
     {
-        if (! show)
-            return;
-
-        if (const char* const filename = uiOpenFile(false, "Open Audio File", ""))
-            uiCustomDataChanged("file", filename);
+        const uint32_t processCounter = fProcessCounter;
 
-        uiClosed();
+        if (processCounter % 2 != 0)
+        {
+            while (fProcessCounter == processCounter)
+                carla_msleep(1);
+        }
     }
 
-private:
-    bool fLoopMode;
-    bool fDoProcess;
-
-    uint32_t fLastFrame;
-    uint32_t fMaxFrame;
-
-    AudioFilePool   fPool;
-    AudioFileThread fThread;
-
     void loadFilename(const char* const filename)
     {
         CARLA_ASSERT(filename != nullptr);
         carla_debug("AudioFilePlugin::loadFilename(\"%s\")", filename);
 
+        // stop the audio thread from touching the current file, then wait until it is really done with it
+        AudioFileCacheEntry* const oldCacheEntry = fCacheEntry;
+
+        fDoProcess  = false;
+        fCacheEntry = nullptr;
+        __sync_synchronize();
+        waitForProcess();
+
         fThread.stopNow();
 
+        if (oldCacheEntry != nullptr)
+            AudioFileCache::getInstance().release(oldCacheEntry);
+
+        fFilename = filename;
+
         if (filename == nullptr || *filename == '\0')
         {
             fDoProcess = false;
@@ -224,10 +245,21 @@ private:
             return;
         }
 
+        // short files are kept in memory, for instant relocation and no disk access while playing
+        if (AudioFileCacheEntry* const entry = AudioFileCache::getInstance().acquire(filename, fCacheLimit))
+        {
+            fMaxFrame = entry->frames;
+            fCacheEntry = entry;
+            __sync_synchronize();
+            fDoProcess = true;
+            return;
+        }
+
         if (fThread.loadFilename(filename))
         {
-            fThread.startNow();
             fMaxFrame = fThread.getMaxFrame();
+            fThread.startNow();
+            __sync_synchronize();
             fDoProcess = true;
         }
         else
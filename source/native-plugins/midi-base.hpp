@@ -20,11 +20,13 @@
 
 #include "CarlaMIDI.h"
 #include "CarlaMutex.hpp"
-#include "LinkedList.hpp"
 
 #include "CarlaJuceUtils.hpp"
 #include "CarlaMathUtils.hpp"
 
+#include <algorithm>
+#include <vector>
+
 // -----------------------------------------------------------------------
 
 #define MAX_EVENT_DATA_SIZE          4
@@ -50,6 +52,14 @@ public:
 
 // -----------------------------------------------------------------------
 
+// Time-sorted MIDI events, played back by a real-time thread while being edited from others.
+//
+// Edits go to a writer-side list protected by a mutex, and are then published as an immutable
+// contiguous array which the audio thread reads without locking. An old array is only deleted
+// after the audio thread is known to be outside of play(), RCU style.
+// Playback keeps a cursor into the array, so each block only costs the events it emits;
+// the cursor is re-positioned with a binary search on seek, loop or edit.
+
 class MidiPattern
 {
 public:
@@ -58,7 +68,11 @@ public:
           fMidiPort(0),
           fStartTime(0),
           fMutex(),
-          fData()
+          fEvents(),
+          fBulkEditDepth(0),
+          fData(nullptr),
+          fPlayCounter(0),
+          fCursor(0)
     {
         CARLA_SAFE_ASSERT(kPlayer != nullptr);
     }
@@ -73,109 +87,82 @@ public:
 
     void addControl(const uint64_t time, const uint8_t channel, const uint8_t control, const uint8_t value)
     {
-        RawMidiEvent* const ctrlEvent(new RawMidiEvent());
-        ctrlEvent->time    = time;
-        ctrlEvent->size    = 3;
-        ctrlEvent->data[0] = uint8_t(MIDI_STATUS_CONTROL_CHANGE | (channel & MIDI_CHANNEL_BIT));
-        ctrlEvent->data[1] = control;
-        ctrlEvent->data[2] = value;
-
-        appendSorted(ctrlEvent);
+        const uint8_t data[3] = { uint8_t(MIDI_STATUS_CONTROL_CHANGE | (channel & MIDI_CHANNEL_BIT)), control, value };
+        addRaw(time, data, 3);
     }
 
     void addChannelPressure(const uint64_t time, const uint8_t channel, const uint8_t pressure)
     {
-        RawMidiEvent* const pressureEvent(new RawMidiEvent());
-        pressureEvent->time    = time;
-        pressureEvent->size    = 2;
-        pressureEvent->data[0] = uint8_t(MIDI_STATUS_CHANNEL_PRESSURE | (channel & MIDI_CHANNEL_BIT));
-        pressureEvent->data[1] = pressure;
-
-        appendSorted(pressureEvent);
+        const uint8_t data[2] = { uint8_t(MIDI_STATUS_CHANNEL_PRESSURE | (channel & MIDI_CHANNEL_BIT)), pressure };
+        addRaw(time, data, 2);
     }
 
     void addNote(const uint64_t time, const uint8_t channel, const uint8_t pitch, const uint8_t velocity, const uint32_t duration)
     {
+        const ScopedBulkEdit sbe(*this);
+
         addNoteOn(time, channel, pitch, velocity);
         addNoteOff(time+duration, channel, pitch, velocity);
     }
 
     void addNoteOn(const uint64_t time, const uint8_t channel, const uint8_t pitch, const uint8_t velocity)
     {
-        RawMidiEvent* const noteOnEvent(new RawMidiEvent());
-        noteOnEvent->time    = time;
-        noteOnEvent->size    = 3;
-        noteOnEvent->data[0] = uint8_t(MIDI_STATUS_NOTE_ON | (channel & MIDI_CHANNEL_BIT));
-        noteOnEvent->data[1] = pitch;
-        noteOnEvent->data[2] = velocity;
-
-        appendSorted(noteOnEvent);
+        const uint8_t data[3] = { uint8_t(MIDI_STATUS_NOTE_ON | (channel & MIDI_CHANNEL_BIT)), pitch, velocity };
+        addRaw(time, data, 3);
     }
 
     void addNoteOff(const uint64_t time, const uint8_t channel, const uint8_t pitch, const uint8_t velocity = 0)
     {
-        RawMidiEvent* const noteOffEvent(new RawMidiEvent());
-        noteOffEvent->time    = time;
-        noteOffEvent->size    = 3;
-        noteOffEvent->data[0] = uint8_t(MIDI_STATUS_NOTE_OFF | (channel & MIDI_CHANNEL_BIT));
-        noteOffEvent->data[1] = pitch;
-        noteOffEvent->data[2] = velocity;
-
-        appendSorted(noteOffEvent);
+        const uint8_t data[3] = { uint8_t(MIDI_STATUS_NOTE_OFF | (channel & MIDI_CHANNEL_BIT)), pitch, velocity };
+        addRaw(time, data, 3);
     }
 
     void addNoteAftertouch(const uint64_t time, const uint8_t channel, const uint8_t pitch, const uint8_t pressure)
     {
-        RawMidiEvent* const noteAfterEvent(new RawMidiEvent());
-        noteAfterEvent->time    = time;
-        noteAfterEvent->size    = 3;
-        noteAfterEvent->data[0] = uint8_t(MIDI_STATUS_POLYPHONIC_AFTERTOUCH | (channel & MIDI_CHANNEL_BIT));
-        noteAfterEvent->data[1] = pitch;
-        noteAfterEvent->data[2] = pressure;
-
-        appendSorted(noteAfterEvent);
+        const uint8_t data[3] = { uint8_t(MIDI_STATUS_POLYPHONIC_AFTERTOUCH | (channel & MIDI_CHANNEL_BIT)), pitch, pressure };
+        addRaw(time, data, 3);
     }
 
     void addProgram(const uint64_t time, const uint8_t channel, const uint8_t bank, const uint8_t program)
     {
-        RawMidiEvent* const bankEvent(new RawMidiEvent());
-        bankEvent->time    = time;
-        bankEvent->size    = 3;
-        bankEvent->data[0] = uint8_t(MIDI_STATUS_CONTROL_CHANGE | (channel & MIDI_CHANNEL_BIT));
-        bankEvent->data[1] = MIDI_CONTROL_BANK_SELECT;
-        bankEvent->data[2] = bank;
-
-        RawMidiEvent* const programEvent(new RawMidiEvent());
-        programEvent->time    = time;
-        programEvent->size    = 2;
-        programEvent->data[0] = uint8_t(MIDI_STATUS_PROGRAM_CHANGE | (channel & MIDI_CHANNEL_BIT));
-        programEvent->data[1] = program;
-
-        appendSorted(bankEvent);
-        appendSorted(programEvent);
+        const uint8_t bankData[3]    = { uint8_t(MIDI_STATUS_CONTROL_CHANGE | (channel & MIDI_CHANNEL_BIT)), MIDI_CONTROL_BANK_SELECT, bank };
+        const uint8_t programData[2] = { uint8_t(MIDI_STATUS_PROGRAM_CHANGE | (channel & MIDI_CHANNEL_BIT)), program };
+
+        const ScopedBulkEdit sbe(*this);
+
+        addRaw(time, bankData, 3);
+        addRaw(time, programData, 2);
     }
 
     void addPitchbend(const uint64_t time, const uint8_t channel, const uint8_t lsb, const uint8_t msb)
     {
-        RawMidiEvent* const pressureEvent(new RawMidiEvent());
-        pressureEvent->time    = time;
-        pressureEvent->size    = 3;
-        pressureEvent->data[0] = uint8_t(MIDI_STATUS_PITCH_WHEEL_CONTROL | (channel & MIDI_CHANNEL_BIT));
-        pressureEvent->data[1] = lsb;
-        pressureEvent->data[2] = msb;
-
-        appendSorted(pressureEvent);
+        const uint8_t data[3] = { uint8_t(MIDI_STATUS_PITCH_WHEEL_CONTROL | (channel & MIDI_CHANNEL_BIT)), lsb, msb };
+        addRaw(time, data, 3);
     }
 
     void addRaw(const uint64_t time, const uint8_t* const data, const uint8_t size)
     {
-        RawMidiEvent* const rawEvent(new RawMidiEvent());
-        rawEvent->time = time;
-        rawEvent->size = size;
+        CARLA_SAFE_ASSERT_RETURN(size > 0 && size <= MAX_EVENT_DATA_SIZE,);
+
+        RawMidiEvent rawEvent;
+        carla_zeroStruct(rawEvent);
+        rawEvent.time = time;
+        rawEvent.size = size;
 
-        carla_copy<uint8_t>(rawEvent->data, data, size);
+        carla_copy<uint8_t>(rawEvent.data, data, size);
+
+        const CarlaMutexLocker sl(fMutex);
 
-        appendSorted(rawEvent);
+        // during bulk edits sorting is deferred until the end
+        if (fBulkEditDepth != 0)
+        {
+            fEvents.push_back(rawEvent);
+            return;
+        }
+
+        // keep insertion order for events with the same time
+        fEvents.insert(std::upper_bound(fEvents.begin(), fEvents.end(), rawEvent, compareTime), rawEvent);
+        _publish();
     }
 
     // -------------------------------------------------------------------
@@ -185,20 +172,27 @@ public:
     {
         const CarlaMutexLocker sl(fMutex);
 
-        for (LinkedList<const RawMidiEvent*>::Itenerator it = fData.begin2(); it.valid(); it.next())
-        {
-            const RawMidiEvent* const rawMidiEvent(it.getValue(nullptr));
-            CARLA_SAFE_ASSERT_CONTINUE(rawMidiEvent != nullptr);
+        RawMidiEvent key;
+        carla_zeroStruct(key);
+        key.time = time;
+
+        std::vector<RawMidiEvent>::iterator it = fBulkEditDepth == 0
+                                               ? std::lower_bound(fEvents.begin(), fEvents.end(), key, compareTime)
+                                               : fEvents.begin();
 
-            if (rawMidiEvent->time != time)
+        for (; it != fEvents.end(); ++it)
+        {
+            if (it->time != time)
                 continue;
-            if (rawMidiEvent->size != size)
+            if (it->size != size)
                 continue;
-            if (std::memcmp(rawMidiEvent->data, data, size) != 0)
+            if (std::memcmp(it->data, data, size) != 0)
                 continue;
 
-            delete rawMidiEvent;
-            fData.remove(it);
+            fEvents.erase(it);
+
+            if (fBulkEditDepth == 0)
+                _publish();
 
             return;
         }
@@ -213,12 +207,54 @@ public:
     {
         const CarlaMutexLocker sl(fMutex);
 
-        for (LinkedList<const RawMidiEvent*>::Itenerator it = fData.begin2(); it.valid(); it.next())
-            delete it.getValue(nullptr);
+        fEvents.clear();
+        _publish();
+    }
+
+    // -------------------------------------------------------------------
+    // bulk edits, events are sorted and published once at the end
 
-        fData.clear();
+    void beginBulkEdit() noexcept
+    {
+        const CarlaMutexLocker sl(fMutex);
+
+        ++fBulkEditDepth;
     }
 
+    void endBulkEdit()
+    {
+        const CarlaMutexLocker sl(fMutex);
+
+        CARLA_SAFE_ASSERT_RETURN(fBulkEditDepth > 0,);
+
+        if (--fBulkEditDepth != 0)
+            return;
+
+        std::stable_sort(fEvents.begin(), fEvents.end(), compareTime);
+        _publish();
+    }
+
+    class ScopedBulkEdit
+    {
+    public:
+        ScopedBulkEdit(MidiPattern& pattern) noexcept
+            : fPattern(pattern)
+        {
+            fPattern.beginBulkEdit();
+        }
+
+        ~ScopedBulkEdit()
+        {
+            fPattern.endBulkEdit();
+        }
+
+    private:
+        MidiPattern& fPattern;
+
+        CARLA_PREVENT_HEAP_ALLOCATION
+        CARLA_DECLARE_NON_COPY_CLASS(ScopedBulkEdit)
+    };
+
     // -------------------------------------------------------------------
     // play on time
 
@@ -229,26 +265,35 @@ public:
 
     void play(long double timePosFrame, const double frames)
     {
-        if (! fMutex.tryLock())
-            return;
+        // odd while playing, lets writers know when an old array can be deleted
+        __sync_add_and_fetch(&fPlayCounter, 1);
 
-        if (fStartTime != 0)
-            timePosFrame += static_cast<long double>(fStartTime);
-
-        for (LinkedList<const RawMidiEvent*>::Itenerator it = fData.begin2(); it.valid(); it.next())
+        if (const Data* const data = fData)
         {
-            const RawMidiEvent* const rawMidiEvent(it.getValue(nullptr));
-            CARLA_SAFE_ASSERT_CONTINUE(rawMidiEvent != nullptr);
+            if (fStartTime != 0)
+                timePosFrame += static_cast<long double>(fStartTime);
 
-            if (timePosFrame > rawMidiEvent->time)
-                continue;
-            if (timePosFrame + frames <= rawMidiEvent->time)
-                continue;
+            const RawMidiEvent* const events(data->events);
+            const std::size_t count = data->count;
+            const long double endTimePos = timePosFrame + frames;
+
+            // cursor must point to the first event at or after timePosFrame
+            std::size_t cursor = fCursor;
+
+            if (cursor > count
+                || (cursor != 0 && static_cast<long double>(events[cursor-1].time) >= timePosFrame)
+                || (cursor != count && static_cast<long double>(events[cursor].time) < timePosFrame))
+            {
+                cursor = static_cast<std::size_t>(std::lower_bound(events, events + count, timePosFrame, compareTimePos) - events);
+            }
+
+            for (; cursor < count && static_cast<long double>(events[cursor].time) < endTimePos; ++cursor)
+                kPlayer->writeMidiEvent(fMidiPort, static_cast<long double>(events[cursor].time)-timePosFrame, &events[cursor]);
 
-            kPlayer->writeMidiEvent(fMidiPort, static_cast<long double>(rawMidiEvent->time)-timePosFrame, rawMidiEvent);
+            fCursor = cursor;
         }
 
-        fMutex.unlock();
+        __sync_add_and_fetch(&fPlayCounter, 1);
     }
 
     // -------------------------------------------------------------------
@@ -272,9 +317,10 @@ public:
         return fMutex;
     }
 
-    LinkedList<const RawMidiEvent*>::Itenerator iteneratorBegin() const noexcept
+    // non real-time, getLock() must be held while using the returned list
+    const std::vector<RawMidiEvent>& getEvents() const noexcept
     {
-        return fData.begin2();
+        return fEvents;
     }
 
     // -------------------------------------------------------------------
@@ -288,19 +334,18 @@ public:
 
         const CarlaMutexLocker sl(fMutex);
 
-        if (fData.count() == 0)
+        if (fEvents.empty())
             return nullptr;
 
-        char* const data((char*)std::calloc(1, fData.count()*maxMsgSize));
+        char* const data((char*)std::calloc(1, fEvents.size()*maxMsgSize));
         CARLA_SAFE_ASSERT_RETURN(data != nullptr, nullptr);
 
         char* dataWrtn = data;
         int wrtn;
 
-        for (LinkedList<const RawMidiEvent*>::Itenerator it = fData.begin2(); it.valid(); it.next())
+        for (std::vector<RawMidiEvent>::const_iterator it = fEvents.begin(); it != fEvents.end(); ++it)
         {
-            const RawMidiEvent* const rawMidiEvent(it.getValue(nullptr));
-            CARLA_SAFE_ASSERT_CONTINUE(rawMidiEvent != nullptr);
+            const RawMidiEvent* const rawMidiEvent(&*it);
 
             wrtn = std::snprintf(dataWrtn, maxTimeSize+4, P_INT64 ":%i:", rawMidiEvent->time, rawMidiEvent->size);
             CARLA_SAFE_ASSERT_BREAK(wrtn > 0);
@@ -337,6 +382,7 @@ public:
 
         clear();
 
+        const ScopedBulkEdit sbe(*this);
         const CarlaMutexLocker sl(fMutex);
 
         for (; *dataRead != '\0';)
@@ -407,46 +453,84 @@ public:
             for (int i=size; i<MAX_EVENT_DATA_SIZE; ++i)
                 midiEvent.data[i] = 0;
 
-            RawMidiEvent* const event(new RawMidiEvent());
-            carla_copyStruct(*event, midiEvent);
-            fData.append(event);
+            fEvents.push_back(midiEvent);
         }
     }
 
     // -------------------------------------------------------------------
 
 private:
+    struct Data {
+        RawMidiEvent* events;
+        std::size_t   count;
+    };
+
     AbstractMidiPlayer* const kPlayer;
 
     uint8_t  fMidiPort;
     uint64_t fStartTime;
 
+    // writer side
     CarlaMutex fMutex;
-    LinkedList<const RawMidiEvent*> fData;
+    std::vector<RawMidiEvent> fEvents;
+    uint fBulkEditDepth;
+
+    // published, read by play()
+    const Data* volatile fData;
+    volatile uint32_t    fPlayCounter;
+    std::size_t          fCursor;
 
-    void appendSorted(const RawMidiEvent* const event)
+    static bool compareTime(const RawMidiEvent& a, const RawMidiEvent& b) noexcept
     {
-        const CarlaMutexLocker sl(fMutex);
+        return a.time < b.time;
+    }
 
-        if (fData.isEmpty())
-        {
-            fData.append(event);
-            return;
-        }
+    static bool compareTimePos(const RawMidiEvent& event, const long double timePos) noexcept
+    {
+        return static_cast<long double>(event.time) < timePos;
+    }
+
+    // copy the writer side events into a new array, swap it in and delete the old one. must hold fMutex
+    void _publish() noexcept
+    {
+        Data* newData = nullptr;
 
-        for (LinkedList<const RawMidiEvent*>::Itenerator it = fData.begin2(); it.valid(); it.next())
+        if (! fEvents.empty())
         {
-            const RawMidiEvent* const oldEvent(it.getValue(nullptr));
-            CARLA_SAFE_ASSERT_CONTINUE(oldEvent != nullptr);
+            try {
+                newData = new Data;
+                newData->count  = fEvents.size();
+                newData->events = new RawMidiEvent[newData->count];
+            } catch(...) {
+                delete newData;
+                carla_safe_exception("MidiPattern::_publish", __FILE__, __LINE__);
+                return;
+            }
 
-            if (event->time >= oldEvent->time)
-                continue;
+            std::memcpy(newData->events, &fEvents[0], sizeof(RawMidiEvent)*newData->count);
+        }
 
-            fData.insertAt(event, it);
+        // the new array must be fully written before play() can see it,
+        // and play() must see it before we look at fPlayCounter
+        const Data* const oldData = fData;
+        __sync_synchronize();
+        fData = newData;
+        __sync_synchronize();
+
+        if (oldData == nullptr)
             return;
+
+        // wait for play() to finish if it might still be using the old array
+        const uint32_t playCounter = fPlayCounter;
+
+        if (playCounter % 2 != 0)
+        {
+            while (fPlayCounter == playCounter)
+                carla_msleep(1);
         }
 
-        fData.append(event);
+        delete[] oldData->events;
+        delete oldData;
     }
 
     CARLA_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiPattern)
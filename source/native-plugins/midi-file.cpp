@@ -16,6 +16,8 @@
  */
 
 #include "CarlaNative.hpp"
+#include "CarlaPipeUtils.hpp"
+#include "CarlaString.hpp"
 #include "midi-base.hpp"
 
 #include "water/files/FileInputStream.h"
@@ -31,9 +33,64 @@ public:
         : NativePluginClass(host),
           fMidiOut(this),
           fNeedsAllNotesOff(false),
-          fWasPlayingBefore(false) {}
+          fWasPlayingBefore(false),
+          fFollowHostTempo(false),
+          fTicksPerQuarter(0.0),
+          fTempoMap(),
+          fTempoMutex(),
+          fTicksPerFrame(0.0),
+          fBlockFrames(0),
+          fNextFrame(0),
+          fNextTick(0.0),
+          fHasNextTick(false) {}
 
 protected:
+    // -------------------------------------------------------------------
+    // Plugin parameter calls
+
+    uint32_t getParameterCount() const override
+    {
+        return 1;
+    }
+
+    const NativeParameter* getParameterInfo(const uint32_t index) const override
+    {
+        if (index != 0)
+            return nullptr;
+
+        static NativeParameter param;
+
+        param.name  = "Follow Host Tempo";
+        param.unit  = nullptr;
+        param.hints = static_cast<NativeParameterHints>(NATIVE_PARAMETER_IS_ENABLED|NATIVE_PARAMETER_IS_BOOLEAN);
+        param.ranges.def = 0.0f;
+        param.ranges.min = 0.0f;
+        param.ranges.max = 1.0f;
+        param.ranges.step = 1.0f;
+        param.ranges.stepSmall = 1.0f;
+        param.ranges.stepLarge = 1.0f;
+        param.scalePointCount = 0;
+        param.scalePoints     = nullptr;
+
+        return &param;
+    }
+
+    float getParameterValue(const uint32_t index) const override
+    {
+        if (index != 0)
+            return 0.0f;
+
+        return fFollowHostTempo ? 1.0f : 0.0f;
+    }
+
+    void setParameterValue(const uint32_t index, const float value) override
+    {
+        if (index != 0)
+            return;
+
+        fFollowHostTempo = (value > 0.5f);
+    }
+
     // -------------------------------------------------------------------
     // Plugin state calls
 
@@ -83,7 +140,9 @@ protected:
         }
 
         if (fWasPlayingBefore)
-            fMidiOut.play(timePos->frame, frames);
+            _play(timePos, frames);
+        else
+            fHasNextTick = false;
     }
 
     // -------------------------------------------------------------------
@@ -105,12 +164,90 @@ protected:
 
     char* getState() const override
     {
-        return fMidiOut.getState();
+        // file resolution and tempo map first, then the events in ticks
+        CarlaString state;
+        char strBuf[0xff+1];
+        strBuf[0xff] = '\0';
+
+        {
+            const CarlaMutexLocker cml(fTempoMutex);
+            const ScopedLocale csl;
+
+            if (fTempoMap.empty())
+                return nullptr;
+
+            std::snprintf(strBuf, 0xff, "ticks-per-quarter:%f\n", fTicksPerQuarter);
+            state += strBuf;
+
+            for (std::vector<TempoMapEntry>::const_iterator it = fTempoMap.begin(); it != fTempoMap.end(); ++it)
+            {
+                std::snprintf(strBuf, 0xff, "tempo:" P_UINT64 ":%f\n", it->tick, it->secondsPerTick * fTicksPerQuarter * 1000000.0);
+                state += strBuf;
+            }
+        }
+
+        char* const events = fMidiOut.getState();
+        const std::size_t stateLen  = state.length();
+        const std::size_t eventsLen = events != nullptr ? std::strlen(events) : 0;
+
+        char* const data = static_cast<char*>(std::malloc(stateLen + eventsLen + 1));
+        CARLA_SAFE_ASSERT_RETURN(data != nullptr, events);
+
+        std::memcpy(data, state.buffer(), stateLen);
+
+        if (events != nullptr)
+        {
+            std::memcpy(data + stateLen, events, eventsLen);
+            std::free(events);
+        }
+
+        data[stateLen + eventsLen] = '\0';
+        return data;
     }
 
     void setState(const char* const data) override
     {
-        fMidiOut.setState(data);
+        CARLA_SAFE_ASSERT_RETURN(data != nullptr,);
+
+        const ScopedLocale csl;
+
+        double ticksPerQuarter = 0.0;
+        std::vector<TempoMapEntry> tempoMap;
+        const char* dataRead = data;
+
+        // header lines start with a letter, events with their time
+        while (*dataRead >= 'a' && *dataRead <= 'z')
+        {
+            if (std::strncmp(dataRead, "ticks-per-quarter:", 18) == 0)
+            {
+                ticksPerQuarter = std::atof(dataRead + 18);
+            }
+            else if (std::strncmp(dataRead, "tempo:", 6) == 0 && ticksPerQuarter > 0.0)
+            {
+                char* end;
+                const long long tick = std::strtoll(dataRead + 6, &end, 10);
+                CARLA_SAFE_ASSERT_BREAK(tick >= 0 && *end == ':');
+
+                _addTempo(tempoMap, static_cast<uint64_t>(tick), std::atof(end + 1) / 1000000.0 / ticksPerQuarter);
+            }
+
+            const char* const newline = std::strchr(dataRead, '\n');
+            CARLA_SAFE_ASSERT_RETURN(newline != nullptr,);
+            dataRead = newline + 1;
+        }
+
+        // states from older versions have event times in frames, play them back as if the file was at 120 BPM
+        if (ticksPerQuarter <= 0.0)
+        {
+            ticksPerQuarter = getSampleRate() * 0.5;
+            tempoMap.clear();
+        }
+
+        if (tempoMap.empty())
+            _addTempo(tempoMap, 0, 0.5 / ticksPerQuarter);
+
+        fMidiOut.setState(dataRead);
+        _setTempoMap(ticksPerQuarter, tempoMap);
     }
 
     // -------------------------------------------------------------------
@@ -118,10 +255,12 @@ protected:
 
     void writeMidiEvent(const uint8_t port, const long double timePosFrame, const RawMidiEvent* const event) override
     {
+        CARLA_SAFE_ASSERT_RETURN(fTicksPerFrame > 0.0,);
+
         NativeMidiEvent midiEvent;
 
         midiEvent.port    = port;
-        midiEvent.time    = uint32_t(timePosFrame);
+        midiEvent.time    = std::min(uint32_t(timePosFrame/fTicksPerFrame), fBlockFrames-1);
         midiEvent.size    = event->size;
         midiEvent.data[0] = event->data[0];
         midiEvent.data[1] = event->data[1];
@@ -134,14 +273,162 @@ protected:
     // -------------------------------------------------------------------
 
 private:
+    // start of a constant tempo section
+    struct TempoMapEntry {
+        uint64_t tick;
+        double   seconds;
+        double   secondsPerTick;
+    };
+
     MidiPattern fMidiOut;
     bool fNeedsAllNotesOff;
     bool fWasPlayingBefore;
 
+    // play at the host tempo instead of the file one, using the host BBT position
+    bool fFollowHostTempo;
+
+    // events are stored in file ticks, converted to frames on every block
+    double fTicksPerQuarter;
+    std::vector<TempoMapEntry> fTempoMap;
+    CarlaMutex fTempoMutex;
+
+    // current block, used for converting event times back to frames
+    double   fTicksPerFrame;
+    uint32_t fBlockFrames;
+
+    // where the last block ended, to keep consecutive blocks gapless
+    uint64_t    fNextFrame;
+    long double fNextTick;
+    bool        fHasNextTick;
+
+    void _play(const NativeTimeInfo* const timePos, const uint32_t frames)
+    {
+        const CarlaMutexTryLocker cmtl(fTempoMutex);
+
+        if (! cmtl.wasLocked() || fTempoMap.empty())
+        {
+            fHasNextTick = false;
+            return;
+        }
+
+        const double sampleRate(getSampleRate());
+        long double startTick;
+        double ticksPerFrame;
+
+        if (fFollowHostTempo && timePos->bbt.valid && timePos->bbt.beatsPerMinute > 0.0 &&
+            timePos->bbt.beatType > 0.0f && timePos->bbt.ticksPerBeat > 0.0)
+        {
+            // follow the host tempo, file tempo changes are ignored
+            const double quartersPerBeat = 4.0 / timePos->bbt.beatType;
+
+            ticksPerFrame = timePos->bbt.beatsPerMinute / 60.0 / sampleRate * quartersPerBeat * fTicksPerQuarter;
+
+            if (fHasNextTick && timePos->frame == fNextFrame)
+            {
+                startTick = fNextTick;
+            }
+            else
+            {
+                const double beats = (timePos->bbt.bar - 1) * static_cast<double>(timePos->bbt.beatsPerBar)
+                                   + (timePos->bbt.beat - 1)
+                                   + timePos->bbt.tick / timePos->bbt.ticksPerBeat;
+
+                startTick = beats * quartersPerBeat * fTicksPerQuarter;
+            }
+        }
+        else
+        {
+            // file tempo map, the host transport only gives the position
+            startTick = _frameToTick(timePos->frame, sampleRate);
+
+            const long double endTick = _frameToTick(timePos->frame + frames, sampleRate);
+            ticksPerFrame = static_cast<double>((endTick - startTick) / frames);
+        }
+
+        if (ticksPerFrame <= 0.0)
+        {
+            fHasNextTick = false;
+            return;
+        }
+
+        fTicksPerFrame = ticksPerFrame;
+        fBlockFrames   = frames;
+        fMidiOut.play(startTick, ticksPerFrame * frames);
+
+        fNextFrame   = timePos->frame + frames;
+        fNextTick    = startTick + ticksPerFrame * frames;
+        fHasNextTick = true;
+    }
+
+    long double _frameToTick(const uint64_t frame, const double sampleRate) const noexcept
+    {
+        const double seconds = static_cast<double>(frame) / sampleRate;
+
+        // last section starting at or before this time
+        std::vector<TempoMapEntry>::const_iterator it = fTempoMap.begin();
+
+        if (fTempoMap.size() > 1)
+        {
+            std::size_t first = 0, last = fTempoMap.size();
+
+            while (last - first > 1)
+            {
+                const std::size_t middle = (first + last) / 2;
+
+                if (fTempoMap[middle].seconds <= seconds)
+                    first = middle;
+                else
+                    last = middle;
+            }
+
+            it += static_cast<std::ptrdiff_t>(first);
+        }
+
+        return static_cast<long double>(it->tick) + (seconds - it->seconds) / it->secondsPerTick;
+    }
+
+    static void _addTempo(std::vector<TempoMapEntry>& tempoMap, const uint64_t tick, const double secondsPerTick)
+    {
+        CARLA_SAFE_ASSERT_RETURN(secondsPerTick > 0.0,);
+
+        TempoMapEntry entry = { tick, 0.0, secondsPerTick };
+
+        if (! tempoMap.empty())
+        {
+            TempoMapEntry& last(tempoMap.back());
+            CARLA_SAFE_ASSERT_RETURN(tick >= last.tick,);
+
+            // several tempo events at the same time, last one wins
+            if (tick == last.tick)
+            {
+                last.secondsPerTick = secondsPerTick;
+                return;
+            }
+
+            entry.seconds = last.seconds + static_cast<double>(tick - last.tick) * last.secondsPerTick;
+        }
+
+        tempoMap.push_back(entry);
+    }
+
+    void _setTempoMap(const double ticksPerQuarter, std::vector<TempoMapEntry>& tempoMap)
+    {
+        const CarlaMutexLocker cml(fTempoMutex);
+
+        fTicksPerQuarter = ticksPerQuarter;
+        fTempoMap.swap(tempoMap);
+        fHasNextTick = false;
+    }
+
     void _loadMidiFile(const char* const filename)
     {
         fMidiOut.clear();
 
+        {
+            std::vector<TempoMapEntry> noTempoMap;
+            _setTempoMap(0.0, noTempoMap);
+        }
+
         using namespace water;
 
         const String jfilename = String(CharPointer_UTF8(filename));
@@ -156,9 +443,45 @@ private:
         if (! midiFile.readFrom(fileStream))
             return;
 
-        midiFile.convertTimestampTicksToSeconds();
+        // keep event times in ticks, and build the tempo map for converting them
+        const short timeFormat(midiFile.getTimeFormat());
+        double ticksPerQuarter;
+        std::vector<TempoMapEntry> tempoMap;
 
-        const double sampleRate(getSampleRate());
+        if (timeFormat > 0)
+        {
+            ticksPerQuarter = timeFormat;
+
+            // anything before the first tempo event plays at 120 BPM
+            _addTempo(tempoMap, 0, 0.5 / ticksPerQuarter);
+
+            MidiMessageSequence tempoEvents;
+            midiFile.findAllTempoEvents(tempoEvents);
+
+            for (int i=0, numEvents = tempoEvents.getNumEvents(); i<numEvents; ++i)
+            {
+                const MidiMessage& tempoEvent(tempoEvents.getEventPointer(i)->message);
+                const double secondsPerQuarter(tempoEvent.getTempoSecondsPerQuarterNote());
+                CARLA_SAFE_ASSERT_CONTINUE(tempoEvent.getTimeStamp() >= 0.0);
+
+                if (secondsPerQuarter > 0.0)
+                    _addTempo(tempoMap, static_cast<uint64_t>(tempoEvent.getTimeStamp()), secondsPerQuarter / ticksPerQuarter);
+            }
+        }
+        else
+        {
+            // SMPTE time, fixed ticks per second. treated as 120 BPM when following the host tempo
+            const int framesPerSecond = -(timeFormat >> 8);
+            const int ticksPerFrame   = timeFormat & 0xff;
+            CARLA_SAFE_ASSERT_RETURN(framesPerSecond > 0 && ticksPerFrame > 0,);
+
+            const double ticksPerSecond = (framesPerSecond == 29 ? 29.97 : framesPerSecond) * ticksPerFrame;
+
+            ticksPerQuarter = ticksPerSecond * 0.5;
+            _addTempo(tempoMap, 0, 1.0 / ticksPerSecond);
+        }
+
+        const MidiPattern::ScopedBulkEdit sbe(fMidiOut);
 
         for (int i=0, numTracks = midiFile.getNumTracks(); i<numTracks; ++i)
         {
@@ -199,13 +522,14 @@ private:
                 if (midiMessage.isSysEx())
                     continue;
 
-                const double time(midiMessage.getTimeStamp()*sampleRate);
+                const double time(midiMessage.getTimeStamp());
                 CARLA_SAFE_ASSERT_CONTINUE(time >= 0.0);
 
                 fMidiOut.addRaw(static_cast<uint64_t>(time), midiMessage.getRawData(), static_cast<uint8_t>(dataSize));
             }
         }
 
+        _setTempoMap(ticksPerQuarter, tempoMap);
         fNeedsAllNotesOff = true;
     }
 
@@ -227,7 +551,7 @@ static const NativePluginDescriptor midifileDesc = {
     /* audioOuts */ 0,
     /* midiIns   */ 0,
     /* midiOuts  */ 1,
-    /* paramIns  */ 0,
+    /* paramIns  */ 1,
     /* paramOuts */ 0,
     /* name      */ "MIDI File",
     /* label     */ "midifile",
@@ -450,10 +450,11 @@ private:
 
         writeMessage("midi-clear-all\n", 15);
 
-        for (LinkedList<const RawMidiEvent*>::Itenerator it = fMidiOut.iteneratorBegin(); it.valid(); it.next())
+        const std::vector<RawMidiEvent>& events(fMidiOut.getEvents());
+
+        for (std::vector<RawMidiEvent>::const_iterator it = events.begin(); it != events.end(); ++it)
         {
-            const RawMidiEvent* const rawMidiEvent(it.getValue(nullptr));
-            CARLA_SAFE_ASSERT_CONTINUE(rawMidiEvent != nullptr);
+            const RawMidiEvent* const rawMidiEvent(&*it);
 
             writeMessage("midievent-add\n", 14);
 
@@ -0,0 +1,99 @@
+/*
+ * Carla project and preset converter
+ * Copyright (C) 2018 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the doc/GPL.txt file.
+ */
+
+#include "CarlaStateUtils.cpp"
+
+#include "water/files/File.h"
+#include "water/xml/XmlDocument.h"
+
+using water::File;
+using water::XmlDocument;
+
+CARLA_BACKEND_USE_NAMESPACE
+
+// -----------------------------------------------------------------------
+// Converts between .carxp/.carxs xml files and their binary counterparts,
+// the direction is picked from the contents of the input file.
+
+int main(int argc, char* argv[])
+{
+    if (argc != 3)
+    {
+        carla_stdout("usage: %s <input-file> <output-file>", argv[0]);
+        return 1;
+    }
+
+    const char* const inputFilename  = argv[1];
+    const char* const outputFilename = argv[2];
+
+    const String jinputFilename  = String(CharPointer_UTF8(inputFilename));
+    const String joutputFilename = String(CharPointer_UTF8(outputFilename));
+    const File inputFile(jinputFilename);
+    const File outputFile(joutputFilename);
+
+    if (! inputFile.existsAsFile())
+    {
+        carla_stderr("Input file '%s' does not exist", inputFilename);
+        return 1;
+    }
+
+    MemoryOutputStream out;
+
+    if (CarlaBinaryStateFile::isBinaryStateFile(inputFilename))
+    {
+        CarlaBinaryStateFile binaryState;
+
+        if (! binaryState.openFile(inputFilename) || ! binaryState.writeAsXml(out))
+        {
+            carla_stderr("Failed to read binary file '%s'", inputFilename);
+            return 1;
+        }
+    }
+    else
+    {
+        const ScopedPointer<XmlElement> xmlElement(XmlDocument::parse(inputFile));
+
+        if (xmlElement == nullptr)
+        {
+            carla_stderr("Failed to parse xml file '%s'", inputFilename);
+            return 1;
+        }
+
+        if (! (xmlElement->getTagName().equalsIgnoreCase("carla-project") ||
+               xmlElement->getTagName().equalsIgnoreCase("carla-preset")))
+        {
+            carla_stderr("'%s' is not a Carla project or preset file", inputFilename);
+            return 1;
+        }
+
+        if (! CarlaBinaryStateWriter::writeFromXmlElement(xmlElement, out))
+        {
+            carla_stderr("Failed to convert '%s'", inputFilename);
+            return 1;
+        }
+    }
+
+    if (! outputFile.replaceWithData(out.getData(), out.getDataSize()))
+    {
+        carla_stderr("Failed to write output file '%s'", outputFilename);
+        return 1;
+    }
+
+    return 0;
+}
+
+// -----------------------------------------------------------------------
@@ -0,0 +1,346 @@
+/*
+ * AudioProcessorGraph Tests
+ * Copyright (C) 2018 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the doc/GPL.txt file.
+ */
+
+#include "CarlaWorkerPool.hpp"
+
+#include "water/processors/AudioProcessorGraph.h"
+#include "water/buffers/AudioSampleBuffer.h"
+#include "water/midi/MidiBuffer.h"
+#include "water/text/String.h"
+
+#include <cstring>
+#include <string>
+
+using water::AudioProcessor;
+using water::AudioProcessorGraph;
+using water::AudioSampleBuffer;
+using water::MidiBuffer;
+using water::String;
+
+// -----------------------------------------------------------------------
+
+static const int kBufferSize = 16;
+static const int kNumBlocks  = 50;
+
+// every processor appends its name here when it runs
+static std::string sProcessOrder;
+
+// runs the graph jobs on a worker pool, like the engine does
+struct PoolJobRunner : public AudioProcessorGraph::JobRunner,
+                       private CarlaWorkerPool::Job
+{
+    CarlaWorkerPool pool;
+    AudioProcessorGraph::JobRunner::Job* job;
+
+    PoolJobRunner() noexcept
+        : pool(),
+          job(nullptr) {}
+
+    void runJob(AudioProcessorGraph::JobRunner::Job& j) noexcept override
+    {
+        job = &j;
+        pool.runJob(*this);
+        job = nullptr;
+    }
+
+    void run(const bool fromWorker) noexcept override
+    {
+        job->run(fromWorker);
+    }
+};
+
+class OrderRecorder : public AudioProcessor
+{
+public:
+    OrderRecorder(const char c)
+        : AudioProcessor(),
+          fName(c)
+    {
+        setPlayConfigDetails(1, 1, 48000.0, kBufferSize);
+    }
+
+    const String getName() const override { return String::charToString(fName); }
+    void prepareToPlay(double, int) override {}
+    void releaseResources() override {}
+    bool acceptsMidi() const override { return false; }
+    bool producesMidi() const override { return false; }
+
+    void processBlock(AudioSampleBuffer&, MidiBuffer&) override
+    {
+        sProcessOrder += fName;
+    }
+
+private:
+    const char fName;
+};
+
+// scales and offsets its input, the offset growing each block so that every block is different
+class GainProcessor : public AudioProcessor
+{
+public:
+    GainProcessor(const float gain, const float offset)
+        : AudioProcessor(),
+          fGain(gain),
+          fOffset(offset),
+          fBlock(0)
+    {
+        setPlayConfigDetails(1, 1, 48000.0, kBufferSize);
+    }
+
+    const String getName() const override { return "Gain"; }
+    void prepareToPlay(double, int) override {}
+    void releaseResources() override {}
+    bool acceptsMidi() const override { return false; }
+    bool producesMidi() const override { return false; }
+
+    void processBlock(AudioSampleBuffer& buffer, MidiBuffer&) override
+    {
+        float* const data(buffer.getWritePointer(0));
+        const float offset(fOffset * static_cast<float>(++fBlock));
+
+        for (int i=0; i < buffer.getNumSamples(); ++i)
+            data[i] = data[i] * fGain + offset + static_cast<float>(i) * 0.001f;
+    }
+
+private:
+    const float fGain, fOffset;
+    int fBlock;
+};
+
+static std::string processAfterReorder(AudioProcessorGraph& graph)
+{
+    AudioSampleBuffer buffer(1, kBufferSize);
+    MidiBuffer midi;
+
+    graph.reorderNowIfNeeded();
+
+    sProcessOrder.clear();
+    graph.processBlock(buffer, midi);
+    graph.releaseOldRenderingSequence();
+
+    return sProcessOrder;
+}
+
+// -----------------------------------------------------------------------
+// a new node placed between two nodes which were not connected, in the opposite order
+
+static void test_NewNodeBetweenUnconnectedNodes()
+{
+    AudioProcessorGraph graph;
+    graph.setPlayConfigDetails(1, 1, 48000.0, kBufferSize);
+    graph.prepareToPlay(48000.0, kBufferSize);
+
+    graph.addNode(new OrderRecorder('B'), 2);
+    graph.addNode(new OrderRecorder('A'), 1);
+    assert(processAfterReorder(graph) == "BA");
+
+    graph.addNode(new OrderRecorder('N'), 3);
+    assert(graph.addConnection(1, 0, 3, 0));
+    assert(graph.addConnection(3, 0, 2, 0));
+    assert(processAfterReorder(graph) == "ANB");
+
+    graph.releaseResources();
+    graph.clear();
+}
+
+// -----------------------------------------------------------------------
+// a new connection going backwards in the previous order, then a feedback loop
+
+static void test_NewConnections()
+{
+    AudioProcessorGraph graph;
+    graph.setPlayConfigDetails(1, 1, 48000.0, kBufferSize);
+    graph.prepareToPlay(48000.0, kBufferSize);
+
+    graph.addNode(new OrderRecorder('C'), 3);
+    graph.addNode(new OrderRecorder('B'), 2);
+    graph.addNode(new OrderRecorder('A'), 1);
+    assert(graph.addConnection(2, 0, 3, 0));
+    assert(processAfterReorder(graph) == "BCA");
+
+    assert(graph.addConnection(1, 0, 2, 0));
+    assert(processAfterReorder(graph) == "ABC");
+
+    // feedback loops can't be sorted, but every node must still run once
+    assert(graph.addConnection(3, 0, 1, 0));
+    const std::string order(processAfterReorder(graph));
+    assert(order.size() == 3);
+    assert(order.find('A') != std::string::npos);
+    assert(order.find('B') != std::string::npos);
+    assert(order.find('C') != std::string::npos);
+
+    graph.releaseResources();
+    graph.clear();
+}
+
+// -----------------------------------------------------------------------
+// a connection going backwards only moves the nodes between its two ends
+
+static void test_LocalReorder()
+{
+    AudioProcessorGraph graph;
+    graph.setPlayConfigDetails(1, 1, 48000.0, kBufferSize);
+    graph.prepareToPlay(48000.0, kBufferSize);
+
+    const char* const names = "ABCDEF";
+
+    for (uint i=0; i < 6; ++i)
+        graph.addNode(new OrderRecorder(names[i]), i + 1);
+
+    assert(processAfterReorder(graph) == "ABCDEF");
+
+    // F -> B
+    assert(graph.addConnection(6, 0, 2, 0));
+    assert(processAfterReorder(graph) == "AFCDEB");
+
+    // B -> D, F stays before B
+    assert(graph.addConnection(2, 0, 4, 0));
+    assert(processAfterReorder(graph) == "AFCBED");
+
+    // removing a connection keeps the order
+    assert(graph.removeConnection(6, 0, 2, 0));
+    assert(processAfterReorder(graph) == "AFCBED");
+
+    graph.releaseResources();
+    graph.clear();
+}
+
+// -----------------------------------------------------------------------
+// a chain rendered by worker threads keeps its order, and the workers stop when asked
+
+static void test_WorkerPool()
+{
+    PoolJobRunner runner;
+    assert(runner.pool.start(2));
+
+    AudioProcessorGraph graph;
+    graph.setJobRunner(&runner);
+    graph.setPlayConfigDetails(1, 1, 48000.0, kBufferSize);
+    graph.prepareToPlay(48000.0, kBufferSize);
+
+    graph.addNode(new OrderRecorder('C'), 3);
+    graph.addNode(new OrderRecorder('B'), 2);
+    graph.addNode(new OrderRecorder('A'), 1);
+    assert(graph.addConnection(1, 0, 2, 0));
+    assert(graph.addConnection(2, 0, 3, 0));
+
+    for (int i=0; i < 100; ++i)
+    {
+        assert(processAfterReorder(graph) == "ABC");
+
+        // let the workers go to sleep from time to time
+        if (i % 10 == 0)
+            carla_msleep(5);
+    }
+
+    graph.releaseResources();
+    graph.setJobRunner(nullptr);
+    graph.clear();
+    runner.pool.stop();
+}
+
+// -----------------------------------------------------------------------
+// independent branches rendered by worker threads give the same output as rendering them serially
+
+static void setupBranches(AudioProcessorGraph& graph)
+{
+    graph.setPlayConfigDetails(1, 1, 48000.0, kBufferSize);
+    graph.prepareToPlay(48000.0, kBufferSize);
+
+    graph.addNode(new AudioProcessorGraph::AudioGraphIOProcessor(AudioProcessorGraph::AudioGraphIOProcessor::audioInputNode), 1);
+    graph.addNode(new AudioProcessorGraph::AudioGraphIOProcessor(AudioProcessorGraph::AudioGraphIOProcessor::audioOutputNode), 2);
+
+    // three branches fed by the input, two of them mixed together and then all mixed into the output
+    for (uint i=0; i < 6; ++i)
+        graph.addNode(new GainProcessor(0.5f + static_cast<float>(i) * 0.25f, 0.01f * static_cast<float>(i + 1)), 10 + i);
+
+    assert(graph.addConnection(1, 0, 10, 0));
+    assert(graph.addConnection(1, 0, 11, 0));
+    assert(graph.addConnection(1, 0, 12, 0));
+    assert(graph.addConnection(10, 0, 13, 0));
+    assert(graph.addConnection(11, 0, 13, 0));
+    assert(graph.addConnection(12, 0, 14, 0));
+    assert(graph.addConnection(13, 0, 15, 0));
+    assert(graph.addConnection(14, 0, 2, 0));
+    assert(graph.addConnection(15, 0, 2, 0));
+    assert(graph.addConnection(10, 0, 2, 0));
+    graph.reorderNowIfNeeded();
+}
+
+static void renderBranches(AudioProcessorGraph& graph, float* const output)
+{
+    AudioSampleBuffer buffer(1, kBufferSize);
+    MidiBuffer midi;
+
+    for (int b=0; b < kNumBlocks; ++b)
+    {
+        float* const data(buffer.getWritePointer(0));
+
+        for (int i=0; i < kBufferSize; ++i)
+            data[i] = static_cast<float>((b * kBufferSize + i) % 23) / 23.0f - 0.5f;
+
+        graph.processBlock(buffer, midi);
+        graph.releaseOldRenderingSequence();
+
+        std::memcpy(output + b * kBufferSize, buffer.getReadPointer(0), sizeof(float)*kBufferSize);
+    }
+}
+
+static void test_ParallelBranches()
+{
+    float serialOutput[kNumBlocks * kBufferSize];
+    float parallelOutput[kNumBlocks * kBufferSize];
+
+    {
+        AudioProcessorGraph graph;
+        setupBranches(graph);
+        renderBranches(graph, serialOutput);
+        graph.releaseResources();
+        graph.clear();
+    }
+
+    PoolJobRunner runner;
+    assert(runner.pool.start(3));
+
+    {
+        AudioProcessorGraph graph;
+        graph.setJobRunner(&runner);
+        setupBranches(graph);
+        renderBranches(graph, parallelOutput);
+        graph.releaseResources();
+        graph.clear();
+    }
+
+    runner.pool.stop();
+
+    assert(std::memcmp(serialOutput, parallelOutput, sizeof(serialOutput)) == 0);
+}
+
+// -----------------------------------------------------------------------
+
+int main()
+{
+    test_NewNodeBetweenUnconnectedNodes();
+    test_NewConnections();
+    test_LocalReorder();
+    test_WorkerPool();
+    test_ParallelBranches();
+
+    return 0;
+}
+
+// -----------------------------------------------------------------------
@@ -0,0 +1,249 @@
+/*
+ * CarlaBase64Utils Tests and Benchmark
+ * Copyright (C) 2018 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the doc/GPL.txt file.
+ */
+
+#include "CarlaBase64Utils.hpp"
+#include "CarlaString.hpp"
+
+#include <ctime>
+#include <string>
+
+// -----------------------------------------------------------------------
+
+static const std::size_t kBenchSize = 8*1024*1024;
+
+static double getTimeInSeconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec) / 1000000000.0;
+}
+
+static uint32_t sRandomSeed = 1;
+
+static uint8_t getRandomByte()
+{
+    sRandomSeed = sRandomSeed * 1103515245 + 12345;
+    return static_cast<uint8_t>(sRandomSeed >> 16);
+}
+
+// -----------------------------------------------------------------------
+// the previous linear search decoder, for speed comparison
+
+static std::vector<uint8_t> getChunkFromBase64StringOld(const char* const base64string)
+{
+    uint i=0, j=0;
+    uint charArray3[3], charArray4[4];
+
+    std::vector<uint8_t> ret;
+    ret.reserve(std::strlen(base64string)*3/4 + 4);
+
+    for (std::size_t l=0, len=std::strlen(base64string); l<len; ++l)
+    {
+        const char c = base64string[l];
+
+        if (c == '\0' || c == '=')
+            break;
+        if (c == ' ' || c == '\n')
+            continue;
+
+        charArray4[i++] = static_cast<uint>(c);
+
+        if (i == 4)
+        {
+            for (i=0; i<4; ++i)
+                charArray4[i] = static_cast<uint>(std::strchr(CarlaBase64Helpers::kBase64Chars,
+                                                              static_cast<char>(charArray4[i])) - CarlaBase64Helpers::kBase64Chars);
+
+            charArray3[0] =  (charArray4[0] << 2)        + ((charArray4[1] & 0x30) >> 4);
+            charArray3[1] = ((charArray4[1] & 0xf) << 4) + ((charArray4[2] & 0x3c) >> 2);
+            charArray3[2] = ((charArray4[2] & 0x3) << 6) +   charArray4[3];
+
+            for (i=0; i<3; ++i)
+                ret.push_back(static_cast<uint8_t>(charArray3[i]));
+
+            i = 0;
+        }
+    }
+
+    if (i != 0)
+    {
+        for (j=0; j<i && j<4; ++j)
+            charArray4[j] = static_cast<uint>(std::strchr(CarlaBase64Helpers::kBase64Chars,
+                                                          static_cast<char>(charArray4[j])) - CarlaBase64Helpers::kBase64Chars);
+
+        for (j=i; j<4; ++j)
+            charArray4[j] = 0;
+
+        charArray3[0] =  (charArray4[0] << 2)        + ((charArray4[1] & 0x30) >> 4);
+        charArray3[1] = ((charArray4[1] & 0xf) << 4) + ((charArray4[2] & 0x3c) >> 2);
+        charArray3[2] = ((charArray4[2] & 0x3) << 6) +   charArray4[3];
+
+        for (j=0; i>0 && j<i-1; j++)
+            ret.push_back(static_cast<uint8_t>(charArray3[j]));
+    }
+
+    return ret;
+}
+
+// -----------------------------------------------------------------------
+// known values, from RFC 4648
+
+static void test_Vectors()
+{
+    static const char* const kVectors[][2] = {
+        { "",       ""         },
+        { "f",      "Zg=="     },
+        { "fo",     "Zm8="     },
+        { "foo",    "Zm9v"     },
+        { "foob",   "Zm9vYg==" },
+        { "fooba",  "Zm9vYmE=" },
+        { "foobar", "Zm9vYmFy" }
+    };
+
+    for (std::size_t i=0; i < sizeof(kVectors)/sizeof(kVectors[0]); ++i)
+    {
+        const char* const data = kVectors[i][0];
+        const char* const text = kVectors[i][1];
+
+        const CarlaString base64(CarlaString::asBase64(data, std::strlen(data)));
+        assert(std::strcmp(base64.buffer(), text) == 0);
+        assert(carla_base64EncodedSize(std::strlen(data)) == std::strlen(text));
+
+        const std::vector<uint8_t> chunk(carla_getChunkFromBase64String(text));
+        assert(chunk.size() == std::strlen(data));
+        assert(chunk.size() == 0 || std::memcmp(&chunk.front(), data, chunk.size()) == 0);
+    }
+
+    // whitespace is skipped, padding and anything after it is ignored
+    {
+        const std::vector<uint8_t> chunk(carla_getChunkFromBase64String(" Zm9v\nYm\r\n\tFy\n"));
+        assert(chunk.size() == 6 && std::memcmp(&chunk.front(), "foobar", 6) == 0);
+
+        const std::vector<uint8_t> chunk2(carla_getChunkFromBase64String("Zm9vYg==Zm9v"));
+        assert(chunk2.size() == 4 && std::memcmp(&chunk2.front(), "foob", 4) == 0);
+    }
+}
+
+// -----------------------------------------------------------------------
+// random data, all at once and in pieces, against the previous decoder
+
+static void test_RoundTrip()
+{
+    std::vector<uint8_t> data(4096);
+
+    for (std::size_t size=0; size < data.size(); size = size * 3 / 2 + 1)
+    {
+        for (std::size_t i=0; i < size; ++i)
+            data[i] = getRandomByte();
+
+        const CarlaString base64(CarlaString::asBase64(&data.front(), size));
+        assert(base64.length() == carla_base64EncodedSize(size));
+
+        // decode everything at once
+        const std::vector<uint8_t> chunk(carla_getChunkFromBase64String(base64.buffer()));
+        assert(chunk.size() == size);
+        assert(size == 0 || std::memcmp(&chunk.front(), &data.front(), size) == 0);
+        assert(chunk == getChunkFromBase64StringOld(base64.buffer()));
+
+        // encode in random pieces
+        {
+            CarlaBase64Encoder encoder;
+            std::string text;
+            char buf[carla_base64EncodedSize(64 + 2)];
+
+            for (std::size_t i=0; i < size;)
+            {
+                const std::size_t piece = std::min<std::size_t>(getRandomByte() % 65, size - i);
+                text.append(buf, encoder.encode(&data[i], piece, buf));
+                i += piece;
+            }
+
+            text.append(buf, encoder.finish(buf));
+            assert(text == base64.buffer());
+        }
+
+        // decode in random pieces, with newlines in the middle
+        {
+            std::string text;
+
+            for (std::size_t i=0; i < base64.length(); i += 120)
+            {
+                text.append(base64.buffer() + i, std::min<std::size_t>(120, base64.length() - i));
+                text.append("\n");
+            }
+
+            CarlaBase64Decoder decoder;
+            std::vector<uint8_t> chunk2(carla_base64DecodedMaxSize(text.size()) + 2);
+            std::size_t written = 0;
+
+            for (std::size_t i=0; i < text.size();)
+            {
+                const std::size_t piece = std::min<std::size_t>(getRandomByte() % 65, text.size() - i);
+                written += decoder.decode(text.data() + i, piece, &chunk2.front() + written);
+                i += piece;
+            }
+
+            written += decoder.finish(&chunk2.front() + written);
+            assert(written == size);
+            assert(size == 0 || std::memcmp(&chunk2.front(), &data.front(), size) == 0);
+        }
+    }
+}
+
+// -----------------------------------------------------------------------
+
+static void bench()
+{
+    std::vector<uint8_t> data(kBenchSize);
+
+    for (std::size_t i=0; i < kBenchSize; ++i)
+        data[i] = getRandomByte();
+
+    double start = getTimeInSeconds();
+    const CarlaString base64(CarlaString::asBase64(&data.front(), kBenchSize));
+    const double encodeTime = getTimeInSeconds() - start;
+
+    start = getTimeInSeconds();
+    const std::vector<uint8_t> chunk(carla_getChunkFromBase64String(base64.buffer()));
+    const double decodeTime = getTimeInSeconds() - start;
+
+    start = getTimeInSeconds();
+    const std::vector<uint8_t> chunkOld(getChunkFromBase64StringOld(base64.buffer()));
+    const double decodeTimeOld = getTimeInSeconds() - start;
+
+    assert(chunk == data);
+    assert(chunkOld == data);
+
+    const double mbytes = static_cast<double>(kBenchSize) / (1024.0 * 1024.0);
+
+    carla_stdout("encode         %8.1f MiB/s", mbytes / encodeTime);
+    carla_stdout("decode         %8.1f MiB/s", mbytes / decodeTime);
+    carla_stdout("decode (old)   %8.1f MiB/s", mbytes / decodeTimeOld);
+}
+
+// -----------------------------------------------------------------------
+
+int main()
+{
+    test_Vectors();
+    test_RoundTrip();
+    bench();
+
+    return 0;
+}
+
+// -----------------------------------------------------------------------
@@ -0,0 +1,214 @@
+/*
+ * Carla FluidSynth Utils Tests
+ * Copyright (C) 2018 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the doc/GPL.txt file.
+ */
+
+#ifdef NDEBUG
+# error Build this file with debug ON please
+#endif
+
+#include "CarlaFluidSynthUtils.hpp"
+#include "CarlaThread.hpp"
+
+// any SoundFont with at least one preset, can be changed with the first argument
+static const char* const kDefaultSoundFont = "/usr/share/sounds/sf2/FluidR3_GM.sf2";
+
+static const int kBufferSize = 256;
+
+// -----------------------------------------------------------------------
+
+static fluid_synth_t* createSynth(fluid_settings_t* const settings, FluidSoundFontCache& cache)
+{
+    fluid_synth_t* const synth = new_fluid_synth(settings);
+    assert(synth != nullptr);
+
+    cache.addLoaderToSynth(synth);
+    return synth;
+}
+
+static uint countPresets(fluid_sfont_t* const sfont)
+{
+    fluid_preset_t preset;
+    uint count = 0;
+
+    sfont->iteration_start(sfont);
+
+    for (; sfont->iteration_next(sfont, &preset);)
+    {
+        // presets handed out by the cache always point back to the synth's own sfont
+        assert(preset.sfont == sfont);
+        assert(preset.get_name(&preset) != nullptr);
+        ++count;
+    }
+
+    return count;
+}
+
+// -----------------------------------------------------------------------
+// renders a synth the way the plugin does on the audio thread, meant to run next to others sharing its SoundFont
+
+class RenderThread : public CarlaThread
+{
+public:
+    RenderThread(fluid_synth_t* const synth, const uint sfontId, const int bank, const int prog) noexcept
+        : CarlaThread("RenderThread"),
+          fSynth(synth),
+          fSfontId(sfontId),
+          fBank(bank),
+          fProg(prog),
+          fPeak(0.0f),
+          fBlocks(0) {}
+
+    float getPeak() const noexcept
+    {
+        return fPeak;
+    }
+
+    uint getBlocks() const noexcept
+    {
+        return fBlocks;
+    }
+
+protected:
+    void run() override
+    {
+        float outL[kBufferSize], outR[kBufferSize];
+
+        for (uint i=0; ! shouldThreadExit(); ++i, ++fBlocks)
+        {
+            const int chan = static_cast<int>(i % MAX_MIDI_CHANNELS);
+            const int key  = 36 + static_cast<int>(i % 48);
+
+            // program changes look up presets from the shared SoundFont too
+            if (i % 64 == 0)
+                fluid_synth_program_select(fSynth, chan, fSfontId, static_cast<uint>(fBank), static_cast<uint>(fProg));
+
+            fluid_synth_noteon(fSynth, chan, key, 100);
+            fluid_synth_write_float(fSynth, kBufferSize, outL, 0, 1, outR, 0, 1);
+            fluid_synth_noteoff(fSynth, chan, key);
+
+            for (int j=0; j < kBufferSize; ++j)
+            {
+                if (outL[j] > fPeak)
+                    fPeak = outL[j];
+                else if (-outL[j] > fPeak)
+                    fPeak = -outL[j];
+            }
+        }
+
+        // let all voices finish
+        for (int i=0; i < MAX_MIDI_CHANNELS; ++i)
+            fluid_synth_all_sounds_off(fSynth, i);
+
+        fluid_synth_write_float(fSynth, kBufferSize, outL, 0, 1, outR, 0, 1);
+    }
+
+private:
+    fluid_synth_t* const fSynth;
+    const uint fSfontId;
+    const int fBank, fProg;
+    float fPeak;
+    uint fBlocks;
+};
+
+// -----------------------------------------------------------------------
+
+int main(int argc, char* argv[])
+{
+    const char* const filename = (argc > 1) ? argv[1] : kDefaultSoundFont;
+
+    FluidSoundFontCache cache;
+
+    fluid_settings_t* const settings = new_fluid_settings();
+    assert(settings != nullptr);
+
+    fluid_settings_setint(settings, "synth.threadsafe-api", 0);
+
+    // two synths loading the same file share a single copy of it
+    fluid_synth_t* const synth1 = createSynth(settings, cache);
+    fluid_synth_t* const synth2 = createSynth(settings, cache);
+
+    const int id1 = fluid_synth_sfload(synth1, filename, 0);
+    const int id2 = fluid_synth_sfload(synth2, filename, 0);
+    assert(id1 >= 0 && id2 >= 0);
+
+    fluid_sfont_t* const sfont1 = fluid_synth_get_sfont_by_id(synth1, static_cast<uint>(id1));
+    fluid_sfont_t* const sfont2 = fluid_synth_get_sfont_by_id(synth2, static_cast<uint>(id2));
+    assert(sfont1 != nullptr && sfont2 != nullptr);
+    assert(sfont1 != sfont2);
+    assert(sfont1->get_name(sfont1) == sfont2->get_name(sfont2));
+
+    // each synth iterates on its own
+    const uint presetCount = countPresets(sfont1);
+    assert(presetCount > 0);
+
+    sfont2->iteration_start(sfont2);
+    assert(countPresets(sfont1) == presetCount);
+
+    fluid_preset_t firstPreset;
+    assert(sfont2->iteration_next(sfont2, &firstPreset) == 1);
+    assert(firstPreset.sfont == sfont2);
+
+    const int bank = firstPreset.get_banknum(&firstPreset);
+    const int prog = firstPreset.get_num(&firstPreset);
+
+    // render both at the same time, while a third synth loads and iterates the same SoundFont
+    RenderThread render1(synth1, static_cast<uint>(id1), bank, prog);
+    RenderThread render2(synth2, static_cast<uint>(id2), bank, prog);
+
+    assert(render1.startThread());
+    assert(render2.startThread());
+
+    for (int i=0; i < 50; ++i)
+    {
+        fluid_synth_t* const synth3 = createSynth(settings, cache);
+
+        const int id3 = fluid_synth_sfload(synth3, filename, 0);
+        assert(id3 >= 0);
+
+        fluid_sfont_t* const sfont3 = fluid_synth_get_sfont_by_id(synth3, static_cast<uint>(id3));
+        assert(sfont3 != nullptr);
+        assert(sfont3->get_name(sfont3) == sfont1->get_name(sfont1));
+        assert(countPresets(sfont3) == presetCount);
+
+        delete_fluid_synth(synth3);
+        carla_msleep(2);
+    }
+
+    assert(render1.stopThread(-1));
+    assert(render2.stopThread(-1));
+
+    assert(render1.getBlocks() > 0 && render2.getBlocks() > 0);
+    assert(render1.getPeak() > 0.0f);
+    assert(render2.getPeak() > 0.0f);
+
+    carla_stdout("rendered %u and %u blocks from %u presets", render1.getBlocks(), render2.getBlocks(), presetCount);
+
+    // the shared copy stays until the last synth using it is gone
+    delete_fluid_synth(synth1);
+    assert(sfont2->get_name(sfont2) != nullptr);
+    assert(countPresets(sfont2) == presetCount);
+    delete_fluid_synth(synth2);
+
+    // and gets loaded again afterwards
+    fluid_synth_t* const synth4 = createSynth(settings, cache);
+    assert(fluid_synth_sfload(synth4, filename, 0) >= 0);
+    delete_fluid_synth(synth4);
+
+    delete_fluid_settings(settings);
+    return 0;
+}
+
+// -----------------------------------------------------------------------
@@ -0,0 +1,300 @@
+/*
+ * CarlaLockFreeQueue Tests and Benchmark
+ * Copyright (C) 2018 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the doc/GPL.txt file.
+ */
+
+#include "CarlaLockFreeQueue.hpp"
+#include "CarlaMutex.hpp"
+
+#include <ctime>
+#include <pthread.h>
+#include <sched.h>
+
+// -----------------------------------------------------------------------
+
+static const uint32_t kQueueSize    = 256;
+static const uint32_t kStressItems  = 1000000;
+static const uint32_t kProducers    = 4;
+static const uint32_t kBenchItems   = 2000000;
+
+struct Item {
+    uint32_t producer;
+    uint32_t seq;
+};
+
+typedef CarlaSpscQueue<Item, kQueueSize> SpscQueue;
+typedef CarlaMpscQueue<Item, kQueueSize> MpscQueue;
+
+static double getTimeInSeconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec) / 1000000000.0;
+}
+
+// -----------------------------------------------------------------------
+// single thread, fill up, overflow and wrap around
+
+template<class Queue>
+static void test_Basic()
+{
+    Queue* const queue(new Queue());
+    Item item = { 0, 0 };
+
+    assert(queue->isEmpty());
+    assert(! queue->get(item));
+    assert(queue->takeOverflowCount() == 0);
+
+    for (uint32_t round=0; round < 10; ++round)
+    {
+        for (uint32_t i=0; i < kQueueSize; ++i)
+        {
+            item.seq = round * kQueueSize + i;
+            assert(queue->put(item));
+        }
+
+        assert(! queue->isEmpty());
+        assert(! queue->put(item));
+        assert(! queue->put(item));
+        assert(queue->takeOverflowCount() == 2);
+        assert(queue->takeOverflowCount() == 0);
+
+        for (uint32_t i=0; i < kQueueSize; ++i)
+        {
+            assert(queue->get(item));
+            assert(item.seq == round * kQueueSize + i);
+        }
+
+        assert(queue->isEmpty());
+        assert(! queue->get(item));
+    }
+
+    // interleaved, so indexes go around many times with few items in
+    for (uint32_t i=0; i < kQueueSize * 1000; ++i)
+    {
+        item.seq = i;
+        assert(queue->put(item));
+        assert(queue->put(item));
+        assert(queue->get(item) && item.seq == i);
+        assert(queue->get(item) && item.seq == i);
+    }
+
+    assert(queue->isEmpty());
+    delete queue;
+}
+
+// -----------------------------------------------------------------------
+// threaded stress tests
+
+struct ProducerArgs {
+    void* queue;
+    uint32_t producer;
+    uint32_t count;
+    bool retry;
+    int done;
+};
+
+template<class Queue>
+static void* producerThread(void* const ptr)
+{
+    ProducerArgs& args(*static_cast<ProducerArgs*>(ptr));
+    Queue* const queue(static_cast<Queue*>(args.queue));
+
+    Item item = { args.producer, 0 };
+
+    for (uint32_t i=0; i < args.count; ++i)
+    {
+        item.seq = i;
+
+        while (! queue->put(item))
+        {
+            if (! args.retry)
+                break;
+            sched_yield();
+        }
+    }
+
+    __atomic_store_n(&args.done, 1, __ATOMIC_RELEASE);
+    return nullptr;
+}
+
+// the consumer runs on the main thread, checks that each producer's items arrive in order
+template<class Queue>
+static void runStress(const uint32_t numProducers, const bool retry)
+{
+    Queue* const queue(new Queue());
+
+    pthread_t threads[kProducers];
+    ProducerArgs args[kProducers];
+    uint32_t nextSeq[kProducers];
+    uint32_t received = 0;
+
+    for (uint32_t p=0; p < numProducers; ++p)
+    {
+        args[p].queue    = queue;
+        args[p].producer = p;
+        args[p].count    = kStressItems / numProducers;
+        args[p].retry    = retry;
+        args[p].done     = 0;
+        nextSeq[p]       = 0;
+
+        const int ret = pthread_create(&threads[p], nullptr, producerThread<Queue>, &args[p]);
+        assert(ret == 0);
+    }
+
+    Item item;
+    bool producersDone = false;
+
+    for (;;)
+    {
+        if (queue->get(item))
+        {
+            assert(item.producer < numProducers);
+
+            if (retry)
+                assert(item.seq == nextSeq[item.producer]);
+            else
+                assert(item.seq >= nextSeq[item.producer]);
+
+            nextSeq[item.producer] = item.seq + 1;
+            ++received;
+            continue;
+        }
+
+        if (producersDone)
+            break;
+
+        // check if all producers are finished, then drain what's left
+        producersDone = true;
+
+        for (uint32_t p=0; p < numProducers; ++p)
+        {
+            if (__atomic_load_n(&args[p].done, __ATOMIC_ACQUIRE) == 0)
+                producersDone = false;
+        }
+
+        if (! producersDone)
+        {
+            sched_yield();
+            continue;
+        }
+
+        for (uint32_t p=0; p < numProducers; ++p)
+            pthread_join(threads[p], nullptr);
+    }
+
+    const uint32_t overflows = queue->takeOverflowCount();
+    const uint32_t sent = (kStressItems / numProducers) * numProducers;
+
+    assert(queue->isEmpty());
+
+    // when retrying, overflows are counted too, but every item gets in eventually
+    if (retry)
+        assert(received == sent);
+    else
+        assert(received + overflows == sent);
+
+    carla_stdout("%u producer(s), %s: %u items received, %u overflows",
+                 numProducers, retry ? "retrying" : "dropping", received, overflows);
+
+    delete queue;
+}
+
+// -----------------------------------------------------------------------
+// benchmark, one producer and one consumer, against a mutex protected array
+
+struct MutexQueue {
+    CarlaMutex mutex;
+    Item items[kQueueSize];
+    uint32_t head, tail;
+
+    MutexQueue() noexcept
+        : mutex(), head(0), tail(0) {}
+
+    bool put(const Item& item) noexcept
+    {
+        const CarlaMutexLocker cml(mutex);
+
+        if (tail - head >= kQueueSize)
+            return false;
+
+        items[tail++ % kQueueSize] = item;
+        return true;
+    }
+
+    bool get(Item& item) noexcept
+    {
+        const CarlaMutexLocker cml(mutex);
+
+        if (head == tail)
+            return false;
+
+        item = items[head++ % kQueueSize];
+        return true;
+    }
+};
+
+template<class Queue>
+static void bench(const char* const name)
+{
+    Queue* const queue(new Queue());
+
+    pthread_t thread;
+    ProducerArgs args = { queue, 0, kBenchItems, true, 0 };
+
+    const double start = getTimeInSeconds();
+
+    const int ret = pthread_create(&thread, nullptr, producerThread<Queue>, &args);
+    assert(ret == 0);
+
+    Item item;
+
+    for (uint32_t received = 0; received < kBenchItems;)
+    {
+        if (queue->get(item))
+            ++received;
+        else
+            sched_yield();
+    }
+
+    pthread_join(thread, nullptr);
+
+    carla_stdout("%-6s %8.2f ns/item", name,
+                 (getTimeInSeconds() - start) * 1000000000.0 / static_cast<double>(kBenchItems));
+
+    delete queue;
+}
+
+// -----------------------------------------------------------------------
+
+int main()
+{
+    test_Basic<SpscQueue>();
+    test_Basic<MpscQueue>();
+
+    runStress<SpscQueue>(1, true);
+    runStress<SpscQueue>(1, false);
+    runStress<MpscQueue>(1, true);
+    runStress<MpscQueue>(kProducers, true);
+    runStress<MpscQueue>(kProducers, false);
+
+    bench<SpscQueue>("spsc");
+    bench<MpscQueue>("mpsc");
+    bench<MutexQueue>("mutex");
+
+    return 0;
+}
+
+// -----------------------------------------------------------------------
@@ -0,0 +1,207 @@
+/*
+ * CarlaMathUtils Tests and Benchmark
+ * Copyright (C) 2018 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the doc/GPL.txt file.
+ */
+
+#include "CarlaMathUtils.hpp"
+
+#include <ctime>
+
+// -----------------------------------------------------------------------
+
+static const std::size_t kMaxFrames  = 4096+7;
+static const std::size_t kBenchLoops = 20000;
+
+static float gBufA[kMaxFrames+1];
+static float gBufB[kMaxFrames+1];
+static float gBufC[kMaxFrames+1];
+static float gRefA[kMaxFrames+1];
+static float gRefB[kMaxFrames+1];
+
+static void fillBuffers()
+{
+    for (std::size_t i=0; i<=kMaxFrames; ++i)
+    {
+        gBufA[i] = std::sin(static_cast<float>(i) * 0.01f) * 0.9f;
+        gBufB[i] = std::cos(static_cast<float>(i) * 0.03f) * 1.3f;
+        gBufC[i] = static_cast<float>(i % 17) / 8.0f - 1.0f;
+    }
+
+    // peak in the middle, not a multiple of any vector size
+    gBufC[kMaxFrames/2+3] = -1.75f;
+}
+
+static bool isClose(const float* a, const float* b, const std::size_t count)
+{
+    for (std::size_t i=0; i<count; ++i)
+    {
+        if (std::abs(a[i] - b[i]) > 1e-6f)
+            return false;
+    }
+
+    return true;
+}
+
+// -----------------------------------------------------------------------
+// check every kernel against the scalar version, using odd sizes and unaligned pointers
+
+static void test_FloatKernels(const CarlaFloatKernels& k)
+{
+    const CarlaFloatKernels& ref(*carla_getScalarFloatKernels());
+
+    static const std::size_t sizes[] = { 0, 1, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 64, 127, 1024, kMaxFrames };
+
+    for (std::size_t s=0; s < sizeof(sizes)/sizeof(sizes[0]); ++s)
+    {
+        for (std::size_t offset=0; offset<2; ++offset)
+        {
+            const std::size_t count = sizes[s];
+
+            if (count+offset > kMaxFrames+1)
+                continue;
+
+            float* const a = gBufA + offset;
+            float* const b = gBufB + offset;
+            float* const c = gBufC + offset;
+            float* const ra = gRefA + offset;
+            float* const rb = gRefB + offset;
+
+            fillBuffers();
+            std::memcpy(gRefA, gBufA, sizeof(gBufA));
+            k.add(a, b, count);
+            ref.add(ra, b, count);
+            assert(isClose(a, ra, count));
+
+            fillBuffers();
+            std::memcpy(gRefA, gBufA, sizeof(gBufA));
+            k.addWithGain(a, b, 0.7f, count);
+            ref.addWithGain(ra, b, 0.7f, count);
+            assert(isClose(a, ra, count));
+
+            fillBuffers();
+            k.copyWithGain(a, c, 0.3f, count);
+            ref.copyWithGain(ra, c, 0.3f, count);
+            assert(isClose(a, ra, count));
+
+            fillBuffers();
+            std::memcpy(gRefA, gBufA, sizeof(gBufA));
+            k.multiply(a, 0.5f, count);
+            ref.multiply(ra, 0.5f, count);
+            assert(isClose(a, ra, count));
+
+            fillBuffers();
+            assert(carla_isEqual(k.findMaxAbs(c, count), ref.findMaxAbs(c, count)));
+            assert(carla_isEqual(k.findMaxAbs(b, count), ref.findMaxAbs(b, count)));
+
+            fillBuffers();
+            std::memcpy(gRefA, gBufA, sizeof(gBufA));
+            k.mixDryWet(a, b, 0.25f, count);
+            ref.mixDryWet(ra, b, 0.25f, count);
+            assert(isClose(a, ra, count));
+
+            fillBuffers();
+            std::memcpy(gRefA, gBufA, sizeof(gBufA));
+            std::memcpy(gRefB, gBufB, sizeof(gBufB));
+            k.applyStereoBalance(a, b, 0.2f, 0.9f, count);
+            ref.applyStereoBalance(ra, rb, 0.2f, 0.9f, count);
+            assert(isClose(a, ra, count));
+            assert(isClose(b, rb, count));
+        }
+    }
+
+    // peak of a silent buffer
+    carla_zeroFloats(gBufA, kMaxFrames);
+    assert(carla_isZero(k.findMaxAbs(gBufA, kMaxFrames)));
+}
+
+// -----------------------------------------------------------------------
+// benchmark, using a typical period size
+
+static double getTimeInSeconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec) / 1000000000.0;
+}
+
+static volatile float gSink = 0.0f;
+
+static void bench_FloatKernels(const CarlaFloatKernels& k, const std::size_t frames)
+{
+    fillBuffers();
+
+    double start;
+    float peak = 0.0f;
+
+#define BENCH(NAME, CODE)                                                               \
+    start = getTimeInSeconds();                                                         \
+    for (std::size_t i=0; i<kBenchLoops; ++i) { CODE; }                                 \
+    carla_stdout("%-6s %-20s %8.2f ns/block", k.name, NAME,                             \
+                 (getTimeInSeconds() - start) * 1000000000.0 / static_cast<double>(kBenchLoops));
+
+    BENCH("add",                k.add(gBufA, gBufB, frames))
+    BENCH("addWithGain",        k.addWithGain(gBufA, gBufB, 0.5f, frames))
+    BENCH("copyWithGain",       k.copyWithGain(gBufA, gBufB, 0.5f, frames))
+    BENCH("multiply",           k.multiply(gBufA, 0.999f, frames))
+    BENCH("findMaxAbs",         peak += k.findMaxAbs(gBufB, frames))
+    BENCH("mixDryWet",          k.mixDryWet(gBufA, gBufB, 0.5f, frames))
+    BENCH("applyStereoBalance", k.applyStereoBalance(gBufA, gBufB, 0.0f, 1.0f, frames))
+
+#undef BENCH
+
+    gSink = peak + gBufA[0];
+}
+
+// -----------------------------------------------------------------------
+
+int main()
+{
+    const CarlaFloatKernels* const kernels[] = {
+        carla_getScalarFloatKernels(),
+        carla_getSSE2FloatKernels(),
+        carla_getAVXFloatKernels(),
+        carla_getNeonFloatKernels(),
+    };
+
+    carla_stdout("Using '%s' float kernels", carla_getFloatKernels().name);
+
+    for (std::size_t i=0; i < sizeof(kernels)/sizeof(kernels[0]); ++i)
+    {
+        if (kernels[i] != nullptr)
+            test_FloatKernels(*kernels[i]);
+    }
+
+    // public API
+    fillBuffers();
+    assert(carla_isEqual(carla_findMaxNormalizedFloat(gBufC, kMaxFrames), 1.0f));
+    assert(carla_isEqual(carla_findMaxNormalizedFloat(gBufA, 64), std::abs(gBufA[63])));
+
+    static const std::size_t frameSizes[] = { 64, 256, 1024 };
+
+    for (std::size_t f=0; f < sizeof(frameSizes)/sizeof(frameSizes[0]); ++f)
+    {
+        carla_stdout("-- %u frames", static_cast<uint>(frameSizes[f]));
+
+        for (std::size_t i=0; i < sizeof(kernels)/sizeof(kernels[0]); ++i)
+        {
+            if (kernels[i] != nullptr)
+                bench_FloatKernels(*kernels[i], frameSizes[f]);
+        }
+    }
+
+    return 0;
+}
+
+// -----------------------------------------------------------------------
@@ -0,0 +1,195 @@
+/*
+ * CarlaPostProcUtils Tests
+ * Copyright (C) 2018 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the doc/GPL.txt file.
+ */
+
+#include "CarlaPostProcUtils.hpp"
+
+#include <cstring>
+
+// -----------------------------------------------------------------------
+
+static const uint32_t kFrames   = 67;
+static const uint32_t kChannels = 2;
+
+static float gIn[kChannels][kFrames];
+static float gLatency[kChannels][kFrames];
+static float gProcessed[kChannels][kFrames];
+
+static void fillBuffers()
+{
+    for (uint32_t c=0; c < kChannels; ++c)
+    {
+        for (uint32_t k=0; k < kFrames; ++k)
+        {
+            gIn[c][k]        = std::sin(static_cast<float>(k + c * 7) * 0.05f) * 0.8f;
+            gLatency[c][k]   = std::cos(static_cast<float>(k + c * 3) * 0.11f) * 0.6f;
+            gProcessed[c][k] = static_cast<float>((k * (c + 3)) % 19) / 9.0f - 1.0f;
+        }
+    }
+}
+
+// -----------------------------------------------------------------------
+// the per-channel post-processing that every plugin type used to have
+
+static void referencePostProcess(float* const* const outBuffers, float* const* const audioOut,
+                                 const uint32_t numIns, const uint32_t numOuts,
+                                 const uint32_t latencyFrames, const uint32_t frames,
+                                 const CarlaPostProcValues& v)
+{
+    const bool doDryWet  = carla_isNotEqual(v.dryWet, 1.0f);
+    const bool doBalance = ! (carla_isEqual(v.balanceLeft, -1.0f) && carla_isEqual(v.balanceRight, 1.0f));
+    const bool isMono    = (numIns == 1);
+
+    bool isPair;
+    float bufValue, oldBufLeft[kFrames];
+
+    for (uint32_t i=0; i < numOuts; ++i)
+    {
+        // Dry/Wet
+        if (doDryWet)
+        {
+            const uint32_t c = isMono ? 0 : i;
+
+            for (uint32_t k=0; k < frames; ++k)
+            {
+                if (k < latencyFrames)
+                    bufValue = gLatency[c][k];
+                else if (latencyFrames < frames)
+                    bufValue = gIn[c][k-latencyFrames];
+                else
+                    bufValue = gIn[c][k];
+
+                outBuffers[i][k] = (outBuffers[i][k] * v.dryWet) + (bufValue * (1.0f - v.dryWet));
+            }
+        }
+
+        // Balance
+        if (doBalance)
+        {
+            isPair = (i % 2 == 0);
+
+            if (isPair)
+                carla_copyFloats(oldBufLeft, outBuffers[i], frames);
+
+            const float balRangeL = (v.balanceLeft  + 1.0f)/2.0f;
+            const float balRangeR = (v.balanceRight + 1.0f)/2.0f;
+
+            for (uint32_t k=0; k < frames; ++k)
+            {
+                if (isPair)
+                {
+                    // left
+                    outBuffers[i][k]  = oldBufLeft[k]        * (1.0f - balRangeL);
+                    outBuffers[i][k] += outBuffers[i+1][k] * (1.0f - balRangeR);
+                }
+                else
+                {
+                    // right
+                    outBuffers[i][k]  = outBuffers[i][k] * balRangeR;
+                    outBuffers[i][k] += oldBufLeft[k]    * balRangeL;
+                }
+            }
+        }
+
+        // Volume (and buffer copy)
+        for (uint32_t k=0; k < frames; ++k)
+            audioOut[i][k] = outBuffers[i][k] * v.volume;
+    }
+}
+
+// -----------------------------------------------------------------------
+// constant values must give exactly the same result as before
+
+static void test_SameAsPerChannel(const uint32_t numIns, const uint32_t latencyFrames, const CarlaPostProcValues& v)
+{
+    float refBufs[kChannels][kFrames], newBufs[kChannels][kFrames];
+    float refOut[kChannels][kFrames],  newOut[kChannels][kFrames];
+
+    std::memcpy(refBufs, gProcessed, sizeof(gProcessed));
+    std::memcpy(newBufs, gProcessed, sizeof(gProcessed));
+
+    float* const refBufPtrs[kChannels] = { refBufs[0], refBufs[1] };
+    float* const newBufPtrs[kChannels] = { newBufs[0], newBufs[1] };
+    float* const refOutPtrs[kChannels] = { refOut[0],  refOut[1]  };
+    float* const newOutPtrs[kChannels] = { newOut[0],  newOut[1]  };
+    const float* const inPtrs[kChannels]      = { gIn[0],      gIn[1]      };
+    const float* const latencyPtrs[kChannels] = { gLatency[0], gLatency[1] };
+
+    referencePostProcess(refBufPtrs, refOutPtrs, numIns, kChannels, latencyFrames, kFrames, v);
+
+    carla_postProcessAudio(newBufPtrs, 0, kChannels, inPtrs, numIns,
+                           latencyFrames != 0 ? latencyPtrs : nullptr, latencyFrames,
+                           newOutPtrs, 0, kFrames, v, v);
+
+    assert(std::memcmp(refOut, newOut, sizeof(refOut)) == 0);
+}
+
+// -----------------------------------------------------------------------
+// a changed value is ramped from the old one to the new one across the block
+
+static void test_Ramp()
+{
+    float bufs[kChannels][kFrames];
+    std::memcpy(bufs, gProcessed, sizeof(gProcessed));
+
+    float* const bufPtrs[kChannels] = { bufs[0], bufs[1] };
+    const float* const inPtrs[kChannels] = { gIn[0], gIn[1] };
+
+    const CarlaPostProcValues from = { 1.0f, 1.0f, -1.0f, 1.0f };
+    const CarlaPostProcValues to   = { 1.0f, 0.0f, -1.0f, 1.0f };
+
+    carla_postProcessAudio(bufPtrs, 0, kChannels, inPtrs, kChannels, nullptr, 0, nullptr, 0, kFrames, from, to);
+
+    for (uint32_t c=0; c < kChannels; ++c)
+    {
+        assert(carla_isEqual(bufs[c][0], gProcessed[c][0]));
+
+        for (uint32_t k=1; k < kFrames; ++k)
+            assert(std::abs(bufs[c][k]) <= std::abs(gProcessed[c][k]));
+
+        assert(std::abs(bufs[c][kFrames-1]) < 0.05f);
+    }
+}
+
+// -----------------------------------------------------------------------
+
+int main()
+{
+    fillBuffers();
+
+    static const CarlaPostProcValues values[] = {
+        { 1.0f, 1.0f, -1.0f, 1.0f },
+        { 0.7f, 1.0f, -1.0f, 1.0f },
+        { 1.0f, 0.8f, -0.5f, 0.3f },
+        { 0.7f, 0.8f, -0.5f, 0.3f },
+        { 0.0f, 1.3f,  0.2f, 0.9f },
+    };
+
+    for (std::size_t i=0; i < sizeof(values)/sizeof(values[0]); ++i)
+    {
+        for (uint32_t numIns=1; numIns <= kChannels; ++numIns)
+        {
+            test_SameAsPerChannel(numIns, 0, values[i]);
+            test_SameAsPerChannel(numIns, 5, values[i]);
+        }
+    }
+
+    test_Ramp();
+
+    return 0;
+}
+
+// -----------------------------------------------------------------------
@@ -0,0 +1,235 @@
+/*
+ * RtMemPool Tests and Benchmark
+ * Copyright (C) 2018 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the doc/GPL.txt file.
+ */
+
+#include "CarlaUtils.hpp"
+
+extern "C" {
+#include "rtmempool/rtmempool.h"
+}
+
+#include <ctime>
+#include <pthread.h>
+
+// -----------------------------------------------------------------------
+
+static const uint kMaxThreads   = 4;
+static const uint kBlocksPerRun = 8;
+static const uint kStressLoops  = 200000;
+static const uint kBenchLoops   = 200000;
+
+struct Block {
+    uint owner;
+    uint serial;
+    char padding[48];
+};
+
+static double getTimeInSeconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec) / 1000000000.0;
+}
+
+// -----------------------------------------------------------------------
+// single thread, limits and reuse
+
+static void test_Limits()
+{
+    RtMemPool_Handle handle = nullptr;
+    void* blocks[16];
+
+    bool ok = rtsafe_memory_pool_create(&handle, "test", sizeof(Block), 4, 16);
+    assert(ok && handle != nullptr);
+
+    // only what was preallocated is available to atomic allocations
+    for (uint i=0; i < 4; ++i)
+    {
+        blocks[i] = rtsafe_memory_pool_allocate_atomic(handle);
+        assert(blocks[i] != nullptr);
+    }
+
+    assert(rtsafe_memory_pool_allocate_atomic(handle) == nullptr);
+
+    // sleepy ones can grow up to max
+    for (uint i=4; i < 16; ++i)
+    {
+        blocks[i] = rtsafe_memory_pool_allocate_sleepy(handle);
+        assert(blocks[i] != nullptr);
+    }
+
+    assert(rtsafe_memory_pool_allocate_sleepy(handle) == nullptr);
+    assert(rtsafe_memory_pool_allocate_atomic(handle) == nullptr);
+
+    for (uint i=0; i < 16; ++i)
+    {
+        for (uint j=i+1; j < 16; ++j)
+            assert(blocks[i] != blocks[j]);
+
+        assert(reinterpret_cast<uintptr_t>(blocks[i]) % sizeof(void*) == 0);
+        std::memset(blocks[i], 0xff, sizeof(Block));
+    }
+
+    for (uint i=0; i < 16; ++i)
+        rtsafe_memory_pool_deallocate(handle, blocks[i]);
+
+    // everything comes back, nothing new gets created
+    for (uint i=0; i < 16; ++i)
+    {
+        blocks[i] = rtsafe_memory_pool_allocate_atomic(handle);
+        assert(blocks[i] != nullptr);
+    }
+
+    assert(rtsafe_memory_pool_allocate_atomic(handle) == nullptr);
+
+    for (uint i=0; i < 16; ++i)
+        rtsafe_memory_pool_deallocate(handle, blocks[i]);
+
+    rtsafe_memory_pool_destroy(handle);
+
+    // min 0 must still allow sleepy allocations
+    ok = rtsafe_memory_pool_create(&handle, nullptr, sizeof(Block), 0, 2);
+    assert(ok && handle != nullptr);
+    assert(rtsafe_memory_pool_allocate_atomic(handle) == nullptr);
+    blocks[0] = rtsafe_memory_pool_allocate_sleepy(handle);
+    assert(blocks[0] != nullptr);
+    rtsafe_memory_pool_deallocate(handle, blocks[0]);
+    rtsafe_memory_pool_destroy(handle);
+}
+
+// -----------------------------------------------------------------------
+// many threads allocating and freeing from the same pool
+
+struct ThreadArgs {
+    RtMemPool_Handle handle;
+    pthread_mutex_t* mutex;
+    uint owner;
+    uint loops;
+    uint failures;
+};
+
+static void* allocThread(void* const ptr)
+{
+    ThreadArgs& args(*static_cast<ThreadArgs*>(ptr));
+    Block* blocks[kBlocksPerRun];
+
+    for (uint i=0; i < args.loops; ++i)
+    {
+        for (uint j=0; j < kBlocksPerRun; ++j)
+        {
+            if (args.mutex != nullptr)
+                pthread_mutex_lock(args.mutex);
+
+            blocks[j] = static_cast<Block*>(rtsafe_memory_pool_allocate_atomic(args.handle));
+
+            if (args.mutex != nullptr)
+                pthread_mutex_unlock(args.mutex);
+
+            if (blocks[j] == nullptr)
+            {
+                ++args.failures;
+                continue;
+            }
+
+            blocks[j]->owner  = args.owner;
+            blocks[j]->serial = i;
+        }
+
+        for (uint j=0; j < kBlocksPerRun; ++j)
+        {
+            if (blocks[j] == nullptr)
+                continue;
+
+            // someone else got the same block?
+            assert(blocks[j]->owner == args.owner && blocks[j]->serial == i);
+
+            if (args.mutex != nullptr)
+                pthread_mutex_lock(args.mutex);
+
+            rtsafe_memory_pool_deallocate(args.handle, blocks[j]);
+
+            if (args.mutex != nullptr)
+                pthread_mutex_unlock(args.mutex);
+        }
+    }
+
+    return nullptr;
+}
+
+// returns nanoseconds per allocate + deallocate pair
+static double runThreads(const uint numThreads, const uint loops, const bool useMutex)
+{
+    RtMemPool_Handle handle = nullptr;
+    pthread_mutex_t mutex;
+    pthread_t threads[kMaxThreads];
+    ThreadArgs args[kMaxThreads];
+
+    // enough for everyone, allocations never fail
+    const bool ok = rtsafe_memory_pool_create(&handle, nullptr, sizeof(Block),
+                                              numThreads * kBlocksPerRun, numThreads * kBlocksPerRun);
+    assert(ok);
+    pthread_mutex_init(&mutex, nullptr);
+
+    const double start = getTimeInSeconds();
+
+    for (uint i=0; i < numThreads; ++i)
+    {
+        args[i].handle   = handle;
+        args[i].mutex    = useMutex ? &mutex : nullptr;
+        args[i].owner    = i;
+        args[i].loops    = loops;
+        args[i].failures = 0;
+
+        const int ret = pthread_create(&threads[i], nullptr, allocThread, &args[i]);
+        assert(ret == 0);
+    }
+
+    for (uint i=0; i < numThreads; ++i)
+    {
+        pthread_join(threads[i], nullptr);
+        assert(args[i].failures == 0);
+    }
+
+    const double elapsed = getTimeInSeconds() - start;
+
+    pthread_mutex_destroy(&mutex);
+    rtsafe_memory_pool_destroy(handle);
+
+    return elapsed * 1000000000.0 / static_cast<double>(numThreads * loops * kBlocksPerRun);
+}
+
+// -----------------------------------------------------------------------
+
+int main()
+{
+    test_Limits();
+
+    for (uint t=1; t <= kMaxThreads; t *= 2)
+        runThreads(t, kStressLoops, false);
+
+    carla_stdout("threads  lock-free  mutex (ns per alloc+free)");
+
+    for (uint t=1; t <= kMaxThreads; t *= 2)
+    {
+        const double lockFree = runThreads(t, kBenchLoops, false);
+        const double mutex    = runThreads(t, kBenchLoops, true);
+        carla_stdout("%7u  %9.2f  %5.2f", t, lockFree, mutex);
+    }
+
+    return 0;
+}
+
+// -----------------------------------------------------------------------
@@ -343,6 +343,14 @@ const char* EngineOption2Str(const EngineOption option) noexcept
 #endif
     case ENGINE_OPTION_DEBUG_CONSOLE_OUTPUT:
         return "ENGINE_OPTION_DEBUG_CONSOLE_OUTPUT";
+    case ENGINE_OPTION_AUDIO_WORKER_THREADS:
+        return "ENGINE_OPTION_AUDIO_WORKER_THREADS";
+    case ENGINE_OPTION_PIPELINED_PLUGIN_BRIDGES:
+        return "ENGINE_OPTION_PIPELINED_PLUGIN_BRIDGES";
+    case ENGINE_OPTION_PLUGIN_BRIDGES_SPIN_TIME:
+        return "ENGINE_OPTION_PLUGIN_BRIDGES_SPIN_TIME";
+    case ENGINE_OPTION_MIN_SUB_BLOCK_SIZE:
+        return "ENGINE_OPTION_MIN_SUB_BLOCK_SIZE";
     }
 
     carla_stderr("CarlaBackend::EngineOption2Str(%i) - invalid option", option);
@@ -0,0 +1,285 @@
+/*
+ * Carla Background Work Pool
+ * Copyright (C) 2018 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the doc/GPL.txt file.
+ */
+
+#ifndef CARLA_BACKGROUND_WORK_POOL_HPP_INCLUDED
+#define CARLA_BACKGROUND_WORK_POOL_HPP_INCLUDED
+
+#include "CarlaMutex.hpp"
+#include "CarlaSemUtils.hpp"
+#include "CarlaThread.hpp"
+#include "LinkedList.hpp"
+
+// -----------------------------------------------------------------------
+// Pool of non-realtime threads that run work scheduled from the audio thread.
+//
+// Each client keeps its own lock-free request/response queues, the pool only tells it when to drain them.
+// A client never runs on more than one thread at a time, so its queues can stay single-producer/single-consumer.
+// Threads are started when the first client is added and stopped when the last one is removed.
+
+class CarlaBackgroundWorkPool
+{
+public:
+    static const uint kThreadCount = 2;
+
+    class Client
+    {
+    public:
+        Client() noexcept
+            : fPending(0),
+              fBusy(0) {}
+
+        virtual ~Client() {}
+
+    protected:
+        /*
+         * Process all queued work, called from a pool thread or from tryRunNow().
+         * Never called concurrently for the same client.
+         */
+        virtual void runWork() = 0;
+
+    private:
+        volatile int fPending;
+        volatile int fBusy;
+
+        friend class CarlaBackgroundWorkPool;
+        CARLA_DECLARE_NON_COPY_CLASS(Client)
+    };
+
+    CarlaBackgroundWorkPool() noexcept
+        : fMutex(),
+          fClients(),
+          fWakePending(0)
+    {
+        carla_zeroStruct(fSem);
+        carla_sem_create2(fSem);
+
+        for (uint i=0; i < kThreadCount; ++i)
+            fThreads[i] = nullptr;
+    }
+
+    ~CarlaBackgroundWorkPool() noexcept
+    {
+        CARLA_SAFE_ASSERT(fClients.isEmpty());
+
+        stopThreads();
+        carla_sem_destroy2(fSem);
+    }
+
+    // -------------------------------------------------------------------
+
+    void addClient(Client* const client)
+    {
+        CARLA_SAFE_ASSERT_RETURN(client != nullptr,);
+
+        bool needsStart;
+
+        {
+            const CarlaMutexLocker cml(fMutex);
+
+            needsStart = fClients.isEmpty();
+            fClients.append(client);
+        }
+
+        if (needsStart)
+            startThreads();
+    }
+
+    void removeClient(Client* const client)
+    {
+        CARLA_SAFE_ASSERT_RETURN(client != nullptr,);
+
+        bool needsStop;
+
+        {
+            const CarlaMutexLocker cml(fMutex);
+
+            fClients.removeOne(client);
+            needsStop = fClients.isEmpty();
+        }
+
+        // pool threads only pick clients while holding the lock, just wait for the current run to finish
+        while (client->fBusy != 0)
+            carla_msleep(1);
+
+        if (needsStop)
+            stopThreads();
+    }
+
+    /*
+     * Mark a client as having work queued and wake up a pool thread.
+     * Real-time safe.
+     */
+    void schedule(Client* const client) noexcept
+    {
+        client->fPending = 1;
+        __sync_synchronize();
+
+        wakeUp();
+    }
+
+    /*
+     * Run a client's queued work on the calling thread, unless a pool thread is already doing it.
+     * Used when the audio thread may block, like during offline rendering.
+     */
+    bool tryRunNow(Client* const client) noexcept
+    {
+        if (! __sync_bool_compare_and_swap(&client->fBusy, 0, 1))
+            return false;
+
+        client->fPending = 0;
+        __sync_synchronize();
+
+        try {
+            client->runWork();
+        } CARLA_SAFE_EXCEPTION("CarlaBackgroundWorkPool::tryRunNow");
+
+        __sync_synchronize();
+        client->fBusy = 0;
+
+        // more work might have come in while we were busy
+        if (client->fPending != 0)
+            wakeUp();
+
+        return true;
+    }
+
+private:
+    class WorkerThread : public CarlaThread
+    {
+    public:
+        WorkerThread(CarlaBackgroundWorkPool& pool) noexcept
+            : CarlaThread("CarlaBackgroundWorkPool"),
+              kPool(pool) {}
+
+    protected:
+        void run() override
+        {
+            while (! shouldThreadExit())
+            {
+                if (carla_sem_timedwait(kPool.fSem, 50))
+                {
+                    kPool.fWakePending = 0;
+                    __sync_synchronize();
+                }
+
+                while (! shouldThreadExit() && kPool.runPendingClient()) {}
+            }
+        }
+
+    private:
+        CarlaBackgroundWorkPool& kPool;
+
+        CARLA_DECLARE_NON_COPY_CLASS(WorkerThread)
+    };
+
+    CarlaMutex fMutex;
+    LinkedList<Client*> fClients;
+
+    carla_sem_t   fSem;
+    volatile int  fWakePending;
+    WorkerThread* fThreads[kThreadCount];
+
+    // only post when nobody has yet, futex based semaphores can't count past 1
+    void wakeUp() noexcept
+    {
+        if (__sync_bool_compare_and_swap(&fWakePending, 0, 1))
+            carla_sem_post(fSem);
+    }
+
+    // claim and run one client with pending work, returns false if there was none
+    bool runPendingClient()
+    {
+        Client* client = nullptr;
+        bool morePending = false;
+
+        {
+            const CarlaMutexLocker cml(fMutex);
+
+            for (LinkedList<Client*>::Itenerator it = fClients.begin2(); it.valid(); it.next())
+            {
+                Client* const c(it.getValue(nullptr));
+                CARLA_SAFE_ASSERT_CONTINUE(c != nullptr);
+
+                if (c->fPending == 0)
+                    continue;
+
+                if (client == nullptr && __sync_bool_compare_and_swap(&c->fBusy, 0, 1))
+                    client = c;
+                else
+                    morePending = true;
+            }
+        }
+
+        if (client == nullptr)
+            return false;
+
+        // let another thread take care of the rest
+        if (morePending)
+            wakeUp();
+
+        client->fPending = 0;
+        __sync_synchronize();
+
+        try {
+            client->runWork();
+        } CARLA_SAFE_EXCEPTION("CarlaBackgroundWorkPool::runPendingClient");
+
+        __sync_synchronize();
+        client->fBusy = 0;
+        return true;
+    }
+
+    void startThreads()
+    {
+        for (uint i=0; i < kThreadCount; ++i)
+        {
+            if (fThreads[i] == nullptr)
+            {
+                try {
+                    fThreads[i] = new WorkerThread(*this);
+                } CARLA_SAFE_EXCEPTION_CONTINUE("CarlaBackgroundWorkPool::startThreads");
+            }
+
+            fThreads[i]->startThread();
+        }
+    }
+
+    void stopThreads() noexcept
+    {
+        for (uint i=0; i < kThreadCount; ++i)
+        {
+            if (fThreads[i] != nullptr)
+                fThreads[i]->signalThreadShouldExit();
+        }
+
+        for (uint i=0; i < kThreadCount; ++i)
+        {
+            if (fThreads[i] == nullptr)
+                continue;
+
+            fThreads[i]->stopThread(1000);
+            delete fThreads[i];
+            fThreads[i] = nullptr;
+        }
+    }
+
+    CARLA_DECLARE_NON_COPY_CLASS(CarlaBackgroundWorkPool)
+};
+
+// -----------------------------------------------------------------------
+
+#endif // CARLA_BACKGROUND_WORK_POOL_HPP_INCLUDED
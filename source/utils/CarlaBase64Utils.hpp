@@ -21,7 +21,7 @@
 
 #include "CarlaUtils.hpp"
 
-#include <cctype>
+#include <algorithm>
 #include <vector>
 
 // -----------------------------------------------------------------------
@@ -34,16 +34,46 @@ static const char* const kBase64Chars =
     "abcdefghijklmnopqrstuvwxyz"
     "0123456789+/";
 
+// special values in the decode table, all have the 2 top bits set
+static const uint8_t kBase64Skip    = 0xfd; // whitespace
+static const uint8_t kBase64End     = 0xfe; // padding or null
+static const uint8_t kBase64Invalid = 0xff;
+
+#define SS kBase64Skip
+#define EE kBase64End
+#define II kBase64Invalid
+
+// character to 6-bit value
+static const uint8_t kBase64Values[256] = {
+    EE, II, II, II, II, II, II, II, II, SS, SS, II, II, SS, II, II,
+    II, II, II, II, II, II, II, II, II, II, II, II, II, II, II, II,
+    SS, II, II, II, II, II, II, II, II, II, II, 62, II, II, II, 63,
+    52, 53, 54, 55, 56, 57, 58, 59, 60, 61, II, II, II, EE, II, II,
+    II,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
+    15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, II, II, II, II, II,
+    II, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+    41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, II, II, II, II, II,
+    II, II, II, II, II, II, II, II, II, II, II, II, II, II, II, II,
+    II, II, II, II, II, II, II, II, II, II, II, II, II, II, II, II,
+    II, II, II, II, II, II, II, II, II, II, II, II, II, II, II, II,
+    II, II, II, II, II, II, II, II, II, II, II, II, II, II, II, II,
+    II, II, II, II, II, II, II, II, II, II, II, II, II, II, II, II,
+    II, II, II, II, II, II, II, II, II, II, II, II, II, II, II, II,
+    II, II, II, II, II, II, II, II, II, II, II, II, II, II, II, II,
+    II, II, II, II, II, II, II, II, II, II, II, II, II, II, II, II
+};
+
+#undef SS
+#undef EE
+#undef II
+
 static inline
 uint8_t findBase64CharIndex(const char c)
 {
-    static const uint8_t kBase64CharsLen(static_cast<uint8_t>(std::strlen(kBase64Chars)));
+    const uint8_t value = kBase64Values[static_cast<uint8_t>(c)];
 
-    for (uint8_t i=0; i<kBase64CharsLen; ++i)
-    {
-        if (kBase64Chars[i] == c)
-            return i;
-    }
+    if (value < 64)
+        return value;
 
     carla_stderr2("findBase64CharIndex('%c') - failed", c);
     return 0;
@@ -52,72 +82,331 @@ uint8_t findBase64CharIndex(const char c)
 static inline
 bool isBase64Char(const char c)
 {
-    return (std::isalnum(c) || (c == '+') || (c == '/'));
+    return kBase64Values[static_cast<uint8_t>(c)] < 64;
 }
 
 } // namespace CarlaBase64Helpers
 
 // -----------------------------------------------------------------------
 
+/*
+ * Number of base64 characters needed to encode 'dataSize' bytes, padding included.
+ */
 static inline
-std::vector<uint8_t> carla_getChunkFromBase64String(const char* const base64string)
+std::size_t carla_base64EncodedSize(const std::size_t dataSize) noexcept
 {
-    CARLA_SAFE_ASSERT_RETURN(base64string != nullptr, std::vector<uint8_t>());
+    return (dataSize + 2) / 3 * 4;
+}
 
-    uint i=0, j=0;
-    uint charArray3[3], charArray4[4];
+/*
+ * Maximum number of bytes that can come out of decoding 'textSize' base64 characters.
+ */
+static inline
+std::size_t carla_base64DecodedMaxSize(const std::size_t textSize) noexcept
+{
+    return (textSize + 3) / 4 * 3;
+}
+
+/*
+ * Encode 'dataSize' bytes into 'text', which must have room for carla_base64EncodedSize(dataSize) characters.
+ * The text is padded but not null terminated, returns the number of characters written.
+ */
+static inline
+std::size_t carla_base64Encode(const void* const data, const std::size_t dataSize, char* const text) noexcept
+{
+    const char* const kBase64Chars = CarlaBase64Helpers::kBase64Chars;
 
-    std::vector<uint8_t> ret;
-    ret.reserve(std::strlen(base64string)*3/4 + 4);
+    const uint8_t* in = static_cast<const uint8_t*>(data);
+    char* out = text;
+    std::size_t left = dataSize;
 
-    for (std::size_t l=0, len=std::strlen(base64string); l<len; ++l)
+    for (; left >= 3; left -= 3, in += 3, out += 4)
     {
-        const char c = base64string[l];
+        const uint32_t bits = (static_cast<uint32_t>(in[0]) << 16) | (static_cast<uint32_t>(in[1]) << 8) | in[2];
 
-        if (c == '\0' || c == '=')
-            break;
-        if (c == ' ' || c == '\n')
-            continue;
+        out[0] = kBase64Chars[bits >> 18];
+        out[1] = kBase64Chars[(bits >> 12) & 0x3f];
+        out[2] = kBase64Chars[(bits >> 6) & 0x3f];
+        out[3] = kBase64Chars[bits & 0x3f];
+    }
+
+    if (left != 0)
+    {
+        const uint32_t bits = (static_cast<uint32_t>(in[0]) << 16) | (left == 2 ? static_cast<uint32_t>(in[1]) << 8 : 0);
+
+        out[0] = kBase64Chars[bits >> 18];
+        out[1] = kBase64Chars[(bits >> 12) & 0x3f];
+        out[2] = left == 2 ? kBase64Chars[(bits >> 6) & 0x3f] : '=';
+        out[3] = '=';
+        out += 4;
+    }
+
+    return static_cast<std::size_t>(out - text);
+}
+
+// -----------------------------------------------------------------------
+// Streaming encoder, for data that arrives (or needs to be written out) in pieces.
+// Up to 2 bytes are kept between calls, so the output matches encoding everything at once.
+
+class CarlaBase64Encoder
+{
+public:
+    CarlaBase64Encoder() noexcept
+        : fPendingSize(0)
+    {
+        fPending[0] = fPending[1] = 0;
+    }
+
+    /*
+     * Encode the next 'dataSize' bytes.
+     * 'text' must have room for carla_base64EncodedSize(dataSize + 2) characters, returns the number written.
+     */
+    std::size_t encode(const void* const data, std::size_t dataSize, char* const text) noexcept
+    {
+        const uint8_t* in = static_cast<const uint8_t*>(data);
+        std::size_t written = 0;
+
+        if (fPendingSize != 0)
+        {
+            uint8_t group[3] = { fPending[0], fPending[1], 0 };
+
+            for (; fPendingSize < 3 && dataSize != 0; --dataSize)
+                group[fPendingSize++] = *in++;
+
+            if (fPendingSize < 3)
+            {
+                fPending[0] = group[0];
+                fPending[1] = group[1];
+                return 0;
+            }
+
+            written = carla_base64Encode(group, 3, text);
+        }
+
+        const std::size_t rest = dataSize % 3;
+
+        written += carla_base64Encode(in, dataSize - rest, text + written);
+
+        for (fPendingSize = 0; fPendingSize < rest; ++fPendingSize)
+            fPending[fPendingSize] = in[dataSize - rest + fPendingSize];
+
+        return written;
+    }
+
+    /*
+     * Encode what is left and reset, 'text' must have room for 4 characters.
+     */
+    std::size_t finish(char* const text) noexcept
+    {
+        const std::size_t written = carla_base64Encode(fPending, fPendingSize, text);
+        fPendingSize = 0;
+        return written;
+    }
+
+private:
+    uint8_t fPending[2];
+    std::size_t fPendingSize;
+
+    CARLA_DECLARE_NON_COPY_CLASS(CarlaBase64Encoder)
+};
+
+// -----------------------------------------------------------------------
+// Streaming decoder, the counterpart of the above.
+// Whitespace is skipped, padding or a null character ends the data, invalid characters are reported and skipped.
+
+class CarlaBase64Decoder
+{
+public:
+    CarlaBase64Decoder() noexcept
+        : fBits(0),
+          fCount(0),
+          fFinished(false) {}
 
-         CARLA_SAFE_ASSERT_CONTINUE(CarlaBase64Helpers::isBase64Char(c));
+    /*
+     * Decode the next 'textSize' characters.
+     * 'data' must have room for carla_base64DecodedMaxSize(textSize) bytes, returns the number written.
+     */
+    std::size_t decode(const char* const text, const std::size_t textSize, uint8_t* const data) noexcept
+    {
+        const uint8_t* const kBase64Values = CarlaBase64Helpers::kBase64Values;
 
-        charArray4[i++] = static_cast<uint>(c);
+        uint8_t* out = data;
+        std::size_t i = 0;
 
-        if (i == 4)
+        if (fFinished)
+            return 0;
+
+        for (;;)
         {
-            for (i=0; i<4; ++i)
-                charArray4[i] = CarlaBase64Helpers::findBase64CharIndex(static_cast<char>(charArray4[i]));
+            // fast path, whole groups of valid characters
+            if (fCount == 0)
+            {
+                for (; i + 4 <= textSize; i += 4, out += 3)
+                {
+                    const uint32_t v0 = kBase64Values[static_cast<uint8_t>(text[i])];
+                    const uint32_t v1 = kBase64Values[static_cast<uint8_t>(text[i+1])];
+                    const uint32_t v2 = kBase64Values[static_cast<uint8_t>(text[i+2])];
+                    const uint32_t v3 = kBase64Values[static_cast<uint8_t>(text[i+3])];
+
+                    if ((v0 | v1 | v2 | v3) & 0xc0)
+                        break;
+
+                    const uint32_t bits = (v0 << 18) | (v1 << 12) | (v2 << 6) | v3;
 
-            charArray3[0] =  (charArray4[0] << 2)        + ((charArray4[1] & 0x30) >> 4);
-            charArray3[1] = ((charArray4[1] & 0xf) << 4) + ((charArray4[2] & 0x3c) >> 2);
-            charArray3[2] = ((charArray4[2] & 0x3) << 6) +   charArray4[3];
+                    out[0] = static_cast<uint8_t>(bits >> 16);
+                    out[1] = static_cast<uint8_t>(bits >> 8);
+                    out[2] = static_cast<uint8_t>(bits);
+                }
+            }
 
-            for (i=0; i<3; ++i)
-                ret.push_back(static_cast<uint8_t>(charArray3[i]));
+            if (i >= textSize)
+                break;
 
-            i = 0;
+            // slow path, one character at a time
+            const char c = text[i++];
+            const uint8_t value = kBase64Values[static_cast<uint8_t>(c)];
+
+            if (value < 64)
+            {
+                fBits = (fBits << 6) | value;
+
+                if (++fCount == 4)
+                {
+                    out[0] = static_cast<uint8_t>(fBits >> 16);
+                    out[1] = static_cast<uint8_t>(fBits >> 8);
+                    out[2] = static_cast<uint8_t>(fBits);
+                    out += 3;
+
+                    fBits  = 0;
+                    fCount = 0;
+                }
+            }
+            else if (value == CarlaBase64Helpers::kBase64End)
+            {
+                fFinished = true;
+                break;
+            }
+            else if (value == CarlaBase64Helpers::kBase64Invalid)
+            {
+                carla_safe_assert("isBase64Char(c)", __FILE__, __LINE__);
+            }
         }
+
+        return static_cast<std::size_t>(out - data);
     }
 
-    if (i != 0)
+    /*
+     * Decode what is left of an incomplete group and reset, 'data' must have room for 2 bytes.
+     */
+    std::size_t finish(uint8_t* const data) noexcept
     {
-        for (j=0; j<i && j<4; ++j)
-            charArray4[j] = CarlaBase64Helpers::findBase64CharIndex(static_cast<char>(charArray4[j]));
+        std::size_t written = 0;
+
+        switch (fCount)
+        {
+        case 2:
+            data[0] = static_cast<uint8_t>(fBits >> 4);
+            written = 1;
+            break;
+        case 3:
+            data[0] = static_cast<uint8_t>(fBits >> 10);
+            data[1] = static_cast<uint8_t>(fBits >> 2);
+            written = 2;
+            break;
+        }
+
+        fBits     = 0;
+        fCount    = 0;
+        fFinished = false;
+        return written;
+    }
+
+private:
+    uint32_t fBits;
+    uint fCount;
+    bool fFinished;
+
+    CARLA_DECLARE_NON_COPY_CLASS(CarlaBase64Decoder)
+};
+
+// -----------------------------------------------------------------------
+
+static inline
+std::vector<uint8_t> carla_getChunkFromBase64String(const char* const base64string)
+{
+    CARLA_SAFE_ASSERT_RETURN(base64string != nullptr, std::vector<uint8_t>());
 
-        for (j=i; j<4; ++j)
-            charArray4[j] = 0;
+    const std::size_t len = std::strlen(base64string);
 
-        charArray3[0] =  (charArray4[0] << 2)        + ((charArray4[1] & 0x30) >> 4);
-        charArray3[1] = ((charArray4[1] & 0xf) << 4) + ((charArray4[2] & 0x3c) >> 2);
-        charArray3[2] = ((charArray4[2] & 0x3) << 6) +   charArray4[3];
+    if (len == 0)
+        return std::vector<uint8_t>();
 
-        for (j=0; i>0 && j<i-1; j++)
-            ret.push_back(static_cast<uint8_t>(charArray3[j]));
+    std::vector<uint8_t> ret(carla_base64DecodedMaxSize(len));
+
+    CarlaBase64Decoder decoder;
+    std::size_t size = decoder.decode(base64string, len, &ret.front());
+    size += decoder.finish(&ret.front() + size);
+
+    ret.resize(size);
+    return ret;
+}
+
+/*
+ * Decode base64 text from 'stream', anything with an 'int read(void*, int)' method, in small blocks.
+ * 'textSize' is only used to size the result up front.
+ */
+template<class InputStream>
+static inline
+std::vector<uint8_t> carla_getChunkFromBase64Stream(InputStream& stream, const std::size_t textSize)
+{
+    std::vector<uint8_t> ret(carla_base64DecodedMaxSize(textSize) + 2);
+
+    CarlaBase64Decoder decoder;
+    std::size_t size = 0;
+    char text[4096];
+
+    for (int read; (read = stream.read(text, static_cast<int>(sizeof(text)))) > 0;)
+    {
+        const std::size_t uread = static_cast<std::size_t>(read);
+
+        // more text than announced
+        if (size + carla_base64DecodedMaxSize(uread) + 2 > ret.size())
+            ret.resize(size + carla_base64DecodedMaxSize(uread) + 2);
+
+        size += decoder.decode(text, uread, &ret.front() + size);
     }
 
+    size += decoder.finish(&ret.front() + size);
+
+    ret.resize(size);
     return ret;
 }
 
+/*
+ * Encode data into 'stream', anything with a 'bool write(const void*, std::size_t)' method, in small blocks.
+ * Avoids having the whole base64 text in memory at once.
+ */
+template<class OutputStream>
+static inline
+bool carla_writeBase64ToStream(OutputStream& stream, const void* const data, const std::size_t dataSize)
+{
+    // multiple of 3, so no bytes are left pending between blocks
+    static const std::size_t kBlockSize = 3072;
+
+    const uint8_t* const bytes = static_cast<const uint8_t*>(data);
+    char text[kBlockSize / 3 * 4];
+
+    for (std::size_t i = 0; i < dataSize; i += kBlockSize)
+    {
+        const std::size_t written = carla_base64Encode(bytes + i, std::min(kBlockSize, dataSize - i), text);
+
+        if (! stream.write(text, written))
+            return false;
+    }
+
+    return true;
+}
+
 // -----------------------------------------------------------------------
 
 #endif // CARLA_BASE64_UTILS_HPP_INCLUDED
@@ -20,7 +20,7 @@
 
 #include "CarlaRingBuffer.hpp"
 
-#define CARLA_PLUGIN_BRIDGE_API_VERSION 2
+#define CARLA_PLUGIN_BRIDGE_API_VERSION 3
 
 // -------------------------------------------------------------------------------------------------------------------
 
@@ -149,6 +149,16 @@ struct BridgeTimeInfo {
 
 static const std::size_t kBridgeRtClientDataMidiOutSize = 511*4;
 static const std::size_t kBridgeBaseMidiOutHeaderSize   = 6U /* time, port and size */;
+static const std::size_t kBridgeWakeHistogramSize       = 16;
+
+// Wake-up latency of the client RT thread, not available on Windows
+struct BridgeWakeStats {
+    uint64_t postTime; // set by server before waking up the client, in monotonic clock nanoseconds
+    uint64_t count;
+    uint32_t maxUsecs;
+    // index 0 counts wake-ups under 1us, index N the ones under 2^N us, the last index everything else
+    uint32_t histogram[kBridgeWakeHistogramSize];
+};
 
 // Server => Client RT
 struct BridgeRtClientData {
@@ -157,6 +167,7 @@ struct BridgeRtClientData {
     SmallStackBuffer ringBuffer;
     uint8_t midiOut[kBridgeRtClientDataMidiOutSize];
     uint32_t procFlags;
+    BridgeWakeStats wakeStats;
 };
 
 // Server => Client Non-RT
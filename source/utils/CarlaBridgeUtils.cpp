@@ -288,10 +288,45 @@ bool BridgeRtClientControl::waitForClient(const uint msecs) noexcept
     CARLA_SAFE_ASSERT_RETURN(data != nullptr, false);
     CARLA_SAFE_ASSERT_RETURN(isServer, false);
 
+#ifndef CARLA_OS_WIN
+    data->wakeStats.postTime = carla_gettime_ns();
+#endif
     jackbridge_sem_post(&data->sem.server, true);
 
     return jackbridge_sem_timedwait(&data->sem.client, msecs, true);
-    return false;
+}
+
+void BridgeRtClientControl::postToClient() noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(data != nullptr,);
+    CARLA_SAFE_ASSERT_RETURN(isServer,);
+
+#ifndef CARLA_OS_WIN
+    data->wakeStats.postTime = carla_gettime_ns();
+#endif
+    jackbridge_sem_post(&data->sem.server, true);
+}
+
+bool BridgeRtClientControl::waitForClientReply(const uint msecs) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(msecs > 0, false);
+    CARLA_SAFE_ASSERT_RETURN(data != nullptr, false);
+    CARLA_SAFE_ASSERT_RETURN(isServer, false);
+
+    return jackbridge_sem_timedwait(&data->sem.client, msecs, true);
+}
+
+bool BridgeRtClientControl::getWakeStats(uint64_t& count, uint32_t& maxUsecs, uint32_t histogram[kBridgeWakeHistogramSize]) const noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(data != nullptr, false);
+    CARLA_SAFE_ASSERT_RETURN(isServer, false);
+
+    // written by the client while we read, values might be off by one
+    count    = data->wakeStats.count;
+    maxUsecs = data->wakeStats.maxUsecs;
+    std::memcpy(histogram, data->wakeStats.histogram, sizeof(data->wakeStats.histogram));
+
+    return true;
 }
 
 bool BridgeRtClientControl::writeOpcode(const PluginBridgeRtClientOpcode opcode) noexcept
@@ -306,9 +341,38 @@ PluginBridgeRtClientOpcode BridgeRtClientControl::readOpcode() noexcept
     return static_cast<PluginBridgeRtClientOpcode>(readUInt());
 }
 
+#ifndef CARLA_OS_WIN
+static void recordWakeUp(BridgeWakeStats& stats) noexcept
+{
+    const uint64_t postTime = stats.postTime;
+    const uint64_t now = carla_gettime_ns();
+
+    if (postTime == 0 || now < postTime)
+        return;
+
+    const uint64_t usecs = (now - postTime) / 1000;
+
+    uint index = 0;
+    while (index+1 < kBridgeWakeHistogramSize && (1ULL << index) <= usecs)
+        ++index;
+
+    ++stats.histogram[index];
+    ++stats.count;
+
+    if (usecs > stats.maxUsecs)
+        stats.maxUsecs = usecs < 0xffffffffULL ? static_cast<uint32_t>(usecs) : 0xffffffffU;
+}
+#endif
+
 BridgeRtClientControl::WaitHelper::WaitHelper(BridgeRtClientControl& c) noexcept
     : data(c.data),
-      ok(jackbridge_sem_timedwait(&data->sem.server, 5000, false)) {}
+      ok(jackbridge_sem_timedwait(&data->sem.server, 5000, false))
+{
+#ifndef CARLA_OS_WIN
+    if (ok)
+        recordWakeUp(data->wakeStats);
+#endif
+}
 
 BridgeRtClientControl::WaitHelper::~WaitHelper() noexcept
 {
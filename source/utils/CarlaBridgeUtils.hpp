@@ -249,6 +249,13 @@ struct BridgeRtClientControl : public CarlaRingBufferControl<SmallStackBuffer> {
     bool waitForClient(const uint msecs) noexcept;
     bool writeOpcode(const PluginBridgeRtClientOpcode opcode) noexcept;
 
+    // non-bridge, server, split version of waitForClient used for pipelined processing
+    void postToClient() noexcept;
+    bool waitForClientReply(const uint msecs) noexcept;
+
+    // non-bridge, server, wake-up latency of the client RT thread
+    bool getWakeStats(uint64_t& count, uint32_t& maxUsecs, uint32_t histogram[kBridgeWakeHistogramSize]) const noexcept;
+
     // bridge, client
     PluginBridgeRtClientOpcode readOpcode() noexcept;
 
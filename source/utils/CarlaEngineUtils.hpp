@@ -114,24 +114,53 @@ const char* EngineControlEventType2Str(const EngineControlEventType type) noexce
 }
 
 // -----------------------------------------------------------------------
+// Engine event buffers keep their events packed at the start, the first null event marks the end.
+// Everything past the end is kept zeroed, so clearing and copying only needs to touch the used part.
+// Writers must never leave a null event between valid ones.
 
 static inline
-void fillEngineEventsFromWaterMidiBuffer(EngineEvent engineEvents[kMaxEngineEventInternalCount], const water::MidiBuffer& midiBuffer)
+uint32_t getEngineEventCount(const EngineEvent engineEvents[kMaxEngineEventInternalCount]) noexcept
 {
-    const uint8_t* midiData;
-    int numBytes, sampleNumber;
-    ushort engineEventIndex = 0;
+    uint32_t i=0;
 
-    for (ushort i=0; i < kMaxEngineEventInternalCount; ++i)
+    for (; i < kMaxEngineEventInternalCount; ++i)
     {
-        const EngineEvent& engineEvent(engineEvents[i]);
+        if (engineEvents[i].type == kEngineEventTypeNull)
+            break;
+    }
 
-        if (engineEvent.type != kEngineEventTypeNull)
-            continue;
+    return i;
+}
 
-        engineEventIndex = i;
-        break;
-    }
+static inline
+void clearEngineEvents(EngineEvent engineEvents[kMaxEngineEventInternalCount], const uint32_t startIndex = 0) noexcept
+{
+    const uint32_t count(getEngineEventCount(engineEvents));
+
+    if (count > startIndex)
+        carla_zeroStructs(engineEvents+startIndex, count-startIndex);
+}
+
+static inline
+void copyEngineEvents(EngineEvent dstEvents[kMaxEngineEventInternalCount], const EngineEvent srcEvents[kMaxEngineEventInternalCount]) noexcept
+{
+    const uint32_t count(getEngineEventCount(srcEvents));
+
+    // remove leftovers from a longer previous content first
+    clearEngineEvents(dstEvents, count);
+
+    if (count > 0)
+        carla_copyStructs(dstEvents, srcEvents, count);
+}
+
+// -----------------------------------------------------------------------
+
+static inline
+void fillEngineEventsFromWaterMidiBuffer(EngineEvent engineEvents[kMaxEngineEventInternalCount], const water::MidiBuffer& midiBuffer)
+{
+    const uint8_t* midiData;
+    int numBytes, sampleNumber;
+    uint32_t engineEventIndex = getEngineEventCount(engineEvents);
 
     for (water::MidiBuffer::Iterator midiBufferIterator(midiBuffer); midiBufferIterator.getNextEvent(midiData, numBytes, sampleNumber) && engineEventIndex < kMaxEngineEventInternalCount;)
     {
@@ -139,10 +168,14 @@ void fillEngineEventsFromWaterMidiBuffer(EngineEvent engineEvents[kMaxEngineEven
         CARLA_SAFE_ASSERT_CONTINUE(sampleNumber >= 0);
         CARLA_SAFE_ASSERT_CONTINUE(numBytes < 0xFF /* uint8_t max */);
 
-        EngineEvent& engineEvent(engineEvents[engineEventIndex++]);
+        EngineEvent& engineEvent(engineEvents[engineEventIndex]);
 
         engineEvent.time = static_cast<uint32_t>(sampleNumber);
         engineEvent.fillFromMidiData(static_cast<uint8_t>(numBytes), midiData, 0);
+
+        // skip invalid data without leaving a gap
+        if (engineEvent.type != kEngineEventTypeNull)
+            ++engineEventIndex;
     }
 }
 
@@ -0,0 +1,471 @@
+/*
+ * Carla FluidSynth utils
+ * Copyright (C) 2018 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the doc/GPL.txt file.
+ */
+
+#ifndef CARLA_FLUIDSYNTH_UTILS_HPP_INCLUDED
+#define CARLA_FLUIDSYNTH_UTILS_HPP_INCLUDED
+
+#include "CarlaMIDI.h"
+#include "CarlaMutex.hpp"
+#include "LinkedList.hpp"
+
+#include <fluidsynth.h>
+
+// -----------------------------------------------------------------------
+// FluidSoundFontCache class
+
+/*
+ * SoundFont cache, meant to be shared by all FluidSynth plugin instances.
+ * Each plugin synth gets a custom sfloader that hands out light wrappers around a single loaded copy of the
+ * SoundFont, so loading the same file again costs no extra sample memory or disk I/O.
+ * The real SoundFonts are owned by a private, never-processed synth, as fluidsynth has no public default loader.
+ *
+ * fluidsynth 1.x keeps the preset iteration state inside the SoundFont, so each wrapper has its own presets and
+ * iteration state, and only iterating the shared copy takes a per-SoundFont lock (never done while processing).
+ * Everything else reads the shared copy, so synths start, stop and render voices without any locking.
+ * The exception is the per-sample voice count, which fluidsynth 1.x updates non-atomically and only checks when
+ * unloading. A miscount from synths rendering in parallel can only keep fluidsynth from freeing the samples
+ * once the last synth using them is gone, in which case it retries the unload later.
+ */
+class FluidSoundFontCache
+{
+public:
+    FluidSoundFontCache() noexcept
+        : fMutex(),
+          fSettings(nullptr),
+          fSynth(nullptr),
+          fSoundFonts() {}
+
+    ~FluidSoundFontCache() noexcept
+    {
+        // all plugins should be gone by now
+        CARLA_SAFE_ASSERT(fSoundFonts.count() == 0);
+
+        for (LinkedList<SoundFont*>::Itenerator it = fSoundFonts.begin2(); it.valid(); it.next())
+        {
+            SoundFont* const sf(it.getValue(nullptr));
+            CARLA_SAFE_ASSERT_CONTINUE(sf != nullptr);
+
+            delete[] sf->filename;
+            delete sf;
+        }
+
+        fSoundFonts.clear();
+
+        // this unloads any leftover SoundFonts too
+        if (fSynth != nullptr)
+        {
+            delete_fluid_synth(fSynth);
+            fSynth = nullptr;
+        }
+
+        if (fSettings != nullptr)
+        {
+            delete_fluid_settings(fSettings);
+            fSettings = nullptr;
+        }
+    }
+
+    // makes 'synth' load SoundFonts through the cache, fluidsynth takes ownership of the loader
+    void addLoaderToSynth(fluid_synth_t* const synth) noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN(synth != nullptr,);
+
+        fluid_sfloader_t* loader;
+
+        try {
+            loader = new fluid_sfloader_t;
+        } CARLA_SAFE_EXCEPTION_RETURN("FluidSoundFontCache::addLoaderToSynth",);
+
+        loader->data = this;
+        loader->free = _loader_free;
+        loader->load = _loader_load;
+
+        // custom loaders are tried before the default one
+        fluid_synth_add_sfloader(synth, loader);
+    }
+
+private:
+    struct SoundFont {
+        CarlaMutex iterMutex;
+        const char* filename;
+        fluid_sfont_t* sfont; // owned by fSynth
+        int sfontId;
+        int count; // number of wrappers
+    };
+
+    // data of each wrapper sfont, used by a single synth
+    struct Wrapper {
+        FluidSoundFontCache* cache;
+        SoundFont* sf;
+        fluid_preset_t* freePresets; // reused presets, linked through their 'data'
+        fluid_preset_t* iterPresets; // copy of the shared SoundFont presets, made on iteration start
+        uint iterCount;
+        uint iterIndex;
+    };
+
+    CarlaMutex fMutex;
+    fluid_settings_t* fSettings;
+    fluid_synth_t*    fSynth;
+    LinkedList<SoundFont*> fSoundFonts;
+
+    // ----------------------------------------------------------------------------------------------------------------
+
+    fluid_sfont_t* attach(const char* const filename) noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN(filename != nullptr && filename[0] != '\0', nullptr);
+
+        const CarlaMutexLocker cml(fMutex);
+
+        SoundFont* sf = nullptr;
+
+        for (LinkedList<SoundFont*>::Itenerator it = fSoundFonts.begin2(); it.valid(); it.next())
+        {
+            SoundFont* const sf2(it.getValue(nullptr));
+            CARLA_SAFE_ASSERT_CONTINUE(sf2 != nullptr);
+
+            if (std::strcmp(sf2->filename, filename) == 0)
+            {
+                sf = sf2;
+                break;
+            }
+        }
+
+        fluid_sfont_t* wrapper = nullptr;
+        Wrapper* wdata = nullptr;
+
+        try {
+            wrapper = new fluid_sfont_t;
+            wdata = new Wrapper;
+        } CARLA_SAFE_EXCEPTION("FluidSoundFontCache::attach");
+
+        if (wdata == nullptr)
+        {
+            delete wrapper;
+            return nullptr;
+        }
+
+        wdata->cache = this;
+        wdata->sf = nullptr;
+        wdata->freePresets = nullptr;
+        wdata->iterPresets = nullptr;
+        wdata->iterCount = 0;
+        wdata->iterIndex = 0;
+
+        wrapper->data = wdata;
+        wrapper->id = 0; // set by the synth that loads it
+        wrapper->free = _sfont_free;
+        wrapper->get_name = _sfont_get_name;
+        wrapper->get_preset = _sfont_get_preset;
+        wrapper->iteration_start = _sfont_iteration_start;
+        wrapper->iteration_next = _sfont_iteration_next;
+
+        // enough presets for program changes on every channel, so these do not allocate while processing
+        for (int i=0; i < MAX_MIDI_CHANNELS * 2; ++i)
+        {
+            fluid_preset_t* preset;
+
+            try {
+                preset = new fluid_preset_t;
+            } CARLA_SAFE_EXCEPTION_BREAK("FluidSoundFontCache::attach");
+
+            preset->data = wdata->freePresets;
+            wdata->freePresets = preset;
+        }
+
+        if (sf != nullptr)
+        {
+            carla_debug("FluidSoundFontCache::attach(\"%s\") - sharing already loaded SoundFont", filename);
+
+            ++sf->count;
+            wdata->sf = sf;
+            return wrapper;
+        }
+
+        if (fSynth == nullptr && ! createSynth())
+        {
+            deleteWrapper(wrapper);
+            return nullptr;
+        }
+
+        const int sfontId = fluid_synth_sfload(fSynth, filename, 0);
+
+        if (sfontId < 0)
+        {
+            deleteWrapper(wrapper);
+            return nullptr;
+        }
+
+        fluid_sfont_t* const sfont = fluid_synth_get_sfont_by_id(fSynth, static_cast<uint>(sfontId));
+        CARLA_SAFE_ASSERT(sfont != nullptr);
+
+        const char* dfilename = nullptr;
+
+        try {
+            dfilename = carla_strdup(filename);
+            sf = new SoundFont;
+            sf->filename = dfilename;
+            sf->sfont    = sfont;
+            sf->sfontId  = sfontId;
+            sf->count    = 1;
+        } CARLA_SAFE_EXCEPTION("FluidSoundFontCache::attach");
+
+        if (sfont == nullptr || sf == nullptr || ! fSoundFonts.append(sf))
+        {
+            delete[] dfilename;
+            delete sf;
+            fluid_synth_sfunload(fSynth, static_cast<uint>(sfontId), 0);
+            deleteWrapper(wrapper);
+            return nullptr;
+        }
+
+        wdata->sf = sf;
+        return wrapper;
+    }
+
+    void unref(SoundFont* const sf) noexcept
+    {
+        const CarlaMutexLocker cml(fMutex);
+
+        CARLA_SAFE_ASSERT_RETURN(sf->count > 0,);
+
+        if (--sf->count != 0)
+            return;
+
+        // every synth using it is gone, so none of its samples are in use anymore
+        fluid_synth_sfunload(fSynth, static_cast<uint>(sf->sfontId), 0);
+
+        fSoundFonts.removeOne(sf);
+        delete[] sf->filename;
+        delete sf;
+    }
+
+    static void deleteWrapper(fluid_sfont_t* const wrapper) noexcept
+    {
+        Wrapper* const wdata(static_cast<Wrapper*>(wrapper->data));
+
+        for (fluid_preset_t* preset = wdata->freePresets; preset != nullptr;)
+        {
+            fluid_preset_t* const next(static_cast<fluid_preset_t*>(preset->data));
+            delete preset;
+            preset = next;
+        }
+
+        delete[] wdata->iterPresets;
+        delete wdata;
+        delete wrapper;
+    }
+
+    bool createSynth() noexcept
+    {
+        if (fSettings == nullptr)
+        {
+            fSettings = new_fluid_settings();
+            CARLA_SAFE_ASSERT_RETURN(fSettings != nullptr, false);
+
+            // only used for loading, keep it small
+            fluid_settings_setint(fSettings, "synth.polyphony", 1);
+        }
+
+        fSynth = new_fluid_synth(fSettings);
+        CARLA_SAFE_ASSERT_RETURN(fSynth != nullptr, false);
+
+        return true;
+    }
+
+    // ----------------------------------------------------------------------------------------------------------------
+
+    static int _loader_free(fluid_sfloader_t* const loader)
+    {
+        delete loader;
+        return 0;
+    }
+
+    static fluid_sfont_t* _loader_load(fluid_sfloader_t* const loader, const char* const filename)
+    {
+        return static_cast<FluidSoundFontCache*>(loader->data)->attach(filename);
+    }
+
+    static int _sfont_free(fluid_sfont_t* const wrapper)
+    {
+        Wrapper* const wdata(static_cast<Wrapper*>(wrapper->data));
+        CARLA_SAFE_ASSERT_RETURN(wdata != nullptr && wdata->sf != nullptr, 0);
+
+        FluidSoundFontCache* const cache(wdata->cache);
+        SoundFont* const sf(wdata->sf);
+
+        deleteWrapper(wrapper);
+        cache->unref(sf);
+        return 0;
+    }
+
+    static char* _sfont_get_name(fluid_sfont_t* const wrapper)
+    {
+        SoundFont* const sf(static_cast<Wrapper*>(wrapper->data)->sf);
+
+        return sf->sfont->get_name(sf->sfont);
+    }
+
+    // presets handed to the synth are our own, pointing back to the wrapper and forwarding to the shared ones.
+    // called on program changes, possibly while processing, reuses a free preset if possible.
+    // looking up a preset does not touch the shared iteration state, so no lock is needed.
+    static fluid_preset_t* _sfont_get_preset(fluid_sfont_t* const wrapper, const uint bank, const uint prenum)
+    {
+        Wrapper* const wdata(static_cast<Wrapper*>(wrapper->data));
+        SoundFont* const sf(wdata->sf);
+
+        fluid_preset_t* const shared = sf->sfont->get_preset(sf->sfont, bank, prenum);
+
+        if (shared == nullptr)
+            return nullptr;
+
+        fluid_preset_t* preset = wdata->freePresets;
+
+        if (preset != nullptr)
+        {
+            wdata->freePresets = static_cast<fluid_preset_t*>(preset->data);
+        }
+        else
+        {
+            try {
+                preset = new fluid_preset_t;
+            } CARLA_SAFE_EXCEPTION("FluidSoundFontCache::_sfont_get_preset");
+
+            if (preset == nullptr)
+            {
+                if (shared->free != nullptr)
+                    shared->free(shared);
+                return nullptr;
+            }
+        }
+
+        setupPreset(wrapper, preset, shared);
+        preset->free = _preset_free;
+        return preset;
+    }
+
+    // the shared iteration state is only used here, a copy of all presets is kept in the wrapper
+    static void _sfont_iteration_start(fluid_sfont_t* const wrapper)
+    {
+        Wrapper* const wdata(static_cast<Wrapper*>(wrapper->data));
+        SoundFont* const sf(wdata->sf);
+
+        const CarlaMutexLocker cml(sf->iterMutex);
+
+        fluid_preset_t preset;
+        uint count = 0;
+
+        sf->sfont->iteration_start(sf->sfont);
+        for (; sf->sfont->iteration_next(sf->sfont, &preset);)
+            ++count;
+
+        if (count != wdata->iterCount)
+        {
+            delete[] wdata->iterPresets;
+            wdata->iterPresets = nullptr;
+            wdata->iterCount = 0;
+
+            try {
+                wdata->iterPresets = new fluid_preset_t[count];
+            } CARLA_SAFE_EXCEPTION_RETURN("FluidSoundFontCache::_sfont_iteration_start",);
+
+            wdata->iterCount = count;
+        }
+
+        uint i = 0;
+        sf->sfont->iteration_start(sf->sfont);
+        for (; i < count && sf->sfont->iteration_next(sf->sfont, &wdata->iterPresets[i]);)
+            ++i;
+
+        wdata->iterCount = i;
+        wdata->iterIndex = 0;
+    }
+
+    static int _sfont_iteration_next(fluid_sfont_t* const wrapper, fluid_preset_t* const preset)
+    {
+        Wrapper* const wdata(static_cast<Wrapper*>(wrapper->data));
+
+        if (wdata->iterIndex >= wdata->iterCount)
+            return 0;
+
+        // owned by the wrapper, nothing to free
+        setupPreset(wrapper, preset, &wdata->iterPresets[wdata->iterIndex++]);
+        preset->free = nullptr;
+        return 1;
+    }
+
+    // ----------------------------------------------------------------------------------------------------------------
+
+    static void setupPreset(fluid_sfont_t* const wrapper, fluid_preset_t* const preset, fluid_preset_t* const shared) noexcept
+    {
+        preset->data = shared;
+        preset->sfont = wrapper;
+        preset->get_name = _preset_get_name;
+        preset->get_banknum = _preset_get_banknum;
+        preset->get_num = _preset_get_num;
+        preset->noteon = _preset_noteon;
+        preset->notify = (shared->notify != nullptr) ? _preset_notify : nullptr;
+    }
+
+    static int _preset_free(fluid_preset_t* const preset)
+    {
+        Wrapper* const wdata(static_cast<Wrapper*>(preset->sfont->data));
+        fluid_preset_t* const shared(static_cast<fluid_preset_t*>(preset->data));
+
+        if (shared->free != nullptr)
+            shared->free(shared);
+
+        preset->data = wdata->freePresets;
+        wdata->freePresets = preset;
+        return 0;
+    }
+
+    static char* _preset_get_name(fluid_preset_t* const preset)
+    {
+        fluid_preset_t* const shared(static_cast<fluid_preset_t*>(preset->data));
+        return shared->get_name(shared);
+    }
+
+    static int _preset_get_banknum(fluid_preset_t* const preset)
+    {
+        fluid_preset_t* const shared(static_cast<fluid_preset_t*>(preset->data));
+        return shared->get_banknum(shared);
+    }
+
+    static int _preset_get_num(fluid_preset_t* const preset)
+    {
+        fluid_preset_t* const shared(static_cast<fluid_preset_t*>(preset->data));
+        return shared->get_num(shared);
+    }
+
+    static int _preset_noteon(fluid_preset_t* const preset, fluid_synth_t* const synth, const int chan, const int key, const int vel)
+    {
+        fluid_preset_t* const shared(static_cast<fluid_preset_t*>(preset->data));
+        return shared->noteon(shared, synth, chan, key, vel);
+    }
+
+    static int _preset_notify(fluid_preset_t* const preset, const int reason, const int chan)
+    {
+        fluid_preset_t* const shared(static_cast<fluid_preset_t*>(preset->data));
+        return shared->notify(shared, reason, chan);
+    }
+
+    CARLA_DECLARE_NON_COPY_CLASS(FluidSoundFontCache)
+};
+
+// -----------------------------------------------------------------------
+
+#endif // CARLA_FLUIDSYNTH_UTILS_HPP_INCLUDED
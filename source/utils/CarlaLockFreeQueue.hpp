@@ -0,0 +1,255 @@
+/*
+ * Carla lock-free queues
+ * Copyright (C) 2018 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the doc/GPL.txt file.
+ */
+
+#ifndef CARLA_LOCK_FREE_QUEUE_HPP_INCLUDED
+#define CARLA_LOCK_FREE_QUEUE_HPP_INCLUDED
+
+#include "CarlaUtils.hpp"
+
+// -----------------------------------------------------------------------
+// Bounded lock-free queues, for passing small copyable items between real-time and non-real-time threads.
+//
+// Nothing is allocated or locked after construction, so any side can be a real-time thread.
+// When full, new items are rejected and counted, so the consumer can report them.
+// Data written by different threads is kept in separate cache lines.
+
+#define CARLA_CACHE_LINE_SIZE 64
+
+// -----------------------------------------------------------------------
+// CarlaSpscQueue, single producer and single consumer
+
+template<typename T, uint32_t kCapacity>
+class CarlaSpscQueue
+{
+public:
+    CarlaSpscQueue() noexcept
+        : fHead(0),
+          fTailCache(0),
+          fTail(0),
+          fHeadCache(0),
+          fOverflowCount(0)
+    {
+        static_assert(kCapacity >= 2 && (kCapacity & (kCapacity - 1)) == 0, "capacity must be a power of 2");
+    }
+
+    /*
+     * Add an item, called from the producer thread only.
+     * Returns false if the queue is full.
+     */
+    bool put(const T& item) noexcept
+    {
+        const uint32_t tail(__atomic_load_n(&fTail, __ATOMIC_RELAXED));
+
+        if (tail - fHeadCache >= kCapacity)
+        {
+            fHeadCache = __atomic_load_n(&fHead, __ATOMIC_ACQUIRE);
+
+            if (tail - fHeadCache >= kCapacity)
+            {
+                __atomic_add_fetch(&fOverflowCount, 1, __ATOMIC_RELAXED);
+                return false;
+            }
+        }
+
+        fItems[tail & kMask] = item;
+        __atomic_store_n(&fTail, tail + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    /*
+     * Take the oldest item, called from the consumer thread only.
+     * Returns false if the queue is empty.
+     */
+    bool get(T& item) noexcept
+    {
+        const uint32_t head(__atomic_load_n(&fHead, __ATOMIC_RELAXED));
+
+        if (head == fTailCache)
+        {
+            fTailCache = __atomic_load_n(&fTail, __ATOMIC_ACQUIRE);
+
+            if (head == fTailCache)
+                return false;
+        }
+
+        item = fItems[head & kMask];
+        __atomic_store_n(&fHead, head + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    /*
+     * Check if the queue is empty, can be called from any thread.
+     * The answer might be outdated by the time it returns.
+     */
+    bool isEmpty() const noexcept
+    {
+        return __atomic_load_n(&fHead, __ATOMIC_ACQUIRE) == __atomic_load_n(&fTail, __ATOMIC_ACQUIRE);
+    }
+
+    /*
+     * Get and reset the number of items rejected because the queue was full.
+     */
+    uint32_t takeOverflowCount() noexcept
+    {
+        return __atomic_exchange_n(&fOverflowCount, 0, __ATOMIC_RELAXED);
+    }
+
+private:
+    static const uint32_t kMask = kCapacity - 1;
+
+    char fPad0[CARLA_CACHE_LINE_SIZE];
+
+    // consumer side
+    uint32_t fHead;
+    uint32_t fTailCache;
+    char fPad1[CARLA_CACHE_LINE_SIZE - 2 * sizeof(uint32_t)];
+
+    // producer side
+    uint32_t fTail;
+    uint32_t fHeadCache;
+    uint32_t fOverflowCount;
+    char fPad2[CARLA_CACHE_LINE_SIZE - 3 * sizeof(uint32_t)];
+
+    T fItems[kCapacity];
+
+    CARLA_DECLARE_NON_COPY_CLASS(CarlaSpscQueue)
+};
+
+// -----------------------------------------------------------------------
+// CarlaMpscQueue, many producers and a single consumer
+//
+// Each cell carries a sequence number that tells whose turn it is, see Dmitry Vyukov's bounded MPMC queue.
+// Producers claim a cell by moving the tail forward, and then publish the item through its sequence.
+
+template<typename T, uint32_t kCapacity>
+class CarlaMpscQueue
+{
+public:
+    CarlaMpscQueue() noexcept
+        : fHead(0),
+          fTail(0),
+          fOverflowCount(0)
+    {
+        static_assert(kCapacity >= 2 && (kCapacity & (kCapacity - 1)) == 0, "capacity must be a power of 2");
+
+        for (uint32_t i=0; i < kCapacity; ++i)
+            fCells[i].sequence = i;
+    }
+
+    /*
+     * Add an item, can be called from any thread.
+     * Returns false if the queue is full.
+     */
+    bool put(const T& item) noexcept
+    {
+        uint32_t pos(__atomic_load_n(&fTail, __ATOMIC_RELAXED));
+        Cell* cell;
+
+        for (;;)
+        {
+            cell = &fCells[pos & kMask];
+
+            const uint32_t seq(__atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE));
+            const int32_t diff(static_cast<int32_t>(seq - pos));
+
+            if (diff == 0)
+            {
+                // cell is free, try to claim it; on failure 'pos' gets the current tail
+                if (__atomic_compare_exchange_n(&fTail, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+                    break;
+            }
+            else if (diff < 0)
+            {
+                // the consumer has not taken this cell yet, queue is full
+                __atomic_add_fetch(&fOverflowCount, 1, __ATOMIC_RELAXED);
+                return false;
+            }
+            else
+            {
+                // another producer got here first
+                pos = __atomic_load_n(&fTail, __ATOMIC_RELAXED);
+            }
+        }
+
+        cell->item = item;
+        __atomic_store_n(&cell->sequence, pos + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    /*
+     * Take the oldest item, called from the consumer thread only.
+     * Returns false if the queue is empty, or if the oldest item is still being written.
+     */
+    bool get(T& item) noexcept
+    {
+        Cell& cell(fCells[fHead & kMask]);
+
+        if (__atomic_load_n(&cell.sequence, __ATOMIC_ACQUIRE) != fHead + 1)
+            return false;
+
+        item = cell.item;
+
+        // hand the cell back to producers, for the next round
+        __atomic_store_n(&cell.sequence, fHead + kCapacity, __ATOMIC_RELEASE);
+        ++fHead;
+        return true;
+    }
+
+    /*
+     * Check if the queue is empty, can be called from any thread.
+     * The answer might be outdated by the time it returns.
+     */
+    bool isEmpty() const noexcept
+    {
+        return __atomic_load_n(&fTail, __ATOMIC_ACQUIRE) == __atomic_load_n(&fHead, __ATOMIC_ACQUIRE);
+    }
+
+    /*
+     * Get and reset the number of items rejected because the queue was full.
+     */
+    uint32_t takeOverflowCount() noexcept
+    {
+        return __atomic_exchange_n(&fOverflowCount, 0, __ATOMIC_RELAXED);
+    }
+
+private:
+    static const uint32_t kMask = kCapacity - 1;
+
+    struct Cell {
+        uint32_t sequence;
+        T item;
+    };
+
+    char fPad0[CARLA_CACHE_LINE_SIZE];
+
+    // consumer side
+    uint32_t fHead;
+    char fPad1[CARLA_CACHE_LINE_SIZE - sizeof(uint32_t)];
+
+    // producer side
+    uint32_t fTail;
+    uint32_t fOverflowCount;
+    char fPad2[CARLA_CACHE_LINE_SIZE - 2 * sizeof(uint32_t)];
+
+    Cell fCells[kCapacity];
+
+    CARLA_DECLARE_NON_COPY_CLASS(CarlaMpscQueue)
+};
+
+// -----------------------------------------------------------------------
+
+#endif // CARLA_LOCK_FREE_QUEUE_HPP_INCLUDED
@@ -19,6 +19,7 @@
 #define CARLA_MATH_UTILS_HPP_INCLUDED
 
 #include "CarlaUtils.hpp"
+#include "CarlaSimdUtils.hpp"
 
 #include <cmath>
 #include <limits>
@@ -171,8 +172,20 @@ void carla_addFloats(float dest[], const float src[], const std::size_t count) n
     CARLA_SAFE_ASSERT_RETURN(src != nullptr,);
     CARLA_SAFE_ASSERT_RETURN(count > 0,);
 
-    for (std::size_t i=0; i<count; ++i)
-        *dest++ += *src++;
+    carla_getFloatKernels().add(dest, src, count);
+}
+
+/*
+ * Add float array values to another float array, multiplied by a fixed gain.
+ */
+static inline
+void carla_addFloatsWithGain(float dest[], const float src[], const float gain, const std::size_t count) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(dest != nullptr,);
+    CARLA_SAFE_ASSERT_RETURN(src != nullptr,);
+    CARLA_SAFE_ASSERT_RETURN(count > 0,);
+
+    carla_getFloatKernels().addWithGain(dest, src, gain, count);
 }
 
 /*
@@ -188,6 +201,19 @@ void carla_copyFloats(float dest[], const float src[], const std::size_t count)
     std::memcpy(dest, src, count*sizeof(float));
 }
 
+/*
+ * Copy float array values to another float array, multiplied by a fixed gain.
+ */
+static inline
+void carla_copyFloatsWithGain(float dest[], const float src[], const float gain, const std::size_t count) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(dest != nullptr,);
+    CARLA_SAFE_ASSERT_RETURN(src != nullptr,);
+    CARLA_SAFE_ASSERT_RETURN(count > 0,);
+
+    carla_getFloatKernels().copyWithGain(dest, src, gain, count);
+}
+
 /*
  * Clear a float array.
  */
@@ -209,25 +235,9 @@ float carla_findMaxNormalizedFloat(float floats[], const std::size_t count)
     CARLA_SAFE_ASSERT_RETURN(floats != nullptr, 0.0f);
     CARLA_SAFE_ASSERT_RETURN(count > 0, 0.0f);
 
-    static const float kEmptyFloats[8192] = { 0.0f };
-
-    if (count <= 8192 && std::memcmp(floats, kEmptyFloats, count) == 0)
-        return 0.0f;
-
-    float tmp, maxf2 = std::abs(floats[0]);
+    const float maxf = carla_getFloatKernels().findMaxAbs(floats, count);
 
-    for (std::size_t i=1; i<count; ++i)
-    {
-        tmp = std::abs(*floats++);
-
-        if (tmp > maxf2)
-            maxf2 = tmp;
-    }
-
-    if (maxf2 > 1.0f)
-        maxf2 = 1.0f;
-
-    return maxf2;
+    return maxf > 1.0f ? 1.0f : maxf;
 }
 
 /*
@@ -245,11 +255,38 @@ void carla_multiply(float data[], const float& multiplier, const std::size_t cou
     }
     else
     {
-        for (std::size_t i=0; i<count; ++i)
-            *data++ *= multiplier;
+        carla_getFloatKernels().multiply(data, multiplier, count);
     }
 }
 
+/*
+ * Mix a processed (wet) float array with its unprocessed (dry) input, in place.
+ * A 'dryWet' of 1.0 keeps the processed signal only.
+ */
+static inline
+void carla_mixFloatsDryWet(float data[], const float dry[], const float dryWet, const std::size_t count) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(data != nullptr,);
+    CARLA_SAFE_ASSERT_RETURN(dry != nullptr,);
+    CARLA_SAFE_ASSERT_RETURN(count > 0,);
+
+    carla_getFloatKernels().mixDryWet(data, dry, dryWet, count);
+}
+
+/*
+ * Apply balance to a stereo pair of float arrays, in place.
+ * 'balanceLeft' and 'balanceRight' are in the -1.0 to 1.0 range, like the plugin balance parameters.
+ */
+static inline
+void carla_applyStereoBalance(float left[], float right[], const float balanceLeft, const float balanceRight, const std::size_t count) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(left != nullptr,);
+    CARLA_SAFE_ASSERT_RETURN(right != nullptr,);
+    CARLA_SAFE_ASSERT_RETURN(count > 0,);
+
+    carla_getFloatKernels().applyStereoBalance(left, right, (balanceLeft + 1.0f)/2.0f, (balanceRight + 1.0f)/2.0f, count);
+}
+
 // --------------------------------------------------------------------------------------------------------------------
 // Missing functions in old OSX versions.
 
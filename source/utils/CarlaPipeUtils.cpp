@@ -978,6 +978,21 @@ void CarlaPipeCommon::writeLv2UridMessage(const uint32_t urid, const char* const
     flushMessages();
 }
 
+void CarlaPipeCommon::writeLv2UriMapMessage(const char* const uri) const noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(uri != nullptr && uri[0] != '\0',);
+
+    const CarlaMutexLocker cml(pData->writeLock);
+
+    if (! _writeMsgBuffer("urimap\n", 7))
+        return;
+
+    if (! writeAndFixMessage(uri))
+        return;
+
+    flushMessages();
+}
+
 // -------------------------------------------------------------------
 
 // internal
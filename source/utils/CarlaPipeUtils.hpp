@@ -217,6 +217,12 @@ public:
      */
     void writeLv2UridMessage(const uint32_t urid, const char* const uri) const noexcept;
 
+    /*!
+     * Write an lv2 "urimap" message, asking the other side for the URID of an URI.
+     * The reply comes back as an "urid" message.
+     */
+    void writeLv2UriMapMessage(const char* const uri) const noexcept;
+
     // -------------------------------------------------------------------
 
 protected:
@@ -0,0 +1,224 @@
+/*
+ * Carla plugin post-processing utils
+ * Copyright (C) 2018 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the doc/GPL.txt file.
+ */
+
+#ifndef CARLA_POST_PROC_UTILS_HPP_INCLUDED
+#define CARLA_POST_PROC_UTILS_HPP_INCLUDED
+
+#include "CarlaMathUtils.hpp"
+
+#include <algorithm>
+
+// --------------------------------------------------------------------------------------------------------------------
+// Post-processing values, as used by the plugin dry/wet, volume and balance parameters
+
+struct CarlaPostProcValues {
+    float dryWet;
+    float volume;
+    float balanceLeft;
+    float balanceRight;
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+// helpers, 'step' is the change per frame while ramping to a new value
+
+static inline
+void carla_postProcDryWet(float out[], const float dry[], const uint32_t frames, const float dryWet, const float step) noexcept
+{
+    if (carla_isZero(step))
+    {
+        carla_mixFloatsDryWet(out, dry, dryWet, frames);
+        return;
+    }
+
+    float value = dryWet;
+
+    for (uint32_t k=0; k < frames; ++k, value += step)
+        out[k] = out[k] * value + dry[k] * (1.0f - value);
+}
+
+static inline
+void carla_postProcBalance(float left[], float right[], const uint32_t frames,
+                           const float balanceLeft, const float balanceRight, const float stepLeft, const float stepRight) noexcept
+{
+    if (carla_isZero(stepLeft) && carla_isZero(stepRight))
+    {
+        carla_applyStereoBalance(left, right, balanceLeft, balanceRight, frames);
+        return;
+    }
+
+    float balRangeL = (balanceLeft  + 1.0f)/2.0f;
+    float balRangeR = (balanceRight + 1.0f)/2.0f;
+    float l, r;
+
+    for (uint32_t k=0; k < frames; ++k, balRangeL += stepLeft/2.0f, balRangeR += stepRight/2.0f)
+    {
+        l = left[k];
+        r = right[k];
+        left[k]  = l * (1.0f - balRangeL) + r * (1.0f - balRangeR);
+        right[k] = r * balRangeR          + l * balRangeL;
+    }
+}
+
+// balance where the left output already had dry/wet applied, but the right one did not yet.
+// the left output is mixed with the right one as it was, the right one with its dry/wet result.
+static inline
+void carla_postProcBalanceDryWet(float left[], float right[], const float dryRight[], const uint32_t frames,
+                                 const float balanceLeft, const float balanceRight, const float stepLeft, const float stepRight,
+                                 const float dryWet, const float dryWetStep) noexcept
+{
+    float balRangeL = (balanceLeft  + 1.0f)/2.0f;
+    float balRangeR = (balanceRight + 1.0f)/2.0f;
+    float value = dryWet;
+    float l, r;
+
+    for (uint32_t k=0; k < frames; ++k, balRangeL += stepLeft/2.0f, balRangeR += stepRight/2.0f, value += dryWetStep)
+    {
+        l = left[k];
+        r = right[k];
+        left[k]  = l * (1.0f - balRangeL) + r * (1.0f - balRangeR);
+        r = r * value + dryRight[k] * (1.0f - value);
+        right[k] = r * balRangeR + l * balRangeL;
+    }
+}
+
+static inline
+void carla_postProcVolume(float out[], const float in[], const uint32_t frames, const float volume, const float step) noexcept
+{
+    if (carla_isZero(step))
+    {
+        if (out == in)
+        {
+            if (carla_isNotEqual(volume, 1.0f))
+                carla_multiply(out, volume, frames);
+        }
+        else if (carla_isEqual(volume, 1.0f))
+        {
+            carla_copyFloats(out, in, frames);
+        }
+        else
+        {
+            carla_copyFloatsWithGain(out, in, volume, frames);
+        }
+        return;
+    }
+
+    float value = volume;
+
+    for (uint32_t k=0; k < frames; ++k, value += step)
+        out[k] = in[k] * value;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+/*
+ * Apply dry/wet, balance and volume to a plugin's audio outputs, ramping each value from 'from' to 'to' across the block.
+ * The outputs are done one at a time, each getting dry/wet, balance and then volume.
+ * This means the balance of a left output uses the right output from before its dry/wet.
+ *
+ * 'buffers' hold the processed audio starting at 'offset', they are modified in place.
+ * 'dryBuffers' hold the plugin input at the same offset, only needed for dry/wet.
+ * If 'latencyBuffers' is not null, the first 'latencyFrames' of the dry signal are taken from it.
+ * If 'outBuffers' is not null, the final result is written there starting at 'outOffset' instead.
+ */
+static inline
+void carla_postProcessAudio(float* const* const buffers, const uint32_t offset, const uint32_t numOuts,
+                            const float* const* const dryBuffers, const uint32_t numIns,
+                            const float* const* const latencyBuffers, const uint32_t latencyFrames,
+                            float* const* const outBuffers, const uint32_t outOffset, const uint32_t frames,
+                            const CarlaPostProcValues& from, const CarlaPostProcValues& to) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(buffers != nullptr,);
+    CARLA_SAFE_ASSERT_RETURN(frames > 0,);
+
+    const bool doDryWet  = carla_isNotEqual(from.dryWet, 1.0f) || carla_isNotEqual(to.dryWet, 1.0f);
+    const bool doBalance = carla_isNotEqual(from.balanceLeft, -1.0f) || carla_isNotEqual(from.balanceRight, 1.0f) ||
+                           carla_isNotEqual(to.balanceLeft,   -1.0f) || carla_isNotEqual(to.balanceRight,   1.0f);
+
+    CARLA_SAFE_ASSERT_RETURN(! doDryWet || dryBuffers != nullptr,);
+
+    const float framesf = static_cast<float>(frames);
+
+    const float dryWetStep   = (to.dryWet       - from.dryWet)       / framesf;
+    const float volumeStep   = (to.volume       - from.volume)       / framesf;
+    const float balLeftStep  = (to.balanceLeft  - from.balanceLeft)  / framesf;
+    const float balRightStep = (to.balanceRight - from.balanceRight) / framesf;
+
+    // the dry signal is the saved latency buffer followed by the current input
+    const uint32_t latframes = latencyBuffers != nullptr ? std::min(latencyFrames, frames) : 0;
+    const float    latframesf = static_cast<float>(latframes);
+    const bool     isMono = (numIns == 1);
+
+    for (uint32_t i=0; i < numOuts; ++i)
+    {
+        float* const out = buffers[i] + offset;
+        const uint32_t c = isMono ? 0 : i;
+
+        // Dry/Wet
+        if (doDryWet)
+        {
+            CARLA_SAFE_ASSERT_BREAK(c < numIns);
+
+            if (latframes != 0)
+                carla_postProcDryWet(out, latencyBuffers[c], latframes, from.dryWet, dryWetStep);
+
+            if (latframes < frames)
+                carla_postProcDryWet(out+latframes, dryBuffers[c] + offset, frames-latframes,
+                                     from.dryWet + dryWetStep * latframesf, dryWetStep);
+        }
+
+        // Balance, the right output of the pair is done together with the left one
+        if (doBalance && i+1 < numOuts)
+        {
+            float* const right = buffers[i+1] + offset;
+
+            if (doDryWet)
+            {
+                const uint32_t cr = isMono ? 0 : i+1;
+                CARLA_SAFE_ASSERT_BREAK(cr < numIns);
+
+                if (latframes != 0)
+                    carla_postProcBalanceDryWet(out, right, latencyBuffers[cr], latframes,
+                                                from.balanceLeft, from.balanceRight, balLeftStep, balRightStep,
+                                                from.dryWet, dryWetStep);
+
+                if (latframes < frames)
+                    carla_postProcBalanceDryWet(out+latframes, right+latframes, dryBuffers[cr] + offset, frames-latframes,
+                                                from.balanceLeft  + balLeftStep  * latframesf,
+                                                from.balanceRight + balRightStep * latframesf,
+                                                balLeftStep, balRightStep,
+                                                from.dryWet + dryWetStep * latframesf, dryWetStep);
+            }
+            else
+            {
+                carla_postProcBalance(out, right, frames, from.balanceLeft, from.balanceRight, balLeftStep, balRightStep);
+            }
+
+            // Volume (and buffer copy)
+            carla_postProcVolume(outBuffers != nullptr ? outBuffers[i] + outOffset : out, out, frames, from.volume, volumeStep);
+            ++i;
+            carla_postProcVolume(outBuffers != nullptr ? outBuffers[i] + outOffset : right, right, frames, from.volume, volumeStep);
+            continue;
+        }
+
+        // Volume (and buffer copy)
+        carla_postProcVolume(outBuffers != nullptr ? outBuffers[i] + outOffset : out, out, frames, from.volume, volumeStep);
+    }
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+#endif // CARLA_POST_PROC_UTILS_HPP_INCLUDED
@@ -134,7 +134,8 @@ public:
         // nothing to commit?
         CARLA_SAFE_ASSERT_RETURN(fBuffer->head != fBuffer->wrtn, false);
 
-        // all ok
+        // all ok, make sure the data is visible before the new head
+        __sync_synchronize();
         fBuffer->head = fBuffer->wrtn;
         fErrorWriting = false;
         return true;
@@ -335,6 +336,9 @@ protected:
         const uint32_t tail(fBuffer->tail);
         const uint32_t wrap((head > tail) ? 0 : fBuffer->size);
 
+        // pairs with commitWrite(), do not read data older than head
+        __sync_synchronize();
+
         if (size > wrap + head - tail)
         {
             if (! fErrorReading)
@@ -362,6 +366,8 @@ protected:
                 readto = 0;
         }
 
+        // done reading before the writer can reuse this space
+        __sync_synchronize();
         fBuffer->tail = readto;
         fErrorReading = false;
         return true;
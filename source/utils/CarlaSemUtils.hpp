@@ -50,6 +50,20 @@ struct carla_sem_t { int count; };
 struct carla_sem_t { sem_t sem; };
 #endif
 
+// spinning is only possible where taking the semaphore does not need a syscall
+#if defined(CARLA_USE_FUTEXES) || ! (defined(CARLA_OS_WIN) || defined(CARLA_OS_MAC))
+# define CARLA_SEM_CAN_SPIN 1
+#endif
+
+/*
+ * Default time spent busy-waiting on a semaphore before going to sleep, in microseconds.
+ */
+#ifdef CARLA_OS_LINUX
+static const uint kCarlaSemDefaultSpinUsecs = 20;
+#else
+static const uint kCarlaSemDefaultSpinUsecs = 0;
+#endif
+
 /*
  * Create a new semaphore, pre-allocated version.
  */
@@ -181,14 +195,94 @@ void carla_sem_post(carla_sem_t& sem, const bool server = true) noexcept
     return; (void)server;
 }
 
+#ifdef CARLA_SEM_CAN_SPIN
+/*
+ * Try to take a semaphore without blocking, as done on each busy-wait iteration.
+ */
+static inline
+bool carla_sem_trytake(carla_sem_t& sem) noexcept
+{
+# ifdef CARLA_USE_FUTEXES
+    // plain read first, so the cache line is not stolen from the poster
+    return (*(volatile int*)&sem.count != 0 && __sync_bool_compare_and_swap(&sem.count, 1, 0));
+# else
+    return (::sem_trywait(&sem.sem) == 0);
+# endif
+}
+
+/*
+ * Measure how many busy-wait iterations take one microsecond on this machine.
+ * Each iteration is timed as a whole, including the attempt to take the semaphore.
+ * Returns 0 on single-core systems, where spinning only delays the thread we are waiting for.
+ * This runs a timing loop, call it once during init and not from a realtime thread.
+ */
+static inline
+uint carla_sem_calibrate_spin() noexcept
+{
+    static const uint kIterations = 2000;
+
+    if (::sysconf(_SC_NPROCESSORS_ONLN) <= 1)
+        return 0;
+
+    // never posted, so every attempt fails like it does while waiting
+    carla_sem_t sem;
+    CARLA_SAFE_ASSERT_RETURN(carla_sem_create2(sem), 0);
+
+    const uint64_t start = carla_gettime_ns();
+
+    for (uint i=0; i < kIterations; ++i)
+    {
+        if (carla_sem_trytake(sem))
+            break;
+        carla_cpu_relax();
+    }
+
+    const uint64_t elapsed = carla_gettime_ns() - start;
+
+    carla_sem_destroy2(sem);
+
+    if (elapsed < 1000)
+        return kIterations;
+
+    const uint64_t perUsec = static_cast<uint64_t>(kIterations) * 1000 / elapsed;
+    return perUsec > 0 ? static_cast<uint>(perUsec) : 1;
+}
+#endif
+
+/*
+ * Busy-wait on a semaphore for up to 'iterations' attempts, without going to sleep.
+ * Use carla_sem_calibrate_spin() to know how many of them fit in some amount of time.
+ * Returns true if the semaphore was taken.
+ */
+static inline
+bool carla_sem_spinwait(carla_sem_t& sem, const uint iterations) noexcept
+{
+#ifdef CARLA_SEM_CAN_SPIN
+    for (uint i=0; i < iterations; ++i)
+    {
+        if (carla_sem_trytake(sem))
+            return true;
+        carla_cpu_relax();
+    }
+#endif
+    return false;
+
+    // may be unused
+    (void)sem; (void)iterations;
+}
+
 /*
  * Wait for a semaphore (lock).
+ * Busy-waits for up to 'spinIterations' attempts first, which avoids a sleep and wake-up when the post comes soon.
  */
 static inline
-bool carla_sem_timedwait(carla_sem_t& sem, const uint msecs, const bool server = true) noexcept
+bool carla_sem_timedwait(carla_sem_t& sem, const uint msecs, const bool server = true, const uint spinIterations = 0) noexcept
 {
     CARLA_SAFE_ASSERT_RETURN(msecs > 0, false);
 
+    if (spinIterations != 0 && carla_sem_spinwait(sem, spinIterations))
+        return true;
+
 #if defined(CARLA_OS_WIN)
     return (::WaitForSingleObject(sem.handle, msecs) == WAIT_OBJECT_0);
 #else
@@ -244,6 +338,46 @@ bool carla_sem_timedwait(carla_sem_t& sem, const uint msecs, const bool server =
     (void)server;
 }
 
+/*
+ * Wait for a semaphore (lock), without a timeout.
+ * Only use this when something is guaranteed to post, for example on shutdown.
+ */
+static inline
+bool carla_sem_wait(carla_sem_t& sem, const bool server = true) noexcept
+{
+#if defined(CARLA_OS_WIN)
+    return (::WaitForSingleObject(sem.handle, INFINITE) == WAIT_OBJECT_0);
+#elif defined(CARLA_OS_MAC)
+    try {
+        return (::semaphore_wait(server ? sem.sem : sem.sem2) == KERN_SUCCESS);
+    } CARLA_SAFE_EXCEPTION_RETURN("carla_sem_wait", false);
+#elif defined(CARLA_USE_FUTEXES)
+    for (;;)
+    {
+        if (__sync_bool_compare_and_swap(&sem.count, 1, 0))
+            return true;
+
+        if (::syscall(__NR_futex, &sem.count, FUTEX_WAIT, 0, nullptr, nullptr, 0) != 0)
+            if (errno != EAGAIN && errno != EINTR)
+                return false;
+    }
+#else
+    for (int ret;;)
+    {
+        try {
+            ret = ::sem_wait(&sem.sem);
+        } CARLA_SAFE_EXCEPTION_RETURN("carla_sem_wait", false);
+
+        if (ret == 0)
+            return true;
+        if (errno != EINTR)
+            return false;
+    }
+#endif
+    // may be unused
+    (void)server;
+}
+
 // -----------------------------------------------------------------------
 
 #endif // CARLA_SEM_UTILS_HPP_INCLUDED
@@ -0,0 +1,616 @@
+/*
+ * Carla SIMD utils
+ * Copyright (C) 2018 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the doc/GPL.txt file.
+ */
+
+#ifndef CARLA_SIMD_UTILS_HPP_INCLUDED
+#define CARLA_SIMD_UTILS_HPP_INCLUDED
+
+#include "CarlaUtils.hpp"
+
+#include <cmath>
+
+#if defined(__SSE2__) && (defined(__x86_64__) || defined(__i386__))
+# define CARLA_SIMD_SSE2
+# include <emmintrin.h>
+# if defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))
+#  define CARLA_SIMD_AVX
+#  include <immintrin.h>
+# endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+# define CARLA_SIMD_NEON
+# include <arm_neon.h>
+#endif
+
+// --------------------------------------------------------------------------------------------------------------------
+// Float kernels used for audio processing.
+// Every instruction set provides the same kernels, the best one is picked at runtime.
+// Unaligned pointers are fine, 'count' can be any value (including 0).
+
+struct CarlaFloatKernels {
+    const char* name;
+
+    // dest[i] += src[i]
+    void (*add)(float* dest, const float* src, std::size_t count);
+
+    // dest[i] += src[i] * gain
+    void (*addWithGain)(float* dest, const float* src, float gain, std::size_t count);
+
+    // dest[i] = src[i] * gain
+    void (*copyWithGain)(float* dest, const float* src, float gain, std::size_t count);
+
+    // data[i] *= multiplier
+    void (*multiply)(float* data, float multiplier, std::size_t count);
+
+    // highest absolute value, 0.0 for empty buffers
+    float (*findMaxAbs)(const float* data, std::size_t count);
+
+    // out[i] = out[i] * dryWet + dry[i] * (1 - dryWet)
+    void (*mixDryWet)(float* out, const float* dry, float dryWet, std::size_t count);
+
+    // left/right pair balance, the same as the plugin post-processing:
+    // newLeft  = left * (1 - balRangeL) + right * (1 - balRangeR)
+    // newRight = left * balRangeL       + right * balRangeR
+    void (*applyStereoBalance)(float* left, float* right, float balRangeL, float balRangeR, std::size_t count);
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+// Helpers
+
+namespace CarlaSimdHelpers {
+
+// ----------------------------------------------------------------------------------------------------------------
+// scalar reference
+
+static inline
+void scalar_add(float* dest, const float* src, const std::size_t count)
+{
+    for (std::size_t i=0; i<count; ++i)
+        dest[i] += src[i];
+}
+
+static inline
+void scalar_addWithGain(float* dest, const float* src, const float gain, const std::size_t count)
+{
+    for (std::size_t i=0; i<count; ++i)
+        dest[i] += src[i] * gain;
+}
+
+static inline
+void scalar_copyWithGain(float* dest, const float* src, const float gain, const std::size_t count)
+{
+    for (std::size_t i=0; i<count; ++i)
+        dest[i] = src[i] * gain;
+}
+
+static inline
+void scalar_multiply(float* data, const float multiplier, const std::size_t count)
+{
+    for (std::size_t i=0; i<count; ++i)
+        data[i] *= multiplier;
+}
+
+static inline
+float scalar_findMaxAbs(const float* data, const std::size_t count)
+{
+    float tmp, maxf = 0.0f;
+
+    for (std::size_t i=0; i<count; ++i)
+    {
+        tmp = std::abs(data[i]);
+
+        if (tmp > maxf)
+            maxf = tmp;
+    }
+
+    return maxf;
+}
+
+static inline
+void scalar_mixDryWet(float* out, const float* dry, const float dryWet, const std::size_t count)
+{
+    const float dryGain = 1.0f - dryWet;
+
+    for (std::size_t i=0; i<count; ++i)
+        out[i] = out[i] * dryWet + dry[i] * dryGain;
+}
+
+static inline
+void scalar_applyStereoBalance(float* left, float* right, const float balRangeL, const float balRangeR, const std::size_t count)
+{
+    const float gainLL = 1.0f - balRangeL;
+    const float gainRL = 1.0f - balRangeR;
+    float l, r;
+
+    for (std::size_t i=0; i<count; ++i)
+    {
+        l = left[i];
+        r = right[i];
+        left[i]  = l * gainLL    + r * gainRL;
+        right[i] = r * balRangeR + l * balRangeL;
+    }
+}
+
+#ifdef CARLA_SIMD_SSE2
+// ----------------------------------------------------------------------------------------------------------------
+// SSE2, 4 floats at a time
+
+static inline
+void sse2_add(float* dest, const float* src, const std::size_t count)
+{
+    std::size_t i=0;
+
+    for (; i+4 <= count; i += 4)
+        _mm_storeu_ps(dest+i, _mm_add_ps(_mm_loadu_ps(dest+i), _mm_loadu_ps(src+i)));
+
+    scalar_add(dest+i, src+i, count-i);
+}
+
+static inline
+void sse2_addWithGain(float* dest, const float* src, const float gain, const std::size_t count)
+{
+    const __m128 g = _mm_set1_ps(gain);
+    std::size_t i=0;
+
+    for (; i+4 <= count; i += 4)
+        _mm_storeu_ps(dest+i, _mm_add_ps(_mm_loadu_ps(dest+i), _mm_mul_ps(_mm_loadu_ps(src+i), g)));
+
+    scalar_addWithGain(dest+i, src+i, gain, count-i);
+}
+
+static inline
+void sse2_copyWithGain(float* dest, const float* src, const float gain, const std::size_t count)
+{
+    const __m128 g = _mm_set1_ps(gain);
+    std::size_t i=0;
+
+    for (; i+4 <= count; i += 4)
+        _mm_storeu_ps(dest+i, _mm_mul_ps(_mm_loadu_ps(src+i), g));
+
+    scalar_copyWithGain(dest+i, src+i, gain, count-i);
+}
+
+static inline
+void sse2_multiply(float* data, const float multiplier, const std::size_t count)
+{
+    const __m128 m = _mm_set1_ps(multiplier);
+    std::size_t i=0;
+
+    for (; i+4 <= count; i += 4)
+        _mm_storeu_ps(data+i, _mm_mul_ps(_mm_loadu_ps(data+i), m));
+
+    scalar_multiply(data+i, multiplier, count-i);
+}
+
+static inline
+float sse2_findMaxAbs(const float* data, const std::size_t count)
+{
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    __m128 maxv = _mm_setzero_ps();
+    std::size_t i=0;
+
+    // new values go first, so NaNs are skipped like in the scalar version
+    for (; i+4 <= count; i += 4)
+        maxv = _mm_max_ps(_mm_and_ps(_mm_loadu_ps(data+i), absMask), maxv);
+
+    float tmp[4];
+    _mm_storeu_ps(tmp, maxv);
+
+    float maxf = scalar_findMaxAbs(data+i, count-i);
+
+    for (int j=0; j<4; ++j)
+    {
+        if (tmp[j] > maxf)
+            maxf = tmp[j];
+    }
+
+    return maxf;
+}
+
+static inline
+void sse2_mixDryWet(float* out, const float* dry, const float dryWet, const std::size_t count)
+{
+    const __m128 wetGain = _mm_set1_ps(dryWet);
+    const __m128 dryGain = _mm_set1_ps(1.0f - dryWet);
+    std::size_t i=0;
+
+    for (; i+4 <= count; i += 4)
+        _mm_storeu_ps(out+i, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(out+i), wetGain),
+                                        _mm_mul_ps(_mm_loadu_ps(dry+i), dryGain)));
+
+    scalar_mixDryWet(out+i, dry+i, dryWet, count-i);
+}
+
+static inline
+void sse2_applyStereoBalance(float* left, float* right, const float balRangeL, const float balRangeR, const std::size_t count)
+{
+    const __m128 gainLL = _mm_set1_ps(1.0f - balRangeL);
+    const __m128 gainRL = _mm_set1_ps(1.0f - balRangeR);
+    const __m128 gainLR = _mm_set1_ps(balRangeL);
+    const __m128 gainRR = _mm_set1_ps(balRangeR);
+    std::size_t i=0;
+
+    for (; i+4 <= count; i += 4)
+    {
+        const __m128 l = _mm_loadu_ps(left+i);
+        const __m128 r = _mm_loadu_ps(right+i);
+        _mm_storeu_ps(left+i,  _mm_add_ps(_mm_mul_ps(l, gainLL), _mm_mul_ps(r, gainRL)));
+        _mm_storeu_ps(right+i, _mm_add_ps(_mm_mul_ps(r, gainRR), _mm_mul_ps(l, gainLR)));
+    }
+
+    scalar_applyStereoBalance(left+i, right+i, balRangeL, balRangeR, count-i);
+}
+#endif // CARLA_SIMD_SSE2
+
+#ifdef CARLA_SIMD_AVX
+// ----------------------------------------------------------------------------------------------------------------
+// AVX, 8 floats at a time.
+// Only built for the AVX target, must not be called unless the CPU supports it.
+
+# define CARLA_SIMD_AVX_FUNCTION static inline __attribute__((target("avx")))
+
+CARLA_SIMD_AVX_FUNCTION
+void avx_add(float* dest, const float* src, const std::size_t count)
+{
+    std::size_t i=0;
+
+    for (; i+8 <= count; i += 8)
+        _mm256_storeu_ps(dest+i, _mm256_add_ps(_mm256_loadu_ps(dest+i), _mm256_loadu_ps(src+i)));
+
+    for (; i<count; ++i)
+        dest[i] += src[i];
+}
+
+CARLA_SIMD_AVX_FUNCTION
+void avx_addWithGain(float* dest, const float* src, const float gain, const std::size_t count)
+{
+    const __m256 g = _mm256_set1_ps(gain);
+    std::size_t i=0;
+
+    for (; i+8 <= count; i += 8)
+        _mm256_storeu_ps(dest+i, _mm256_add_ps(_mm256_loadu_ps(dest+i), _mm256_mul_ps(_mm256_loadu_ps(src+i), g)));
+
+    for (; i<count; ++i)
+        dest[i] += src[i] * gain;
+}
+
+CARLA_SIMD_AVX_FUNCTION
+void avx_copyWithGain(float* dest, const float* src, const float gain, const std::size_t count)
+{
+    const __m256 g = _mm256_set1_ps(gain);
+    std::size_t i=0;
+
+    for (; i+8 <= count; i += 8)
+        _mm256_storeu_ps(dest+i, _mm256_mul_ps(_mm256_loadu_ps(src+i), g));
+
+    for (; i<count; ++i)
+        dest[i] = src[i] * gain;
+}
+
+CARLA_SIMD_AVX_FUNCTION
+void avx_multiply(float* data, const float multiplier, const std::size_t count)
+{
+    const __m256 m = _mm256_set1_ps(multiplier);
+    std::size_t i=0;
+
+    for (; i+8 <= count; i += 8)
+        _mm256_storeu_ps(data+i, _mm256_mul_ps(_mm256_loadu_ps(data+i), m));
+
+    for (; i<count; ++i)
+        data[i] *= multiplier;
+}
+
+CARLA_SIMD_AVX_FUNCTION
+float avx_findMaxAbs(const float* data, const std::size_t count)
+{
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    __m256 maxv = _mm256_setzero_ps();
+    std::size_t i=0;
+
+    for (; i+8 <= count; i += 8)
+        maxv = _mm256_max_ps(_mm256_and_ps(_mm256_loadu_ps(data+i), absMask), maxv);
+
+    float tmp[8];
+    _mm256_storeu_ps(tmp, maxv);
+
+    float absf, maxf = 0.0f;
+
+    for (; i<count; ++i)
+    {
+        absf = std::abs(data[i]);
+
+        if (absf > maxf)
+            maxf = absf;
+    }
+
+    for (int j=0; j<8; ++j)
+    {
+        if (tmp[j] > maxf)
+            maxf = tmp[j];
+    }
+
+    return maxf;
+}
+
+CARLA_SIMD_AVX_FUNCTION
+void avx_mixDryWet(float* out, const float* dry, const float dryWet, const std::size_t count)
+{
+    const float dryGainf = 1.0f - dryWet;
+    const __m256 wetGain = _mm256_set1_ps(dryWet);
+    const __m256 dryGain = _mm256_set1_ps(dryGainf);
+    std::size_t i=0;
+
+    for (; i+8 <= count; i += 8)
+        _mm256_storeu_ps(out+i, _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(out+i), wetGain),
+                                              _mm256_mul_ps(_mm256_loadu_ps(dry+i), dryGain)));
+
+    for (; i<count; ++i)
+        out[i] = out[i] * dryWet + dry[i] * dryGainf;
+}
+
+CARLA_SIMD_AVX_FUNCTION
+void avx_applyStereoBalance(float* left, float* right, const float balRangeL, const float balRangeR, const std::size_t count)
+{
+    const float gainLLf = 1.0f - balRangeL;
+    const float gainRLf = 1.0f - balRangeR;
+    const __m256 gainLL = _mm256_set1_ps(gainLLf);
+    const __m256 gainRL = _mm256_set1_ps(gainRLf);
+    const __m256 gainLR = _mm256_set1_ps(balRangeL);
+    const __m256 gainRR = _mm256_set1_ps(balRangeR);
+    std::size_t i=0;
+
+    for (; i+8 <= count; i += 8)
+    {
+        const __m256 l = _mm256_loadu_ps(left+i);
+        const __m256 r = _mm256_loadu_ps(right+i);
+        _mm256_storeu_ps(left+i,  _mm256_add_ps(_mm256_mul_ps(l, gainLL), _mm256_mul_ps(r, gainRL)));
+        _mm256_storeu_ps(right+i, _mm256_add_ps(_mm256_mul_ps(r, gainRR), _mm256_mul_ps(l, gainLR)));
+    }
+
+    for (float l, r; i<count; ++i)
+    {
+        l = left[i];
+        r = right[i];
+        left[i]  = l * gainLLf   + r * gainRLf;
+        right[i] = r * balRangeR + l * balRangeL;
+    }
+}
+
+# undef CARLA_SIMD_AVX_FUNCTION
+#endif // CARLA_SIMD_AVX
+
+#ifdef CARLA_SIMD_NEON
+// ----------------------------------------------------------------------------------------------------------------
+// NEON, 4 floats at a time
+
+static inline
+void neon_add(float* dest, const float* src, const std::size_t count)
+{
+    std::size_t i=0;
+
+    for (; i+4 <= count; i += 4)
+        vst1q_f32(dest+i, vaddq_f32(vld1q_f32(dest+i), vld1q_f32(src+i)));
+
+    scalar_add(dest+i, src+i, count-i);
+}
+
+static inline
+void neon_addWithGain(float* dest, const float* src, const float gain, const std::size_t count)
+{
+    const float32x4_t g = vdupq_n_f32(gain);
+    std::size_t i=0;
+
+    for (; i+4 <= count; i += 4)
+        vst1q_f32(dest+i, vaddq_f32(vld1q_f32(dest+i), vmulq_f32(vld1q_f32(src+i), g)));
+
+    scalar_addWithGain(dest+i, src+i, gain, count-i);
+}
+
+static inline
+void neon_copyWithGain(float* dest, const float* src, const float gain, const std::size_t count)
+{
+    const float32x4_t g = vdupq_n_f32(gain);
+    std::size_t i=0;
+
+    for (; i+4 <= count; i += 4)
+        vst1q_f32(dest+i, vmulq_f32(vld1q_f32(src+i), g));
+
+    scalar_copyWithGain(dest+i, src+i, gain, count-i);
+}
+
+static inline
+void neon_multiply(float* data, const float multiplier, const std::size_t count)
+{
+    const float32x4_t m = vdupq_n_f32(multiplier);
+    std::size_t i=0;
+
+    for (; i+4 <= count; i += 4)
+        vst1q_f32(data+i, vmulq_f32(vld1q_f32(data+i), m));
+
+    scalar_multiply(data+i, multiplier, count-i);
+}
+
+static inline
+float neon_findMaxAbs(const float* data, const std::size_t count)
+{
+    float32x4_t maxv = vdupq_n_f32(0.0f);
+    std::size_t i=0;
+
+    for (; i+4 <= count; i += 4)
+        maxv = vmaxq_f32(vabsq_f32(vld1q_f32(data+i)), maxv);
+
+    float tmp[4];
+    vst1q_f32(tmp, maxv);
+
+    float maxf = scalar_findMaxAbs(data+i, count-i);
+
+    for (int j=0; j<4; ++j)
+    {
+        if (tmp[j] > maxf)
+            maxf = tmp[j];
+    }
+
+    return maxf;
+}
+
+static inline
+void neon_mixDryWet(float* out, const float* dry, const float dryWet, const std::size_t count)
+{
+    const float32x4_t wetGain = vdupq_n_f32(dryWet);
+    const float32x4_t dryGain = vdupq_n_f32(1.0f - dryWet);
+    std::size_t i=0;
+
+    for (; i+4 <= count; i += 4)
+        vst1q_f32(out+i, vaddq_f32(vmulq_f32(vld1q_f32(out+i), wetGain),
+                                   vmulq_f32(vld1q_f32(dry+i), dryGain)));
+
+    scalar_mixDryWet(out+i, dry+i, dryWet, count-i);
+}
+
+static inline
+void neon_applyStereoBalance(float* left, float* right, const float balRangeL, const float balRangeR, const std::size_t count)
+{
+    const float32x4_t gainLL = vdupq_n_f32(1.0f - balRangeL);
+    const float32x4_t gainRL = vdupq_n_f32(1.0f - balRangeR);
+    const float32x4_t gainLR = vdupq_n_f32(balRangeL);
+    const float32x4_t gainRR = vdupq_n_f32(balRangeR);
+    std::size_t i=0;
+
+    for (; i+4 <= count; i += 4)
+    {
+        const float32x4_t l = vld1q_f32(left+i);
+        const float32x4_t r = vld1q_f32(right+i);
+        vst1q_f32(left+i,  vaddq_f32(vmulq_f32(l, gainLL), vmulq_f32(r, gainRL)));
+        vst1q_f32(right+i, vaddq_f32(vmulq_f32(r, gainRR), vmulq_f32(l, gainLR)));
+    }
+
+    scalar_applyStereoBalance(left+i, right+i, balRangeL, balRangeR, count-i);
+}
+#endif // CARLA_SIMD_NEON
+
+} // namespace CarlaSimdHelpers
+
+// --------------------------------------------------------------------------------------------------------------------
+// Kernel sets
+
+/*
+ * Plain C++ kernels, always available.
+ */
+static inline
+const CarlaFloatKernels* carla_getScalarFloatKernels() noexcept
+{
+    using namespace CarlaSimdHelpers;
+
+    static const CarlaFloatKernels kernels = {
+        "scalar",
+        scalar_add, scalar_addWithGain, scalar_copyWithGain, scalar_multiply,
+        scalar_findMaxAbs, scalar_mixDryWet, scalar_applyStereoBalance
+    };
+
+    return &kernels;
+}
+
+/*
+ * SSE2 kernels, null if not built for x86.
+ */
+static inline
+const CarlaFloatKernels* carla_getSSE2FloatKernels() noexcept
+{
+#ifdef CARLA_SIMD_SSE2
+    using namespace CarlaSimdHelpers;
+
+    static const CarlaFloatKernels kernels = {
+        "SSE2",
+        sse2_add, sse2_addWithGain, sse2_copyWithGain, sse2_multiply,
+        sse2_findMaxAbs, sse2_mixDryWet, sse2_applyStereoBalance
+    };
+
+    return &kernels;
+#else
+    return nullptr;
+#endif
+}
+
+/*
+ * AVX kernels, null if not built for x86 or if the current CPU does not support AVX.
+ */
+static inline
+const CarlaFloatKernels* carla_getAVXFloatKernels() noexcept
+{
+#ifdef CARLA_SIMD_AVX
+    using namespace CarlaSimdHelpers;
+
+    static const CarlaFloatKernels kernels = {
+        "AVX",
+        avx_add, avx_addWithGain, avx_copyWithGain, avx_multiply,
+        avx_findMaxAbs, avx_mixDryWet, avx_applyStereoBalance
+    };
+
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx") ? &kernels : nullptr;
+#else
+    return nullptr;
+#endif
+}
+
+/*
+ * NEON kernels, null if not built for ARM with NEON enabled.
+ */
+static inline
+const CarlaFloatKernels* carla_getNeonFloatKernels() noexcept
+{
+#ifdef CARLA_SIMD_NEON
+    using namespace CarlaSimdHelpers;
+
+    static const CarlaFloatKernels kernels = {
+        "NEON",
+        neon_add, neon_addWithGain, neon_copyWithGain, neon_multiply,
+        neon_findMaxAbs, neon_mixDryWet, neon_applyStereoBalance
+    };
+
+    return &kernels;
+#else
+    return nullptr;
+#endif
+}
+
+/*
+ * Best kernel set for the current CPU.
+ */
+static inline
+const CarlaFloatKernels* carla_detectFloatKernels() noexcept
+{
+    if (const CarlaFloatKernels* const kernels = carla_getAVXFloatKernels())
+        return kernels;
+    if (const CarlaFloatKernels* const kernels = carla_getSSE2FloatKernels())
+        return kernels;
+    if (const CarlaFloatKernels* const kernels = carla_getNeonFloatKernels())
+        return kernels;
+    return carla_getScalarFloatKernels();
+}
+
+/*
+ * Best kernel set for the current CPU, detected on first use.
+ */
+static inline
+const CarlaFloatKernels& carla_getFloatKernels() noexcept
+{
+    static const CarlaFloatKernels* const kernels = carla_detectFloatKernels();
+    return *kernels;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+#endif // CARLA_SIMD_UTILS_HPP_INCLUDED
@@ -18,16 +18,29 @@
 #include "CarlaStateUtils.hpp"
 
 #include "CarlaBackendUtils.hpp"
+#include "CarlaBase64Utils.hpp"
+#include "CarlaJuceUtils.hpp"
 #include "CarlaMathUtils.hpp"
 #include "CarlaMIDI.h"
 
+#include "water/containers/OwnedArray.h"
+#include "water/files/File.h"
+#include "water/files/FileInputStream.h"
 #include "water/streams/MemoryOutputStream.h"
+#include "water/text/StringArray.h"
 #include "water/xml/XmlElement.h"
 
-#include <string>
+#ifndef CARLA_OS_WIN
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+#endif
 
+using water::CharPointer_UTF8;
 using water::MemoryOutputStream;
+using water::OwnedArray;
 using water::String;
+using water::StringArray;
 using water::XmlElement;
 
 CARLA_BACKEND_START_NAMESPACE
@@ -54,49 +67,61 @@ static void getNewLineSplittedString(MemoryOutputStream& stream, const String& s
     stream << (raw+i);
 }
 
-// -----------------------------------------------------------------------
-// xmlSafeStringFast
+// Same as above, but encoding binary data as base64 straight into the stream.
+static void getNewLineSplittedBase64(MemoryOutputStream& stream, const void* const data, const std::size_t dataSize)
+{
+    // 90 bytes make exactly one 120 characters line
+    static const std::size_t kLineBytes = 90;
+    static const std::size_t kLineWidth = 120;
 
-/* Based on some code by James Kanze from stackoverflow
- * https://stackoverflow.com/questions/7724011/in-c-whats-the-fastest-way-to-replace-all-occurrences-of-a-substring-within */
+    const uint8_t* const bytes = static_cast<const uint8_t*>(data);
+    const std::size_t length = carla_base64EncodedSize(dataSize);
 
-static std::string replaceStdString(const std::string& original, const std::string& before, const std::string& after)
-{
-    std::string::const_iterator current = original.begin(), end = original.end(), next;
-    std::string retval;
+    stream.preallocate(stream.getDataSize() + length + length/kLineWidth + 3);
 
-    for (; (next = std::search(current, end, before.begin(), before.end())) != end;)
+    char line[kLineWidth+1];
+    line[kLineWidth] = '\n';
+
+    std::size_t i = 0;
+
+    for (; i+kLineBytes < dataSize; i += kLineBytes)
     {
-        retval.append(current, next);
-        retval.append(after);
-        current = next + static_cast<ssize_t>(before.size());
+        carla_base64Encode(bytes+i, kLineBytes, line);
+        stream.write(line, kLineWidth+1);
     }
-    retval.append(current, next);
-    return retval;
+
+    stream.write(line, carla_base64Encode(bytes+i, dataSize-i, line));
 }
 
-static std::string xmlSafeStringFast(const char* const cstring, const bool toXml)
+// -----------------------------------------------------------------------
+// writeXmlSafeString
+
+/* Escape a string for xml in a single pass, writing straight into the stream.
+ * Used for custom data values, which can be very large. */
+
+static void writeXmlSafeString(MemoryOutputStream& stream, const char* const cstring)
 {
-    std::string string(cstring);
+    const char* start = cstring;
+    const char* escaped;
 
-    if (toXml)
+    for (const char* c = cstring; *c != '\0'; ++c)
     {
-        string = replaceStdString(string, "&","&amp;");
-        string = replaceStdString(string, "<","&lt;");
-        string = replaceStdString(string, ">","&gt;");
-        string = replaceStdString(string, "'","&apos;");
-        string = replaceStdString(string, "\"","&quot;");
-    }
-    else
-    {
-        string = replaceStdString(string, "&lt;","<");
-        string = replaceStdString(string, "&gt;",">");
-        string = replaceStdString(string, "&apos;","'");
-        string = replaceStdString(string, "&quot;","\"");
-        string = replaceStdString(string, "&amp;","&");
+        switch (*c)
+        {
+        case '&':  escaped = "&amp;";  break;
+        case '<':  escaped = "&lt;";   break;
+        case '>':  escaped = "&gt;";   break;
+        case '\'': escaped = "&apos;"; break;
+        case '"':  escaped = "&quot;"; break;
+        default:   continue;
+        }
+
+        stream.write(start, static_cast<std::size_t>(c - start));
+        stream << escaped;
+        start = c + 1;
     }
 
-    return string;
+    stream << start;
 }
 
 // -----------------------------------------------------------------------
@@ -203,6 +228,8 @@ CarlaStateSave::CarlaStateSave() noexcept
       currentMidiBank(-1),
       currentMidiProgram(-1),
       chunk(nullptr),
+      rawChunk(nullptr),
+      rawChunkSize(0),
       parameters(),
       customData() {}
 
@@ -244,6 +271,9 @@ void CarlaStateSave::clear() noexcept
         chunk = nullptr;
     }
 
+    rawChunk     = nullptr;
+    rawChunkSize = 0;
+
     uniqueId = 0;
     options  = 0x0;
 
@@ -647,13 +677,13 @@ void CarlaStateSave::dumpToMemoryStream(MemoryOutputStream& content) const
         if (std::strcmp(stateCustomData->type, CUSTOM_DATA_TYPE_CHUNK) == 0 || std::strlen(stateCustomData->value) >= 128)
         {
             customDataXml << "    <Value>\n";
-            customDataXml << xmlSafeStringFast(stateCustomData->value, true);
+            writeXmlSafeString(customDataXml, stateCustomData->value);
             customDataXml << "\n    </Value>\n";
         }
         else
         {
             customDataXml << "    <Value>";
-            customDataXml << xmlSafeStringFast(stateCustomData->value, true);
+            writeXmlSafeString(customDataXml, stateCustomData->value);
             customDataXml << "</Value>\n";
         }
 
@@ -662,10 +692,14 @@ void CarlaStateSave::dumpToMemoryStream(MemoryOutputStream& content) const
         content << customDataXml;
     }
 
-    if (chunk != nullptr && chunk[0] != '\0')
+    if ((chunk != nullptr && chunk[0] != '\0') || rawChunkSize != 0)
     {
         MemoryOutputStream chunkXml, chunkSplt;
-        getNewLineSplittedString(chunkSplt, chunk);
+
+        if (chunk != nullptr && chunk[0] != '\0')
+            getNewLineSplittedString(chunkSplt, chunk);
+        else
+            getNewLineSplittedBase64(chunkSplt, rawChunk, rawChunkSize);
 
         chunkXml << "\n   <Chunk>\n";
         chunkXml << chunkSplt;
@@ -677,6 +711,1047 @@ void CarlaStateSave::dumpToMemoryStream(MemoryOutputStream& content) const
     content << "  </Data>\n";
 }
 
+
+// -----------------------------------------------------------------------
+// CarlaBinaryStateFile
+
+static const char     kBinaryStateMagic[8]    = { 'C', 'A', 'R', 'L', 'A', 'B', 'I', 'N' };
+static const uint32_t kBinaryStateVersion     = 2;
+static const uint32_t kBinaryStateHeaderSize  = 24;
+static const uint32_t kBinaryStateSectionSize = 24;
+static const uint32_t kBinaryStateBlobAlign   = 16;
+static const uint32_t kBinaryStateNullString  = 0xffffffff;
+
+enum BinaryStateSectionType {
+    kBinaryStateSectionInfo             = 1,
+    kBinaryStateSectionEngineSettings   = 2,
+    kBinaryStateSectionPatchbay         = 3,
+    kBinaryStateSectionExternalPatchbay = 4,
+    kBinaryStateSectionPlugin           = 5,
+    kBinaryStateSectionBlob             = 6
+};
+
+enum BinaryStateInfoFlags {
+    kBinaryStateInfoIsPreset = 0x1
+};
+
+enum BinaryStateChunkType {
+    kBinaryStateChunkNone = 0,
+    kBinaryStateChunkBlob = 1, // raw data in a blob section
+    kBinaryStateChunkText = 2  // chunk text that is not valid base64, kept as-is
+};
+
+static uint32_t readBinaryStateInt(const uint8_t* const data) noexcept
+{
+    return static_cast<uint32_t>(data[0])
+        | (static_cast<uint32_t>(data[1]) << 8)
+        | (static_cast<uint32_t>(data[2]) << 16)
+        | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+static uint64_t readBinaryStateInt64(const uint8_t* const data) noexcept
+{
+    return static_cast<uint64_t>(readBinaryStateInt(data)) | (static_cast<uint64_t>(readBinaryStateInt(data + 4)) << 32);
+}
+
+// Sequential reader for a section, every read is bounds-checked.
+struct BinaryStateReader {
+    const uint8_t* data;
+    const uint8_t* const end;
+
+    BinaryStateReader(const uint8_t* const d, const std::size_t size) noexcept
+        : data(d),
+          end(d + size) {}
+
+    bool readByte(uint8_t& value) noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN(end - data >= 1, false);
+        value = *data++;
+        return true;
+    }
+
+    bool readInt(uint32_t& value) noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN(end - data >= 4, false);
+        value = readBinaryStateInt(data);
+        data += 4;
+        return true;
+    }
+
+    bool readInt64(uint64_t& value) noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN(end - data >= 8, false);
+        value = readBinaryStateInt64(data);
+        data += 8;
+        return true;
+    }
+
+    bool readFloat(float& value) noexcept
+    {
+        uint32_t bits;
+        if (! readInt(bits))
+            return false;
+
+        std::memcpy(&value, &bits, sizeof(float));
+        return true;
+    }
+
+    // strings are nul-terminated and point into the data
+    bool readString(const char*& string) noexcept
+    {
+        uint32_t length;
+        if (! readInt(length))
+            return false;
+
+        if (length == kBinaryStateNullString)
+        {
+            string = nullptr;
+            return true;
+        }
+
+        CARLA_SAFE_ASSERT_RETURN(static_cast<std::size_t>(end - data) > length, false);
+        CARLA_SAFE_ASSERT_RETURN(data[length] == '\0', false);
+
+        string = reinterpret_cast<const char*>(data);
+        data += length + 1;
+        return true;
+    }
+};
+
+static const char* binaryStateStringDup(const char* const string)
+{
+    return string != nullptr ? carla_strdup(string) : nullptr;
+}
+
+static void writeBinaryStateString(MemoryOutputStream& stream, const char* const string)
+{
+    if (string == nullptr)
+    {
+        stream.writeInt(static_cast<int>(kBinaryStateNullString));
+        return;
+    }
+
+    const std::size_t length = std::strlen(string);
+
+    stream.writeInt(static_cast<int>(length));
+    stream.write(string, length + 1);
+}
+
+static void alignBinaryStateStream(MemoryOutputStream& stream, const std::size_t start, const std::size_t alignment)
+{
+    if (const std::size_t rest = (stream.getDataSize() - start) % alignment)
+        stream.writeRepeatedByte(0, alignment - rest);
+}
+
+// Decode a chunk, only if encoding it back gives the same text (ignoring whitespace), so conversions stay lossless.
+static bool getBinaryStateChunkFromText(const String& text, std::vector<uint8_t>& chunk)
+{
+    const String trimmed(text.removeCharacters(" \t\r\n"));
+
+    if (trimmed.isEmpty() || ! trimmed.containsOnly("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/="))
+        return false;
+
+    chunk = carla_getChunkFromBase64String(trimmed.toRawUTF8());
+
+    if (chunk.size() == 0)
+        return false;
+
+    return trimmed == CarlaString::asBase64(chunk.data(), chunk.size()).buffer();
+}
+
+CarlaBinaryStateFile::CarlaBinaryStateFile() noexcept
+    : fData(nullptr),
+      fSize(0),
+      fSectionCount(0),
+      fFlags(0),
+#ifdef CARLA_OS_WIN
+      fMapping(INVALID_HANDLE_VALUE),
+#endif
+      fMappedData(nullptr) {}
+
+CarlaBinaryStateFile::~CarlaBinaryStateFile() noexcept
+{
+    close();
+}
+
+bool CarlaBinaryStateFile::openFile(const char* const filename) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(filename != nullptr && filename[0] != '\0', false);
+
+    close();
+
+    std::size_t size = 0;
+
+#ifdef CARLA_OS_WIN
+    const HANDLE file = ::CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    CARLA_SAFE_ASSERT_RETURN(file != INVALID_HANDLE_VALUE, false);
+
+    LARGE_INTEGER fileSize;
+    if (::GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0)
+    {
+        size = static_cast<std::size_t>(fileSize.QuadPart);
+        fMapping = ::CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+        if (fMapping != nullptr)
+        {
+            fMappedData = ::MapViewOfFile(fMapping, FILE_MAP_READ, 0, 0, 0);
+
+            if (fMappedData == nullptr)
+            {
+                ::CloseHandle(fMapping);
+                fMapping = INVALID_HANDLE_VALUE;
+            }
+        }
+        else
+        {
+            fMapping = INVALID_HANDLE_VALUE;
+        }
+    }
+
+    ::CloseHandle(file);
+#else
+    const int fd = ::open(filename, O_RDONLY);
+    CARLA_SAFE_ASSERT_RETURN(fd >= 0, false);
+
+    struct stat st;
+    if (::fstat(fd, &st) == 0 && st.st_size > 0)
+    {
+        size = static_cast<std::size_t>(st.st_size);
+        fMappedData = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (fMappedData == MAP_FAILED)
+            fMappedData = nullptr;
+    }
+
+    ::close(fd);
+#endif
+
+    if (fMappedData == nullptr)
+    {
+        carla_stderr2("CarlaBinaryStateFile::openFile(\"%s\") - failed to map file", filename);
+        return false;
+    }
+
+    fData = static_cast<const uint8_t*>(fMappedData);
+    fSize = size;
+
+    if (openData(fData, fSize))
+        return true;
+
+    close();
+    return false;
+}
+
+bool CarlaBinaryStateFile::openData(const void* const data, const std::size_t size) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(isBinaryStateData(data, size), false);
+
+    const uint8_t* const bytes = static_cast<const uint8_t*>(data);
+
+    const uint32_t version      = readBinaryStateInt(bytes + 8);
+    const uint32_t sectionCount = readBinaryStateInt(bytes + 12);
+    const uint64_t indexOffset  = readBinaryStateInt64(bytes + 16);
+
+    if (version != kBinaryStateVersion)
+    {
+        carla_stderr2("CarlaBinaryStateFile::openData() - unsupported version %u", version);
+        return false;
+    }
+
+    CARLA_SAFE_ASSERT_RETURN(sectionCount > 0, false);
+    CARLA_SAFE_ASSERT_RETURN(indexOffset % 8 == 0, false);
+    CARLA_SAFE_ASSERT_RETURN(indexOffset <= size && (size - indexOffset) / kBinaryStateSectionSize >= sectionCount, false);
+
+    fData = bytes;
+    fSize = size;
+    fSectionCount = sectionCount;
+
+    const uint8_t* section;
+    std::size_t sectionSize;
+    uint32_t type;
+
+    for (uint32_t i=0; i < sectionCount; ++i)
+    {
+        if (! readSection(i, type, section, sectionSize))
+        {
+            fSectionCount = 0;
+            return false;
+        }
+    }
+
+    if (! readSection(0, type, section, sectionSize) || type != kBinaryStateSectionInfo || sectionSize < 4)
+    {
+        carla_stderr2("CarlaBinaryStateFile::openData() - missing info section");
+        fSectionCount = 0;
+        return false;
+    }
+
+    fFlags = readBinaryStateInt(section);
+    return true;
+}
+
+void CarlaBinaryStateFile::close() noexcept
+{
+    if (fMappedData != nullptr)
+    {
+#ifdef CARLA_OS_WIN
+        ::UnmapViewOfFile(fMappedData);
+        ::CloseHandle(fMapping);
+        fMapping = INVALID_HANDLE_VALUE;
+#else
+        ::munmap(fMappedData, fSize);
+#endif
+        fMappedData = nullptr;
+    }
+
+    fData = nullptr;
+    fSize = 0;
+    fSectionCount = 0;
+    fFlags = 0;
+}
+
+bool CarlaBinaryStateFile::isPreset() const noexcept
+{
+    return (fFlags & kBinaryStateInfoIsPreset) != 0;
+}
+
+uint32_t CarlaBinaryStateFile::getPluginCount() const noexcept
+{
+    const uint8_t* section;
+    std::size_t sectionSize;
+    uint32_t type, count = 0;
+
+    for (uint32_t i=0; i < fSectionCount; ++i)
+    {
+        if (readSection(i, type, section, sectionSize) && type == kBinaryStateSectionPlugin)
+            ++count;
+    }
+
+    return count;
+}
+
+bool CarlaBinaryStateFile::readSection(const uint32_t index, uint32_t& type, const uint8_t*& data, std::size_t& size) const noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(index < fSectionCount, false);
+
+    const uint8_t* const entry = fData + readBinaryStateInt64(fData + 16) + index * kBinaryStateSectionSize;
+
+    const uint64_t offset = readBinaryStateInt64(entry + 8);
+    const uint64_t length = readBinaryStateInt64(entry + 16);
+
+    CARLA_SAFE_ASSERT_RETURN(offset <= fSize && length <= fSize - offset, false);
+
+    type = readBinaryStateInt(entry);
+    data = fData + offset;
+    size = static_cast<std::size_t>(length);
+    return true;
+}
+
+// Find the n-th section of a type.
+bool CarlaBinaryStateFile::findSection(const uint32_t type, uint32_t index, const uint8_t*& data, std::size_t& size) const noexcept
+{
+    uint32_t sectionType;
+
+    for (uint32_t i=0; i < fSectionCount; ++i)
+    {
+        if (! readSection(i, sectionType, data, size) || sectionType != type)
+            continue;
+        if (index-- == 0)
+            return true;
+    }
+
+    return false;
+}
+
+bool CarlaBinaryStateFile::readStringPairs(const uint32_t type, std::vector<const char*>& strings) const
+{
+    const uint8_t* section;
+    std::size_t sectionSize;
+
+    if (! findSection(type, 0, section, sectionSize))
+        return false;
+
+    BinaryStateReader reader(section, sectionSize);
+
+    uint32_t count;
+    CARLA_SAFE_ASSERT_RETURN(reader.readInt(count), false);
+    CARLA_SAFE_ASSERT_RETURN(count <= sectionSize / 10, false);
+
+    strings.clear();
+    strings.reserve(count * 2);
+
+    const char* first;
+    const char* second;
+
+    for (uint32_t i=0; i < count; ++i)
+    {
+        CARLA_SAFE_ASSERT_RETURN(reader.readString(first) && reader.readString(second), false);
+        CARLA_SAFE_ASSERT_CONTINUE(first != nullptr && second != nullptr);
+
+        strings.push_back(first);
+        strings.push_back(second);
+    }
+
+    return true;
+}
+
+bool CarlaBinaryStateFile::getEngineSettings(std::vector<const char*>& namesAndValues) const
+{
+    return readStringPairs(kBinaryStateSectionEngineSettings, namesAndValues);
+}
+
+bool CarlaBinaryStateFile::getConnections(const bool external, std::vector<const char*>& sourcesAndTargets) const
+{
+    return readStringPairs(external ? kBinaryStateSectionExternalPatchbay : kBinaryStateSectionPatchbay, sourcesAndTargets);
+}
+
+static bool readBinaryStateSave(BinaryStateReader& reader, CarlaStateSave& stateSave,
+                                uint32_t& chunkType, uint32_t& blobIndex, const char*& chunkText)
+{
+    const char* string;
+    uint32_t u32;
+    uint64_t u64;
+    uint8_t u8;
+    float f;
+
+    if (! reader.readString(string)) return false;
+    stateSave.type = binaryStateStringDup(string);
+    if (! reader.readString(string)) return false;
+    stateSave.name = binaryStateStringDup(string);
+    if (! reader.readString(string)) return false;
+    stateSave.label = binaryStateStringDup(string);
+    if (! reader.readString(string)) return false;
+    stateSave.binary = binaryStateStringDup(string);
+
+    if (! reader.readInt64(u64)) return false;
+    stateSave.uniqueId = static_cast<int64_t>(u64);
+    if (! reader.readInt(u32)) return false;
+    stateSave.options = u32;
+
+    // internal data, always stored so bridges can read full files
+    uint8_t active;
+    float dryWet, volume, balanceLeft, balanceRight, panning;
+    uint32_t ctrlChannel;
+
+    if (! (reader.readByte(active) && reader.readFloat(dryWet) && reader.readFloat(volume) &&
+           reader.readFloat(balanceLeft) && reader.readFloat(balanceRight) && reader.readFloat(panning) &&
+           reader.readInt(ctrlChannel)))
+        return false;
+
+#ifndef BUILD_BRIDGE
+    stateSave.active       = active != 0;
+    stateSave.dryWet       = carla_fixedValue(0.0f, 1.0f, dryWet);
+    stateSave.volume       = carla_fixedValue(0.0f, 1.27f, volume);
+    stateSave.balanceLeft  = carla_fixedValue(-1.0f, 1.0f, balanceLeft);
+    stateSave.balanceRight = carla_fixedValue(-1.0f, 1.0f, balanceRight);
+    stateSave.panning      = carla_fixedValue(-1.0f, 1.0f, panning);
+
+    if (static_cast<int32_t>(ctrlChannel) >= 0 && static_cast<int32_t>(ctrlChannel) < MAX_MIDI_CHANNELS)
+        stateSave.ctrlChannel = static_cast<int8_t>(ctrlChannel);
+#endif
+
+    if (! reader.readInt(u32)) return false;
+    stateSave.currentProgramIndex = static_cast<int32_t>(u32) >= 0 ? static_cast<int32_t>(u32) : -1;
+    if (! reader.readString(string)) return false;
+    stateSave.currentProgramName = binaryStateStringDup(string);
+    if (! reader.readInt(u32)) return false;
+    stateSave.currentMidiBank = static_cast<int32_t>(u32) >= 0 ? static_cast<int32_t>(u32) : -1;
+    if (! reader.readInt(u32)) return false;
+    stateSave.currentMidiProgram = static_cast<int32_t>(u32) >= 0 ? static_cast<int32_t>(u32) : -1;
+
+    // parameters
+    uint32_t count;
+    if (! reader.readInt(count)) return false;
+
+    for (uint32_t i=0; i < count; ++i)
+    {
+        CarlaStateSave::Parameter* const stateParameter(new CarlaStateSave::Parameter());
+        stateSave.parameters.append(stateParameter);
+
+        if (! reader.readByte(u8)) return false;
+        stateParameter->dummy = u8 != 0;
+        if (! reader.readInt(u32)) return false;
+        stateParameter->index = static_cast<int32_t>(u32) >= 0 ? static_cast<int32_t>(u32) : -1;
+        if (! reader.readString(string)) return false;
+        stateParameter->name = binaryStateStringDup(string);
+        if (! reader.readString(string)) return false;
+        stateParameter->symbol = binaryStateStringDup(string);
+        if (! reader.readFloat(f)) return false;
+        stateParameter->value = f;
+
+        uint8_t midiChannel;
+        uint32_t midiCC;
+        if (! (reader.readByte(midiChannel) && reader.readInt(midiCC))) return false;
+
+#ifndef BUILD_BRIDGE
+        if (midiChannel < MAX_MIDI_CHANNELS)
+            stateParameter->midiChannel = midiChannel;
+        if (static_cast<int32_t>(midiCC) >= -1 && static_cast<int32_t>(midiCC) < MAX_MIDI_CONTROL)
+            stateParameter->midiCC = static_cast<int16_t>(static_cast<int32_t>(midiCC));
+#endif
+    }
+
+    // custom data
+    if (! reader.readInt(count)) return false;
+
+    for (uint32_t i=0; i < count; ++i)
+    {
+        const char* type;
+        const char* key;
+        const char* value;
+        if (! (reader.readString(type) && reader.readString(key) && reader.readString(value))) return false;
+
+        CarlaStateSave::CustomData* const stateCustomData(new CarlaStateSave::CustomData());
+        stateCustomData->type  = binaryStateStringDup(type);
+        stateCustomData->key   = binaryStateStringDup(key);
+        stateCustomData->value = binaryStateStringDup(value);
+
+        if (stateCustomData->isValid())
+        {
+            stateSave.customData.append(stateCustomData);
+        }
+        else
+        {
+            carla_stderr("Reading CustomData property failed, missing data");
+            delete stateCustomData;
+        }
+    }
+
+    // chunk
+    if (! reader.readInt(chunkType)) return false;
+
+    switch (chunkType)
+    {
+    case kBinaryStateChunkNone:
+        return true;
+    case kBinaryStateChunkBlob:
+        return reader.readInt(blobIndex);
+    case kBinaryStateChunkText:
+        return reader.readString(chunkText) && chunkText != nullptr;
+    default:
+        carla_stderr2("readBinaryStateSave() - invalid chunk type %u", chunkType);
+        return false;
+    }
+}
+
+bool CarlaBinaryStateFile::fillStateSave(const uint32_t index, CarlaStateSave& stateSave) const
+{
+    const uint8_t* section;
+    std::size_t sectionSize;
+
+    stateSave.clear();
+
+    CARLA_SAFE_ASSERT_RETURN(findSection(kBinaryStateSectionPlugin, index, section, sectionSize), false);
+
+    BinaryStateReader reader(section, sectionSize);
+
+    uint32_t chunkType = kBinaryStateChunkNone, blobIndex = 0;
+    const char* chunkText = nullptr;
+
+    bool ok;
+
+    try {
+        ok = readBinaryStateSave(reader, stateSave, chunkType, blobIndex, chunkText);
+    } CARLA_SAFE_EXCEPTION_RETURN("CarlaBinaryStateFile::fillStateSave", false);
+
+    if (ok && chunkType == kBinaryStateChunkBlob)
+    {
+        const uint8_t* blob;
+        std::size_t blobSize;
+        uint32_t type;
+
+        ok = readSection(blobIndex, type, blob, blobSize) && type == kBinaryStateSectionBlob;
+
+        if (ok)
+        {
+            stateSave.rawChunk     = blob;
+            stateSave.rawChunkSize = blobSize;
+        }
+    }
+    else if (ok && chunkType == kBinaryStateChunkText)
+    {
+        stateSave.chunk = carla_strdup(chunkText);
+    }
+
+    if (! ok)
+    {
+        carla_stderr2("CarlaBinaryStateFile::fillStateSave(%u) - malformed plugin data", index);
+        stateSave.clear();
+        return false;
+    }
+
+    return true;
+}
+
+static void writeXmlConnections(MemoryOutputStream& stream, const char* const tagName, const std::vector<const char*>& connections)
+{
+    stream << "\n <" << tagName << ">\n";
+
+    for (std::size_t i=0; i+1 < connections.size(); i += 2)
+    {
+        stream << "  <Connection>\n";
+        stream << "   <Source>" << xmlSafeString(connections[i],   true) << "</Source>\n";
+        stream << "   <Target>" << xmlSafeString(connections[i+1], true) << "</Target>\n";
+        stream << "  </Connection>\n";
+    }
+
+    stream << " </" << tagName << ">\n";
+}
+
+bool CarlaBinaryStateFile::writeAsXml(MemoryOutputStream& stream) const
+{
+    CARLA_SAFE_ASSERT_RETURN(fSectionCount > 0, false);
+
+    const bool preset = isPreset();
+    const uint32_t pluginCount = getPluginCount();
+    CARLA_SAFE_ASSERT_RETURN(! preset || pluginCount == 1, false);
+
+    stream << "<?xml version='1.0' encoding='UTF-8'?>\n";
+
+    if (preset)
+    {
+        CarlaStateSave stateSave;
+        CARLA_SAFE_ASSERT_RETURN(fillStateSave(0, stateSave), false);
+
+        stream << "<!DOCTYPE CARLA-PRESET>\n";
+        stream << "<CARLA-PRESET VERSION='2.0'>\n";
+        stateSave.dumpToMemoryStream(stream);
+        stream << "</CARLA-PRESET>\n";
+        return true;
+    }
+
+    stream << "<!DOCTYPE CARLA-PROJECT>\n";
+    stream << "<CARLA-PROJECT VERSION='2.0'>\n";
+
+    std::vector<const char*> strings;
+
+    if (getEngineSettings(strings))
+    {
+        stream << " <EngineSettings>\n";
+
+        for (std::size_t i=0; i+1 < strings.size(); i += 2)
+        {
+            const String settingName(CharPointer_UTF8(strings[i]));
+            CARLA_SAFE_ASSERT_CONTINUE(XmlElement::isValidXmlName(settingName));
+
+            stream << "  <" << settingName << ">" << xmlSafeString(strings[i+1], true) << "</" << settingName << ">\n";
+        }
+
+        stream << " </EngineSettings>\n";
+    }
+
+    for (uint32_t i=0; i < pluginCount; ++i)
+    {
+        CarlaStateSave stateSave;
+        CARLA_SAFE_ASSERT_RETURN(fillStateSave(i, stateSave), false);
+
+        stream << "\n";
+        stream << " <Plugin>\n";
+        stateSave.dumpToMemoryStream(stream);
+        stream << " </Plugin>\n";
+    }
+
+    if (getConnections(false, strings))
+        writeXmlConnections(stream, "Patchbay", strings);
+
+    if (getConnections(true, strings))
+        writeXmlConnections(stream, "ExternalPatchbay", strings);
+
+    stream << "</CARLA-PROJECT>\n";
+    return true;
+}
+
+bool CarlaBinaryStateFile::isBinaryStateData(const void* const data, const std::size_t size) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(data != nullptr, false);
+
+    return size >= kBinaryStateHeaderSize && std::memcmp(data, kBinaryStateMagic, sizeof(kBinaryStateMagic)) == 0;
+}
+
+bool CarlaBinaryStateFile::isBinaryStateFile(const char* const filename) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(filename != nullptr && filename[0] != '\0', false);
+
+    char header[kBinaryStateHeaderSize];
+
+    try {
+        const String jfilename = String(CharPointer_UTF8(filename));
+        const water::File file(jfilename);
+        water::FileInputStream stream(file);
+
+        if (stream.failedToOpen() || stream.read(header, kBinaryStateHeaderSize) != static_cast<int>(kBinaryStateHeaderSize))
+            return false;
+    } CARLA_SAFE_EXCEPTION_RETURN("CarlaBinaryStateFile::isBinaryStateFile", false);
+
+    return isBinaryStateData(header, kBinaryStateHeaderSize);
+}
+
+// -----------------------------------------------------------------------
+// CarlaBinaryStateWriter
+
+struct BinaryStateSection {
+    const uint32_t type;
+    MemoryOutputStream data;
+
+    BinaryStateSection(const uint32_t t) noexcept
+        : type(t),
+          data() {}
+
+    CARLA_DECLARE_NON_COPY_STRUCT(BinaryStateSection)
+};
+
+struct CarlaBinaryStateWriter::PrivateData {
+    const bool isPreset;
+
+    uint32_t numEngineSettings;
+    MemoryOutputStream engineSettings;
+
+    // everything after the info and engine settings sections, in file order
+    OwnedArray<BinaryStateSection> sections;
+
+    PrivateData(const bool preset)
+        : isPreset(preset),
+          numEngineSettings(0),
+          engineSettings(),
+          sections() {}
+
+    // index of the section about to be added
+    uint32_t nextSectionIndex() const noexcept
+    {
+        return 2 + static_cast<uint32_t>(sections.size());
+    }
+
+    CARLA_DECLARE_NON_COPY_STRUCT(PrivateData)
+};
+
+CarlaBinaryStateWriter::CarlaBinaryStateWriter(const bool isPreset)
+    : pData(new PrivateData(isPreset)) {}
+
+CarlaBinaryStateWriter::~CarlaBinaryStateWriter() noexcept
+{
+    delete pData;
+}
+
+void CarlaBinaryStateWriter::addEngineSetting(const char* const name, const char* const value)
+{
+    CARLA_SAFE_ASSERT_RETURN(name != nullptr && name[0] != '\0',);
+    CARLA_SAFE_ASSERT_RETURN(value != nullptr,);
+
+    writeBinaryStateString(pData->engineSettings, name);
+    writeBinaryStateString(pData->engineSettings, value);
+    ++pData->numEngineSettings;
+}
+
+void CarlaBinaryStateWriter::addConnections(const bool external, const char* const* const connections)
+{
+    CARLA_SAFE_ASSERT_RETURN(connections != nullptr,);
+
+    BinaryStateSection* const section(new BinaryStateSection(external ? kBinaryStateSectionExternalPatchbay
+                                                                      : kBinaryStateSectionPatchbay));
+    pData->sections.add(section);
+
+    uint32_t count = 0;
+
+    for (int i=0; connections[i] != nullptr && connections[i+1] != nullptr; i += 2)
+    {
+        if (connections[i][0] != '\0' && connections[i+1][0] != '\0')
+            ++count;
+    }
+
+    section->data.writeInt(static_cast<int>(count));
+
+    for (int i=0; connections[i] != nullptr && connections[i+1] != nullptr; i += 2)
+    {
+        const char* const connSource(connections[i]);
+        const char* const connTarget(connections[i+1]);
+
+        CARLA_SAFE_ASSERT_CONTINUE(connSource[0] != '\0');
+        CARLA_SAFE_ASSERT_CONTINUE(connTarget[0] != '\0');
+
+        writeBinaryStateString(section->data, connSource);
+        writeBinaryStateString(section->data, connTarget);
+    }
+}
+
+void CarlaBinaryStateWriter::addStateSave(const CarlaStateSave& stateSave)
+{
+    CARLA_SAFE_ASSERT_RETURN(! pData->isPreset || pData->sections.size() == 0,);
+
+    // the chunk goes right before its plugin
+    uint32_t chunkType = kBinaryStateChunkNone, blobIndex = 0;
+
+    if (stateSave.rawChunk != nullptr && stateSave.rawChunkSize != 0)
+    {
+        blobIndex = pData->nextSectionIndex();
+        chunkType = kBinaryStateChunkBlob;
+
+        BinaryStateSection* const blob(new BinaryStateSection(kBinaryStateSectionBlob));
+        blob->data.write(stateSave.rawChunk, stateSave.rawChunkSize);
+        pData->sections.add(blob);
+    }
+    else if (stateSave.chunk != nullptr && stateSave.chunk[0] != '\0')
+    {
+        std::vector<uint8_t> chunk;
+
+        if (getBinaryStateChunkFromText(stateSave.chunk, chunk))
+        {
+            blobIndex = pData->nextSectionIndex();
+            chunkType = kBinaryStateChunkBlob;
+
+            BinaryStateSection* const blob(new BinaryStateSection(kBinaryStateSectionBlob));
+            blob->data.write(chunk.data(), chunk.size());
+            pData->sections.add(blob);
+        }
+        else
+        {
+            chunkType = kBinaryStateChunkText;
+        }
+    }
+
+    BinaryStateSection* const section(new BinaryStateSection(kBinaryStateSectionPlugin));
+    MemoryOutputStream& out(section->data);
+
+    writeBinaryStateString(out, stateSave.type);
+    writeBinaryStateString(out, stateSave.name);
+    writeBinaryStateString(out, stateSave.label);
+    writeBinaryStateString(out, stateSave.binary);
+    out.writeInt64(stateSave.uniqueId);
+    out.writeInt(static_cast<int>(stateSave.options));
+
+#ifndef BUILD_BRIDGE
+    out.writeByte(stateSave.active ? 1 : 0);
+    out.writeFloat(stateSave.dryWet);
+    out.writeFloat(stateSave.volume);
+    out.writeFloat(stateSave.balanceLeft);
+    out.writeFloat(stateSave.balanceRight);
+    out.writeFloat(stateSave.panning);
+    out.writeInt(stateSave.ctrlChannel);
+#else
+    out.writeByte(0);
+    out.writeFloat(1.0f);
+    out.writeFloat(1.0f);
+    out.writeFloat(-1.0f);
+    out.writeFloat(1.0f);
+    out.writeFloat(0.0f);
+    out.writeInt(-1);
+#endif
+
+    out.writeInt(stateSave.currentProgramIndex);
+    writeBinaryStateString(out, stateSave.currentProgramName);
+    out.writeInt(stateSave.currentMidiBank);
+    out.writeInt(stateSave.currentMidiProgram);
+
+    out.writeInt(static_cast<int>(stateSave.parameters.count()));
+
+    for (CarlaStateSave::ParameterItenerator it = stateSave.parameters.begin2(); it.valid(); it.next())
+    {
+        const CarlaStateSave::Parameter* const stateParameter(it.getValue(nullptr));
+        CARLA_SAFE_ASSERT_CONTINUE(stateParameter != nullptr);
+
+        out.writeByte(stateParameter->dummy ? 1 : 0);
+        out.writeInt(stateParameter->index);
+        writeBinaryStateString(out, stateParameter->name);
+        writeBinaryStateString(out, stateParameter->symbol);
+        out.writeFloat(stateParameter->value);
+#ifndef BUILD_BRIDGE
+        out.writeByte(static_cast<char>(stateParameter->midiChannel));
+        out.writeInt(stateParameter->midiCC);
+#else
+        out.writeByte(0);
+        out.writeInt(-1);
+#endif
+    }
+
+    uint32_t numCustomData = 0;
+
+    for (CarlaStateSave::CustomDataItenerator it = stateSave.customData.begin2(); it.valid(); it.next())
+    {
+        const CarlaStateSave::CustomData* const stateCustomData(it.getValue(nullptr));
+
+        if (stateCustomData != nullptr && stateCustomData->isValid())
+            ++numCustomData;
+    }
+
+    out.writeInt(static_cast<int>(numCustomData));
+
+    for (CarlaStateSave::CustomDataItenerator it = stateSave.customData.begin2(); it.valid(); it.next())
+    {
+        const CarlaStateSave::CustomData* const stateCustomData(it.getValue(nullptr));
+        CARLA_SAFE_ASSERT_CONTINUE(stateCustomData != nullptr);
+        CARLA_SAFE_ASSERT_CONTINUE(stateCustomData->isValid());
+
+        writeBinaryStateString(out, stateCustomData->type);
+        writeBinaryStateString(out, stateCustomData->key);
+        writeBinaryStateString(out, stateCustomData->value);
+    }
+
+    out.writeInt(static_cast<int>(chunkType));
+
+    if (chunkType == kBinaryStateChunkBlob)
+        out.writeInt(static_cast<int>(blobIndex));
+    else if (chunkType == kBinaryStateChunkText)
+        writeBinaryStateString(out, stateSave.chunk);
+
+    pData->sections.add(section);
+}
+
+bool CarlaBinaryStateWriter::writeToStream(MemoryOutputStream& stream) const
+{
+    const uint32_t sectionCount = pData->nextSectionIndex();
+    const std::size_t start = stream.getDataSize();
+
+    // header and section index, offsets are relative to the start of the file
+    stream.write(kBinaryStateMagic, sizeof(kBinaryStateMagic));
+    stream.writeInt(static_cast<int>(kBinaryStateVersion));
+    stream.writeInt(static_cast<int>(sectionCount));
+    stream.writeInt64(kBinaryStateHeaderSize);
+
+    uint64_t offset = kBinaryStateHeaderSize + sectionCount * kBinaryStateSectionSize;
+
+    stream.writeInt(kBinaryStateSectionInfo);
+    stream.writeInt(0);
+    stream.writeInt64(static_cast<water::int64>(offset));
+    stream.writeInt64(4);
+    offset += 4;
+
+    stream.writeInt(kBinaryStateSectionEngineSettings);
+    stream.writeInt(0);
+    stream.writeInt64(static_cast<water::int64>(offset));
+    stream.writeInt64(static_cast<water::int64>(4 + pData->engineSettings.getDataSize()));
+    offset += 4 + pData->engineSettings.getDataSize();
+
+    for (int i=0, size=pData->sections.size(); i < size; ++i)
+    {
+        const BinaryStateSection* const section(pData->sections.getUnchecked(i));
+
+        if (section->type == kBinaryStateSectionBlob)
+            offset = (offset + kBinaryStateBlobAlign - 1) / kBinaryStateBlobAlign * kBinaryStateBlobAlign;
+
+        stream.writeInt(static_cast<int>(section->type));
+        stream.writeInt(0);
+        stream.writeInt64(static_cast<water::int64>(offset));
+        stream.writeInt64(static_cast<water::int64>(section->data.getDataSize()));
+        offset += section->data.getDataSize();
+    }
+
+    stream.writeInt(pData->isPreset ? kBinaryStateInfoIsPreset : 0);
+
+    stream.writeInt(static_cast<int>(pData->numEngineSettings));
+    stream << pData->engineSettings;
+
+    for (int i=0, size=pData->sections.size(); i < size; ++i)
+    {
+        const BinaryStateSection* const section(pData->sections.getUnchecked(i));
+
+        if (section->type == kBinaryStateSectionBlob)
+            alignBinaryStateStream(stream, start, kBinaryStateBlobAlign);
+
+        stream << section->data;
+    }
+
+    return stream.getDataSize() - start == offset;
+}
+
+// Collects the connections of a patchbay element into a null-terminated list of source and target pairs.
+static void getXmlConnections(const XmlElement* const xmlElement, StringArray& strings, std::vector<const char*>& connections)
+{
+    for (XmlElement* patchElem = xmlElement->getFirstChildElement(); patchElem != nullptr; patchElem = patchElem->getNextElement())
+    {
+        if (! patchElem->getTagName().equalsIgnoreCase("connection"))
+            continue;
+
+        String sourcePort, targetPort;
+
+        for (XmlElement* connElem = patchElem->getFirstChildElement(); connElem != nullptr; connElem = connElem->getNextElement())
+        {
+            const String& tag(connElem->getTagName());
+            const String  text(connElem->getAllSubText().trim());
+
+            /**/ if (tag.equalsIgnoreCase("source"))
+                sourcePort = xmlSafeString(text, false);
+            else if (tag.equalsIgnoreCase("target"))
+                targetPort = xmlSafeString(text, false);
+        }
+
+        if (sourcePort.isNotEmpty() && targetPort.isNotEmpty())
+        {
+            strings.add(sourcePort);
+            strings.add(targetPort);
+        }
+    }
+
+    connections.clear();
+
+    for (int i=0; i < strings.size(); ++i)
+        connections.push_back(strings[i].toRawUTF8());
+
+    connections.push_back(nullptr);
+}
+
+bool CarlaBinaryStateWriter::writeFromXmlElement(const XmlElement* const xmlElement, MemoryOutputStream& stream)
+{
+    CARLA_SAFE_ASSERT_RETURN(xmlElement != nullptr, false);
+
+    const String& xmlType(xmlElement->getTagName());
+    const bool isPreset(xmlType.equalsIgnoreCase("carla-preset"));
+
+    CARLA_SAFE_ASSERT_RETURN(isPreset || xmlType.equalsIgnoreCase("carla-project"), false);
+
+    CarlaBinaryStateWriter writer(isPreset);
+
+    if (isPreset)
+    {
+        CarlaStateSave stateSave;
+        CARLA_SAFE_ASSERT_RETURN(stateSave.fillFromXmlElement(xmlElement), false);
+
+        writer.addStateSave(stateSave);
+        return writer.writeToStream(stream);
+    }
+
+    bool hasPatchbay = false, hasExternalPatchbay = false;
+    StringArray strings;
+    std::vector<const char*> connections;
+
+    for (XmlElement* elem = xmlElement->getFirstChildElement(); elem != nullptr; elem = elem->getNextElement())
+    {
+        const String& tagName(elem->getTagName());
+
+        if (tagName.equalsIgnoreCase("enginesettings"))
+        {
+            for (XmlElement* settElem = elem->getFirstChildElement(); settElem != nullptr; settElem = settElem->getNextElement())
+            {
+                if (settElem->isTextElement())
+                    continue;
+
+                writer.addEngineSetting(settElem->getTagName().toRawUTF8(), settElem->getAllSubText().trim().toRawUTF8());
+            }
+        }
+        else if (tagName.equalsIgnoreCase("plugin"))
+        {
+            CarlaStateSave stateSave;
+            CARLA_SAFE_ASSERT_CONTINUE(stateSave.fillFromXmlElement(elem));
+
+            writer.addStateSave(stateSave);
+        }
+        else if (tagName.equalsIgnoreCase("patchbay") && ! hasPatchbay)
+        {
+            hasPatchbay = true;
+            strings.clear();
+            getXmlConnections(elem, strings, connections);
+            writer.addConnections(false, connections.data());
+        }
+        else if (tagName.equalsIgnoreCase("externalpatchbay") && ! hasExternalPatchbay)
+        {
+            hasExternalPatchbay = true;
+            strings.clear();
+            getXmlConnections(elem, strings, connections);
+            writer.addConnections(true, connections.data());
+        }
+    }
+
+    return writer.writeToStream(stream);
+}
+
 // -----------------------------------------------------------------------
 
 CARLA_BACKEND_END_NAMESPACE
@@ -23,6 +23,8 @@
 
 #include "water/text/String.h"
 
+#include <vector>
+
 CARLA_BACKEND_START_NAMESPACE
 
 // -----------------------------------------------------------------------
@@ -85,6 +87,8 @@ struct CarlaStateSave {
     int32_t     currentMidiBank;
     int32_t     currentMidiProgram;
     const char* chunk;
+    const void* rawChunk; // chunk as raw data, from a binary state file or a plugin while saving
+    std::size_t rawChunkSize;
 
     ParameterList parameters;
     CustomDataList customData;
@@ -121,6 +125,119 @@ water::String xmlSafeString(const water::String& string, const bool toXml)
         return newString.replace("&lt;","<").replace("&gt;",">").replace("&apos;","'").replace("&quot;","\"").replace("&amp;","&");
 }
 
+// -----------------------------------------------------------------------
+// Binary project and preset files
+//
+// These hold the same data as .carxp and .carxs files, written straight from CarlaStateSave and read straight back into it.
+// Everything is little-endian, the layout is:
+//  - header: "CARLABIN" magic, format version, section count and section index offset
+//  - section index: type, offset and size of each section
+//  - section 0: file info, telling projects and presets apart
+//  - engine settings and patchbay connections as lists of string pairs, projects only
+//  - one section per plugin state, with strings stored inline
+//  - one section per plugin chunk, holding the raw data aligned to 16 bytes
+// Files are memory-mapped when opened, so chunk data goes to plugins without being copied or decoded.
+
+class CarlaBinaryStateFile
+{
+public:
+    CarlaBinaryStateFile() noexcept;
+    ~CarlaBinaryStateFile() noexcept;
+
+    /*
+     * Map a binary state file into memory and validate its header and section index.
+     */
+    bool openFile(const char* const filename) noexcept;
+
+    /*
+     * Use binary state data from memory, which must stay valid until close() is called.
+     */
+    bool openData(const void* const data, const std::size_t size) noexcept;
+
+    void close() noexcept;
+
+    bool isPreset() const noexcept;
+    uint32_t getPluginCount() const noexcept;
+
+    /*
+     * Fill a plugin state from the file.
+     * Chunks are set as rawChunk, pointing into the file data, valid while the file is open.
+     */
+    bool fillStateSave(const uint32_t index, CarlaStateSave& stateSave) const;
+
+    /*
+     * Get the engine settings as name and value pairs, pointing into the file data.
+     */
+    bool getEngineSettings(std::vector<const char*>& namesAndValues) const;
+
+    /*
+     * Get the internal or external patchbay connections as source and target pairs, pointing into the file data.
+     * Returns false if the project did not save them.
+     */
+    bool getConnections(const bool external, std::vector<const char*>& sourcesAndTargets) const;
+
+    /*
+     * Write the data as a regular .carxp or .carxs document.
+     */
+    bool writeAsXml(water::MemoryOutputStream& stream) const;
+
+    static bool isBinaryStateData(const void* const data, const std::size_t size) noexcept;
+    static bool isBinaryStateFile(const char* const filename) noexcept;
+
+private:
+    const uint8_t* fData;
+    std::size_t    fSize;
+    uint32_t       fSectionCount;
+    uint32_t       fFlags;
+
+#ifdef CARLA_OS_WIN
+    HANDLE fMapping;
+#endif
+    void* fMappedData;
+
+    bool readSection(const uint32_t index, uint32_t& type, const uint8_t*& data, std::size_t& size) const noexcept;
+    bool findSection(const uint32_t type, uint32_t index, const uint8_t*& data, std::size_t& size) const noexcept;
+    bool readStringPairs(const uint32_t type, std::vector<const char*>& strings) const;
+
+    CARLA_DECLARE_NON_COPY_CLASS(CarlaBinaryStateFile)
+};
+
+// -----------------------------------------------------------------------
+// Writes binary project and preset files, see above for the layout.
+
+class CarlaBinaryStateWriter
+{
+public:
+    CarlaBinaryStateWriter(const bool isPreset);
+    ~CarlaBinaryStateWriter() noexcept;
+
+    void addEngineSetting(const char* const name, const char* const value);
+
+    /*
+     * Add the internal or external patchbay connections, as a null-terminated list of source and target pairs.
+     */
+    void addConnections(const bool external, const char* const* const connections);
+
+    /*
+     * Add a plugin state.
+     * The chunk is taken from rawChunk if set, otherwise base64 chunk text is decoded.
+     */
+    void addStateSave(const CarlaStateSave& stateSave);
+
+    bool writeToStream(water::MemoryOutputStream& stream) const;
+
+    /*
+     * Convert a .carxp or .carxs document into binary state data.
+     */
+    static bool writeFromXmlElement(const water::XmlElement* const xmlElement, water::MemoryOutputStream& stream);
+
+private:
+    struct PrivateData;
+    PrivateData* const pData;
+
+    CARLA_DECLARE_NON_COPY_CLASS(CarlaBinaryStateWriter)
+};
+
 // -----------------------------------------------------------------------
 
 CARLA_BACKEND_END_NAMESPACE
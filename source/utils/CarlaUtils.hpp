@@ -37,6 +37,7 @@
 # include <winsock2.h>
 # include <windows.h>
 #else
+# include <ctime>
 # include <unistd.h>
 #endif
 
@@ -291,6 +292,56 @@ void carla_msleep(const uint msecs) noexcept
     } CARLA_SAFE_EXCEPTION("carla_msleep");
 }
 
+/*
+ * Sleep for 'usecs' microseconds.
+ * On Windows this has millisecond precision, shorter sleeps only yield the CPU.
+ */
+static inline
+void carla_usleep(const uint usecs) noexcept
+{
+    CARLA_SAFE_ASSERT_RETURN(usecs > 0,);
+
+    try {
+#ifdef CARLA_OS_WIN
+        ::Sleep(usecs / 1000);
+#else
+        ::usleep(usecs);
+#endif
+    } CARLA_SAFE_EXCEPTION("carla_usleep");
+}
+
+/*
+ * Hint the CPU that we are inside a busy-wait loop.
+ */
+static inline
+void carla_cpu_relax() noexcept
+{
+#if defined(__i386__) || defined(__x86_64__)
+    __asm__ __volatile__("pause");
+#elif defined(__aarch64__) || defined(__ARM_ARCH_7A__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+/*
+ * Get the current time of a monotonic clock, in nanoseconds.
+ * Values are comparable between processes, except on Windows.
+ */
+static inline
+uint64_t carla_gettime_ns() noexcept
+{
+#ifdef CARLA_OS_WIN
+    LARGE_INTEGER freq, count;
+    ::QueryPerformanceFrequency(&freq);
+    ::QueryPerformanceCounter(&count);
+    return static_cast<uint64_t>(static_cast<double>(count.QuadPart) * 1000000000.0 / static_cast<double>(freq.QuadPart));
+#else
+    timespec ts;
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+#endif
+}
+
 // --------------------------------------------------------------------------------------------------------------------
 // carla_setenv
 
@@ -0,0 +1,265 @@
+/*
+ * Carla Worker Pool
+ * Copyright (C) 2018 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the doc/GPL.txt file.
+ */
+
+#ifndef CARLA_WORKER_POOL_HPP_INCLUDED
+#define CARLA_WORKER_POOL_HPP_INCLUDED
+
+#include "CarlaSemUtils.hpp"
+#include "CarlaThread.hpp"
+
+// -----------------------------------------------------------------------
+// CarlaWorkerPool class
+
+/*
+ * A pool of pre-spawned threads that help the audio thread run a job.
+ * The audio thread calls runJob(), which wakes the workers and runs the job on the calling thread too.
+ * runJob() only returns once no worker is touching the job anymore.
+ * Workers spin for a short while after each job before going to sleep on a semaphore,
+ * so back-to-back audio periods usually do not need any syscall to wake them up.
+ * Nothing is allocated or locked while a job is running.
+ */
+class CarlaWorkerPool
+{
+public:
+    /*
+     * A job to be run by the pool.
+     * run() is called concurrently by the caller of runJob() and by every awake worker,
+     * it must split the work between its callers by itself.
+     * Workers may return as soon as there is nothing left for them to take right now,
+     * but the calling thread must only return once every part of the job has been taken.
+     * runJob() then waits for the workers to finish their parts.
+     */
+    struct Job {
+        Job() noexcept {}
+        virtual ~Job() {}
+        virtual void run(const bool fromWorker) noexcept = 0;
+
+        CARLA_DECLARE_NON_COPY_STRUCT(Job)
+    };
+
+    /*
+     * Constructor.
+     */
+    CarlaWorkerPool() noexcept
+        : fWorkers(nullptr),
+          fNumWorkers(0),
+          fJob(nullptr),
+          fGeneration(0),
+          fActiveWorkers(0),
+          fJobClosed(1) {}
+
+    /*
+     * Destructor.
+     */
+    ~CarlaWorkerPool() noexcept
+    {
+        stop();
+    }
+
+    /*
+     * Spawn 'numWorkers' threads, stopping any previous ones.
+     * Must not be called while a job is running.
+     */
+    bool start(const uint numWorkers) noexcept
+    {
+        stop();
+
+        if (numWorkers == 0)
+            return true;
+
+        try {
+            fWorkers = new Worker[numWorkers];
+        } CARLA_SAFE_EXCEPTION_RETURN("CarlaWorkerPool::start", false);
+
+        for (uint i=0; i < numWorkers; ++i)
+        {
+            Worker& worker(fWorkers[i]);
+            worker.fPool = this;
+            worker.fLastGeneration = fGeneration;
+
+            if (! worker.startThread(true))
+            {
+                fNumWorkers = i;
+                stop();
+                return false;
+            }
+        }
+
+        fNumWorkers = numWorkers;
+        return true;
+    }
+
+    /*
+     * Stop all worker threads.
+     * Must not be called while a job is running.
+     */
+    void stop() noexcept
+    {
+        if (fWorkers == nullptr)
+            return;
+
+        for (uint i=0; i < fNumWorkers; ++i)
+        {
+            Worker& worker(fWorkers[i]);
+            worker.signalThreadShouldExit();
+            worker.wakeUp();
+        }
+
+        for (uint i=0; i < fNumWorkers; ++i)
+            fWorkers[i].stopThread(-1);
+
+        delete[] fWorkers;
+        fWorkers = nullptr;
+        fNumWorkers = 0;
+    }
+
+    /*
+     * Number of running worker threads, not counting the caller of runJob().
+     */
+    uint getNumWorkers() const noexcept
+    {
+        return fNumWorkers;
+    }
+
+    /*
+     * Run a job on the calling thread and all workers.
+     * Returns after the job has been fully processed.
+     */
+    void runJob(Job& job) noexcept
+    {
+        if (fNumWorkers == 0)
+            return job.run(false);
+
+        fJob = &job;
+        __sync_synchronize();
+        __sync_lock_test_and_set(&fJobClosed, 0);
+        __sync_add_and_fetch(&fGeneration, 1);
+
+        for (uint i=0; i < fNumWorkers; ++i)
+            fWorkers[i].wakeUp();
+
+        job.run(false);
+
+        // Once closed, late workers will skip this job.
+        // The ones that already entered are finishing their last piece of work.
+        __sync_lock_test_and_set(&fJobClosed, 1);
+        __sync_synchronize();
+
+        while (__sync_fetch_and_add(&fActiveWorkers, 0) != 0)
+            carla_cpu_relax();
+    }
+
+private:
+    // how many times a worker checks for a new job before going to sleep
+    static const uint kSpinCount = 20000;
+
+    struct Worker : public CarlaThread {
+        CarlaWorkerPool* fPool;
+        carla_sem_t fSem;
+        int fLastGeneration;
+        int fSleeping;
+
+        Worker() noexcept
+            : CarlaThread("CarlaWorkerPool"),
+              fPool(nullptr),
+              fSem(),
+              fLastGeneration(0),
+              fSleeping(0)
+        {
+            carla_sem_create2(fSem);
+        }
+
+        ~Worker() noexcept override
+        {
+            carla_sem_destroy2(fSem);
+        }
+
+        void wakeUp() noexcept
+        {
+            if (__sync_bool_compare_and_swap(&fSleeping, 1, 0))
+                carla_sem_post(fSem);
+        }
+
+        bool waitForJob() noexcept
+        {
+            for (uint i=0; i < kSpinCount; ++i)
+            {
+                if (__sync_fetch_and_add(&fPool->fGeneration, 0) != fLastGeneration)
+                    return true;
+
+                carla_cpu_relax();
+            }
+
+            __sync_lock_test_and_set(&fSleeping, 1);
+            __sync_synchronize();
+
+            // runJob() and stop() change their flag before waking us, so either we see it here or they see us sleeping
+            if (__sync_fetch_and_add(&fPool->fGeneration, 0) == fLastGeneration && ! shouldThreadExit())
+            {
+                if (carla_sem_wait(fSem))
+                    return true;
+            }
+
+            // nobody woke us up, we're done here
+            if (__sync_bool_compare_and_swap(&fSleeping, 1, 0))
+                return false;
+
+            // a wake up call is on its way, consume it
+            carla_sem_wait(fSem);
+            return true;
+        }
+
+        void run() override
+        {
+            while (! shouldThreadExit())
+            {
+                if (! waitForJob())
+                    continue;
+
+                const int generation = __sync_fetch_and_add(&fPool->fGeneration, 0);
+
+                if (generation == fLastGeneration)
+                    continue;
+
+                fLastGeneration = generation;
+
+                __sync_add_and_fetch(&fPool->fActiveWorkers, 1);
+
+                if (__sync_fetch_and_add(&fPool->fJobClosed, 0) == 0)
+                    fPool->fJob->run(true);
+
+                __sync_sub_and_fetch(&fPool->fActiveWorkers, 1);
+            }
+        }
+
+        CARLA_DECLARE_NON_COPY_STRUCT(Worker)
+    };
+
+    Worker* fWorkers;
+    uint fNumWorkers;
+
+    Job* volatile fJob;
+    int fGeneration;
+    int fActiveWorkers;
+    int fJobClosed;
+
+    CARLA_DECLARE_NON_COPY_CLASS(CarlaWorkerPool)
+};
+
+// -----------------------------------------------------------------------
+
+#endif // CARLA_WORKER_POOL_HPP_INCLUDED
@@ -152,6 +152,15 @@ public:
         return writeAtomChunk(atom, data, static_cast<int32_t>(portIndex));
     }
 
+    // NOTE: does not lock, only safe when there is a single writer thread
+    bool putChunkUnlocked(const LV2_Atom* const atom, const void* const data, const uint32_t portIndex) noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN(atom != nullptr && atom->size > 0, false);
+        CARLA_SAFE_ASSERT_RETURN(data != nullptr, false);
+
+        return writeAtomChunk(atom, data, static_cast<int32_t>(portIndex));
+    }
+
 protected:
     // -------------------------------------------------------------------
 
@@ -0,0 +1,145 @@
+/*
+ * Carla LV2 fixed URIDs
+ * Copyright (C) 2011-2018 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the doc/GPL.txt file.
+ */
+
+#ifndef LV2_FIXED_URIDS_HPP_INCLUDED
+#define LV2_FIXED_URIDS_HPP_INCLUDED
+
+#include "lv2/atom.h"
+#include "lv2/buf-size.h"
+#include "lv2/log.h"
+#include "lv2/midi.h"
+#include "lv2/parameters.h"
+#include "lv2/time.h"
+#include "lv2/ui.h"
+#include "lv2/lv2_kxstudio_properties.h"
+
+#define URI_CARLA_ATOM_WORKER "http://kxstudio.sf.net/ns/carla/atomWorker"
+
+// -----------------------------------------------------------------------
+// URIDs known in advance by both the plugin host and its UI bridges.
+// They are added to every Lv2UridMap first, so they have the same values everywhere.
+
+// LV2 URI Map Ids
+enum CarlaLv2URIDs {
+    kUridNull = 0,
+    kUridAtomBlank,
+    kUridAtomBool,
+    kUridAtomChunk,
+    kUridAtomDouble,
+    kUridAtomEvent,
+    kUridAtomFloat,
+    kUridAtomInt,
+    kUridAtomLiteral,
+    kUridAtomLong,
+    kUridAtomNumber,
+    kUridAtomObject,
+    kUridAtomPath,
+    kUridAtomProperty,
+    kUridAtomResource,
+    kUridAtomSequence,
+    kUridAtomSound,
+    kUridAtomString,
+    kUridAtomTuple,
+    kUridAtomURI,
+    kUridAtomURID,
+    kUridAtomVector,
+    kUridAtomTransferAtom,
+    kUridAtomTransferEvent,
+    kUridBufMaxLength,
+    kUridBufMinLength,
+    kUridBufNominalLength,
+    kUridBufSequenceSize,
+    kUridLogError,
+    kUridLogNote,
+    kUridLogTrace,
+    kUridLogWarning,
+    // time base type
+    kUridTimePosition,
+     // time values
+    kUridTimeBar,
+    kUridTimeBarBeat,
+    kUridTimeBeat,
+    kUridTimeBeatUnit,
+    kUridTimeBeatsPerBar,
+    kUridTimeBeatsPerMinute,
+    kUridTimeFrame,
+    kUridTimeFramesPerSecond,
+    kUridTimeSpeed,
+    kUridTimeTicksPerBeat,
+    kUridMidiEvent,
+    kUridParamSampleRate,
+    kUridWindowTitle,
+    kUridCarlaAtomWorker,
+    kUridCarlaTransientWindowId,
+    kUridCount
+};
+
+// URIs of the fixed ids above, in the same order
+static const char* const kCarlaLv2URIs[kUridCount] = {
+    nullptr,
+    LV2_ATOM__Blank,                                   // kUridAtomBlank
+    LV2_ATOM__Bool,                                    // kUridAtomBool
+    LV2_ATOM__Chunk,                                   // kUridAtomChunk
+    LV2_ATOM__Double,                                  // kUridAtomDouble
+    LV2_ATOM__Event,                                   // kUridAtomEvent
+    LV2_ATOM__Float,                                   // kUridAtomFloat
+    LV2_ATOM__Int,                                     // kUridAtomInt
+    LV2_ATOM__Literal,                                 // kUridAtomLiteral
+    LV2_ATOM__Long,                                    // kUridAtomLong
+    LV2_ATOM__Number,                                  // kUridAtomNumber
+    LV2_ATOM__Object,                                  // kUridAtomObject
+    LV2_ATOM__Path,                                    // kUridAtomPath
+    LV2_ATOM__Property,                                // kUridAtomProperty
+    LV2_ATOM__Resource,                                // kUridAtomResource
+    LV2_ATOM__Sequence,                                // kUridAtomSequence
+    LV2_ATOM__Sound,                                   // kUridAtomSound
+    LV2_ATOM__String,                                  // kUridAtomString
+    LV2_ATOM__Tuple,                                   // kUridAtomTuple
+    LV2_ATOM__URI,                                     // kUridAtomURI
+    LV2_ATOM__URID,                                    // kUridAtomURID
+    LV2_ATOM__Vector,                                  // kUridAtomVector
+    LV2_ATOM__atomTransfer,                            // kUridAtomTransferAtom
+    LV2_ATOM__eventTransfer,                           // kUridAtomTransferEvent
+    LV2_BUF_SIZE__maxBlockLength,                      // kUridBufMaxLength
+    LV2_BUF_SIZE__minBlockLength,                      // kUridBufMinLength
+    LV2_BUF_SIZE__nominalBlockLength,                  // kUridBufNominalLength
+    LV2_BUF_SIZE__sequenceSize,                        // kUridBufSequenceSize
+    LV2_LOG__Error,                                    // kUridLogError
+    LV2_LOG__Note,                                     // kUridLogNote
+    LV2_LOG__Trace,                                    // kUridLogTrace
+    LV2_LOG__Warning,                                  // kUridLogWarning
+    LV2_TIME__Position,                                // kUridTimePosition
+    LV2_TIME__bar,                                     // kUridTimeBar
+    LV2_TIME__barBeat,                                 // kUridTimeBarBeat
+    LV2_TIME__beat,                                    // kUridTimeBeat
+    LV2_TIME__beatUnit,                                // kUridTimeBeatUnit
+    LV2_TIME__beatsPerBar,                             // kUridTimeBeatsPerBar
+    LV2_TIME__beatsPerMinute,                          // kUridTimeBeatsPerMinute
+    LV2_TIME__frame,                                   // kUridTimeFrame
+    LV2_TIME__framesPerSecond,                         // kUridTimeFramesPerSecond
+    LV2_TIME__speed,                                   // kUridTimeSpeed
+    LV2_KXSTUDIO_PROPERTIES__TimePositionTicksPerBeat, // kUridTimeTicksPerBeat
+    LV2_MIDI__MidiEvent,                               // kUridMidiEvent
+    LV2_PARAMETERS__sampleRate,                        // kUridParamSampleRate
+    LV2_UI__windowTitle,                               // kUridWindowTitle
+    URI_CARLA_ATOM_WORKER,                             // kUridCarlaAtomWorker
+    LV2_KXSTUDIO_PROPERTIES__TransientWindowId,        // kUridCarlaTransientWindowId
+};
+
+// -----------------------------------------------------------------------
+
+#endif // LV2_FIXED_URIDS_HPP_INCLUDED
@@ -0,0 +1,262 @@
+/*
+ * LV2 URID Map
+ * Copyright (C) 2018 Filipe Coelho <falktx@falktx.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * For a full copy of the GNU General Public License see the doc/GPL.txt file.
+ */
+
+#ifndef LV2_URID_MAP_HPP_INCLUDED
+#define LV2_URID_MAP_HPP_INCLUDED
+
+#include "CarlaMutex.hpp"
+
+#include "lv2/urid.h"
+
+// -----------------------------------------------------------------------
+// Table of URI <-> URID mappings, meant to be shared by many plugin instances.
+//
+// URIDs are never removed, and the strings they point to never move.
+// Lookups of already known URIs or URIDs do not lock nor allocate, so they are real-time safe.
+// Adding a new URI takes a lock and allocates memory.
+// URIDs are assigned in order, so every URID below getCount() is valid (except 0).
+
+class Lv2UridMap
+{
+public:
+    Lv2UridMap() noexcept
+        : fMutex(),
+          fCount(1)
+    {
+        for (uint32_t i=0; i < kBucketCount; ++i)
+            fBuckets[i] = nullptr;
+
+        for (uint32_t i=0; i < kMaxChunks; ++i)
+            fChunks[i] = nullptr;
+    }
+
+    ~Lv2UridMap() noexcept
+    {
+        for (uint32_t i=0; i < kBucketCount; ++i)
+        {
+            for (Node* node = fBuckets[i]; node != nullptr;)
+            {
+                Node* const next(node->next);
+                std::free(node);
+                node = next;
+            }
+        }
+
+        for (uint32_t i=0; i < kMaxChunks; ++i)
+            delete[] fChunks[i];
+    }
+
+    /*
+     * Add a list of fixed URIs, where uris[i] gets URID i.
+     * uris[0] is ignored, as URID 0 is never valid.
+     * Does nothing if the map already has them.
+     */
+    void addFixedURIs(const char* const uris[], const uint32_t count) noexcept
+    {
+        const CarlaMutexLocker cml(fMutex);
+
+        if (fCount > 1)
+        {
+            CARLA_SAFE_ASSERT(fCount >= count);
+            return;
+        }
+
+        for (uint32_t i=1; i < count; ++i)
+        {
+            CARLA_SAFE_ASSERT_BREAK(uris[i] != nullptr && uris[i][0] != '\0');
+            CARLA_SAFE_ASSERT_BREAK(_insert(uris[i], hash(uris[i])) == i);
+        }
+    }
+
+    /*
+     * Get the URID of an URI, adding it if needed.
+     * Returns 0 on failure.
+     */
+    LV2_URID map(const char* const uri) noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN(uri != nullptr && uri[0] != '\0', 0);
+
+        const uint32_t uriHash(hash(uri));
+
+        if (const LV2_URID urid = _find(uri, uriHash))
+            return urid;
+
+        const CarlaMutexLocker cml(fMutex);
+
+        // someone might have added it meanwhile
+        if (const LV2_URID urid = _find(uri, uriHash))
+            return urid;
+
+        return _insert(uri, uriHash);
+    }
+
+    /*
+     * Get the URID of an URI, without adding it.
+     * Returns 0 if the URI is unknown.
+     */
+    LV2_URID find(const char* const uri) const noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN(uri != nullptr && uri[0] != '\0', 0);
+
+        return _find(uri, hash(uri));
+    }
+
+    /*
+     * Get the URI of an URID.
+     * Returns null if the URID is unknown.
+     */
+    const char* unmap(const LV2_URID urid) const noexcept
+    {
+        if (urid == 0 || urid >= fCount)
+            return nullptr;
+
+        __sync_synchronize();
+
+        const Node* const node(fChunks[urid / kChunkSize][urid % kChunkSize]);
+        CARLA_SAFE_ASSERT_RETURN(node != nullptr, nullptr);
+
+        return node->uri;
+    }
+
+    /*
+     * Add an URI with a URID given by someone else, like a remote copy of this map.
+     * Returns false if the URID is already taken by a different URI, or if it is not the next free one.
+     */
+    bool mapWithURID(const LV2_URID urid, const char* const uri) noexcept
+    {
+        CARLA_SAFE_ASSERT_RETURN(urid != 0, false);
+        CARLA_SAFE_ASSERT_RETURN(uri != nullptr && uri[0] != '\0', false);
+
+        const CarlaMutexLocker cml(fMutex);
+
+        if (urid < fCount)
+        {
+            const char* const ourURI(unmap(urid));
+            return ourURI != nullptr && std::strcmp(ourURI, uri) == 0;
+        }
+
+        if (urid != fCount)
+            return false;
+
+        const uint32_t uriHash(hash(uri));
+
+        if (_find(uri, uriHash) != 0)
+            return false;
+
+        return _insert(uri, uriHash) == urid;
+    }
+
+    /*
+     * Number of URIDs in use, including the invalid URID 0.
+     * A snapshot of the map is the list of URIs from 1 up to (but not including) this value.
+     */
+    uint32_t getCount() const noexcept
+    {
+        return fCount;
+    }
+
+private:
+    static const uint32_t kBucketCount = 1024;
+    static const uint32_t kChunkSize   = 256;
+    static const uint32_t kMaxChunks   = 1024;
+
+    struct Node {
+        Node* volatile next;
+        uint32_t hash;
+        LV2_URID urid;
+        char uri[1];
+    };
+
+    mutable CarlaMutex fMutex;
+
+    Node* volatile fBuckets[kBucketCount];
+    Node* volatile* volatile fChunks[kMaxChunks];
+    volatile uint32_t fCount;
+
+    // FNV-1a
+    static uint32_t hash(const char* uri) noexcept
+    {
+        uint32_t h = 2166136261U;
+
+        for (; *uri != '\0'; ++uri)
+        {
+            h ^= static_cast<uint8_t>(*uri);
+            h *= 16777619U;
+        }
+
+        return h;
+    }
+
+    LV2_URID _find(const char* const uri, const uint32_t uriHash) const noexcept
+    {
+        for (const Node* node = fBuckets[uriHash % kBucketCount]; node != nullptr; node = node->next)
+        {
+            if (node->hash == uriHash && std::strcmp(node->uri, uri) == 0)
+                return node->urid;
+        }
+
+        return 0;
+    }
+
+    // must be called with the lock held
+    LV2_URID _insert(const char* const uri, const uint32_t uriHash) noexcept
+    {
+        const LV2_URID urid(fCount);
+        const uint32_t chunkIndex(urid / kChunkSize);
+        CARLA_SAFE_ASSERT_RETURN(chunkIndex < kMaxChunks, 0);
+
+        if (fChunks[chunkIndex] == nullptr)
+        {
+            Node* volatile* chunk;
+
+            try {
+                chunk = new Node* volatile[kChunkSize];
+            } CARLA_SAFE_EXCEPTION_RETURN("Lv2UridMap::_insert", 0);
+
+            for (uint32_t i=0; i < kChunkSize; ++i)
+                chunk[i] = nullptr;
+
+            __sync_synchronize();
+            fChunks[chunkIndex] = chunk;
+        }
+
+        const std::size_t uriLen(std::strlen(uri));
+        Node* const node((Node*)std::malloc(sizeof(Node) + uriLen));
+        CARLA_SAFE_ASSERT_RETURN(node != nullptr, 0);
+
+        node->hash = uriHash;
+        node->urid = urid;
+        std::memcpy(node->uri, uri, uriLen+1);
+
+        Node* volatile& bucket(fBuckets[uriHash % kBucketCount]);
+        node->next = bucket;
+
+        // everything must be in place before readers can see the new node
+        fChunks[chunkIndex][urid % kChunkSize] = node;
+        __sync_synchronize();
+        fCount = urid + 1;
+        bucket = node;
+
+        return urid;
+    }
+
+    CARLA_DECLARE_NON_COPY_CLASS(Lv2UridMap)
+};
+
+// -----------------------------------------------------------------------
+
+#endif // LV2_URID_MAP_HPP_INCLUDED